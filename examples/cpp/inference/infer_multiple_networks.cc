@@ -14,6 +14,7 @@
  * limitations under the License.
  *******************************************************************************/
 
+#include <iomanip>
 #include <thread>
 
 #include "tensorflow/cc/client/client_session.h"
@@ -27,6 +28,8 @@
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/macros.h"
@@ -41,6 +44,7 @@
 #include "ngraph_bridge/version.h"
 
 #include "inference_engine.h"
+#include "load_generator.h"
 
 using namespace std;
 namespace tf = tensorflow;
@@ -92,20 +96,25 @@ void PrintVersion() {
 }
 
 //-----------------------------------------------------------------------------
-//  The benchmark test for inference does the following
-//    1. Preloads the input image buffer (currently single image)
-//    2. Creates the TensorFlow Session by loading a frozem inference graph
-//    3. Starts the worker threads and runs the test for a specifed iterations
+//  Load test for inference. It does the following
+//    1. Preloads a pool of inputs (the given images, and/or random tensors)
+//    2. Creates num_sessions TensorFlow Sessions from a frozen inference
+//       graph, and runs each once to get the nGraph compilation done
+//    3. Runs one load test per concurrency level (one, or each of sweep),
+//       either closed loop or open loop at a fixed QPS
+//    4. Prints the throughput and the latency percentiles of each, and
+//       writes them to json_output if given
 //
-//  Each worker thread does the following:
-//    1. Gets an image from the image pool
-//    2. Copies the data to a TensorFlow Tensor
-//    3. Runs the inference using the same session used by others as well
+//  Each request does the following:
+//    1. Gets the next input from the pool
+//    2. Gets the next available network model (i.e., session)
+//    3. Runs the inference on it, and gives it back
 //
 //-----------------------------------------------------------------------------
 int main(int argc, char** argv) {
   // parameters below need to modified as per model
-  string image_file = "grace_hopper.jpg";
+  string image_files_flag = "grace_hopper.jpg";
+  int random_inputs = 0;
   int batch_size = 1;
   string graph = "inception_v3_2016_08_28_frozen.pb";
   string labels = "";
@@ -119,11 +128,21 @@ int main(int argc, char** argv) {
   bool use_NCHW = false;
   bool preload_images = true;
   int input_channels = 3;
-  int iteration_count = 20;
-  int num_threads = 3;
+  int num_sessions = 3;
+  string mode = "closed";
+  int concurrency = 3;
+  float qps = 0;
+  float warmup_s = 2;
+  float duration_s = 10;
+  tf::int64 max_requests = 0;
+  string sweep = "";
+  string json_output = "";
 
   std::vector<tf::Flag> flag_list = {
-      tf::Flag("image", &image_file, "image to be processed"),
+      tf::Flag("image", &image_files_flag,
+               "comma separated images to be processed, one input each"),
+      tf::Flag("random_inputs", &random_inputs,
+               "Number of random inputs to add to the input pool"),
       tf::Flag("graph", &graph, "graph to be executed"),
       tf::Flag("labels", &labels, "name of file containing labels"),
       tf::Flag("label_index", &label_index, "Index of the expected label"),
@@ -137,14 +156,28 @@ int main(int argc, char** argv) {
       tf::Flag("input_layer", &input_layer, "name of input layer"),
       tf::Flag("output_layer", &output_layer, "name of output layer"),
       tf::Flag("use_NCHW", &use_NCHW, "Input data in NCHW format"),
-      tf::Flag("iteration_count", &iteration_count,
-               "How many times to repeat the inference"),
       tf::Flag("preload_images", &preload_images,
-               "Repeat the same image for inference"),
+               "Load the images before running the inference"),
       tf::Flag(
           "batch_size", &batch_size,
           "Input bach size. The same images is copied to create the batch"),
-      tf::Flag("num_threads", &num_threads, "Number of threads to use."),
+      tf::Flag("num_sessions", &num_sessions,
+               "Number of sessions (network models) sharing the load"),
+      tf::Flag("mode", &mode,
+               "closed: every worker sends its next request as soon as the "
+               "last one is done. open: requests are sent at a fixed qps"),
+      tf::Flag("concurrency", &concurrency, "Number of worker threads"),
+      tf::Flag("qps", &qps, "Requests per second in the open mode"),
+      tf::Flag("warmup_s", &warmup_s,
+               "Seconds of load before the measurement starts"),
+      tf::Flag("duration_s", &duration_s, "Seconds of measured load"),
+      tf::Flag("max_requests", &max_requests,
+               "Stop after this many measured requests (0 for no limit)"),
+      tf::Flag("sweep", &sweep,
+               "comma separated concurrency levels to run one after the "
+               "other, instead of concurrency"),
+      tf::Flag("json_output", &json_output,
+               "File to write the results to as JSON"),
   };
 
   string usage = tensorflow::Flags::Usage(argv[0], flag_list);
@@ -161,6 +194,36 @@ int main(int argc, char** argv) {
     return -1;
   }
 
+  benchmark::LoadConfig load_config;
+  if (mode == "open") {
+    load_config.mode = benchmark::LoadConfig::Mode::kOpenLoop;
+    if (qps <= 0) {
+      std::cout << "Error: The open mode needs a qps\n";
+      return -1;
+    }
+  } else if (mode != "closed") {
+    std::cout << "Error: Unknown mode " << mode << "\n" << usage;
+    return -1;
+  }
+  load_config.target_qps = qps;
+  load_config.warmup_s = warmup_s;
+  load_config.duration_s = duration_s;
+  load_config.max_requests = max_requests;
+
+  vector<int> concurrency_levels;
+  for (const auto& level : tf::str_util::Split(sweep, ',',
+                                               tf::str_util::SkipEmpty())) {
+    tf::int32 value;
+    if (!tf::strings::safe_strto32(level, &value) || value < 1) {
+      std::cout << "Error: Bad concurrency level in sweep: " << level << "\n";
+      return -1;
+    }
+    concurrency_levels.push_back(value);
+  }
+  if (concurrency_levels.empty()) {
+    concurrency_levels.push_back(concurrency);
+  }
+
 // Register cpu backend for static linking
 // [TODO]: Revisit this to see if we can remove registering here and register
 // only in BackendManager.
@@ -177,16 +240,33 @@ int main(int argc, char** argv) {
   std::cout << "Component versions\n";
   PrintVersion();
 
-  // If batch size is more than one then expand the input
-  vector<string> image_files;
-  for (int i = 0; i < batch_size; i++) {
-    image_files.push_back(image_file);
-  }
-  // Instantiate the Engine
+  //
+  // Fill the input pool
+  //
   benchmark::InferenceEngine inference_engine("Foo");
-  TF_CHECK_OK(inference_engine.LoadImage(
-      graph, image_files, input_width, input_height, input_mean, input_std,
-      input_layer, output_layer, use_NCHW, preload_images, input_channels));
+  for (const auto& image_file :
+       tf::str_util::Split(image_files_flag, ',', tf::str_util::SkipEmpty())) {
+    // If batch size is more than one then expand the input
+    vector<string> image_files(batch_size, image_file);
+    TF_CHECK_OK(inference_engine.LoadImage(
+        graph, image_files, input_width, input_height, input_mean, input_std,
+        input_layer, output_layer, use_NCHW, preload_images, input_channels));
+  }
+  if (random_inputs > 0) {
+    tf::TensorShape input_shape =
+        use_NCHW ? tf::TensorShape{batch_size, input_channels, input_height,
+                                   input_width}
+                 : tf::TensorShape{batch_size, input_height, input_width,
+                                   input_channels};
+    TF_CHECK_OK(inference_engine.AddRandomInputs(
+        random_inputs, input_shape, (0 - input_mean) / input_std,
+        (255 - input_mean) / input_std));
+  }
+  if (inference_engine.InputPoolSize() == 0) {
+    std::cout << "Error: No inputs. Give images to preload, or "
+                 "random_inputs\n";
+    return -1;
+  }
 
   string backend_name = "CPU";
   if (std::getenv("NGRAPH_TF_BACKEND") != nullptr) {
@@ -194,184 +274,88 @@ int main(int argc, char** argv) {
   }
 
   //
-  // Create the sessions
+  // Create the sessions, and run each once to get the nGraph compilation done
   //
-  map<Session*, string> session_db;
-  unique_ptr<Session> session_one;
-  TF_CHECK_OK(benchmark::InferenceEngine::CreateSession(graph, backend_name,
-                                                        "0", session_one));
-  session_db[session_one.get()] = "One";
-
-  unique_ptr<Session> session_two;
-  TF_CHECK_OK(benchmark::InferenceEngine::CreateSession(graph, backend_name,
-                                                        "0", session_two));
-  session_db[session_two.get()] = "Two";
-
-  unique_ptr<Session> session_three;
-  TF_CHECK_OK(benchmark::InferenceEngine::CreateSession(graph, backend_name,
-                                                        "0", session_three));
-  session_db[session_three.get()] = "Three";
+  tf::ngraph_bridge::ThreadSafeQueue<unique_ptr<Session>> session_queue;
   std::vector<Tensor> outputs;
   {
-    NG_TRACE("Compilation", "Compilation", "");
-
-    //
-    // Warm-up i.e., Call it onces to get the nGraph compilation done
-    //
     Tensor next_image;
     TF_CHECK_OK(inference_engine.GetNextImage(next_image));
-    // Run inference once. This will trigger a compilation
     tf::ngraph_bridge::Timer compilation_time;
-    TF_CHECK_OK(session_one->Run({{input_layer, next_image}}, {output_layer},
-                                 {}, &outputs));
-    TF_CHECK_OK(session_two->Run({{input_layer, next_image}}, {output_layer},
-                                 {}, &outputs));
-    TF_CHECK_OK(session_three->Run({{input_layer, next_image}}, {output_layer},
-                                   {}, &outputs));
+    for (int i = 0; i < num_sessions; i++) {
+      unique_ptr<Session> session;
+      TF_CHECK_OK(benchmark::InferenceEngine::CreateSession(
+          graph, backend_name, "0", session));
+      TF_CHECK_OK(
+          session->Run({{input_layer, next_image}}, {output_layer}, {},
+                       &outputs));
+      session_queue.Add(move(session));
+    }
     compilation_time.Stop();
 
     cout << "Compilation took: " << compilation_time.ElapsedInMS() << " ms"
          << endl;
   }
-  //
-  // Add these sessions to the queue
-  //
-  tf::ngraph_bridge::ThreadSafeQueue<unique_ptr<Session>> session_queue;
-  session_queue.Add(move(session_one));
-  session_queue.Add(move(session_two));
-  session_queue.Add(move(session_three));
-
-  cout << "Session: " << session_db[session_one.get()] << "\n";
-  unordered_map<Session*, pair<float, float>> session_stats;
 
   //------------------------------------
-  // Worker thread function
+  // One request
   //------------------------------------
-  auto worker = [&](int worker_id) {
-    ostringstream oss;
-    oss << "Worker" << worker_id;
-    std::vector<Tensor> output_each_thread;
-
-    unordered_map<Session*, pair<float, float>> local_stats;
-    unordered_map<Session*, int> num_items;
-
-    //-----------------------------------------
-    // Run the inference loop
-    //-----------------------------------------
-    for (int i = 0; i < iteration_count; i++) {
-      NG_TRACE(oss.str(), to_string(i), "");
-
-      tf::ngraph_bridge::Timer get_image_timer;
-      //
-      // Get the image
-      //
-      Tensor next_image;
-      TF_CHECK_OK(inference_engine.GetNextImage(next_image));
-      get_image_timer.Stop();
-
-      //
-      // Get the next available network model (i.e., session)
-      //
-      tf::ngraph_bridge::Timer execute_inference_timer;
-      unique_ptr<Session> next_available_session;
-      {
-        NG_TRACE("Get Session", string("Iteration") + to_string(i), "");
-        next_available_session = session_queue.GetNextAvailable();
-      }
-
-      //
-      // Run inference on this network model (i.e., session)
-      //
-      {
-        NG_TRACE("Run Session", string("Iteration") + to_string(i), "");
-        TF_CHECK_OK(next_available_session->Run({{input_layer, next_image}},
-                                                {output_layer}, {},
-                                                &output_each_thread));
-      }
-      Session* next_session_ptr = next_available_session.get();
-      session_queue.Add(move(next_available_session));
-      execute_inference_timer.Stop();
-
-      //
-      // Update the stats
-      //
-      local_stats[next_session_ptr].first += get_image_timer.ElapsedInMS();
-      local_stats[next_session_ptr].second +=
-          execute_inference_timer.ElapsedInMS();
-      num_items[next_session_ptr]++;
-    }
-
-    //-----------------------------------------
-    // Calculate the average across all the
-    // sessions used by this thread
-    //-----------------------------------------
-    map<Session*, vector<float>> get_avg;
-    map<Session*, vector<float>> infer_avg;
-    for (auto& next : num_items) {
-      Session* next_session = next.first;
-      int total_inferences = next.second;
-      float avg_get_time = local_stats[next_session].first / total_inferences;
-      float avg_infer_time =
-          local_stats[next_session].second / total_inferences;
-
-      get_avg[next_session].push_back(avg_get_time);
-      infer_avg[next_session].push_back(avg_infer_time);
-    }
-
-    // Now calcuate the average for each session
-    unordered_map<Session*, pair<float, float>> per_session_stats;
-    for (auto& next : get_avg) {
-      Session* next_session = next.first;
-      int total_inferences = next.second.size();
-      float avg_img_get_time = 0.0;
-      for (int i = 0; i < total_inferences; i++) {
-        avg_img_get_time += next.second[i];
-      }
-      avg_img_get_time = avg_img_get_time / total_inferences;
-
-      per_session_stats[next_session].first = avg_img_get_time;
-    }
-
-    for (auto& next : infer_avg) {
-      Session* next_session = next.first;
-      int total_inferences = next.second.size();
-
-      float avg_infer_time = 0.0;
-      for (int i = 0; i < total_inferences; i++) {
-        avg_infer_time += next.second[i];
-      }
-
-      per_session_stats[next_session].second = avg_infer_time;
-    }
-
-    // Print the stats
-    for (auto& next : per_session_stats) {
-      Session* next_session = next.first;
-      cout << "Worker: " << worker_id
-           << " Session: " << session_db[next_session]
-           << " Get Img Avg: " << next.second.first << " ms "
-           << " Inf Avg: " << next.second.second << " ms "
-           << "\n";
-    }
+  auto request = [&](int worker_id) -> Status {
+    Tensor next_image;
+    TF_RETURN_IF_ERROR(inference_engine.GetNextImage(next_image));
+
+    unique_ptr<Session> next_available_session =
+        session_queue.GetNextAvailable();
+    std::vector<Tensor> output_each_request;
+    Status status = next_available_session->Run(
+        {{input_layer, next_image}}, {output_layer}, {}, &output_each_request);
+    session_queue.Add(move(next_available_session));
+    return status;
   };
 
   //
-  // Spawn the threads
+  // Run the load, once per concurrency level
   //
-  tf::ngraph_bridge::Timer benchmark_timer;
-  vector<thread> threads;
-
-  for (int i = 0; i < num_threads; i++) {
-    std::thread thread_next(worker, i);
-    threads.push_back(move(thread_next));
+  vector<benchmark::LoadResult> results;
+  bool failed = false;
+  for (int level : concurrency_levels) {
+    load_config.concurrency = level;
+    results.push_back(benchmark::RunLoad(load_config, request));
+    const benchmark::LoadResult& result = results.back();
+    cout << result.Summary() << "\n";
+    if (!result.first_error.empty()) {
+      cout << "Error: " << result.first_error << "\n";
+      failed = true;
+    }
   }
 
-  for (int i = 0; i < num_threads; i++) {
-    threads[i].join();
+  if (results.size() > 1) {
+    cout << "\nThroughput (images/s) and latency (ms) by concurrency\n";
+    cout << std::fixed << std::setprecision(2) << std::setw(12)
+         << "concurrency" << std::setw(12) << "images/s" << std::setw(10)
+         << "p50" << std::setw(10) << "p99" << "\n";
+    for (const auto& result : results) {
+      cout << std::setw(12) << result.config.concurrency << std::setw(12)
+           << result.Throughput() * batch_size << std::setw(10)
+           << result.latency.Percentile(50) / 1000.0 << std::setw(10)
+           << result.latency.Percentile(99) / 1000.0 << "\n";
+    }
   }
 
-  benchmark_timer.Stop();
-  cout << "Total time: " << benchmark_timer.ElapsedInMS() << " ms\n";
+  if (!json_output.empty()) {
+    ostringstream json;
+    json << "{\"graph\":\"" << graph << "\",\"backend\":\"" << backend_name
+         << "\",\"batch_size\":" << batch_size
+         << ",\"input_pool_size\":" << inference_engine.InputPoolSize()
+         << ",\"num_sessions\":" << num_sessions << ",\"runs\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+      json << (i == 0 ? "" : ",") << "\n" << results[i].ToJson();
+    }
+    json << "\n]}\n";
+    TF_CHECK_OK(tf::WriteStringToFile(tf::Env::Default(), json_output,
+                                      json.str()));
+    cout << "Results written to " << json_output << "\n";
+  }
 
   //
   // Validate the label if provided
@@ -389,5 +373,5 @@ int main(int argc, char** argv) {
       }
     }
   }
-  return 0;
+  return failed ? -1 : 0;
 }
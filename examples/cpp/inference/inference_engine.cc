@@ -16,6 +16,7 @@
 
 #include <chrono>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <vector>
 
@@ -83,7 +84,7 @@ Status InferenceEngine::LoadImage(const string& network,
     TF_CHECK_OK(ReadTensorFromImageFile(
         m_image_files, m_input_height, m_input_width, m_input_mean, m_input_std,
         m_use_NCHW, m_input_channels, &resized_tensors));
-    m_image_to_repeat = resized_tensors[0];
+    m_input_pool.push_back(resized_tensors[0]);
     TF_CHECK_OK(tf::ngraph_bridge::BackendManager::SetBackend(current_backend));
   }
   // Now compile the graph if needed
@@ -96,10 +97,23 @@ Status InferenceEngine::LoadImage(const string& network,
   return Status::OK();
 }
 
-InferenceEngine::~InferenceEngine() {
-  if (m_worker.joinable()) {
-    m_worker.join();
+InferenceEngine::~InferenceEngine() {}
+
+Status InferenceEngine::AddRandomInputs(int count,
+                                        const tensorflow::TensorShape& shape,
+                                        float low, float high,
+                                        unsigned int seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> distribution(low, high);
+  for (int i = 0; i < count; i++) {
+    Tensor input(tensorflow::DT_FLOAT, shape);
+    auto values = input.flat<float>();
+    for (int64_t j = 0; j < values.size(); j++) {
+      values(j) = distribution(generator);
+    }
+    m_input_pool.push_back(input);
   }
+  return Status::OK();
 }
 
 Status InferenceEngine::CreateSession(const string& graph_filename,
@@ -17,14 +17,15 @@
 #define _INFERENCE_ENGINE_H_
 
 #include <unistd.h>
+#include <atomic>
 #include <chrono>
-#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
-#include <thread>
 #include <vector>
 
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/public/session.h"
 
@@ -34,9 +35,6 @@ using tensorflow::Tensor;
 
 using std::string;
 using std::unique_ptr;
-using std::thread;
-using std::atomic;
-using std::function;
 
 namespace benchmark {
 class InferenceEngine {
@@ -44,16 +42,28 @@ class InferenceEngine {
   InferenceEngine(const string& name);
   ~InferenceEngine();
 
+  // Adds the images (one per element of the batch) to the input pool
   Status LoadImage(const string& network,
                    const std::vector<string>& image_files, int input_width,
                    int input_height, float input_mean, float input_std,
                    const string& input_layer, const string& output_layer,
                    bool use_NCHW, bool preload_images, int input_channels);
 
+  // Adds count tensors of the given shape to the input pool, filled with
+  // random values between low and high
+  Status AddRandomInputs(int count, const tensorflow::TensorShape& shape,
+                         float low, float high, unsigned int seed = 0);
+
+  // Goes round the input pool, so that consecutive requests get distinct
+  // inputs
   Status GetNextImage(Tensor& image) const {
-    image = m_image_to_repeat;
+    if (m_input_pool.empty()) {
+      return tensorflow::errors::FailedPrecondition("No inputs loaded");
+    }
+    image = m_input_pool[m_next_input++ % m_input_pool.size()];
     return Status::OK();
   }
+  size_t InputPoolSize() const { return m_input_pool.size(); }
 
   static Status CreateSession(const string& network, const string& backend,
                               const string& dev_id,
@@ -61,10 +71,6 @@ class InferenceEngine {
 
  private:
   const string m_name;
-  unique_ptr<Session> m_session;
-  thread m_worker;
-  atomic<bool> m_terminate_worker{false};
-  std::function<void(int)> m_step_callback{nullptr};
 
   // Image related info
   std::vector<string> m_image_files;
@@ -77,7 +83,8 @@ class InferenceEngine {
   bool m_use_NCHW;
   bool m_preload_images;
   int m_input_channels;
-  Tensor m_image_to_repeat;
+  std::vector<Tensor> m_input_pool;
+  mutable std::atomic<size_t> m_next_input{0};
 };
 }  // namespace benchmark
 #endif  // _INFERENCE_ENGINE_H_
@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "load_generator.h"
+
+#include "ngraph_bridge/thread_safe_queue.h"
+
+using std::string;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+namespace benchmark {
+
+// Values below 2 * kSubBuckets get a bucket each. Above that every power of
+// two is split into kSubBuckets buckets.
+static const int kSubBuckets = 64;
+static const int kNumBuckets = 2 * kSubBuckets + 57 * kSubBuckets;
+
+LatencyHistogram::LatencyHistogram()
+    : m_counts(kNumBuckets, 0),
+      m_count(0),
+      m_min(INT64_MAX),
+      m_max(0),
+      m_sum(0) {}
+
+int LatencyHistogram::BucketIndex(int64_t value) {
+  if (value < 2 * kSubBuckets) {
+    return static_cast<int>(value);
+  }
+  int msb = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+  int shift = msb - 6;
+  return 2 * kSubBuckets + (shift - 1) * kSubBuckets +
+         static_cast<int>((value >> shift) - kSubBuckets);
+}
+
+int64_t LatencyHistogram::BucketHighest(int index) {
+  if (index < 2 * kSubBuckets) {
+    return index;
+  }
+  int shift = (index - 2 * kSubBuckets) / kSubBuckets + 1;
+  int64_t sub_bucket = (index - 2 * kSubBuckets) % kSubBuckets + kSubBuckets;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(int64_t value_us) {
+  value_us = std::max<int64_t>(value_us, 0);
+  m_counts[BucketIndex(value_us)]++;
+  m_count++;
+  m_min = std::min(m_min, value_us);
+  m_max = std::max(m_max, value_us);
+  m_sum += value_us;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (int i = 0; i < kNumBuckets; i++) {
+    m_counts[i] += other.m_counts[i];
+  }
+  m_count += other.m_count;
+  m_min = std::min(m_min, other.m_min);
+  m_max = std::max(m_max, other.m_max);
+  m_sum += other.m_sum;
+}
+
+double LatencyHistogram::Mean() const {
+  return m_count == 0 ? 0 : m_sum / m_count;
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) const {
+  if (m_count == 0) {
+    return 0;
+  }
+  int64_t rank = static_cast<int64_t>(
+      std::ceil(std::min(std::max(percentile, 0.0), 100.0) / 100 * m_count));
+  rank = std::max<int64_t>(rank, 1);
+  int64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    seen += m_counts[i];
+    if (seen >= rank) {
+      return std::min(BucketHighest(i), m_max);
+    }
+  }
+  return m_max;
+}
+
+static const char* ModeName(LoadConfig::Mode mode) {
+  return mode == LoadConfig::Mode::kOpenLoop ? "open" : "closed";
+}
+
+string LoadResult::Summary() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  out << ModeName(config.mode) << " loop, " << config.concurrency
+      << " workers";
+  if (config.mode == LoadConfig::Mode::kOpenLoop) {
+    out << ", target " << config.target_qps << " req/s";
+  }
+  out << ": " << requests << " requests, " << Throughput() << " req/s"
+      << ", latency (ms) p50 " << latency.Percentile(50) / 1000.0 << " p90 "
+      << latency.Percentile(90) / 1000.0 << " p99 "
+      << latency.Percentile(99) / 1000.0 << " p99.9 "
+      << latency.Percentile(99.9) / 1000.0 << " max "
+      << latency.Max() / 1000.0 << ", " << errors << " errors";
+  return out.str();
+}
+
+string LoadResult::ToJson() const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "{\"mode\":\"" << ModeName(config.mode) << "\""
+      << ",\"concurrency\":" << config.concurrency
+      << ",\"target_qps\":" << config.target_qps
+      << ",\"warmup_s\":" << config.warmup_s
+      << ",\"duration_s\":" << config.duration_s
+      << ",\"requests\":" << requests << ",\"errors\":" << errors
+      << ",\"elapsed_s\":" << elapsed_s
+      << ",\"throughput_rps\":" << Throughput() << ",\"latency_ms\":{"
+      << "\"min\":" << latency.Min() / 1000.0
+      << ",\"mean\":" << latency.Mean() / 1000.0
+      << ",\"p50\":" << latency.Percentile(50) / 1000.0
+      << ",\"p90\":" << latency.Percentile(90) / 1000.0
+      << ",\"p99\":" << latency.Percentile(99) / 1000.0
+      << ",\"p999\":" << latency.Percentile(99.9) / 1000.0
+      << ",\"max\":" << latency.Max() / 1000.0 << "}}";
+  return out.str();
+}
+
+namespace {
+
+struct WorkerStats {
+  LatencyHistogram latency;
+  int64_t errors = 0;
+  string first_error;
+  Clock::time_point last_done;
+};
+
+Clock::duration Seconds(double seconds) {
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(seconds));
+}
+
+}  // namespace
+
+LoadResult RunLoad(const LoadConfig& config, const RequestFunction& request) {
+  LoadResult result;
+  result.config = config;
+  int concurrency = std::max(1, config.concurrency);
+  result.config.concurrency = concurrency;
+  bool open_loop = config.mode == LoadConfig::Mode::kOpenLoop;
+  if (open_loop && config.target_qps <= 0) {
+    result.first_error = "The open loop needs a target QPS";
+    return result;
+  }
+
+  const Clock::time_point start = Clock::now();
+  const Clock::time_point measure_start = start + Seconds(config.warmup_s);
+  const Clock::time_point end = measure_start + Seconds(config.duration_s);
+  std::atomic<int64_t> measured{0};
+  std::atomic<bool> stop{false};
+  vector<WorkerStats> stats(concurrency);
+  for (auto& worker_stats : stats) {
+    worker_stats.last_done = measure_start;
+  }
+
+  // Runs one request that was due at the given time
+  auto run_request = [&](int worker, Clock::time_point due) {
+    tensorflow::Status status = request(worker);
+    Clock::time_point done = Clock::now();
+    if (due < measure_start) {
+      return;
+    }
+    WorkerStats& worker_stats = stats[worker];
+    if (status.ok()) {
+      worker_stats.latency.Record(
+          std::chrono::duration_cast<std::chrono::microseconds>(done - due)
+              .count());
+    } else if (worker_stats.errors++ == 0) {
+      worker_stats.first_error = status.error_message();
+    }
+    worker_stats.last_done = done;
+    if (config.max_requests > 0 && ++measured >= config.max_requests) {
+      stop = true;
+    }
+  };
+
+  // Requests go out on schedule in the open loop, to whichever worker is
+  // free. Each is identified by its due time, in nanoseconds from the start;
+  // a negative one tells a worker to quit.
+  tensorflow::ngraph_bridge::ThreadSafeQueue<int64_t> due_times;
+  vector<std::thread> workers;
+  if (!open_loop) {
+    for (int i = 0; i < concurrency; i++) {
+      workers.emplace_back([&, i]() {
+        Clock::time_point now;
+        while (!stop && (now = Clock::now()) < end) {
+          run_request(i, now);
+        }
+      });
+    }
+  } else {
+    for (int i = 0; i < concurrency; i++) {
+      workers.emplace_back([&, i]() {
+        while (true) {
+          int64_t due_ns = due_times.GetNextAvailable();
+          if (due_ns < 0) {
+            break;
+          }
+          if (!stop) {
+            run_request(i, start + std::chrono::nanoseconds(due_ns));
+          }
+        }
+      });
+    }
+    double interval_ns = 1e9 / config.target_qps;
+    for (int64_t i = 0; !stop; i++) {
+      auto due_ns = static_cast<int64_t>(i * interval_ns);
+      Clock::time_point due = start + std::chrono::nanoseconds(due_ns);
+      if (due >= end) {
+        break;
+      }
+      std::this_thread::sleep_until(due);
+      due_times.Add(due_ns);
+    }
+    for (int i = 0; i < concurrency; i++) {
+      due_times.Add(-1);
+    }
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  Clock::time_point last_done = measure_start;
+  for (const auto& worker_stats : stats) {
+    result.latency.Merge(worker_stats.latency);
+    if (result.errors == 0) {
+      result.first_error = worker_stats.first_error;
+    }
+    result.errors += worker_stats.errors;
+    last_done = std::max(last_done, worker_stats.last_done);
+  }
+  result.requests = result.latency.Count();
+  result.elapsed_s =
+      std::chrono::duration<double>(last_done - measure_start).count();
+  return result;
+}
+
+}  // namespace benchmark
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef _LOAD_GENERATOR_H_
+#define _LOAD_GENERATOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+
+namespace benchmark {
+
+// Latency histogram in the style of HdrHistogram: buckets grow with the
+// magnitude of the value, so that every recorded value is known within
+// 1/64 of itself (about 1.6%), from 1 us up to years, in a fixed amount of
+// memory. Values are in microseconds.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void Record(int64_t value_us);
+  void Merge(const LatencyHistogram& other);
+
+  int64_t Count() const { return m_count; }
+  int64_t Min() const { return m_count == 0 ? 0 : m_min; }
+  int64_t Max() const { return m_max; }
+  double Mean() const;
+  // The value that percentile (0 to 100) of the recorded values are at or
+  // below, rounded up to the top of its bucket
+  int64_t Percentile(double percentile) const;
+
+ private:
+  static int BucketIndex(int64_t value);
+  static int64_t BucketHighest(int index);
+
+  std::vector<int64_t> m_counts;
+  int64_t m_count;
+  int64_t m_min;
+  int64_t m_max;
+  double m_sum;
+};
+
+struct LoadConfig {
+  enum class Mode {
+    // Every worker issues its next request as soon as the last one is done
+    kClosedLoop,
+    // Requests are issued at target_qps whether or not the workers keep up;
+    // latency counts from when a request was due, so time spent waiting for
+    // a free worker is included
+    kOpenLoop,
+  };
+  Mode mode = Mode::kClosedLoop;
+  int concurrency = 1;
+  double target_qps = 0;
+  // Requests issued in the first warmup_s seconds are not measured
+  double warmup_s = 1;
+  double duration_s = 10;
+  // Stop after this many measured requests (0 for no limit)
+  int64_t max_requests = 0;
+};
+
+struct LoadResult {
+  LoadConfig config;
+  int64_t requests = 0;
+  int64_t errors = 0;
+  std::string first_error;
+  // From the end of the warmup to the last measured completion
+  double elapsed_s = 0;
+  LatencyHistogram latency;
+
+  double Throughput() const {
+    return elapsed_s > 0 ? requests / elapsed_s : 0;
+  }
+  std::string Summary() const;
+  std::string ToJson() const;
+};
+
+// Runs request(worker) under the load described by config. Workers are
+// numbered from 0 to config.concurrency - 1, and never run concurrently with
+// themselves.
+using RequestFunction = std::function<tensorflow::Status(int worker)>;
+LoadResult RunLoad(const LoadConfig& config, const RequestFunction& request);
+
+}  // namespace benchmark
+#endif  // _LOAD_GENERATOR_H_
@@ -28,6 +28,10 @@
 
 #include "ngraph_bridge/grappler/ngraph_optimizer.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
+#include "ngraph_bridge/ngraph_fold_static_inputs.h"
+#include "ngraph_bridge/ngraph_rewrite_cache.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 
 #include <iostream>
 
@@ -64,6 +68,7 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
   // arbitrary integer to avoid filename collisions resulting from subsequent
   // runs of this pass.
   int idx = FreshIndex();
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kGrapplerPass, idx);
 
   // If ngraph is disabled via ngraph_bridge api or NGRAPH_TF_DISABLE is set
   // we will not do anything; all subsequent passes become a no-op.
@@ -77,10 +82,10 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
     NGRAPH_VLOG(1) << std::string("Rewrite pass will not run because ") +
                           (already_processed ? "graph is already preprocessed"
                                              : "ngraph is disabled");
-    NGraphClusterManager::EvictAllClusters();
     graph.ToGraphDef(output);
     return Status::OK();
   }
+  RewriteReport report(idx);
 
   // TODO: Find out a better way to preserve feed nodes, init_ops and
   // keep_ops instead of just skipping those from clustering.
@@ -132,6 +137,37 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
                            nodes_to_add_identity_to.end());
   std::set<string>& skip_these_nodes = nodes_to_preserve;
 
+  // If this exact graph has been rewritten before, in this process or in any
+  // process sharing NGRAPH_TF_REWRITE_CACHE_DIR, reuse the result and skip
+  // all of the phases below. The key is computed over item.graph, i.e.
+  // before AddIdentityN, so that it only depends on the caller's input.
+  string cache_key;
+  if (NGraphRewriteCache::IsEnabled()) {
+    Status status = NGraphRewriteCache::ComputeKey(
+        item.graph, skip_these_nodes, m_config_map, cache_key);
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "NGTF_OPTIMIZER: Rewrite cache disabled for this "
+                        "graph: "
+                     << status.error_message();
+      cache_key.clear();
+    }
+  }
+  if (!cache_key.empty()) {
+    bool cache_hit = false;
+    Status status =
+        NGraphRewriteCache::Lookup(cache_key, idx, output, cache_hit);
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "NGTF_OPTIMIZER: Rewrite cache lookup failed: "
+                     << status.error_message();
+    } else if (cache_hit) {
+      NGRAPH_VLOG(1) << "NGTF_OPTIMIZER: Reusing cached rewrite for grappler "
+                        "item "
+                     << item.id;
+      report.Finish(/*cache_hit=*/true);
+      return Status::OK();
+    }
+  }
+
   //
   // Encapsulation: Part that rewrites the graph for nGraph operation.
   //
@@ -153,33 +189,45 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
   //   NGRAPH_TF_DUMP_ENCAPSULATED_GRAPHS=1  dumps graphs after phase 4
   //   NGRAPH_TF_DUMP_GRAPHS=1               all of the above
   //
+  // The time and counts of every phase go into the rewrite report of idx.
+  //
 
   // If requested, dump unmarked graphs.
   if (DumpUnmarkedGraphs()) {
     DumpGraphs(graph, idx, "unmarked", "Unmarked Graph");
   }
 
-  // 1. Mark for clustering then, if requested, dump the graphs.
-  TF_RETURN_IF_ERROR(MarkForClustering(&graph, skip_these_nodes));
+  // 1. Mark for clustering and fold the static inputs we can evaluate then,
+  //    if requested, dump the graphs.
+  TF_RETURN_IF_ERROR(report.RunPhase("mark", [&]() {
+    return MarkForClustering(&graph, skip_these_nodes);
+  }));
+  TF_RETURN_IF_ERROR(report.RunPhase("fold_static_inputs", [&]() {
+    return FoldStaticInputs(&graph, skip_these_nodes);
+  }));
   if (DumpMarkedGraphs()) {
     DumpGraphs(graph, idx, "marked", "Graph Marked for Clustering");
   }
 
   // 2. Assign clusters then, if requested, dump the graphs.
-  TF_RETURN_IF_ERROR(AssignClusters(&graph));
+  TF_RETURN_IF_ERROR(
+      report.RunPhase("assign", [&]() { return AssignClusters(&graph); }));
   if (DumpClusteredGraphs()) {
     DumpGraphs(graph, idx, "clustered", "Graph with Clusters Assigned");
   }
 
   // 3. Deassign trivial clusters then, if requested, dump the graphs.
-  TF_RETURN_IF_ERROR(DeassignClusters(&graph));
+  TF_RETURN_IF_ERROR(
+      report.RunPhase("deassign", [&]() { return DeassignClusters(&graph); }));
   if (DumpDeclusteredGraphs()) {
     DumpGraphs(graph, idx, "declustered",
                "Graph with Trivial Clusters De-Assigned");
   }
 
   // 4. Encapsulate clusters then, if requested, dump the graphs.
-  auto status = EncapsulateClusters(&graph, idx, m_config_map);
+  auto status = report.RunPhase("encapsulate", [&]() {
+    return EncapsulateClusters(&graph, idx, m_config_map);
+  });
   if (status != Status::OK()) {
     return status;
   }
@@ -189,6 +237,15 @@ Status NgraphOptimizer::Optimize(tensorflow::grappler::Cluster* cluster,
 
   // Convert the graph back to Graphdef
   graph.ToGraphDef(output);
+
+  if (!cache_key.empty()) {
+    status = NGraphRewriteCache::Insert(cache_key, *output);
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "NGTF_OPTIMIZER: Failed to cache rewritten graph: "
+                     << status.error_message();
+    }
+  }
+  report.Finish();
   return Status::OK();
 }
 
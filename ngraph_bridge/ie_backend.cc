@@ -44,7 +44,13 @@ IE_Backend::IE_Backend(const string& config) {
 IE_Backend::~IE_Backend() { m_exec_map.clear(); }
 
 shared_ptr<Executable> IE_Backend::compile(shared_ptr<ngraph::Function> func,
-                                           bool) {
+                                           bool enable_performance_data) {
+  return compile_dynamic(func, nullptr, enable_performance_data);
+}
+
+shared_ptr<Executable> IE_Backend::compile_dynamic(
+    shared_ptr<ngraph::Function> func, const StaticPasses& static_passes,
+    bool enable_performance_data) {
   shared_ptr<Executable> rc;
   {
     std::lock_guard<std::mutex> guard(m_exec_map_mutex);
@@ -55,7 +61,8 @@ shared_ptr<Executable> IE_Backend::compile(shared_ptr<ngraph::Function> func,
     }
   }
 
-  rc = make_shared<IE_Executable>(func, m_device);
+  rc = make_shared<IE_Executable>(func, m_device, enable_performance_data,
+                                  static_passes);
   {
     std::lock_guard<std::mutex> guard(m_exec_map_mutex);
     m_exec_map.insert({func, rc});
@@ -38,6 +38,9 @@ class IE_Backend final : public Backend {
 
   shared_ptr<Executable> compile(shared_ptr<ngraph::Function> func,
                                  bool enable_performance_data = false) override;
+  shared_ptr<Executable> compile_dynamic(
+      shared_ptr<ngraph::Function> func, const StaticPasses& static_passes,
+      bool enable_performance_data = false) override;
   void remove_compiled_function(std::shared_ptr<Executable> exec) override;
   bool is_supported(const ngraph::Node& node) const override;
   bool is_supported_property(const Property prop) const override;
@@ -45,6 +48,9 @@ class IE_Backend final : public Backend {
   shared_ptr<ngraph::runtime::Tensor> create_dynamic_tensor(
       const ngraph::element::Type& type,
       const ngraph::PartialShape& shape) override;
+  // IE networks have static shapes, but IE_Executable makes one for every
+  // input shape a function with dynamic dimensions is called for
+  bool supports_dynamic_dimensions() override { return true; }
 
   static vector<string> get_registered_devices();
 
@@ -14,6 +14,7 @@
 // limitations under the License.
 //*****************************************************************************
 
+#include "ngraph/graph_util.hpp"
 #include "ngraph/ngraph.hpp"
 #include "ngraph/opsets/opset.hpp"
 
@@ -28,8 +29,13 @@ using namespace ngraph;
 namespace tensorflow {
 namespace ngraph_bridge {
 
-IE_Executable::IE_Executable(shared_ptr<Function> func, string device)
-    : m_device{device}, m_trivial_fn{nullptr} {
+IE_Executable::IE_Executable(
+    shared_ptr<Function> func, string device, bool enable_performance_data,
+    std::function<void(shared_ptr<Function>)> static_passes)
+    : m_device{device},
+      m_performance_data{enable_performance_data},
+      m_trivial_fn{nullptr},
+      m_static_passes{static_passes} {
   NGRAPH_VLOG(2) << "Checking for unsupported ops in IE backend";
   const auto& opset = ngraph::get_opset3();
   for (const auto& node : func->get_ops()) {
@@ -40,6 +46,15 @@ IE_Executable::IE_Executable(shared_ptr<Function> func, string device)
     }
   }
 
+  // IE networks are static, so a function with dynamic dimensions is made
+  // static for the input shapes of every call, see call_dynamic
+  if (func->is_dynamic()) {
+    NGRAPH_VLOG(2) << "Function is dynamic, deferring IE network creation";
+    set_parameters_and_results(*func);
+    m_dynamic_fn = func;
+    return;
+  }
+
   // A trivial function is one of
   //  1. constant function (Const -> Result)
   //  2. identity function (Parameter -> Result)
@@ -112,15 +127,24 @@ IE_Executable::IE_Executable(shared_ptr<Function> func, string device)
 
   NGRAPH_VLOG(2) << "Loading IE CNN network to device " << m_device;
 
+  std::map<string, string> config;
+  if (m_performance_data) {
+    config[InferenceEngine::PluginConfigParams::KEY_PERF_COUNT] =
+        InferenceEngine::PluginConfigParams::YES;
+  }
+
   InferenceEngine::Core ie;
   // Load network to the plugin (m_device) and create an infer request
   InferenceEngine::ExecutableNetwork exe_network =
-      ie.LoadNetwork(m_network, m_device);
+      ie.LoadNetwork(m_network, m_device, config);
   m_infer_req = exe_network.CreateInferRequest();
 }
 
 bool IE_Executable::call(const vector<shared_ptr<runtime::Tensor>>& outputs,
                          const vector<shared_ptr<runtime::Tensor>>& inputs) {
+  if (m_dynamic_fn) {
+    return call_dynamic(outputs, inputs);
+  }
   if (m_trivial_fn) {
     NGRAPH_VLOG(2) << "Calling trivial IE function with inputs="
                    << inputs.size() << " outputs=" << outputs.size();
@@ -169,6 +193,97 @@ bool IE_Executable::call(const vector<shared_ptr<runtime::Tensor>>& outputs,
   return true;
 }
 
+bool IE_Executable::call_dynamic(
+    const vector<shared_ptr<runtime::Tensor>>& outputs,
+    const vector<shared_ptr<runtime::Tensor>>& inputs) {
+  auto parameters = m_dynamic_fn->get_parameters();
+  if (inputs.size() != parameters.size()) {
+    THROW_IE_EXCEPTION
+        << "Function inputs number differ from number of given inputs";
+  }
+  vector<Shape> input_shapes;
+  for (const auto& input : inputs) {
+    input_shapes.push_back(input->get_shape());
+  }
+
+  auto it = m_static_executables.find(input_shapes);
+  if (it == m_static_executables.end()) {
+    // The function is cloned with static Parameters, which makes all its
+    // ops infer their shapes again
+    NodeMap node_map;
+    for (size_t i = 0; i < parameters.size(); i++) {
+      if (!parameters[i]->get_partial_shape().relaxes(input_shapes[i])) {
+        THROW_IE_EXCEPTION << "Input " << i << " of shape " << input_shapes[i]
+                           << " does not fit parameter of shape "
+                           << parameters[i]->get_partial_shape();
+      }
+      auto param = make_shared<opset::Parameter>(
+          parameters[i]->get_element_type(), input_shapes[i]);
+      param->set_friendly_name(parameters[i]->get_friendly_name());
+      node_map[parameters[i].get()] = param;
+    }
+    auto func = clone_function(*m_dynamic_fn, node_map);
+    func->validate_nodes_and_infer_types();
+    // The passes that need static shapes were skipped on the dynamic
+    // function; they can run now
+    if (m_static_passes) {
+      m_static_passes(func);
+    }
+
+    // Networks are not evicted one by one, since a dynamic function is
+    // expected to see few distinct input shapes
+    if (m_static_executables.size() >= kMaxStaticExecutables) {
+      NGRAPH_VLOG(1) << "Dropping " << m_static_executables.size()
+                     << " IE networks of dynamic function "
+                     << m_dynamic_fn->get_friendly_name();
+      m_static_executables.clear();
+    }
+    NGRAPH_VLOG(2) << "Creating IE network of dynamic function "
+                   << m_dynamic_fn->get_friendly_name() << " for "
+                   << m_static_executables.size() + 1 << ". input shapes";
+    auto exec = make_shared<IE_Executable>(func, m_device, m_performance_data);
+    it = m_static_executables.emplace(input_shapes, exec).first;
+  }
+  m_last_static_executable = it->second;
+
+  // The static function tells the shapes of the outputs
+  auto results = it->second->get_results();
+  for (size_t i = 0; i < outputs.size() && i < results.size(); i++) {
+    if (outputs[i]->get_partial_shape().is_dynamic()) {
+      static_pointer_cast<IETensor>(outputs[i])
+          ->set_shape(results[i]->get_shape());
+    }
+  }
+  return it->second->call(outputs, inputs);
+}
+
+map<string, InferenceEngine::InferenceEngineProfileInfo>
+IE_Executable::get_performance_counts() {
+  if (m_dynamic_fn) {
+    if (m_last_static_executable == nullptr) {
+      return {};
+    }
+    return m_last_static_executable->get_performance_counts();
+  }
+  if (!m_performance_data || m_trivial_fn) {
+    return {};
+  }
+  return m_infer_req.GetPerformanceCounts();
+}
+
+shared_ptr<const Function> IE_Executable::get_function() const {
+  if (m_dynamic_fn) {
+    if (m_last_static_executable == nullptr) {
+      return m_dynamic_fn;
+    }
+    return m_last_static_executable->get_function();
+  }
+  if (m_trivial_fn) {
+    return m_trivial_fn;
+  }
+  return m_network.getFunction();
+}
+
 bool IE_Executable::call_trivial(
     const vector<shared_ptr<runtime::Tensor>>& outputs,
     const vector<shared_ptr<runtime::Tensor>>& inputs) {
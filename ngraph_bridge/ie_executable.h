@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -34,22 +36,46 @@ namespace ngraph_bridge {
 // function.
 class IE_Executable final : public Executable {
  public:
-  IE_Executable(shared_ptr<ngraph::Function> func, string device);
+  // static_passes are run on the static clones of a function with dynamic
+  // dimensions
+  IE_Executable(shared_ptr<ngraph::Function> func, string device,
+                bool enable_performance_data = false,
+                std::function<void(shared_ptr<ngraph::Function>)>
+                    static_passes = nullptr);
   virtual ~IE_Executable() {}
   bool call(const vector<shared_ptr<ngraph::runtime::Tensor>>& outputs,
             const vector<shared_ptr<ngraph::runtime::Tensor>>& inputs) final;
 
+  // Per-layer times of the last call, by IE layer name. Empty unless
+  // compiled with performance data enabled.
+  map<string, InferenceEngine::InferenceEngineProfileInfo>
+  get_performance_counts();
+  // The function the IE network was built from (of the last call, for a
+  // function with dynamic dimensions)
+  shared_ptr<const ngraph::Function> get_function() const;
+
  private:
   bool call_trivial(const vector<shared_ptr<ngraph::runtime::Tensor>>& outputs,
                     const vector<shared_ptr<ngraph::runtime::Tensor>>& inputs);
+  bool call_dynamic(const vector<shared_ptr<ngraph::runtime::Tensor>>& outputs,
+                    const vector<shared_ptr<ngraph::runtime::Tensor>>& inputs);
   InferenceEngine::CNNNetwork m_network;
   InferenceEngine::InferRequest m_infer_req;
   string m_device;
+  bool m_performance_data;
   // This holds the parameters we insert for functions with no input parameters
   vector<pair<string, shared_ptr<ngraph::runtime::Tensor>>> m_hoisted_params;
   // This keeps track of whether the original function was trivial: either a
   // constant function, an identity function or a zero function
   shared_ptr<ngraph::Function> m_trivial_fn;
+  // A function with dynamic dimensions, and the executables of its static
+  // clones by input shapes. Outputs of dynamic shape get the shapes of the
+  // clone's results before it is called.
+  shared_ptr<ngraph::Function> m_dynamic_fn;
+  std::function<void(shared_ptr<ngraph::Function>)> m_static_passes;
+  map<vector<ngraph::Shape>, shared_ptr<IE_Executable>> m_static_executables;
+  shared_ptr<IE_Executable> m_last_static_executable;
+  static constexpr size_t kMaxStaticExecutables = 16;
 };
 }
 }
@@ -76,13 +76,30 @@ static InferenceEngine::Precision getPrecision(
   }
 }
 
-IETensor::IETensor(const element::Type& element_type, const Shape& shape_,
+IETensor::IETensor(const element::Type& element_type, const Shape& shape,
                    void* memory_pointer)
     : runtime::Tensor(
-          make_shared<descriptor::Tensor>(element_type, shape_, "")) {
+          make_shared<descriptor::Tensor>(element_type, shape, "")) {
+  create_blob(memory_pointer);
+}
+
+IETensor::IETensor(const element::Type& element_type, const Shape& shape)
+    : IETensor(element_type, shape, nullptr) {}
+
+IETensor::IETensor(const element::Type& element_type, const PartialShape& shape)
+    : runtime::Tensor(
+          make_shared<descriptor::Tensor>(element_type, shape, "")) {
+  if (shape.is_static()) {
+    create_blob(nullptr);
+  }
+}
+
+void IETensor::create_blob(void* memory_pointer) {
   m_descriptor->set_tensor_layout(
       make_shared<descriptor::layout::DenseTensorLayout>(*m_descriptor));
 
+  const element::Type& element_type = get_element_type();
+  const Shape& shape_ = get_shape();
   InferenceEngine::SizeVector shape = shape_;
   InferenceEngine::Precision precision = getPrecision(element_type);
   InferenceEngine::Layout layout = getLayoutByDims(shape.size());
@@ -139,22 +156,31 @@ IETensor::IETensor(const element::Type& element_type, const Shape& shape_,
   }
 }
 
-IETensor::IETensor(const element::Type& element_type, const Shape& shape)
-    : IETensor(element_type, shape, nullptr) {}
-
-IETensor::IETensor(const element::Type& element_type, const PartialShape& shape)
-    : runtime::Tensor(
-          make_shared<descriptor::Tensor>(element_type, shape, "")) {
-  throw runtime_error("partial shapes not supported.");
+void IETensor::set_shape(const Shape& shape) {
+  if (m_blob != nullptr) {
+    if (shape == get_shape()) {
+      return;
+    }
+    m_blob->deallocate();
+  }
+  m_descriptor->set_tensor_type(get_element_type(), shape);
+  create_blob(nullptr);
 }
 
-IETensor::~IETensor() { m_blob->deallocate(); }
+IETensor::~IETensor() {
+  if (m_blob != nullptr) {
+    m_blob->deallocate();
+  }
+}
 
 void IETensor::write(const void* src, size_t bytes) {
   const int8_t* src_ptr = static_cast<const int8_t*>(src);
   if (src_ptr == nullptr) {
     return;
   }
+  if (m_blob == nullptr) {
+    THROW_IE_EXCEPTION << "Can't write to a tensor of dynamic shape";
+  }
 
   auto lm = m_blob->wmap();
   uint8_t* output_ptr = lm.as<uint8_t*>();
@@ -166,6 +192,9 @@ void IETensor::read(void* dst, size_t bytes) const {
   if (dst_ptr == nullptr) {
     return;
   }
+  if (m_blob == nullptr) {
+    THROW_IE_EXCEPTION << "Can't read from a tensor of dynamic shape";
+  }
 
   auto lm = m_blob->rmap();
   uint8_t* output_ptr = lm.as<uint8_t*>();
@@ -38,7 +38,13 @@ class IETensor : public ngraph::runtime::Tensor {
   const void* get_data_ptr() const;
   InferenceEngine::MemoryBlob::Ptr get_blob() { return m_blob; }
 
+  // A tensor made with a dynamic partial shape has no blob until it is given
+  // a static shape, which IE_Executable does for its outputs before a call.
+  // A tensor that has a blob already gets a new one if the shape changes.
+  void set_shape(const ngraph::Shape& shape);
+
  private:
+  void create_blob(void* memory_pointer);
   IETensor(const IETensor&) = delete;
   IETensor(IETensor&&) = delete;
   IETensor& operator=(const IETensor&) = delete;
@@ -15,6 +15,10 @@
  *******************************************************************************/
 
 #include "ngraph_bridge/ngraph_api.h"
+#include "ngraph_bridge/ngraph_layer_profiler.h"
+#include "ngraph_bridge/ngraph_metrics.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 
 namespace tensorflow {
 namespace ngraph_bridge {
@@ -66,6 +70,40 @@ extern void ngraph_set_disabled_ops(const char* op_type_list) {
 extern const char* ngraph_get_disabled_ops() {
   return ngraph::join(GetDisabledOps(), ",").c_str();
 }
+
+bool ngraph_get_metrics(char** metrics) {
+  *metrics = strdup(GetMetrics().c_str());
+  return true;
+}
+
+void ngraph_reset_metrics() { ResetMetrics(); }
+
+bool ngraph_dump_metrics(const char* path) {
+  return DumpMetrics(string(path)) == tensorflow::Status::OK();
+}
+
+void ngraph_enable_tracing() { EnableTracing(); }
+void ngraph_disable_tracing() { DisableTracing(); }
+
+bool ngraph_flush_trace(const char* path) {
+  return FlushTrace(string(path)) == tensorflow::Status::OK();
+}
+
+bool ngraph_get_layer_profile(char** report) {
+  *report = strdup(GetLayerProfile().c_str());
+  return true;
+}
+
+void ngraph_reset_layer_profile() { ResetLayerProfile(); }
+
+bool ngraph_get_rewrite_report(int graph_id, char** report) {
+  string json = GetRewriteReport(graph_id);
+  if (json.empty()) {
+    return false;
+  }
+  *report = strdup(json.c_str());
+  return true;
+}
 }
 
 // note that TensorFlow always uses camel case for the C++ API, but not for
@@ -113,6 +151,21 @@ void SetDisabledOps(set<string> disabled_ops_set) {
   disabled_op_types = disabled_ops_set;
 }
 
+string GetMetrics() { return MetricsRegistry::ToText(); }
+void ResetMetrics() { MetricsRegistry::Reset(); }
+Status DumpMetrics(const string& path) {
+  return MetricsRegistry::DumpToFile(path);
+}
+
+void EnableTracing() { Tracer::Enable(); }
+void DisableTracing() { Tracer::Disable(); }
+Status FlushTrace(const string& path) { return Tracer::Flush(path); }
+
+string GetLayerProfile() { return LayerProfiler::Report(); }
+void ResetLayerProfile() { LayerProfiler::Reset(); }
+
+string GetRewriteReport(int graph_id) { return RewriteReport::Get(graph_id); }
+
 }  // namespace config
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
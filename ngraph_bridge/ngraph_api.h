@@ -47,6 +47,19 @@ extern bool ngraph_is_logging_placement();
 
 extern void ngraph_set_disabled_ops(const char* op_type_list);
 extern const char* ngraph_get_disabled_ops();
+
+extern bool ngraph_get_metrics(char** metrics);
+extern void ngraph_reset_metrics();
+extern bool ngraph_dump_metrics(const char* path);
+
+extern void ngraph_enable_tracing();
+extern void ngraph_disable_tracing();
+extern bool ngraph_flush_trace(const char* path);
+
+extern bool ngraph_get_layer_profile(char** report);
+extern void ngraph_reset_layer_profile();
+
+extern bool ngraph_get_rewrite_report(int graph_id, char** report);
 }
 
 extern void Enable();
@@ -65,6 +78,25 @@ extern bool IsLoggingPlacement();
 extern std::set<string> GetDisabledOps();
 extern void SetDisabledOps(std::set<string>);
 extern void SetDisabledOps(string);
+
+// Metrics of all clusters, in the Prometheus text exposition format
+extern string GetMetrics();
+extern void ResetMetrics();
+extern tensorflow::Status DumpMetrics(const string& path);
+
+// Chrome trace of the bridge's rewrite passes, compilation and execution.
+// An empty path means NGRAPH_TF_TRACE_FILE (or ngtf_trace_<pid>.json).
+extern void EnableTracing();
+extern void DisableTracing();
+extern tensorflow::Status FlushTrace(const string& path);
+
+// Backend time per TF node, if NGRAPH_TF_LAYER_PROFILE is set
+extern string GetLayerProfile();
+extern void ResetLayerProfile();
+
+// Time and counts of every phase of the rewrite of graph_id, as JSON. -1
+// gives an array of the reports of all the graphs rewritten so far.
+extern string GetRewriteReport(int graph_id = -1);
 }  // namespace config
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
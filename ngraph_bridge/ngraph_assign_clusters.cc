@@ -31,6 +31,8 @@
 #include "ngraph_bridge/ngraph_assign_clusters.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/tf_deadness_analysis.h"
 #include "ngraph_bridge/tf_graphcycles.h"
@@ -292,6 +294,7 @@ void MergeClusters(Edge* edge,
 // Adds an attribute "_ngraph_cluster" (cluster_id) to each Node that can be
 // encapsulated
 Status AssignClusters(Graph* graph) {
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kAssignClusters);
   std::map<Node*, std::shared_ptr<Cluster>> cluster_map;
 
 #if !defined(NGRAPH_TF_DISABLE_DEADNESS_CHECK)
@@ -433,6 +436,7 @@ Status AssignClusters(Graph* graph) {
 
   do {
     changed = false;
+    RewriteReport::Count("contraction_iterations", 1);
 
     auto log_reason = [](EdgeNonContractionReasons reason, Edge* edge) {
       NGRAPH_VLOG(0) << "NONCONTRACTION: " << reason_string[reason] << ": "
@@ -512,6 +516,7 @@ Status AssignClusters(Graph* graph) {
       if (gc.HasEdge(src_index, dst_index) &&
           gc.ContractEdge(src_index, dst_index)) {
         MergeClusters(edge, cluster_map);
+        RewriteReport::Count("edges_contracted", 1);
         // something changed
         changed = true;
       } else {
@@ -598,7 +603,9 @@ Status AssignClusters(Graph* graph) {
       continue;
     }
 
-    size_t cluster_idx = NGraphClusterManager::NewCluster();
+    size_t cluster_idx;
+    TF_RETURN_IF_ERROR(NGraphClusterManager::NewCluster(cluster_idx));
+    RewriteReport::Count("clusters", 1);
 
     for (auto node : cluster->nodes) {
       if (NGRAPH_VLOG_IS_ON(5)) {
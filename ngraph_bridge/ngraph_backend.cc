@@ -68,6 +68,12 @@ std::shared_ptr<Executable> Backend::compile(
   return compile(func, enable_performance_data);
 }
 
+std::shared_ptr<Executable> Backend::compile_dynamic(
+    std::shared_ptr<Function> func, const StaticPasses& /* static_passes */,
+    bool enable_performance_data) {
+  return compile(func, enable_performance_data);
+}
+
 bool Backend::is_supported(const Node& /* node */) const {
   // The default behavior is that a backend does not support any ops. If this is
   // not the case
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -99,6 +100,14 @@ class Backend {
 
   /// \returns `true` if this backend supports dynamic tensors, else `false`.
   virtual bool supports_dynamic_tensors() { return false; }
+
+  /// \returns `true` if this backend compiles functions whose parameters
+  ///   have dimensions of unknown size (but known rank and element type),
+  ///   and resolves them when it is called. Backends that support dynamic
+  ///   tensors do this too.
+  virtual bool supports_dynamic_dimensions() {
+    return supports_dynamic_tensors();
+  }
   /// \brief Compiles a Function.
   /// \param func The function to compile
   /// \returns compiled function or nullptr on failure
@@ -114,6 +123,20 @@ class Backend {
                                          ngraph::pass::PassConfig& pass_config,
                                          bool enable_performance_data = false);
 
+  /// \brief Passes run on the static functions a backend makes of a
+  ///   function with dimensions of unknown size
+  using StaticPasses = std::function<void(shared_ptr<ngraph::Function>)>;
+
+  /// \brief Compiles a Function with dimensions of unknown size.
+  /// \param func The function to compile
+  /// \param static_passes Run on each static clone of func the backend makes
+  ///   for the input shapes it is called with, e.g. the passes that need
+  ///   static shapes and were skipped on func
+  /// \returns compiled function or nullptr on failure
+  virtual shared_ptr<Executable> compile_dynamic(
+      shared_ptr<ngraph::Function> func, const StaticPasses& static_passes,
+      bool enable_performance_data = false);
+
   /// \brief Loads a previously saved Executable object from a stream.
   /// \param input_stream the opened input stream containing the saved
   /// Executable
@@ -114,6 +114,15 @@ void BackendManager::SetConfig(const map<string, string>& config) {
   }
 }
 
+bool BackendManager::SupportsDynamicDimensions() {
+  auto backend = GetBackend();
+#if !defined(ENABLE_OPENVINO)
+  return backend->supports_dynamic_tensors();
+#else
+  return backend->supports_dynamic_dimensions();
+#endif
+}
+
 // Returns the nGraph supported backend names
 vector<string> BackendManager::GetSupportedBackends() {
 #if !defined(ENABLE_OPENVINO)
@@ -53,6 +53,10 @@ class BackendManager {
 
   static void SetConfig(const map<string, string>& config);
 
+  // Whether the currently set backend compiles functions with input
+  // dimensions of unknown size, see NGRAPH_TF_DYNAMIC_DIMS
+  static bool SupportsDynamicDimensions();
+
   ~BackendManager();
 
  private:
@@ -21,9 +21,9 @@
 #include "tensorflow/core/lib/core/errors.h"
 
 #include "ngraph/builder/autobroadcast.hpp"
+#include "ngraph/graph_util.hpp"
 #include "ngraph/op/experimental/layers/interpolate.hpp"
 #include "ngraph/op/util/logical_reduction.hpp"
-#include "ngraph/pass/constant_folding.hpp"
 #include "ngraph/pass/manager.hpp"
 #include "ngraph/pass/pass_config.hpp"
 #include "ngraph/slice_plan.hpp"
@@ -32,9 +32,16 @@
 #include "ngraph_bridge/default_opset.h"
 #include "ngraph_bridge/ngraph_api.h"
 #include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_control_flow.h"
 #include "ngraph_bridge/ngraph_conversions.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
+#include "ngraph_bridge/pass/common_subexpression_elimination.h"
+#include "ngraph_bridge/pass/constant_deduplication.h"
+#include "ngraph_bridge/pass/fusions.h"
+#include "ngraph_bridge/pass/guarded_constant_folding.h"
+#include "ngraph_bridge/pass/layout_assignment.h"
 #include "ngraph_bridge/pass/transpose_folding.h"
 #include "ngraph_bridge/pass/transpose_sinking.h"
 
@@ -67,26 +74,42 @@ static Status ValidateInputCountMin(const Node* op, tensorflow::int32 count) {
   }
   return Status::OK();
 }
+Builder::OpMap::OpMap(const Graph& graph)
+    : m_flib(&graph.flib_def()),
+      m_outputs(graph.num_node_ids()),
+      m_input_edges(graph.num_node_ids()) {
+  for (const Edge* edge : graph.edges()) {
+    if (edge->IsControlEdge()) {
+      continue;
+    }
+    auto& edges = m_input_edges[edge->dst()->id()];
+    if (edges.empty()) {
+      edges.resize(edge->dst()->num_inputs(), nullptr);
+    }
+    if (edge->dst_input() < (int)edges.size()) {
+      edges[edge->dst_input()] = edge;
+    }
+  }
+}
+
 //
 // Helper for storing ops in ng_op_map.
 // For most of the cases, op would have one output so
-// vector ng_op_map[op_name] would contain one element.
+// vector ng_op_map.Outputs(op) would contain one element.
 //
 // If storing more than one output_nodes, make sure it's in
 // the same order as tensorflow would do that.
 //
 // Parameters:
 //    Builder::OpMap& ng_op_map        - The TF-to-nGraph op map.
-//    std::string op_name              - Name of the op.
+//    const Node* op                   - The TF op.
 //
 //    ng::Output<ng::Node> output_node - ng::Node to store
 //
 
-static void SaveNgOp(Builder::OpMap& ng_op_map, const std::string& op_name,
+static void SaveNgOp(Builder::OpMap& ng_op_map, const Node* op,
                      ng::Output<ng::Node> output_node) {
-  // no need to try-catch, map[key] will create vector object
-  // if not exists
-  ng_op_map[op_name].push_back(output_node);
+  ng_op_map.Outputs(op).push_back(output_node);
 }
 
 void Builder::SetTracingInfo(const std::string& op_name,
@@ -145,30 +168,22 @@ static Status GetInputNode(const Builder::OpMap& ng_op_map, const Node* op,
                            size_t input_idx, ng::Output<ng::Node>& result) {
   // input op may have resulted in more than one ng::Node (eg. Split)
   // we need to look at Edge to check index of the input op
-  std::vector<const Edge*> edges;
-  TF_RETURN_IF_ERROR(op->input_edges(&edges));
-  size_t src_output_idx;
-  try {
-    src_output_idx = edges.at(input_idx)->src_output();
-  } catch (const out_of_range&) {
+  const Edge* edge = ng_op_map.InputEdge(op, input_idx);
+  if (edge == nullptr) {
     return Status(error::NOT_FOUND, "Edge not found");
   }
+  size_t src_output_idx = edge->src_output();
 
-  Node* tf_input;
-  TF_RETURN_IF_ERROR(op->input_node(input_idx, &tf_input));
-  std::vector<ng::Output<ng::Node>> ng_op;
-  try {
-    ng_op = ng_op_map.at(tf_input->name());
-  } catch (const out_of_range&) {
+  const auto& ng_op = ng_op_map.Outputs(edge->src());
+  if (ng_op.empty()) {
     return Status(error::NOT_FOUND,
-                  string("Ngraph op not found for ") + tf_input->name());
+                  string("Ngraph op not found for ") + edge->src()->name());
   }
-  try {
-    result = ng_op.at(src_output_idx);
-  } catch (const out_of_range&) {
+  if (src_output_idx >= ng_op.size()) {
     return Status(error::NOT_FOUND, string("Input node not found at index ") +
                                         to_string(src_output_idx));
   }
+  result = ng_op[src_output_idx];
   return Status::OK();
 }
 
@@ -299,6 +314,29 @@ static Status GetStaticInputVector(
   return Status::OK();
 }
 
+// Returns true if the value of the input_index-th input of op is known at
+// translation time, i.e. it comes from a Const or from an _Arg in the static
+// input map. Inputs that MarkForClustering left parametric (see
+// BackendAcceptsParametricInputs) are only known at run time, and have to be
+// translated into nGraph ops that take them as an input.
+static bool InputIsKnown(const Node* op, int input_index,
+                         const std::vector<const Tensor*>& static_input_map) {
+  Node* input_node;
+  if (op->input_node(input_index, &input_node) != Status::OK()) {
+    return false;
+  }
+  if (input_node->type_string() == "Const") {
+    return true;
+  }
+  int arg_index;
+  if (!input_node->IsArg() ||
+      GetNodeAttr(input_node->attrs(), "index", &arg_index) != Status::OK()) {
+    return false;
+  }
+  return arg_index < static_input_map.size() &&
+         static_input_map[arg_index] != nullptr;
+}
+
 // Helper for Builder::TranslateGraph ("Const" op)
 template <typename T, typename VecT = T>
 static Status MakeConstOp(const Node* op, ng::element::Type et,
@@ -370,7 +408,7 @@ static Status TranslateUnaryOp(
   if (ng_node != ng_input) {
     Builder::SetTracingInfo(op->name(), ng_node);
   }
-  SaveNgOp(ng_op_map, op->name(), ng_node);
+  SaveNgOp(ng_op_map, op, ng_node);
   return Status::OK();
 }
 
@@ -431,7 +469,7 @@ static Status TranslateBinaryOp(
   if (ng_node != ng_lhs && ng_node != ng_rhs) {
     Builder::SetTracingInfo(op->name(), ng_node);
   }
-  SaveNgOp(ng_op_map, op->name(), ng_node);
+  SaveNgOp(ng_op_map, op, ng_node);
   return Status::OK();
 }
 
@@ -471,7 +509,7 @@ static Status TranslateAddNOp(const Node* op, const std::vector<const Tensor*>&,
       });  // accumulation: start with
            // first element. default op is
            // addition
-  SaveNgOp(ng_op_map, op->name(), ng_addn);
+  SaveNgOp(ng_op_map, op, ng_addn);
   return Status::OK();
 }
 static Status TranslateArgMinMax(
@@ -519,7 +557,7 @@ static Status TranslateArgMinMax(
   auto reshaped_indices =
       ConstructNgNode<opset::Squeeze>(op->name(), ng_indices, axis_to_remove);
   Builder::SetTracingInfo(op->name(), reshaped_indices);
-  SaveNgOp(ng_op_map, op->name(), reshaped_indices);
+  SaveNgOp(ng_op_map, op, reshaped_indices);
   return Status::OK();
 }
 
@@ -595,7 +633,7 @@ static Status TranslateAvgPoolOp(const Node* op,
   NGRAPH_VLOG(3) << "avgpool outshape: {" << ng::join(ng_avgpool.get_shape())
                  << "}";
 
-  SaveNgOp(ng_op_map, op->name(), ng_avgpool);
+  SaveNgOp(ng_op_map, op, ng_avgpool);
   return Status::OK();
 }
 
@@ -645,7 +683,7 @@ static Status TranslateBiasAddOp(
   ng::Output<ng::Node> ng_add =
       ConstructNgNode<opset::Add>(op->name(), ng_input, ng_bias_reshaped);
 
-  SaveNgOp(ng_op_map, op->name(), ng_add);
+  SaveNgOp(ng_op_map, op, ng_add);
   return Status::OK();
 }
 
@@ -661,7 +699,7 @@ static Status TranslateCastOp(const Node* op, const std::vector<const Tensor*>&,
   TF_RETURN_IF_ERROR(TFDataTypeToNGraphElementType(dtype, &ng_et));
 
   try {
-    SaveNgOp(ng_op_map, op->name(),
+    SaveNgOp(ng_op_map, op,
              ConstructNgNode<opset::Convert>(op->name(), ng_input, ng_et));
   } catch (const std::out_of_range&) {
     return errors::Unimplemented("Failed to convert TF data type: ",
@@ -685,7 +723,12 @@ static Status TranslateConcatV2Op(
     ng::Output<ng::Node> ng_first_arg;
     TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, op, 0, ng_first_arg));
 
-    concat_axis += int64(ng_first_arg.get_shape().size());
+    const auto& rank = ng_first_arg.get_partial_shape().rank();
+    if (rank.is_dynamic()) {
+      return errors::Unimplemented("Negative axis of ", op->name(),
+                                   " for an input of unknown rank");
+    }
+    concat_axis += rank.get_length();
   }
 
   ng::OutputVector ng_args;
@@ -696,9 +739,9 @@ static Status TranslateConcatV2Op(
     ng_args.push_back(ng_arg);
   }
 
-  SaveNgOp(
-      ng_op_map, op->name(),
-      ConstructNgNode<opset::Concat>(op->name(), ng_args, size_t(concat_axis)));
+  SaveNgOp(ng_op_map, op,
+           ConstructNgNode<opset::Concat>(op->name(), ng_args,
+                                          size_t(concat_axis)));
   return Status::OK();
 }
 
@@ -728,7 +771,7 @@ static Status TranslateConstOp(const Node* op,
                                  DataType_Name(dtype));
   }
 
-  SaveNgOp(ng_op_map, op->name(), ng_node);
+  SaveNgOp(ng_op_map, op, ng_node);
   return Status::OK();
 }
 
@@ -806,7 +849,7 @@ static Status TranslateConv2DOp(const Node* op,
       ng_padding_above, ng_dilations, ng_pad_type);
 
   BatchToTensorflow(op->name(), is_nhwc, ng_conv);
-  SaveNgOp(ng_op_map, op->name(), ng_conv);
+  SaveNgOp(ng_op_map, op, ng_conv);
   return Status::OK();
 }
 
@@ -905,7 +948,7 @@ static Status TranslateConv2DBackpropInputOp(
       ng_padding_below, ng_padding_above, ng_dilations, ng_pad_type);
 
   BatchToTensorflow(op->name(), is_nhwc, ng_data);
-  SaveNgOp(ng_op_map, op->name(), ng_data);
+  SaveNgOp(ng_op_map, op, ng_data);
   return Status::OK();
 }
 
@@ -986,7 +1029,7 @@ static Status TranslateConv3DOp(const Node* op,
       ng_padding_above, ng_dilations, ng_pad_type);
 
   BatchToTensorflow3D(op->name(), is_ndhwc, ng_conv);
-  SaveNgOp(ng_op_map, op->name(), ng_conv);
+  SaveNgOp(ng_op_map, op, ng_conv);
   return Status::OK();
 }
 
@@ -999,7 +1042,7 @@ static Status TranslateCumsumOp(const Node* op,
   TF_RETURN_IF_ERROR(GetNodeAttr(op->attrs(), "exclusive", &exclusive));
   TF_RETURN_IF_ERROR(GetNodeAttr(op->attrs(), "reverse", &reverse));
 
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::CumSum>(op->name(), ng_x, ng_axis, exclusive,
                                           reverse));
   return Status::OK();
@@ -1030,7 +1073,7 @@ static Status TranslateDepthToSpaceOp(const Node* op,
   ng::Output<ng::Node> depth_to_space = ConstructNgNode<opset::DepthToSpace>(
       op->name(), ng_input, ng_mode, block_size);
   BatchToTensorflow(op->name(), is_nhwc, depth_to_space);
-  SaveNgOp(ng_op_map, op->name(), depth_to_space);
+  SaveNgOp(ng_op_map, op, depth_to_space);
   return Status::OK();
 }
 
@@ -1143,7 +1186,7 @@ static Status TranslateDepthwiseConv2dNativeOp(
                                                   ng_concatenation_axis);
 
   BatchToTensorflow(op->name(), is_nhwc, ng_concat);
-  SaveNgOp(ng_op_map, op->name(), ng_concat);
+  SaveNgOp(ng_op_map, op, ng_concat);
   return Status::OK();
 }
 
@@ -1176,7 +1219,7 @@ static Status TranslateExpandDimsOp(
   ng::Output<ng::Node> ng_expand_dim =
       ConstructNgNode<opset::Reshape>(op->name(), ng_input, ng_shape, false);
 
-  SaveNgOp(ng_op_map, op->name(), ng_expand_dim);
+  SaveNgOp(ng_op_map, op, ng_expand_dim);
   return Status::OK();
 }
 
@@ -1192,8 +1235,9 @@ static Status TranslateFillOp(
   auto ng_output_shape = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::i64, ng::Shape{dims_vec.size()}, dims_vec);
 
-  SaveNgOp(ng_op_map, op->name(), ConstructNgNode<opset::Broadcast>(
-                                      op->name(), ng_value, ng_output_shape));
+  SaveNgOp(ng_op_map, op,
+           ConstructNgNode<opset::Broadcast>(op->name(), ng_value,
+                                             ng_output_shape));
   return Status::OK();
 }
 
@@ -1275,14 +1319,14 @@ static Status TranslateFusedBatchNormOp(
       op->name(), ng_input, ng_scale, ng_offset, ng_mean, ng_variance,
       tf_epsilon);
   BatchToTensorflow(op->name(), is_nhwc, ng_batch_norm);
-  SaveNgOp(ng_op_map, op->name(), ng_batch_norm);
-  SaveNgOp(ng_op_map, op->name(), ng_mean);
-  SaveNgOp(ng_op_map, op->name(), ng_variance);
-  SaveNgOp(ng_op_map, op->name(), ng_mean);      // reserve_space_1
-  SaveNgOp(ng_op_map, op->name(), ng_variance);  // reserve_space_2
+  SaveNgOp(ng_op_map, op, ng_batch_norm);
+  SaveNgOp(ng_op_map, op, ng_mean);
+  SaveNgOp(ng_op_map, op, ng_variance);
+  SaveNgOp(ng_op_map, op, ng_mean);      // reserve_space_1
+  SaveNgOp(ng_op_map, op, ng_variance);  // reserve_space_2
   if (is_v3) {
     // FusedBatchNormV3 has 6 outputs
-    SaveNgOp(ng_op_map, op->name(), ng_mean);  // reserve_space_3
+    SaveNgOp(ng_op_map, op, ng_mean);  // reserve_space_3
   }
   return Status::OK();
 }
@@ -1318,13 +1362,12 @@ static Status TranslateFusedMatMulOp(const Node* op,
 
   auto ng_add = ConstructNgNode<opset::Add>(op->name(), ng_matmul, ng_bias);
   if (fused_ops.size() == 1) {  // Only fusing BiasAdd
-    SaveNgOp(ng_op_map, op->name(), ng_add);
+    SaveNgOp(ng_op_map, op, ng_add);
   } else if (fused_ops.size() == 2) {  // Also has activation
     if (fused_ops[1] == "Relu") {
-      SaveNgOp(ng_op_map, op->name(),
-               ConstructNgNode<opset::Relu>(op->name(), ng_add));
+      SaveNgOp(ng_op_map, op, ConstructNgNode<opset::Relu>(op->name(), ng_add));
     } else if (fused_ops[1] == "Relu6") {
-      SaveNgOp(ng_op_map, op->name(),
+      SaveNgOp(ng_op_map, op,
                ConstructNgNode<opset::Clamp>(op->name(), ng_add, 0, 6));
     } else {
       return errors::Internal(
@@ -1375,7 +1418,7 @@ static Status TranslateGatherV2Op(
   auto gather_op = ConstructNgNode<opset::Gather>(op->name(), ng_input,
                                                   ng_input_coords, ng_axis);
 
-  SaveNgOp(ng_op_map, op->name(), gather_op);
+  SaveNgOp(ng_op_map, op, gather_op);
   return Status::OK();
 }
 
@@ -1497,15 +1540,15 @@ static Status TranslateFusedConv2DOp(const Node* op,
       auto ng_relu = ConstructNgNode<opset::Relu>(
           op->name() + "_FusedConv2D_Relu", ng_add);
       BatchToTensorflow(op->name(), is_nhwc, ng_relu);
-      SaveNgOp(ng_op_map, op->name(), ng_relu);
+      SaveNgOp(ng_op_map, op, ng_relu);
     } else if (VecStrCmp(fused_ops, {"BiasAdd", "Relu6"})) {
       auto ng_relu6 = ConstructNgNode<opset::Clamp>(
           op->name() + "_FusedConv2D_Relu6", ng_add, 0, 6);
       BatchToTensorflow(op->name(), is_nhwc, ng_relu6);
-      SaveNgOp(ng_op_map, op->name(), ng_relu6);
+      SaveNgOp(ng_op_map, op, ng_relu6);
     } else {
       BatchToTensorflow(op->name(), is_nhwc, ng_add);
-      SaveNgOp(ng_op_map, op->name(), ng_add);
+      SaveNgOp(ng_op_map, op, ng_add);
     }
   } else if (VecStrCmp(fused_ops, {"FusedBatchNorm"}) ||
              VecStrCmp(fused_ops, {"FusedBatchNorm", "Relu"}) ||
@@ -1533,15 +1576,15 @@ static Status TranslateFusedConv2DOp(const Node* op,
       auto ng_relu = ConstructNgNode<opset::Relu>(
           op->name() + "_FusedConv2D_BatchNormRelu", ng_batch_norm);
       BatchToTensorflow(op->name(), is_nhwc, ng_relu);
-      SaveNgOp(ng_op_map, op->name(), ng_relu);
+      SaveNgOp(ng_op_map, op, ng_relu);
     } else if (VecStrCmp(fused_ops, {"FusedBatchNorm", "Relu6"})) {
       auto ng_relu6 = ConstructNgNode<opset::Clamp>(
           op->name() + "_FusedConv2D_BatchNormRelu", ng_batch_norm, 0, 6);
       BatchToTensorflow(op->name(), is_nhwc, ng_relu6);
-      SaveNgOp(ng_op_map, op->name(), ng_relu6);
+      SaveNgOp(ng_op_map, op, ng_relu6);
     } else {
       BatchToTensorflow(op->name(), is_nhwc, ng_batch_norm);
-      SaveNgOp(ng_op_map, op->name(), ng_batch_norm);
+      SaveNgOp(ng_op_map, op, ng_batch_norm);
     }
   } else {
     return errors::Unimplemented("Unsupported _FusedConv2D " +
@@ -1555,7 +1598,115 @@ static Status TranslateIdentityOp(const Node* op,
                                   Builder::OpMap& ng_op_map) {
   ng::Output<ng::Node> ng_arg;
   TF_RETURN_IF_ERROR(GetInputNodes(ng_op_map, op, ng_arg));
-  SaveNgOp(ng_op_map, op->name(), ng_arg);
+  SaveNgOp(ng_op_map, op, ng_arg);
+  return Status::OK();
+}
+
+// Translates the function body_graph for arguments like ng_args, into a
+// function with a Parameter for every argument
+static Status TranslateFunction(
+    const Graph* body_graph, const std::vector<ng::Output<ng::Node>>& ng_args,
+    shared_ptr<ng::Function>& ng_function) {
+  std::vector<PartialTensorShape> arg_shapes;
+  for (const auto& ng_arg : ng_args) {
+    const ng::PartialShape& ng_shape = ng_arg.get_partial_shape();
+    if (ng_shape.rank().is_dynamic()) {
+      arg_shapes.emplace_back();
+      continue;
+    }
+    std::vector<int64> dims;
+    for (const auto& dim : ng_shape) {
+      dims.push_back(dim.is_dynamic() ? -1 : dim.get_length());
+    }
+    arg_shapes.emplace_back(dims);
+  }
+  std::vector<const Tensor*> static_input_map(ng_args.size(), nullptr);
+  TF_RETURN_IF_ERROR(Builder::TranslateGraphTemplate(
+      arg_shapes, static_input_map, body_graph, ng_function));
+
+  auto ng_params = ng_function->get_parameters();
+  if (ng_params.size() != ng_args.size()) {
+    return errors::InvalidArgument("Function has ", ng_params.size(),
+                                   " arguments, got ", ng_args.size());
+  }
+  for (size_t i = 0; i < ng_args.size(); i++) {
+    if (ng_params[i]->get_element_type() != ng_args[i].get_element_type()) {
+      return errors::InvalidArgument("Argument ", i, " of function is of type ",
+                                     ng_params[i]->get_element_type(),
+                                     ", got ", ng_args[i].get_element_type());
+    }
+  }
+  return Status::OK();
+}
+
+// Translates func of the graph's library with its ops connected to ng_args
+// directly, and sets ng_outputs to what it returns
+static Status InlineFunction(const Builder::OpMap& ng_op_map,
+                             const NameAttrList& func,
+                             const std::vector<ng::Output<ng::Node>>& ng_args,
+                             std::vector<ng::Output<ng::Node>>& ng_outputs) {
+  std::unique_ptr<FunctionBody> fbody;
+  TF_RETURN_IF_ERROR(
+      GetFunctionBody(ng_op_map.FunctionLibrary(), func, &fbody));
+  shared_ptr<ng::Function> ng_function;
+  TF_RETURN_IF_ERROR(TranslateFunction(fbody->graph, ng_args, ng_function));
+
+  auto ng_params = ng_function->get_parameters();
+  for (size_t i = 0; i < ng_params.size(); i++) {
+    for (auto input : ng_params[i]->output(0).get_target_inputs()) {
+      input.replace_source_output(ng_args[i]);
+    }
+  }
+  ng_outputs.clear();
+  for (const auto& ng_result : ng_function->get_results()) {
+    ng_outputs.push_back(ng_result->input_value(0));
+  }
+  return Status::OK();
+}
+
+// Both branches are computed, and the predicate selects the outputs of one.
+// Branches are functions without side effects, so the one not taken only
+// costs time.
+static Status TranslateIfOp(const Node* op, const std::vector<const Tensor*>&,
+                            Builder::OpMap& ng_op_map) {
+  ng::Output<ng::Node> ng_cond;
+  TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, op, 0, ng_cond));
+  std::vector<ng::Output<ng::Node>> ng_args(op->num_inputs() - 1);
+  for (size_t i = 0; i < ng_args.size(); i++) {
+    TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, op, i + 1, ng_args[i]));
+  }
+
+  const auto& cond_rank = ng_cond.get_partial_shape().rank();
+  if (cond_rank.is_dynamic() || cond_rank.get_length() != 0) {
+    return errors::Unimplemented("Predicate of ", op->name(),
+                                 " is not a scalar");
+  }
+  if (ng_cond.get_element_type() != ng::element::boolean) {
+    auto ng_zero = ConstructNgNode<opset::Constant>(
+        op->name(), ng_cond.get_element_type(), ng::Shape{},
+        std::vector<std::string>{"0"});
+    ng_cond = ConstructNgNode<opset::NotEqual>(op->name(), ng_cond, ng_zero);
+  }
+
+  std::vector<NameAttrList> branches;
+  TF_RETURN_IF_ERROR(GetCalledFunctions(op, &branches));
+  std::vector<ng::Output<ng::Node>> ng_then, ng_else;
+  TF_RETURN_IF_ERROR(InlineFunction(ng_op_map, branches[0], ng_args, ng_then));
+  TF_RETURN_IF_ERROR(InlineFunction(ng_op_map, branches[1], ng_args, ng_else));
+  if (ng_then.size() != ng_else.size()) {
+    return errors::InvalidArgument("Branches of ", op->name(),
+                                   " return different numbers of values");
+  }
+  for (size_t i = 0; i < ng_then.size(); i++) {
+    if (!ng_then[i].get_partial_shape().same_scheme(
+            ng_else[i].get_partial_shape())) {
+      return errors::Unimplemented("Branches of ", op->name(),
+                                   " return output ", i,
+                                   " in different shapes");
+    }
+    SaveNgOp(ng_op_map, op, ConstructNgNode<opset::Select>(
+                                op->name(), ng_cond, ng_then[i], ng_else[i]));
+  }
   return Status::OK();
 }
 
@@ -1587,7 +1738,7 @@ static Status TranslateIsFiniteOp(
   auto is_finite = ConstructNgNode<opset::LogicalAnd>(
       op->name(), neq_inf_and_neq_neg_inf, eq_nan);
 
-  SaveNgOp(ng_op_map, op->name(), is_finite);
+  SaveNgOp(ng_op_map, op, is_finite);
   return Status::OK();
 }
 
@@ -1616,7 +1767,7 @@ static Status TranslateL2LossOp(const Node* op,
   auto ng_sum =
       ConstructNgNode<opset::ReduceSum>(op->name(), ng_pow, ng_reduction_axes);
   auto ng_l2loss = ConstructNgNode<opset::Divide>(op->name(), ng_sum, const_2);
-  SaveNgOp(ng_op_map, op->name(), ng_l2loss);
+  SaveNgOp(ng_op_map, op, ng_l2loss);
   return Status::OK();
 }
 
@@ -1660,7 +1811,7 @@ static Status TranslateLogSoftmaxOp(const Node* op,
       ConstructNgNode<opset::ReduceSum>(op->name(), ng_exp, ng_axis, true));
   auto ng_output = ConstructNgNode<opset::Subtract>(
       op->name(), ng_inp_minus_max, ng_log_sum);
-  SaveNgOp(ng_op_map, op->name(), ng_output);
+  SaveNgOp(ng_op_map, op, ng_output);
   return Status::OK();
 }
 
@@ -1675,7 +1826,7 @@ static Status TranslateSoftplusOp(const Node* op,
       std::vector<std::string>(ng::shape_size(ng_inp.get_shape()), "1"));
   auto ng_output = ConstructNgNode<opset::Log>(
       op->name(), ConstructNgNode<opset::Add>(op->name(), ng_exp, constant_1));
-  SaveNgOp(ng_op_map, op->name(), ng_output);
+  SaveNgOp(ng_op_map, op, ng_output);
   return Status::OK();
 }
 
@@ -1692,7 +1843,7 @@ static Status TranslateMatMulOp(const Node* op,
   bool transpose_b = false;
   TF_RETURN_IF_ERROR(GetNodeAttr(op->attrs(), "transpose_b", &transpose_b));
 
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::MatMul>(op->name(), ng_lhs, ng_rhs,
                                           transpose_a, transpose_b));
   return Status::OK();
@@ -1761,7 +1912,7 @@ static Status TranslateMaxPoolOp(const Node* op,
   NGRAPH_VLOG(3) << "maxpool outshape: {" << ng::join(ng_maxpool.get_shape())
                  << "}";
 
-  SaveNgOp(ng_op_map, op->name(), ng_maxpool);
+  SaveNgOp(ng_op_map, op, ng_maxpool);
   return Status::OK();
 }
 
@@ -1828,7 +1979,7 @@ static Status TranslateMaxPool3DOp(const Node* op,
   NGRAPH_VLOG(3) << "maxpool outshape: {" << ng::join(ng_maxpool.get_shape())
                  << "}";
 
-  SaveNgOp(ng_op_map, op->name(), ng_maxpool);
+  SaveNgOp(ng_op_map, op, ng_maxpool);
   return Status::OK();
 }
 
@@ -1888,8 +2039,8 @@ static Status TranslateNonMaxSuppressionV4Op(
   Builder::SetTracingInfo(op->name(), ng_nmsv4);
   auto ng_selected_indices = ng_nmsv4.get_node_shared_ptr()->output(0);
   auto ng_valid_output = ng_nmsv4.get_node_shared_ptr()->output(1);
-  SaveNgOp(ng_op_map, op->name(), ng_selected_indices);
-  SaveNgOp(ng_op_map, op->name(), ng_valid_output);
+  SaveNgOp(ng_op_map, op, ng_selected_indices);
+  SaveNgOp(ng_op_map, op, ng_valid_output);
   return Status::OK();
 }
 
@@ -1926,7 +2077,7 @@ static Status TranslateReduceOp(
       create_ng_node(ng_input, ng_reduction_axes, tf_keep_dims);
   Builder::SetTracingInfo(op->name(), ng_node);
 
-  SaveNgOp(ng_op_map, op->name(), ng_node);
+  SaveNgOp(ng_op_map, op, ng_node);
   return Status::OK();
 }
 
@@ -1975,7 +2126,7 @@ static Status TranslateOneHotOp(
 
   auto ng_onehot = ConstructNgNode<opset::OneHot>(
       op->name(), ng_features, const_depth, ng_on, ng_off, one_hot_axis);
-  SaveNgOp(ng_op_map, op->name(), ng_onehot);
+  SaveNgOp(ng_op_map, op, ng_onehot);
   return Status::OK();
 }
 
@@ -1992,49 +2143,52 @@ static Status TranslatePackOp(const Node* op, const std::vector<const Tensor*>&,
 
   int32 tf_axis;
   TF_RETURN_IF_ERROR(GetNodeAttr(op->attrs(), "axis", &tf_axis));
-  size_t input_rank = ng_concat_inputs[0].get_shape().size();
-
-  auto concat_axis = tf_axis;
-  if (concat_axis == -1) {
-    concat_axis = input_rank;
-  }
-
-  ng::Shape input_shape = ng_concat_inputs[0].get_shape();
-  ng::Shape output_shape(input_rank + 1);
-
-  // if inputs shape is (2, 3, 4), and axis is 1, then we want
-  // to create output_shape (2, num_inputs, 3, 4)
-  for (size_t i = 0; i < input_rank; ++i) {
-    output_shape[((int)i < concat_axis) ? i : i + 1] = input_shape[i];
+  int64 input_rank = ng_concat_inputs[0].get_shape().size();
+  if (tf_axis < -input_rank - 1 || tf_axis > input_rank) {
+    return errors::InvalidArgument("Pack axis ", tf_axis,
+                                   " is out of range for inputs of rank ",
+                                   input_rank);
+  }
+  int64 concat_axis = tf_axis < 0 ? tf_axis + input_rank + 1 : tf_axis;
+
+  if (ng_concat_inputs.size() == 1) {
+    auto ng_axis = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{1},
+        std::vector<int64>{concat_axis});
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::Unsqueeze>(op->name(), ng_concat_inputs[0],
+                                               ng_axis));
+    return Status::OK();
   }
-  output_shape[concat_axis] = op->num_inputs();
 
-  ng::AxisVector ng_axis_order(input_rank);
-  std::iota(ng_axis_order.begin(), ng_axis_order.end(), 0);
-
-  if ((size_t)concat_axis == input_rank) {
-    // need to add extra dimension before we concatenate
-    // along it
-    ng::Shape extended_shape = input_shape;
-    extended_shape.push_back(1);
-    auto ng_shape = ConstructNgNode<opset::Constant>(
-        op->name(), ng::element::u64, ng::Shape{extended_shape.size()},
-        extended_shape);
-
-    for (size_t i = 0; i < ng_concat_inputs.size(); ++i) {
-      ng_concat_inputs[i] = ConstructNgNode<opset::Reshape>(
-          op->name(), ng_concat_inputs[i], ng_shape, false);
+  if (concat_axis == input_rank) {
+    // the inputs need a new last dimension to be concatenated along
+    auto ng_axis = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{1},
+        std::vector<int64>{concat_axis});
+    for (auto& ng_input : ng_concat_inputs) {
+      ng_input =
+          ConstructNgNode<opset::Unsqueeze>(op->name(), ng_input, ng_axis);
     }
-    ng_axis_order.push_back(input_rank);
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::Concat>(op->name(), ng_concat_inputs,
+                                            concat_axis));
+    return Status::OK();
   }
 
+  // Otherwise concatenating along the axis lays the data out the same way,
+  // so one Reshape of the result does for all inputs: if inputs shape is
+  // (2, 3, 4), and axis is 1, the (2, num_inputs * 3, 4) of the Concat
+  // becomes (2, num_inputs, 3, 4)
+  ng::Shape output_shape = ng_concat_inputs[0].get_shape();
+  output_shape.insert(output_shape.begin() + concat_axis,
+                      ng_concat_inputs.size());
   auto concat = ConstructNgNode<opset::Concat>(op->name(), ng_concat_inputs,
-                                               (size_t)concat_axis);
-
+                                               concat_axis);
   auto ng_output_shape = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::u64, ng::Shape{output_shape.size()},
       output_shape);
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::Reshape>(op->name(), concat, ng_output_shape,
                                            false));
   return Status::OK();
@@ -2079,31 +2233,55 @@ static Status TranslatePadOp(const Node* op,
   }
 
   // Set pads_begin & pads_end (from the pad_val_op)
-  std::vector<int64> paddings;
-  TF_RETURN_IF_ERROR(GetStaticInputVector(op, 1, static_input_map, &paddings));
-  NGRAPH_VLOG(3) << op->name() << " pads {" << ng::join(paddings) << "}";
-  if (paddings.size() % 2 != 0) {
-    return errors::InvalidArgument(
-        "Constant node for paddings does not have an even number of "
-        "elements");
-  }
-  std::vector<int64> pad_begin(paddings.size() / 2);
-  std::vector<int64> pad_end(paddings.size() / 2);
-  for (size_t i = 0; i < paddings.size() / 2; i++) {
-    pad_begin[i] = paddings[2 * i];
-    pad_end[i] = paddings[2 * i + 1];
+  ng::Output<ng::Node> pads_begin_node, pads_end_node;
+  if (InputIsKnown(op, 1, static_input_map)) {
+    std::vector<int64> paddings;
+    TF_RETURN_IF_ERROR(
+        GetStaticInputVector(op, 1, static_input_map, &paddings));
+    NGRAPH_VLOG(3) << op->name() << " pads {" << ng::join(paddings) << "}";
+    if (paddings.size() % 2 != 0) {
+      return errors::InvalidArgument(
+          "Constant node for paddings does not have an even number of "
+          "elements");
+    }
+    std::vector<int64> pad_begin(paddings.size() / 2);
+    std::vector<int64> pad_end(paddings.size() / 2);
+    for (size_t i = 0; i < paddings.size() / 2; i++) {
+      pad_begin[i] = paddings[2 * i];
+      pad_end[i] = paddings[2 * i + 1];
+    }
+    pads_begin_node = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{pad_begin.size()}, pad_begin);
+    pads_end_node = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{pad_end.size()}, pad_end);
+  } else {
+    // The paddings are a [rank, 2] tensor fed at run time; split it into its
+    // two columns.
+    const auto& paddings_shape = ng_paddings_op.get_partial_shape();
+    if (!paddings_shape.compatible(ng::PartialShape{ng::Dimension(), 2})) {
+      return errors::InvalidArgument("Paddings must be of shape [rank, 2], ",
+                                     "got ", paddings_shape);
+    }
+    auto ng_paddings = ConstructNgNode<opset::Convert>(
+        op->name(), ng_paddings_op, ng::element::i64);
+    auto ng_split_axis = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{}, 1);
+    auto ng_split = make_shared<opset::Split>(ng_paddings, ng_split_axis, 2);
+    Builder::SetTracingInfo(op->name(), ng_split->output(0));
+    auto ng_pads_shape = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{1}, std::vector<int64>{-1});
+    pads_begin_node = ConstructNgNode<opset::Reshape>(
+        op->name(), ng_split->output(0), ng_pads_shape, false);
+    pads_end_node = ConstructNgNode<opset::Reshape>(
+        op->name(), ng_split->output(1), ng_pads_shape, false);
   }
-  auto pads_begin_node = ConstructNgNode<opset::Constant>(
-      op->name(), ng::element::i64, ng::Shape{pad_begin.size()}, pad_begin);
-  auto pads_end_node = ConstructNgNode<opset::Constant>(
-      op->name(), ng::element::i64, ng::Shape{pad_end.size()}, pad_end);
 
   // Create final Op
   result_pad_op =
       ConstructNgNode<opset::Pad>(op->name(), ng_input, pads_begin_node,
                                   pads_end_node, pad_val_op, pad_mode);
 
-  SaveNgOp(ng_op_map, op->name(), result_pad_op);
+  SaveNgOp(ng_op_map, op, result_pad_op);
   return Status::OK();
 }
 
@@ -2119,7 +2297,7 @@ static Status TranslateRankOp(const Node* op, const std::vector<const Tensor*>&,
       op->name(), ng::element::i32, ng::Shape(),
       std::vector<int>({input_rank}));
 
-  SaveNgOp(ng_op_map, op->name(), ng_rank);
+  SaveNgOp(ng_op_map, op, ng_rank);
   return Status::OK();
 }
 
@@ -2146,7 +2324,7 @@ static Status TranslateRelu6Op(const Node* op,
                                Builder::OpMap& ng_op_map) {
   ng::Output<ng::Node> ng_input;
   TF_RETURN_IF_ERROR(GetInputNodes(ng_op_map, op, ng_input));
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::Clamp>(op->name(), ng_input, 0, 6));
   return Status::OK();
 }
@@ -2157,7 +2335,14 @@ static Status TranslateReshapeOp(
   ng::Output<ng::Node> ng_input, ng_shape_op;
   TF_RETURN_IF_ERROR(GetInputNodes(ng_op_map, op, ng_input, ng_shape_op));
 
-  NGRAPH_VLOG(3) << "Input shape: " << ng::join(ng_input.get_shape());
+  NGRAPH_VLOG(3) << "Input shape: " << ng_input.get_partial_shape();
+
+  if (!InputIsKnown(op, 1, static_input_map)) {
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::Reshape>(op->name(), ng_input, ng_shape_op,
+                                             false));
+    return Status::OK();
+  }
 
   std::vector<int64> shape;
   TF_RETURN_IF_ERROR(GetStaticInputVector(op, 1, static_input_map, &shape));
@@ -2166,8 +2351,9 @@ static Status TranslateReshapeOp(
 
   auto ng_shape = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::u64, ng::Shape{shape.size()}, shape);
-  SaveNgOp(ng_op_map, op->name(), ConstructNgNode<opset::Reshape>(
-                                      op->name(), ng_input, ng_shape, false));
+  SaveNgOp(ng_op_map, op,
+           ConstructNgNode<opset::Reshape>(op->name(), ng_input, ng_shape,
+                                           false));
   return Status::OK();
 }
 
@@ -2202,7 +2388,7 @@ static Status TranslateShapeOp(const Node* op,
   TF_RETURN_IF_ERROR(TFDataTypeToNGraphElementType(dtype, &type));
 
   // default output_type = element::i64
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::ShapeOf>(op->name(), ng_input, type));
   return Status::OK();
 }
@@ -2229,7 +2415,7 @@ static Status TranslateSizeOp(const Node* op, const std::vector<const Tensor*>&,
   auto ng_result = ConstructNgNode<opset::Constant>(
       op->name(), type, ng::Shape(0), std::vector<int64>({result}));
 
-  SaveNgOp(ng_op_map, op->name(), ng_result);
+  SaveNgOp(ng_op_map, op, ng_result);
   return Status::OK();
 }
 
@@ -2239,6 +2425,29 @@ static Status TranslateSliceOp(
   ng::Output<ng::Node> ng_input, ng_begin, ng_size;
   TF_RETURN_IF_ERROR(GetInputNodes(ng_op_map, op, ng_input, ng_begin, ng_size));
 
+  if (!InputIsKnown(op, 1, static_input_map) ||
+      !InputIsKnown(op, 2, static_input_map)) {
+    // begin and size are fed at run time: end = begin + size, except where
+    // size is -1, which means "up to the end of the dimension". The input
+    // may only get its shape at run time too.
+    auto begin = ConstructNgNode<opset::Convert>(op->name(), ng_begin,
+                                                 ng::element::i64);
+    auto size =
+        ConstructNgNode<opset::Convert>(op->name(), ng_size, ng::element::i64);
+    auto dims = ConstructNgNode<opset::ShapeOf>(op->name(), ng_input,
+                                                ng::element::i64);
+    auto minus_one = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{}, std::vector<int64>{-1});
+    auto end = ConstructNgNode<opset::Select>(
+        op->name(), ConstructNgNode<opset::Equal>(op->name(), size, minus_one),
+        dims, ConstructNgNode<opset::Add>(op->name(), begin, size));
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::StridedSlice>(
+                 op->name(), ng_input, begin, end, std::vector<int64_t>{},
+                 std::vector<int64_t>{}));
+    return Status::OK();
+  }
+
   std::vector<int64> begin_vec;
   std::vector<int64> size_vec;
   TF_RETURN_IF_ERROR(GetStaticInputVector(op, 1, static_input_map, &begin_vec));
@@ -2287,7 +2496,7 @@ static Status TranslateSliceOp(
   auto end = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::i64, ng::Shape{end_vec.size()}, end_vec);
 
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::StridedSlice>(op->name(), ng_input, begin,
                                                 end, std::vector<int64_t>{},
                                                 std::vector<int64_t>{}));
@@ -2306,7 +2515,7 @@ static Status TranslateSoftmaxOp(const Node* op,
     return errors::InvalidArgument("TF Softmax logits must be >=1 dimension");
   }
 
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::Softmax>(op->name(), ng_input, rank - 1));
   return Status::OK();
 }
@@ -2336,7 +2545,7 @@ static Status TranslateSpaceToDepthOp(const Node* op,
   auto space_to_depth = ConstructNgNode<opset::SpaceToDepth>(
       op->name(), ng_input, ng_mode, block_size);
   BatchToTensorflow(op->name(), is_nhwc, space_to_depth);
-  SaveNgOp(ng_op_map, op->name(), space_to_depth);
+  SaveNgOp(ng_op_map, op, space_to_depth);
   return Status::OK();
 }
 
@@ -2364,7 +2573,7 @@ static Status TranslateSplitOp(
   for (int i = 0; i < num_split; ++i) {
     auto out = ng_split->output(i);
     Builder::SetTracingInfo(op->name(), out);
-    SaveNgOp(ng_op_map, op->name(), out);
+    SaveNgOp(ng_op_map, op, out);
   }
   return Status::OK();
 }
@@ -2418,7 +2627,7 @@ static Status TranslateSplitVOp(
   }
 
   // Size splits must sum to the dimension of value along split_dim
-  if (idx > 0) {
+  if (has_one_neg) {
     split_lengths_vec[idx] = shape[split_dim] - length;
   }
 
@@ -2439,10 +2648,10 @@ static Status TranslateSplitVOp(
     for (size_t i = 0; i < split_lengths_vec.size(); ++i) {
       auto out = ng_split->output(i);
       Builder::SetTracingInfo(op->name(), out);
-      SaveNgOp(ng_op_map, op->name(), out);
+      SaveNgOp(ng_op_map, op, out);
     }
   } else {
-    SaveNgOp(ng_op_map, op->name(), ng_input);
+    SaveNgOp(ng_op_map, op, ng_input);
   }
 
   return Status::OK();
@@ -2475,7 +2684,7 @@ static Status TranslateSqueezeOp(const Node* op,
   auto ng_const = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::i32, ng::Shape{tf_axis.size()}, tf_axis);
 
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::Squeeze>(op->name(), ng_input, ng_const));
   return Status::OK();
 }
@@ -2529,12 +2738,12 @@ static Status TranslateStridedSliceOp(
     return vec;
   };
 
-  SaveNgOp(
-      ng_op_map, op->name(),
-      ConstructNgNode<opset::StridedSlice>(
-          op->name(), ng_input, begin, end, strides, mask_to_vec(begin_mask),
-          mask_to_vec(end_mask), mask_to_vec(new_axis_mask),
-          mask_to_vec(shrink_axis_mask), mask_to_vec(ellipsis_mask)));
+  SaveNgOp(ng_op_map, op,
+           ConstructNgNode<opset::StridedSlice>(
+               op->name(), ng_input, begin, end, strides,
+               mask_to_vec(begin_mask), mask_to_vec(end_mask),
+               mask_to_vec(new_axis_mask), mask_to_vec(shrink_axis_mask),
+               mask_to_vec(ellipsis_mask)));
   return Status::OK();
 }
 
@@ -2544,12 +2753,18 @@ static Status TranslateTileOp(
   ng::Output<ng::Node> ng_input, ng_multiples;
   TF_RETURN_IF_ERROR(GetInputNodes(ng_op_map, op, ng_input, ng_multiples));
 
+  if (!InputIsKnown(op, 1, static_input_map)) {
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::Tile>(op->name(), ng_input, ng_multiples));
+    return Status::OK();
+  }
+
   std::vector<int64> multiples;
   TF_RETURN_IF_ERROR(GetStaticInputVector(op, 1, static_input_map, &multiples));
 
   auto ng_repeats = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::i64, ng::Shape{multiples.size()}, multiples);
-  SaveNgOp(ng_op_map, op->name(),
+  SaveNgOp(ng_op_map, op,
            ConstructNgNode<opset::Tile>(op->name(), ng_input, ng_repeats));
   return Status::OK();
 }
@@ -2591,8 +2806,8 @@ static Status TranslateTopKV2Op(
   NGRAPH_VLOG(0) << "ng_indices " << ng_indices;
   Builder::SetTracingInfo(op->name(), ng_indices);
 
-  SaveNgOp(ng_op_map, op->name(), ng_values);
-  SaveNgOp(ng_op_map, op->name(), ng_indices);
+  SaveNgOp(ng_op_map, op, ng_values);
+  SaveNgOp(ng_op_map, op, ng_indices);
 
   return Status::OK();
 }
@@ -2603,6 +2818,14 @@ static Status TranslateTransposeOp(
   ng::Output<ng::Node> ng_input, ng_permutation;
   TF_RETURN_IF_ERROR(GetInputNodes(ng_op_map, op, ng_input, ng_permutation));
 
+  // The permutation is fed at run time; the backend checks it.
+  if (!InputIsKnown(op, 1, static_input_map)) {
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::Transpose>(op->name(), ng_input,
+                                               ng_permutation));
+    return Status::OK();
+  }
+
   std::vector<int64> permutation;
   TF_RETURN_IF_ERROR(
       GetStaticInputVector(op, 1, static_input_map, &permutation));
@@ -2612,7 +2835,13 @@ static Status TranslateTransposeOp(
   // - it should not have duplicates,
   // - it should have all the dimensions.
 
-  int ng_input_rank = ng_input.get_shape().size();
+  int ng_input_rank = permutation.size();
+  const auto& rank = ng_input.get_partial_shape().rank();
+  if (rank.is_static() && rank.get_length() != ng_input_rank) {
+    return errors::InvalidArgument("Permutation {", ng::join(permutation),
+                                   "} does not match the input rank ",
+                                   rank.get_length());
+  }
   vector<bool> count(ng_input_rank, false);
   for (auto p : permutation) {
     if (0 <= p && p < ng_input_rank) {
@@ -2630,8 +2859,9 @@ static Status TranslateTransposeOp(
 
   auto input_order = ConstructNgNode<opset::Constant>(
       op->name(), ng::element::u64, ng::Shape{permutation.size()}, permutation);
-  SaveNgOp(ng_op_map, op->name(), ConstructNgNode<opset::Transpose>(
-                                      op->name(), ng_input, input_order));
+  SaveNgOp(ng_op_map, op,
+           ConstructNgNode<opset::Transpose>(op->name(), ng_input,
+                                             input_order));
   return Status::OK();
 }
 
@@ -2643,57 +2873,148 @@ static Status TranslateUnpackOp(const Node* op,
   ng::Output<ng::Node> ng_input;
   TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, op, 0, ng_input));
 
-  ng::Shape input_shape = ng_input.get_shape();
-  size_t input_rank = input_shape.size();
+  int64 input_rank = ng_input.get_shape().size();
 
   int32 tf_axis;
   TF_RETURN_IF_ERROR(GetNodeAttr(op->attrs(), "axis", &tf_axis));
-  auto unpack_axis = tf_axis;
-  if (unpack_axis == -1) {
-    unpack_axis = input_rank - 1;
+  if (tf_axis < -input_rank || tf_axis >= input_rank) {
+    return errors::InvalidArgument("Unpack axis ", tf_axis,
+                                   " is out of range for an input of rank ",
+                                   input_rank);
   }
+  int64 unpack_axis = tf_axis < 0 ? tf_axis + input_rank : tf_axis;
 
   int32 tf_num;
   TF_RETURN_IF_ERROR(GetNodeAttr(op->attrs(), "num", &tf_num));
-  int num_outputs = tf_num;
+  if ((int64)ng_input.get_shape()[unpack_axis] != tf_num) {
+    return errors::InvalidArgument(
+        "Unpack of ", tf_num, " outputs along a dimension of size ",
+        ng_input.get_shape()[unpack_axis]);
+  }
 
-  std::vector<int64> output_shape;
-  for (size_t i = 0; i < input_rank; ++i) {
-    if ((int)i != unpack_axis) {
-      output_shape.push_back(input_shape[i]);
-    }
+  // One Split into num slices of size 1, each of which loses that dimension
+  ng::OutputVector ng_slices;
+  if (tf_num == 1) {
+    ng_slices.push_back(ng_input);
+  } else {
+    auto ng_axis = ConstructNgNode<opset::Constant>(
+        op->name(), ng::element::i64, ng::Shape{}, unpack_axis);
+    auto ng_split = make_shared<opset::Split>(ng_input, ng_axis, tf_num);
+    Builder::SetTracingInfo(op->name(), ng_split->output(0));
+    ng_slices = ng_split->outputs();
+  }
+  auto ng_squeeze_axis = ConstructNgNode<opset::Constant>(
+      op->name(), ng::element::i64, ng::Shape{1},
+      std::vector<int64>{unpack_axis});
+  for (const auto& ng_slice : ng_slices) {
+    SaveNgOp(ng_op_map, op,
+             ConstructNgNode<opset::Squeeze>(op->name(), ng_slice,
+                                             ng_squeeze_axis));
+  }
+  return Status::OK();
+}
+
+// A While whose condition compares loop counters with limits that are known
+// at translation time (see FindLoopCounters) runs a known number of times,
+// and becomes a TensorIterator. Other loops are not supported.
+static Status TranslateWhileOp(
+    const Node* op, const std::vector<const Tensor*>& static_input_map,
+    Builder::OpMap& ng_op_map) {
+  std::vector<ng::Output<ng::Node>> ng_inputs(op->num_inputs());
+  for (size_t i = 0; i < ng_inputs.size(); i++) {
+    TF_RETURN_IF_ERROR(GetInputNode(ng_op_map, op, i, ng_inputs[i]));
   }
 
-  ng::AxisVector ng_axis_order;
-  for (size_t i = 0; i < input_rank; i++) {
-    ng_axis_order.push_back(i);
+  std::vector<NameAttrList> funcs;
+  TF_RETURN_IF_ERROR(GetCalledFunctions(op, &funcs));
+  std::unique_ptr<FunctionBody> cond_fbody, body_fbody;
+  TF_RETURN_IF_ERROR(
+      GetFunctionBody(ng_op_map.FunctionLibrary(), funcs[0], &cond_fbody));
+  TF_RETURN_IF_ERROR(
+      GetFunctionBody(ng_op_map.FunctionLibrary(), funcs[1], &body_fbody));
+
+  std::vector<LoopCounter> counters;
+  bool found;
+  TF_RETURN_IF_ERROR(FindLoopCounters(*cond_fbody->graph, *body_fbody->graph,
+                                      &counters, &found));
+  if (!found) {
+    return errors::Unimplemented("Condition of ", op->name(),
+                                 " does not compare a loop counter with a "
+                                 "limit");
+  }
+  int64 trip_count = std::numeric_limits<int64>::max();
+  for (const auto& counter : counters) {
+    std::vector<int64> init;
+    std::vector<int64> limit{counter.limit};
+    TF_RETURN_IF_ERROR(
+        GetStaticInputVector(op, counter.index, static_input_map, &init));
+    if (counter.limit_index >= 0) {
+      TF_RETURN_IF_ERROR(GetStaticInputVector(op, counter.limit_index,
+                                              static_input_map, &limit));
+    }
+    if (init.size() != 1 || limit.size() != 1) {
+      return errors::InvalidArgument("Loop counter of ", op->name(),
+                                     " is not a scalar");
+    }
+    trip_count = std::min(trip_count, TripCount(counter, init[0], limit[0]));
+  }
+  NGRAPH_VLOG(3) << op->name() << " runs " << trip_count << " times";
+  if (trip_count > kMaxWhileTripCount) {
+    return errors::Unimplemented(op->name(), " runs ", trip_count,
+                                 " times, more than the ", kMaxWhileTripCount,
+                                 " a While is translated for");
   }
 
-  std::vector<size_t> lower_bound_vec(input_rank, 0);
-  std::vector<size_t> upper_bound_vec(input_rank);
+  if (trip_count == 0) {
+    for (const auto& ng_input : ng_inputs) {
+      SaveNgOp(ng_op_map, op, ng_input);
+    }
+    return Status::OK();
+  }
 
-  for (size_t i = 0; i < input_rank; i++) {
-    upper_bound_vec[i] = input_shape[i];
+  shared_ptr<ng::Function> ng_body;
+  TF_RETURN_IF_ERROR(TranslateFunction(body_fbody->graph, ng_inputs, ng_body));
+  auto ng_body_params = ng_body->get_parameters();
+  auto ng_body_results = ng_body->get_results();
+  if (ng_body_results.size() != ng_inputs.size()) {
+    return errors::InvalidArgument("Body of ", op->name(), " returns ",
+                                   ng_body_results.size(), " values for ",
+                                   ng_inputs.size(), " loop variables");
+  }
+  for (size_t i = 0; i < ng_inputs.size(); i++) {
+    if (!ng_body_results[i]->get_input_partial_shape(0).same_scheme(
+            ng_inputs[i].get_partial_shape())) {
+      return errors::Unimplemented("Loop variable ", i, " of ", op->name(),
+                                   " changes its shape");
+    }
   }
 
-  for (int i = 0; i < num_outputs; ++i) {
-    lower_bound_vec[unpack_axis] = i;
-    upper_bound_vec[unpack_axis] = i + 1;
-    auto lower_bound = ConstructNgNode<opset::Constant>(
-        op->name(), ng::element::i64, ng::Shape{lower_bound_vec.size()},
-        lower_bound_vec);
-    auto upper_bound = ConstructNgNode<opset::Constant>(
-        op->name(), ng::element::i64, ng::Shape{upper_bound_vec.size()},
-        upper_bound_vec);
-    auto slice = ConstructNgNode<opset::StridedSlice>(
-        op->name(), ng_input, lower_bound, upper_bound, std::vector<int64_t>{},
-        std::vector<int64_t>{});
-    auto ng_shape = ConstructNgNode<opset::Constant>(
-        op->name(), ng::element::u64, ng::Shape{output_shape.size()},
-        output_shape);
-    auto reshaped =
-        ConstructNgNode<opset::Reshape>(op->name(), slice, ng_shape, false);
-    SaveNgOp(ng_op_map, op->name(), reshaped);
+  // The TensorIterator runs once for every row of a constant that is not
+  // used otherwise
+  auto ng_iterations = ConstructNgNode<opset::Constant>(
+      op->name(), ng::element::f32, ng::Shape{size_t(trip_count), 1},
+      std::vector<float>{0.0f});
+  auto ng_iteration =
+      make_shared<opset::Parameter>(ng::element::f32, ng::Shape{1, 1});
+  ng_body_params.push_back(ng_iteration);
+
+  auto ng_loop = make_shared<opset::TensorIterator>();
+  ng_loop->set_body(make_shared<opset::TensorIterator::BodyLambda>(
+      ng_body_results, ng_body_params));
+  ng_loop->set_sliced_input(ng_iteration, ng_iterations, 0, 1, 1, -1, 0);
+  for (size_t i = 0; i < ng_inputs.size(); i++) {
+    ng_loop->set_merged_input(ng_body_params[i], ng_inputs[i],
+                              ng_body_results[i]->output(0));
+  }
+  std::vector<ng::Output<ng::Node>> ng_outputs;
+  for (const auto& ng_body_result : ng_body_results) {
+    ng_outputs.push_back(
+        ng_loop->get_iter_value(ng_body_result->output(0), -1));
+  }
+  ng_loop->validate_and_infer_types();
+  Builder::SetTracingInfo(op->name(), ng_loop);
+  for (const auto& ng_output : ng_outputs) {
+    SaveNgOp(ng_op_map, op, ng_output);
   }
   return Status::OK();
 }
@@ -2708,8 +3029,9 @@ static Status TranslateXdivyOp(
                                        ngraph::Shape{}, std::vector<int>({0}));
   auto x_is_zero = ConstructNgNode<opset::Equal>(op->name(), ng_x, zero);
   auto ng_xdivy = ConstructNgNode<opset::Divide>(op->name(), ng_x, ng_y);
-  SaveNgOp(ng_op_map, op->name(), ConstructNgNode<opset::Select>(
-                                      op->name(), x_is_zero, ng_x, ng_xdivy));
+  SaveNgOp(ng_op_map, op,
+           ConstructNgNode<opset::Select>(op->name(), x_is_zero, ng_x,
+                                          ng_xdivy));
   return Status::OK();
 }
 
@@ -2721,7 +3043,7 @@ static Status TranslateSelectOp(const Node* op,
       GetInputNodes(ng_op_map, op, ng_input1, ng_input2, ng_input3));
   auto ng_select = ConstructNgNode<opset::Select>(op->name(), ng_input1,
                                                   ng_input2, ng_input3);
-  SaveNgOp(ng_op_map, op->name(), ng_select);
+  SaveNgOp(ng_op_map, op, ng_select);
   return Status::OK();
 }
 
@@ -2735,14 +3057,14 @@ static Status TranslateZerosLikeOp(const Node* op,
   std::vector<std::string> const_values(ng::shape_size(input_shape), "0");
   auto ng_result = ConstructNgNode<opset::Constant>(
       op->name(), ng_input.get_element_type(), input_shape, const_values);
-  SaveNgOp(ng_op_map, op->name(), ng_result);
+  SaveNgOp(ng_op_map, op, ng_result);
   return Status::OK();
 }
 
-const static std::map<
-    const string,
-    const function<Status(const Node*, const std::vector<const Tensor*>&,
-                          Builder::OpMap&)>>
+using TranslateOpFunction = function<Status(
+    const Node*, const std::vector<const Tensor*>&, Builder::OpMap&)>;
+
+const static std::unordered_map<string, const TranslateOpFunction>
     TRANSLATE_OP_MAP{
         {"Abs", TranslateUnaryOp<opset::Abs>},
         {"Acos", TranslateUnaryOp<opset::Acos>},
@@ -2770,6 +3092,7 @@ const static std::map<
         {"DepthToSpace", TranslateDepthToSpaceOp},
         {"DepthwiseConv2dNative", TranslateDepthwiseConv2dNativeOp},
         {"Equal", TranslateBinaryOp<opset::Equal>},
+        {"Erf", TranslateUnaryOp<opset::Erf>},
         {"Exp", TranslateUnaryOp<opset::Exp>},
         {"ExpandDims", TranslateExpandDimsOp},
         {"Fill", TranslateFillOp},
@@ -2785,6 +3108,7 @@ const static std::map<
         {"Greater", TranslateBinaryOp<opset::Greater>},
         {"GreaterEqual", TranslateBinaryOp<opset::GreaterEqual>},
         {"Identity", TranslateIdentityOp},
+        {"If", TranslateIfOp},
         {"IsFinite", TranslateIsFiniteOp},
         {"L2Loss", TranslateL2LossOp},
         {"LogSoftmax", TranslateLogSoftmaxOp},
@@ -2846,6 +3170,8 @@ const static std::map<
         {"Square", TranslateSquareOp},
         {"SquaredDifference", TranslateBinaryOp<opset::SquaredDifference>},
         {"Squeeze", TranslateSqueezeOp},
+        {"StatelessIf", TranslateIfOp},
+        {"StatelessWhile", TranslateWhileOp},
         {"StridedSlice", TranslateStridedSliceOp},
         {"Sub", TranslateBinaryOp<opset::Subtract>},
         {"Sum", TranslateDirectReduceOp<opset::ReduceSum>},
@@ -2855,13 +3181,38 @@ const static std::map<
         {"TopKV2", TranslateTopKV2Op},
         {"Transpose", TranslateTransposeOp},
         {"Unpack", TranslateUnpackOp},
+        {"While", TranslateWhileOp},
         {"Xdivy", TranslateXdivyOp},
         {"ZerosLike", TranslateZerosLikeOp}};
 
+// Runs one nGraph pass on ng_function, in a trace scope of its own.
+template <typename TPass>
+static void RunTracedPass(const char* name,
+                          std::shared_ptr<ng::Function> ng_function) {
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kNgraphPass, -1, name);
+  ngraph::pass::Manager passes;
+  passes.register_pass<TPass>();
+  passes.run_passes(ng_function);
+}
+
 Status Builder::TranslateGraph(
     const std::vector<TensorShape>& inputs,
     const std::vector<const Tensor*>& static_input_map,
     const Graph* input_graph, shared_ptr<ng::Function>& ng_function) {
+  std::vector<PartialTensorShape> partial_inputs;
+  for (const auto& input : inputs) {
+    partial_inputs.emplace_back(input.dim_sizes());
+  }
+  TF_RETURN_IF_ERROR(TranslateGraphTemplate(partial_inputs, static_input_map,
+                                            input_graph, ng_function));
+  RunPasses(ng_function);
+  return Status::OK();
+}
+
+Status Builder::TranslateGraphTemplate(
+    const std::vector<PartialTensorShape>& inputs,
+    const std::vector<const Tensor*>& static_input_map,
+    const Graph* input_graph, shared_ptr<ng::Function>& ng_function) {
   //
   // We will visit ops in topological order.
   //
@@ -2898,10 +3249,10 @@ Status Builder::TranslateGraph(
   }
 
   //
-  // The op map holds a mapping from TensorFlow op names (strings) to
-  // vector of generated nGraph Output<Node>.
+  // The op map holds a mapping from TensorFlow nodes to the vector of
+  // generated nGraph Output<Node>.
   //
-  Builder::OpMap ng_op_map;
+  Builder::OpMap ng_op_map(*input_graph);
 
   //
   // Populate the parameter list, and also put parameters into the op map.
@@ -2921,31 +3272,42 @@ Status Builder::TranslateGraph(
     ng::element::Type ng_et;
     TF_RETURN_IF_ERROR(TFDataTypeToNGraphElementType(dtype, &ng_et));
 
-    ng::Shape ng_shape;
-    TF_RETURN_IF_ERROR(TFTensorShapeToNGraphShape(inputs[index], &ng_shape));
+    ng::PartialShape ng_shape = ng::PartialShape::dynamic();
+    if (!inputs[index].unknown_rank()) {
+      std::vector<ng::Dimension> dims;
+      for (auto dim : inputs[index].dim_sizes()) {
+        dims.push_back(dim < 0 ? ng::Dimension::dynamic() : ng::Dimension(dim));
+      }
+      ng_shape = ng::PartialShape(dims);
+    }
 
     string prov_tag;
     GetNodeAttr(parm->attrs(), "_prov_tag", &prov_tag);
     auto ng_param =
         ConstructNgNode<opset::Parameter>(prov_tag, ng_et, ng_shape);
-    SaveNgOp(ng_op_map, parm->name(), ng_param);
+    SaveNgOp(ng_op_map, parm, ng_param);
     ng_parameter_list[index] =
         ngraph::as_type_ptr<opset::Parameter>(ng_param.get_node_shared_ptr());
   }
 
   //
-  // Now create the nGraph ops from TensorFlow ops.
+  // Now create the nGraph ops from TensorFlow ops. The handler of each op
+  // type is looked up once, by the OpDef from the registry the nodes of
+  // that type share.
   //
+  std::unordered_map<const OpDef*, const TranslateOpFunction*> op_funs;
   for (auto op : tf_ops) {
     NGRAPH_VLOG(2) << "Constructing op " << op->name() << " which is "
                    << op->type_string();
 
-    const function<Status(const Node*, const std::vector<const Tensor*>&,
-                          Builder::OpMap&)>* op_fun;
-
-    try {
-      op_fun = &(TRANSLATE_OP_MAP.at(op->type_string()));
-    } catch (const std::out_of_range&) {
+    const TranslateOpFunction*& op_fun = op_funs[&op->op_def()];
+    if (op_fun == nullptr) {
+      auto it = TRANSLATE_OP_MAP.find(op->type_string());
+      if (it != TRANSLATE_OP_MAP.end()) {
+        op_fun = &it->second;
+      }
+    }
+    if (op_fun == nullptr) {
       // -----------------------------
       // Catch-all for unsupported ops
       // -----------------------------
@@ -2995,12 +3357,60 @@ Status Builder::TranslateGraph(
   // Create the nGraph function.
   //
   ng_function = make_shared<ng::Function>(ng_result_list, ng_parameter_list);
+  return Status::OK();
+}
 
+Status Builder::InstantiateTemplate(const ng::Function& ng_template,
+                                    const std::vector<TensorShape>& inputs,
+                                    shared_ptr<ng::Function>& ng_function) {
+  auto ng_template_params = ng_template.get_parameters();
+  if (ng_template_params.size() != inputs.size()) {
+    return errors::InvalidArgument("Template has ", ng_template_params.size(),
+                                   " parameters, got ", inputs.size(),
+                                   " input shapes");
+  }
+
+  // The template is cloned with Parameters of the given shapes in place of
+  // its own, which makes all its ops infer their shapes again
+  ng::NodeMap node_map;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    const auto& ng_template_param = ng_template_params[i];
+    ng::Shape ng_shape;
+    TF_RETURN_IF_ERROR(TFTensorShapeToNGraphShape(inputs[i], &ng_shape));
+    if (!ng_template_param->get_partial_shape().relaxes(ng_shape)) {
+      return errors::InvalidArgument("Input shape ", inputs[i].DebugString(),
+                                     " does not fit template parameter ", i);
+    }
+    auto ng_param = make_shared<opset::Parameter>(
+        ng_template_param->get_element_type(), ng_shape);
+    ng_param->set_friendly_name(ng_template_param->get_friendly_name());
+    ng_param->add_provenance_tags(ng_template_param->get_provenance_tags());
+    node_map[ng_template_param.get()] = ng_param;
+  }
+  try {
+    ng_function = ng::clone_function(ng_template, node_map);
+    ng_function->validate_nodes_and_infer_types();
+  } catch (const std::exception& e) {
+    return errors::Internal("Failed to instantiate template: ", e.what());
+  }
+  for (const auto& node : ng_function->get_ops()) {
+    for (const auto& output : node->outputs()) {
+      if (output.get_partial_shape().is_dynamic()) {
+        return errors::InvalidArgument("Template leaves ", node->get_name(),
+                                       " with a dynamic shape");
+      }
+    }
+  }
+
+  RunPasses(ng_function);
+  return Status::OK();
+}
+
+void Builder::RunPasses(shared_ptr<ng::Function> ng_function) {
   //
   // Apply additional passes on the nGraph function here.
   //
   {
-    ngraph::pass::Manager passes;
     ngraph::pass::PassConfig pass_config;
     // set/honor the defaults, unless specified via env var
     auto set_default = [&pass_config](std::string pass, bool enable) {
@@ -3008,14 +3418,53 @@ Status Builder::TranslateGraph(
       if (enables_map.find(pass) == enables_map.end())
         pass_config.set_pass_enable(pass, enable);
     };
-    set_default("ConstantFolding", false);
+    set_default("ConstantFolding", true);
+    set_default("LayoutAssignment", true);
     set_default("TransposeSinking", true);
-
+    set_default("TransposeFolding", true);
+    set_default("ConvBatchNormFusion", true);
+    set_default("LayerNormFusion", true);
+    set_default("GeluFusion", true);
+    set_default("SoftmaxFusion", true);
+    set_default("XdivyFusion", true);
+    set_default("ConstantDeduplication", true);
+    set_default("CommonSubexpressionElimination", true);
+
+    // Folds the weight transposes and shape arithmetic of the translation,
+    // but not the broadcasts that are cheaper to compute than to hold
     if (pass_config.get_pass_enable("ConstantFolding"))
-      passes.register_pass<ngraph::pass::ConstantFolding>();
+      RunTracedPass<pass::GuardedConstantFolding>("ConstantFolding",
+                                                  ng_function);
+    // LayoutAssignment leaves transposes only where an op needs the TF
+    // layout; TransposeSinking and TransposeFolding clean up after it, or do
+    // what they can if it is disabled
+    if (pass_config.get_pass_enable("LayoutAssignment"))
+      RunTracedPass<pass::LayoutAssignment>("LayoutAssignment", ng_function);
     if (pass_config.get_pass_enable("TransposeSinking"))
-      passes.register_pass<pass::TransposeSinking>();
-    passes.run_passes(ng_function);
+      RunTracedPass<pass::TransposeSinking>("TransposeSinking", ng_function);
+    if (pass_config.get_pass_enable("TransposeFolding"))
+      RunTracedPass<pass::TransposeFolding>("TransposeFolding", ng_function);
+    // The fusions run on what the layout passes leave, where a convolution
+    // is followed directly by its bias and batch norm
+    if (pass_config.get_pass_enable("ConvBatchNormFusion"))
+      RunTracedPass<pass::ConvBatchNormFusion>("ConvBatchNormFusion",
+                                               ng_function);
+    if (pass_config.get_pass_enable("LayerNormFusion"))
+      RunTracedPass<pass::LayerNormFusion>("LayerNormFusion", ng_function);
+    if (pass_config.get_pass_enable("GeluFusion"))
+      RunTracedPass<pass::GeluFusion>("GeluFusion", ng_function);
+    if (pass_config.get_pass_enable("SoftmaxFusion"))
+      RunTracedPass<pass::SoftmaxFusion>("SoftmaxFusion", ng_function);
+    if (pass_config.get_pass_enable("XdivyFusion"))
+      RunTracedPass<pass::XdivyFusion>("XdivyFusion", ng_function);
+    // Deduplication goes last, to merge what the other passes made too.
+    // Merged constants make more inputs the same, so it goes before CSE.
+    if (pass_config.get_pass_enable("ConstantDeduplication"))
+      RunTracedPass<pass::ConstantDeduplication>("ConstantDeduplication",
+                                                 ng_function);
+    if (pass_config.get_pass_enable("CommonSubexpressionElimination"))
+      RunTracedPass<pass::CommonSubexpressionElimination>(
+          "CommonSubexpressionElimination", ng_function);
   }
 
   //
@@ -3024,8 +3473,6 @@ Status Builder::TranslateGraph(
   for (auto result : ng_function->get_results()) {
     result->set_needs_default_layout(true);
   }
-
-  return Status::OK();
 }
 
 }  // namespace ngraph_bridge
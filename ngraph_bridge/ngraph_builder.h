@@ -37,8 +37,65 @@ class Builder {
       const std::vector<const Tensor*>& static_input_map, const Graph* tf_graph,
       std::shared_ptr<ngraph::Function>& ng_function);
 
-  using OpMap = std::unordered_map<std::string,
-                                   std::vector<ngraph::Output<ngraph::Node>>>;
+  // Translates tf_graph like TranslateGraph, but for inputs of partial
+  // shapes, and without running the nGraph passes. An op that needs to know
+  // a dimension that is unknown makes the translation fail, so the function
+  // is good for any input shapes that fit the partial ones.
+  static Status TranslateGraphTemplate(
+      const std::vector<PartialTensorShape>& inputs,
+      const std::vector<const Tensor*>& static_input_map, const Graph* tf_graph,
+      std::shared_ptr<ngraph::Function>& ng_function);
+
+  // Makes the function TranslateGraph would make for the given input shapes
+  // (and the static inputs the template was translated for) out of a
+  // template of TranslateGraphTemplate, without going through tf_graph.
+  static Status InstantiateTemplate(
+      const ngraph::Function& ng_template,
+      const std::vector<TensorShape>& inputs,
+      std::shared_ptr<ngraph::Function>& ng_function);
+
+  // Runs the nGraph passes of TranslateGraph on ng_function. On a function
+  // with dynamic shapes, the pass manager skips the passes that need static
+  // ones; the encapsulate op hands RunPasses to backends that make such a
+  // function static per call (Backend::compile_dynamic), which run it on
+  // every static clone.
+  static void RunPasses(std::shared_ptr<ngraph::Function> ng_function);
+
+  // The nGraph outputs of the TF nodes translated so far, and the data input
+  // edges of all TF nodes of the graph, in arrays indexed by Node::id(). The
+  // edges are gathered once, so that looking up an input of a node is a
+  // couple of array accesses rather than a walk over its in-edges and a
+  // lookup by name.
+  class OpMap {
+   public:
+    explicit OpMap(const Graph& graph);
+
+    // The outputs of node, in the order TF has them
+    std::vector<ngraph::Output<ngraph::Node>>& Outputs(const Node* node) {
+      return m_outputs[node->id()];
+    }
+    const std::vector<ngraph::Output<ngraph::Node>>& Outputs(
+        const Node* node) const {
+      return m_outputs[node->id()];
+    }
+
+    // The edge into the input_idx-th input of node, or nullptr if there is
+    // no such input
+    const Edge* InputEdge(const Node* node, size_t input_idx) const {
+      const auto& edges = m_input_edges[node->id()];
+      return input_idx < edges.size() ? edges[input_idx] : nullptr;
+    }
+
+    // The library of the graph, for the functions control flow ops call
+    const FunctionLibraryDefinition& FunctionLibrary() const {
+      return *m_flib;
+    }
+
+   private:
+    const FunctionLibraryDefinition* m_flib;
+    std::vector<std::vector<ngraph::Output<ngraph::Node>>> m_outputs;
+    std::vector<std::vector<const Edge*>> m_input_edges;
+  };
 
   template <typename T>
   static void MakePadding(const std::string& tf_padding_type,
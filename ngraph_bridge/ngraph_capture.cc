@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <cstdlib>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_capture.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+static const char* kCaptureCompression = "ZLIB";
+
+// Whether NGRAPH_TF_CAPTURE_CLUSTERS selects cluster
+static Status IsCaptured(int cluster, bool* is_captured) {
+  *is_captured = false;
+  const char* clusters_env = std::getenv("NGRAPH_TF_CAPTURE_CLUSTERS");
+  if (clusters_env == nullptr) {
+    return Status::OK();
+  }
+  for (const auto& id :
+       str_util::Split(clusters_env, ',', str_util::SkipEmpty())) {
+    int32 value;
+    if (!strings::safe_strto32(id, &value)) {
+      return errors::InvalidArgument(
+          "Invalid cluster in NGRAPH_TF_CAPTURE_CLUSTERS: ", id);
+    }
+    *is_captured |= (value == -1 || value == cluster);
+  }
+  return Status::OK();
+}
+
+static Status CaptureSteps(int* steps) {
+  *steps = 10;
+  const char* steps_env = std::getenv("NGRAPH_TF_CAPTURE_STEPS");
+  if (steps_env != nullptr &&
+      (!strings::safe_strto32(steps_env, steps) || *steps < 1)) {
+    return errors::InvalidArgument(
+        "Invalid number of steps in NGRAPH_TF_CAPTURE_STEPS: ", steps_env);
+  }
+  return Status::OK();
+}
+
+ClusterCapture::ClusterCapture(std::unique_ptr<WritableFile> file, int steps)
+    : m_file(std::move(file)),
+      m_writer(new io::RecordWriter(
+          m_file.get(), io::RecordWriterOptions::CreateRecordWriterOptions(
+                            kCaptureCompression))),
+      m_steps_left(steps) {}
+
+Status ClusterCapture::Create(const string& name, int cluster, int graph_id,
+                              int instance_id, const Graph& graph,
+                              const vector<bool>& input_is_static,
+                              std::unique_ptr<ClusterCapture>* capture) {
+  capture->reset();
+  bool is_captured;
+  TF_RETURN_IF_ERROR(IsCaptured(cluster, &is_captured));
+  if (!is_captured) {
+    return Status::OK();
+  }
+  int steps;
+  TF_RETURN_IF_ERROR(CaptureSteps(&steps));
+
+  const char* dir_env = std::getenv("NGRAPH_TF_CAPTURE_DIR");
+  string path = io::JoinPath(
+      dir_env == nullptr ? "." : dir_env,
+      strings::StrCat("ngtf_capture_", cluster, "_", instance_id, ".tfrecord"));
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(path, &file));
+  std::unique_ptr<ClusterCapture> new_capture(
+      new ClusterCapture(std::move(file), steps));
+
+  NameAttrList info;
+  info.set_name(name);
+  auto& attr = *info.mutable_attr();
+  attr["cluster"].set_i(cluster);
+  attr["graph_id"].set_i(graph_id);
+  string backend;
+  if (BackendManager::GetBackendName(backend).ok()) {
+    attr["backend"].set_s(backend);
+  }
+  auto* static_inputs = attr["input_is_static"].mutable_list();
+  for (bool is_static : input_is_static) {
+    static_inputs->add_b(is_static);
+  }
+  GraphDef graph_def;
+  graph.ToGraphDef(&graph_def);
+
+  TF_RETURN_IF_ERROR(
+      new_capture->m_writer->WriteRecord(info.SerializeAsString()));
+  TF_RETURN_IF_ERROR(
+      new_capture->m_writer->WriteRecord(graph_def.SerializeAsString()));
+  TF_RETURN_IF_ERROR(new_capture->m_writer->Flush());
+
+  NGRAPH_VLOG(0) << "Capturing " << steps << " calls of cluster " << cluster
+                 << " to " << path;
+  *capture = std::move(new_capture);
+  return Status::OK();
+}
+
+Status ClusterCapture::AddStep(const vector<Tensor>& inputs) {
+  if (Done()) {
+    return Status::OK();
+  }
+  AttrValue step;
+  for (const auto& input : inputs) {
+    input.AsProtoTensorContent(step.mutable_list()->add_tensor());
+  }
+  TF_RETURN_IF_ERROR(m_writer->WriteRecord(step.SerializeAsString()));
+  // Keep what is captured so far readable if the process dies
+  TF_RETURN_IF_ERROR(m_writer->Flush());
+  if (--m_steps_left == 0) {
+    return Close();
+  }
+  return Status::OK();
+}
+
+Status ClusterCapture::Close() {
+  TF_RETURN_IF_ERROR(m_writer->Close());
+  m_writer.reset();
+  return m_file->Close();
+}
+
+Status ClusterCapture::Read(const string& path, CapturedCluster* captured) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(path, &file));
+  io::SequentialRecordReader reader(
+      file.get(),
+      io::RecordReaderOptions::CreateRecordReaderOptions(kCaptureCompression));
+  tstring record;
+
+  NameAttrList info;
+  TF_RETURN_IF_ERROR(reader.ReadRecord(&record));
+  if (!info.ParseFromArray(record.data(), record.size())) {
+    return errors::DataLoss("Bad cluster description in ", path);
+  }
+  auto attr = [&info](const string& key) {
+    auto it = info.attr().find(key);
+    return it == info.attr().end() ? AttrValue() : it->second;
+  };
+  captured->name = info.name();
+  captured->cluster = attr("cluster").i();
+  captured->graph_id = attr("graph_id").i();
+  captured->backend = attr("backend").s();
+  captured->input_is_static.clear();
+  for (bool is_static : attr("input_is_static").list().b()) {
+    captured->input_is_static.push_back(is_static);
+  }
+
+  TF_RETURN_IF_ERROR(reader.ReadRecord(&record));
+  if (!captured->graph_def.ParseFromArray(record.data(), record.size())) {
+    return errors::DataLoss("Bad cluster graph in ", path);
+  }
+
+  captured->steps.clear();
+  while (true) {
+    Status status = reader.ReadRecord(&record);
+    if (errors::IsOutOfRange(status)) {
+      break;
+    }
+    TF_RETURN_IF_ERROR(status);
+    AttrValue step;
+    if (!step.ParseFromArray(record.data(), record.size())) {
+      return errors::DataLoss("Bad inputs for call ", captured->steps.size(),
+                              " in ", path);
+    }
+    vector<Tensor> inputs;
+    for (const auto& tensor_proto : step.list().tensor()) {
+      Tensor input;
+      if (!input.FromProto(tensor_proto)) {
+        return errors::DataLoss("Bad input tensor for call ",
+                                captured->steps.size(), " in ", path);
+      }
+      inputs.push_back(input);
+    }
+    captured->steps.push_back(inputs);
+  }
+  return Status::OK();
+}
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
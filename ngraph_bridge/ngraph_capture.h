@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_CAPTURE_H_
+#define NGRAPH_TF_BRIDGE_CAPTURE_H_
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+// A cluster and the inputs of some of its calls, as read back from a capture
+struct CapturedCluster {
+  std::string name;
+  int cluster = -1;
+  int graph_id = -1;
+  std::string backend;
+  std::vector<bool> input_is_static;
+  GraphDef graph_def;
+  std::vector<std::vector<Tensor>> steps;
+};
+
+//
+// Records the calls of selected clusters, so that they can be replayed and
+// benchmarked in isolation by tools/ngtf_replay.
+//
+// NGRAPH_TF_CAPTURE_CLUSTERS=<cluster>,<cluster>... selects the clusters (-1
+// selects all). Every encapsulate op of a selected cluster writes the TF
+// graph of the cluster and the inputs of its first NGRAPH_TF_CAPTURE_STEPS
+// calls (default 10) to ngtf_capture_<cluster>_<instance>.tfrecord, in
+// NGRAPH_TF_CAPTURE_DIR (default: the working directory).
+//
+// The file is a ZLIB compressed TFRecord file. The first record is a
+// NameAttrList describing the cluster, the second its GraphDef, and every
+// following one an AttrValue listing the input tensors of one call.
+//
+class ClusterCapture {
+ public:
+  // Sets capture to null if the cluster is not selected
+  static Status Create(const std::string& name, int cluster, int graph_id,
+                       int instance_id, const Graph& graph,
+                       const std::vector<bool>& input_is_static,
+                       std::unique_ptr<ClusterCapture>* capture);
+
+  // Writes the inputs of one call. Once the configured number of calls is
+  // written, the file is closed and Done() turns true.
+  Status AddStep(const std::vector<Tensor>& inputs);
+  bool Done() const { return m_steps_left == 0; }
+
+  static Status Read(const std::string& path, CapturedCluster* captured);
+
+ private:
+  ClusterCapture(std::unique_ptr<WritableFile> file, int steps);
+  Status Close();
+
+  std::unique_ptr<WritableFile> m_file;
+  std::unique_ptr<io::RecordWriter> m_writer;
+  int m_steps_left;
+};
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_CAPTURE_H_
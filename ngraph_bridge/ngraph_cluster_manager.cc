@@ -13,6 +13,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *******************************************************************************/
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/platform/logging.h"
+
+#include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_cluster_manager.h"
 
 using namespace std;
@@ -21,23 +25,211 @@ namespace tensorflow {
 
 namespace ngraph_bridge {
 // Static initializers
-std::vector<GraphDef*> NGraphClusterManager::s_cluster_graphs;
-std::mutex NGraphClusterManager::s_cluster_graphs_mutex;
+constexpr size_t NGraphClusterManager::kChunkSize;
+constexpr size_t NGraphClusterManager::kMaxChunks;
+std::atomic<NGraphClusterManager::Chunk*>
+    NGraphClusterManager::s_chunks[NGraphClusterManager::kMaxChunks];
+std::atomic<size_t> NGraphClusterManager::s_num_clusters{0};
+std::set<size_t> NGraphClusterManager::s_free_indices;
+std::map<size_t, NGraphClusterManager::Hold> NGraphClusterManager::s_holds;
+std::map<int, std::shared_ptr<NGraphClusterManager::GraphScope>>
+    NGraphClusterManager::s_scopes;
+std::mutex NGraphClusterManager::s_mutex;
+
+std::shared_ptr<NGraphClusterManager::Cluster>
+NGraphClusterManager::LoadCluster(size_t idx) {
+  if (idx >= s_num_clusters.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  Chunk* chunk = s_chunks[idx / kChunkSize].load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+  return std::atomic_load(&chunk->slots[idx % kChunkSize]);
+}
 
-size_t NGraphClusterManager::NewCluster() {
-  std::lock_guard<std::mutex> guard(s_cluster_graphs_mutex);
+void NGraphClusterManager::StoreCluster(size_t idx,
+                                        std::shared_ptr<Cluster> cluster) {
+  Chunk* chunk = s_chunks[idx / kChunkSize].load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    chunk = new Chunk();
+    s_chunks[idx / kChunkSize].store(chunk, std::memory_order_release);
+  }
+  std::atomic_store(&chunk->slots[idx % kChunkSize], cluster);
+}
 
-  size_t new_idx = s_cluster_graphs.size();
-  s_cluster_graphs.push_back(new GraphDef());
-  return new_idx;
+void NGraphClusterManager::FreeCluster(size_t idx) {
+  if (LoadCluster(idx) != nullptr) {
+    StoreCluster(idx, nullptr);
+  }
+  if (s_holds.find(idx) == s_holds.end()) {
+    s_free_indices.insert(idx);
+  }
+}
+
+Status NGraphClusterManager::NewCluster(size_t& idx) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+
+  if (!s_free_indices.empty()) {
+    idx = *s_free_indices.begin();
+    s_free_indices.erase(s_free_indices.begin());
+    StoreCluster(idx, std::make_shared<Cluster>());
+    return Status::OK();
+  }
+
+  size_t new_idx = s_num_clusters.load(std::memory_order_relaxed);
+  if (new_idx >= kChunkSize * kMaxChunks) {
+    return errors::ResourceExhausted("Too many nGraph clusters alive (",
+                                     new_idx, ")");
+  }
+  StoreCluster(new_idx, std::make_shared<Cluster>());
+  s_num_clusters.store(new_idx + 1, std::memory_order_release);
+  idx = new_idx;
+  return Status::OK();
 }
 
 GraphDef* NGraphClusterManager::GetClusterGraph(size_t idx) {
-  std::lock_guard<std::mutex> guard(s_cluster_graphs_mutex);
-  return idx < s_cluster_graphs.size() ? s_cluster_graphs[idx] : nullptr;
+  // The manager keeps the cluster alive until it is evicted, and only the
+  // rewrite passes (which own it until it is published) hold on to the
+  // returned pointer.
+  auto cluster = LoadCluster(idx);
+  return cluster == nullptr ? nullptr : &cluster->graph_def;
+}
+
+Status NGraphClusterManager::GetClusterTFGraph(
+    size_t idx, std::shared_ptr<const Graph>& graph) {
+  auto cluster = LoadCluster(idx);
+  if (cluster == nullptr) {
+    return errors::NotFound("No cluster graph with index ", idx);
+  }
+
+  std::lock_guard<std::mutex> guard(cluster->graph_mutex);
+  if (cluster->graph == nullptr) {
+    GraphConstructorOptions opts;
+    opts.allow_internal_ops = true;
+    auto new_graph = std::make_shared<Graph>(OpRegistry::Global());
+    TF_RETURN_IF_ERROR(
+        ConvertGraphDefToGraph(opts, cluster->graph_def, new_graph.get()));
+    cluster->graph = new_graph;
+  }
+  graph = cluster->graph;
+  return Status::OK();
 }
 
-void NGraphClusterManager::EvictAllClusters() { s_cluster_graphs.clear(); }
+Status NGraphClusterManager::PublishCluster(size_t idx, int graph_id) {
+  auto cluster = LoadCluster(idx);
+  if (cluster == nullptr) {
+    return errors::NotFound("No cluster graph with index ", idx);
+  }
+  std::shared_ptr<const Graph> graph;
+  TF_RETURN_IF_ERROR(GetClusterTFGraph(idx, graph));
+
+  std::lock_guard<std::mutex> guard(s_mutex);
+  if (std::atomic_load(&cluster->scope) != nullptr) {
+    return errors::Internal("Cluster ", idx, " is already published");
+  }
+  auto& scope = s_scopes[graph_id];
+  if (scope == nullptr) {
+    scope = std::make_shared<GraphScope>();
+    scope->graph_id = graph_id;
+  }
+  scope->clusters.push_back(idx);
+  std::atomic_store(&cluster->scope, scope);
+  return Status::OK();
+}
+
+Status NGraphClusterManager::AcquireCluster(
+    size_t idx, std::shared_ptr<const Graph>& graph) {
+  auto cluster = LoadCluster(idx);
+  if (cluster == nullptr) {
+    return errors::NotFound("No cluster graph with index ", idx);
+  }
+  TF_RETURN_IF_ERROR(GetClusterTFGraph(idx, graph));
+
+  std::lock_guard<std::mutex> guard(s_mutex);
+  // The cluster may have been evicted while its graph was parsed
+  if (LoadCluster(idx) != cluster) {
+    return errors::NotFound("No cluster graph with index ", idx);
+  }
+  // Unpublished clusters (e.g. ones built by hand in tests) have no scope;
+  // they stay until evicted.
+  auto& hold = s_holds[idx];
+  hold.count++;
+  hold.scope = std::atomic_load(&cluster->scope);
+  if (hold.scope != nullptr) {
+    hold.scope->users++;
+  }
+  return Status::OK();
+}
+
+void NGraphClusterManager::ReleaseCluster(size_t idx) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  auto it = s_holds.find(idx);
+  if (it == s_holds.end()) {
+    return;
+  }
+  auto scope = it->second.scope;
+  if (--it->second.count == 0) {
+    s_holds.erase(it);
+    if (LoadCluster(idx) == nullptr) {
+      s_free_indices.insert(idx);
+    }
+  }
+  if (scope != nullptr && --scope->users == 0) {
+    NGRAPH_VLOG(2) << "Releasing clusters of graph " << scope->graph_id;
+    EvictScope(scope);
+  }
+}
+
+void NGraphClusterManager::EvictScope(
+    const std::shared_ptr<GraphScope>& scope) {
+  for (auto idx : scope->clusters) {
+    auto cluster = LoadCluster(idx);
+    if (cluster != nullptr && std::atomic_load(&cluster->scope) == scope) {
+      FreeCluster(idx);
+    }
+  }
+  auto it = s_scopes.find(scope->graph_id);
+  if (it != s_scopes.end() && it->second == scope) {
+    s_scopes.erase(it);
+  }
+}
+
+void NGraphClusterManager::EvictCluster(size_t idx) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  if (LoadCluster(idx) != nullptr) {
+    FreeCluster(idx);
+  }
+}
+
+void NGraphClusterManager::EvictAllClusters() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  size_t num_clusters = s_num_clusters.load(std::memory_order_relaxed);
+  size_t num_kept = 0;
+  for (size_t idx = 0; idx < num_clusters; idx++) {
+    auto cluster = LoadCluster(idx);
+    auto scope =
+        cluster == nullptr ? nullptr : std::atomic_load(&cluster->scope);
+    bool in_use = s_holds.find(idx) != s_holds.end() ||
+                  (scope != nullptr && scope->users > 0);
+    if (in_use) {
+      num_kept = idx + 1;
+    } else if (cluster != nullptr) {
+      StoreCluster(idx, nullptr);
+    }
+  }
+  for (auto it = s_scopes.begin(); it != s_scopes.end();) {
+    it = it->second->users == 0 ? s_scopes.erase(it) : std::next(it);
+  }
+
+  s_free_indices.clear();
+  for (size_t idx = 0; idx < num_kept; idx++) {
+    if (LoadCluster(idx) == nullptr && s_holds.find(idx) == s_holds.end()) {
+      s_free_indices.insert(idx);
+    }
+  }
+  s_num_clusters.store(num_kept, std::memory_order_release);
+}
 
 }  // namespace ngraph_bridge
 
@@ -16,24 +16,105 @@
 #ifndef NGRAPH_LIBRARY_MANAGER_H_
 #define NGRAPH_LIBRARY_MANAGER_H_
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <vector>
 
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/graph/graph.h"
 
 namespace tensorflow {
 
 namespace ngraph_bridge {
 
+//
+// Owns the cluster graphs produced by the rewrite passes until the
+// NGraphEncapsulate kernels that run them are done with them.
+//
+// A cluster goes through three stages:
+//
+//   1. NewCluster() creates it empty, and the rewrite passes fill in its
+//      GraphDef through GetClusterGraph().
+//   2. PublishCluster() hands it to the TF graph (graph id) it was rewritten
+//      for. From here on it is immutable and can be read without locking.
+//   3. Every encapsulate kernel calls AcquireCluster() when it is built and
+//      ReleaseCluster() when it is destroyed. When the last kernel of a graph
+//      id is released, all clusters of that graph id are freed.
+//
+// Clusters that lose all their nodes during deassignment can be dropped
+// early with EvictCluster().
+//
+// The index of a freed cluster is handed out again by a later NewCluster(),
+// but only once no kernel holds it any more, so a late ReleaseCluster() can
+// never hit the cluster that took over the index.
+//
 class NGraphClusterManager {
  public:
-  static size_t NewCluster();
+  // Fails with ResourceExhausted if every index is taken.
+  static Status NewCluster(size_t& idx);
+  // Returns nullptr if there is no cluster with this index (any more). The
+  // GraphDef must not be modified once the cluster is published.
   static tensorflow::GraphDef* GetClusterGraph(size_t idx);
+  // Returns the cluster graph as a TF Graph, converting the GraphDef on first
+  // use only. The Graph is shared by everyone asking for the same cluster, so
+  // it must not be modified, and the GraphDef must not be modified after the
+  // first call either.
+  static Status GetClusterTFGraph(size_t idx,
+                                  std::shared_ptr<const Graph>& graph);
+  static Status PublishCluster(size_t idx, int graph_id);
+  static Status AcquireCluster(size_t idx,
+                               std::shared_ptr<const Graph>& graph);
+  static void ReleaseCluster(size_t idx);
+  static void EvictCluster(size_t idx);
+  // Drops every cluster that no kernel holds, along with the graph ids none
+  // of whose kernels are alive, and numbers new clusters from the lowest free
+  // index again. Meant for tests.
   static void EvictAllClusters();
 
  private:
-  static std::vector<tensorflow::GraphDef*> s_cluster_graphs;
-  static std::mutex s_cluster_graphs_mutex;
+  struct GraphScope {
+    int graph_id;
+    int users = 0;                 // guarded by s_mutex
+    std::vector<size_t> clusters;  // guarded by s_mutex
+  };
+
+  struct Cluster {
+    tensorflow::GraphDef graph_def;
+    std::mutex graph_mutex;
+    std::shared_ptr<const Graph> graph;  // guarded by graph_mutex
+    std::shared_ptr<GraphScope> scope;   // set once, under s_mutex
+  };
+
+  // The kernels holding an index, and the scope they acquired it in (which
+  // outlives an eviction of the cluster itself)
+  struct Hold {
+    int count = 0;
+    std::shared_ptr<GraphScope> scope;
+  };
+
+  // Cluster slots live in fixed-size chunks that are never moved or freed,
+  // so a reader only needs two atomic loads to get at a cluster.
+  static constexpr size_t kChunkSize = 1024;
+  static constexpr size_t kMaxChunks = 16384;
+  struct Chunk {
+    std::shared_ptr<Cluster> slots[kChunkSize];
+  };
+
+  static std::shared_ptr<Cluster> LoadCluster(size_t idx);
+  // The functions below must be called with s_mutex held.
+  static void StoreCluster(size_t idx, std::shared_ptr<Cluster> cluster);
+  static void FreeCluster(size_t idx);
+  static void EvictScope(const std::shared_ptr<GraphScope>& scope);
+
+  static std::atomic<Chunk*> s_chunks[kMaxChunks];
+  static std::atomic<size_t> s_num_clusters;
+  static std::set<size_t> s_free_indices;
+  static std::map<size_t, Hold> s_holds;
+  static std::map<int, std::shared_ptr<GraphScope>> s_scopes;
+  static std::mutex s_mutex;
 };
 
 }  // namespace ngraph_bridge
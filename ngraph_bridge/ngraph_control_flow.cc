@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+
+#include "ngraph_bridge/ngraph_control_flow.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+bool IsFunctionalControlFlow(const Node* node) {
+  const string& type = node->type_string();
+  return type == "If" || type == "StatelessIf" || type == "While" ||
+         type == "StatelessWhile";
+}
+
+Status GetCalledFunctions(const Node* node, std::vector<NameAttrList>* funcs) {
+  funcs->clear();
+  bool is_if = node->type_string() == "If" ||
+               node->type_string() == "StatelessIf";
+  for (const char* attr : is_if ? std::vector<const char*>{"then_branch",
+                                                           "else_branch"}
+                                : std::vector<const char*>{"cond", "body"}) {
+    NameAttrList func;
+    TF_RETURN_IF_ERROR(GetNodeAttr(node->attrs(), attr, &func));
+    funcs->push_back(func);
+  }
+  return Status::OK();
+}
+
+Status GetFunctionBody(const FunctionLibraryDefinition& flib,
+                       const NameAttrList& func,
+                       std::unique_ptr<FunctionBody>* fbody) {
+  const FunctionDef* fdef = flib.Find(func.name());
+  if (fdef == nullptr) {
+    return errors::NotFound("Function ", func.name(),
+                            " is not in the library");
+  }
+  const auto get_func_sig = [&flib](const string& op, const OpDef** sig) {
+    return flib.LookUpOpDef(op, sig);
+  };
+  return FunctionDefToBodyHelper(*fdef, AttrSlice(&func.attr()), &flib,
+                                 get_func_sig, fbody);
+}
+
+// The node behind any Identity ops feeding node's input_index-th input
+static const Node* InputSkippingIdentity(const Node* node, int input_index) {
+  const Node* input;
+  if (!node->input_node(input_index, &input).ok()) {
+    return nullptr;
+  }
+  while (input->type_string() == "Identity") {
+    if (!input->input_node(0, &input).ok()) {
+      return nullptr;
+    }
+  }
+  return input;
+}
+
+// The index of an _Arg or _Retval node, or -1 for other nodes
+static int IndexOf(const Node* node) {
+  int index;
+  if (node == nullptr || !(node->IsArg() || node->IsRetval()) ||
+      !GetNodeAttr(node->attrs(), "index", &index).ok()) {
+    return -1;
+  }
+  return index;
+}
+
+// The value of a Const node with a single integer element
+static bool GetIntConst(const Node* node, int64* value) {
+  TensorProto proto;
+  if (node == nullptr || node->type_string() != "Const" ||
+      !GetNodeAttr(node->attrs(), "value", &proto).ok()) {
+    return false;
+  }
+  Tensor tensor;
+  if (!tensor.FromProto(proto) || tensor.NumElements() != 1) {
+    return false;
+  }
+  if (tensor.dtype() == DT_INT32) {
+    *value = tensor.flat<int32>()(0);
+    return true;
+  }
+  if (tensor.dtype() == DT_INT64) {
+    *value = tensor.flat<int64>()(0);
+    return true;
+  }
+  return false;
+}
+
+// The node that the loop body returns as the index-th loop variable
+static const Node* BodyResult(const Graph& body, int index) {
+  for (const Node* node : body.op_nodes()) {
+    if (node->IsRetval() && IndexOf(node) == index) {
+      return InputSkippingIdentity(node, 0);
+    }
+  }
+  return nullptr;
+}
+
+// If the body adds a constant to the index-th loop variable, sets step to it
+static bool GetCounterStep(const Graph& body, int index, int64* step) {
+  const Node* next = BodyResult(body, index);
+  if (next == nullptr) {
+    return false;
+  }
+  const string& type = next->type_string();
+  if (type != "Add" && type != "AddV2" && type != "Sub") {
+    return false;
+  }
+  const Node* lhs = InputSkippingIdentity(next, 0);
+  const Node* rhs = InputSkippingIdentity(next, 1);
+  if (type == "Sub") {
+    if (IndexOf(lhs) != index || !GetIntConst(rhs, step)) {
+      return false;
+    }
+    *step = -*step;
+  } else if (!((IndexOf(lhs) == index && GetIntConst(rhs, step)) ||
+               (IndexOf(rhs) == index && GetIntConst(lhs, step)))) {
+    return false;
+  }
+  return *step != 0;
+}
+
+// Adds the counters of the condition predicate to counters
+static bool FindCounters(const Graph& body, const Node* predicate,
+                         std::vector<LoopCounter>* counters) {
+  if (predicate == nullptr) {
+    return false;
+  }
+  const string& type = predicate->type_string();
+  if (type == "LogicalAnd") {
+    return FindCounters(body, InputSkippingIdentity(predicate, 0), counters) &&
+           FindCounters(body, InputSkippingIdentity(predicate, 1), counters);
+  }
+  bool less = type == "Less" || type == "LessEqual";
+  bool greater = type == "Greater" || type == "GreaterEqual";
+  if (!less && !greater) {
+    return false;
+  }
+
+  // The counter may be on either side; limit < counter is counter > limit
+  const Node* counter_node = InputSkippingIdentity(predicate, 0);
+  const Node* limit_node = InputSkippingIdentity(predicate, 1);
+  LoopCounter counter;
+  counter.index = IndexOf(counter_node);
+  if (counter.index < 0 ||
+      !GetCounterStep(body, counter.index, &counter.step)) {
+    std::swap(counter_node, limit_node);
+    std::swap(less, greater);
+    counter.index = IndexOf(counter_node);
+    if (counter.index < 0 ||
+        !GetCounterStep(body, counter.index, &counter.step)) {
+      return false;
+    }
+  }
+  // A counter that moves away from its limit never stops the loop
+  if ((less && counter.step < 0) || (greater && counter.step > 0)) {
+    return false;
+  }
+  counter.inclusive = type == "LessEqual" || type == "GreaterEqual";
+
+  counter.limit_index = -1;
+  counter.limit = 0;
+  if (!GetIntConst(limit_node, &counter.limit)) {
+    counter.limit_index = IndexOf(limit_node);
+    if (counter.limit_index < 0 || counter.limit_index == counter.index ||
+        IndexOf(BodyResult(body, counter.limit_index)) !=
+            counter.limit_index) {
+      return false;
+    }
+  }
+  counters->push_back(counter);
+  return true;
+}
+
+Status FindLoopCounters(const Graph& cond, const Graph& body,
+                        std::vector<LoopCounter>* counters, bool* found) {
+  counters->clear();
+  *found = false;
+  const Node* retval = nullptr;
+  for (const Node* node : cond.op_nodes()) {
+    if (node->IsRetval()) {
+      if (retval != nullptr) {
+        return errors::InvalidArgument("Loop condition has several results");
+      }
+      retval = node;
+    }
+  }
+  if (retval == nullptr) {
+    return errors::InvalidArgument("Loop condition has no result");
+  }
+  *found = FindCounters(body, InputSkippingIdentity(retval, 0), counters);
+  if (!*found) {
+    counters->clear();
+  }
+  return Status::OK();
+}
+
+int64 TripCount(const LoopCounter& counter, int64 init, int64 limit) {
+  // The distance the counter has to cover, in the direction of its step
+  int64 distance = counter.step > 0 ? limit - init : init - limit;
+  int64 step = counter.step > 0 ? counter.step : -counter.step;
+  if (counter.inclusive) {
+    return distance < 0 ? 0 : distance / step + 1;
+  }
+  return distance <= 0 ? 0 : (distance + step - 1) / step;
+}
+
+void ConstTripCount(const Node* node, const std::vector<LoopCounter>& counters,
+                    int64* trip_count, bool* known) {
+  *known = false;
+  *trip_count = std::numeric_limits<int64>::max();
+  for (const auto& counter : counters) {
+    int64 init;
+    int64 limit = counter.limit;
+    const Node* input;
+    if (!node->input_node(counter.index, &input).ok() ||
+        !GetIntConst(input, &init)) {
+      return;
+    }
+    if (counter.limit_index >= 0 &&
+        (!node->input_node(counter.limit_index, &input).ok() ||
+         !GetIntConst(input, &limit))) {
+      return;
+    }
+    *trip_count = std::min(*trip_count, TripCount(counter, init, limit));
+  }
+  *known = !counters.empty();
+}
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#ifndef NGRAPH_TF_BRIDGE_CONTROL_FLOW_H_
+#define NGRAPH_TF_BRIDGE_CONTROL_FLOW_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+// Helpers for the functional control flow ops (If, StatelessIf, While and
+// StatelessWhile), whose branches, loop condition and loop body are
+// functions of the graph's library.
+
+// Whether node is one of the functional control flow ops
+bool IsFunctionalControlFlow(const Node* node);
+
+// The functions node calls: then_branch and else_branch of an If, cond and
+// body of a While
+Status GetCalledFunctions(const Node* node, std::vector<NameAttrList>* funcs);
+
+// Instantiates func from flib as a graph of _Arg, _Retval and op nodes. The
+// graph has flib as its library, for the functions func calls in turn.
+Status GetFunctionBody(const FunctionLibraryDefinition& flib,
+                       const NameAttrList& func,
+                       std::unique_ptr<FunctionBody>* fbody);
+
+// A loop variable of a While that counts its iterations: the loop body adds
+// a constant step to it, and the loop condition compares it with a limit.
+// The limit is a constant of the condition, or a loop variable that the body
+// passes through unchanged.
+struct LoopCounter {
+  // The loop variable that counts
+  int index;
+  int64 step;
+  // The loop variable that holds the limit, or -1 if the limit is constant
+  int limit_index;
+  int64 limit;
+  // Whether the loop also runs for a counter equal to the limit
+  bool inclusive;
+};
+
+// Finds the counters of a While whose condition is a comparison of a counter
+// with its limit, or a LogicalAnd of such comparisons. found is false for any
+// other condition. A loop with counters runs for as many iterations as the
+// smallest of their TripCounts.
+Status FindLoopCounters(const Graph& cond, const Graph& body,
+                        std::vector<LoopCounter>* counters, bool* found);
+
+// The number of iterations counter allows, if it starts at init and its
+// limit is limit
+int64 TripCount(const LoopCounter& counter, int64 init, int64 limit);
+
+// The number of iterations of the While node with the given counters, if the
+// inputs the counters start from and the inputs of their limits are Const
+// nodes. known is false otherwise.
+void ConstTripCount(const Node* node, const std::vector<LoopCounter>& counters,
+                    int64* trip_count, bool* known);
+
+// The most iterations a While is translated for. Its TensorIterator takes the
+// number of iterations from a constant with one row per iteration, so longer
+// loops are left to TF.
+constexpr int64 kMaxWhileTripCount = 1 << 16;
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_CONTROL_FLOW_H_
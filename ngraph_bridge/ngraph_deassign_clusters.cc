@@ -30,8 +30,11 @@
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_api.h"
 #include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "ngraph_bridge/ngraph_cluster_manager.h"
 #include "ngraph_bridge/ngraph_deassign_clusters.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
 using namespace std;
@@ -56,6 +59,8 @@ static const int MIN_NONTRIVIAL_NODES = 6;
 unordered_map<string, int> deassigned_histogram;
 int num_nodes_marked_before_deassign = 0;
 
+int MinNontrivialNodes() { return MIN_NONTRIVIAL_NODES; }
+
 static void MaybeLogPlacement(const Graph* graph) {
   if (!config::IsLoggingPlacement()) return;
 
@@ -145,6 +150,7 @@ static void MaybeLogPlacement(const Graph* graph) {
 }
 
 Status DeassignClusters(Graph* graph) {
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kDeassignClusters);
   //
   // When running unit tests, we do not want to see trivial clusters
   // deassigned. This flag (used by the Python tests) makes this possible.
@@ -154,13 +160,17 @@ Status DeassignClusters(Graph* graph) {
 
   if (std::getenv("NGRAPH_TF_DISABLE_DEASSIGN_CLUSTERS") != nullptr) {
     // still need to calculate num_nodes_marked_before_deassign
+    std::set<int> clusters;
     for (auto node : graph->nodes()) {
       int cluster_idx;
 
       if (GetNodeCluster(node, &cluster_idx) == Status::OK()) {
         num_nodes_marked_before_deassign++;
+        clusters.insert(cluster_idx);
       }
     }
+    RewriteReport::Count("clusters_before", clusters.size());
+    RewriteReport::Count("clusters_after", clusters.size());
     MaybeLogPlacement(graph);
     return Status::OK();
   }
@@ -177,6 +187,8 @@ Status DeassignClusters(Graph* graph) {
     cluster_map[cluster_idx].insert(node);
   }
 
+  int num_clusters_deassigned = 0;
+  int num_nodes_deassigned = 0;
   for (auto& kv : cluster_map) {
     int cluster_idx = kv.first;
     std::set<Node*>& nodes = kv.second;
@@ -203,9 +215,17 @@ Status DeassignClusters(Graph* graph) {
 
         deassigned_histogram[node->type_string()]++;
       }
+      NGraphClusterManager::EvictCluster(cluster_idx);
+      num_clusters_deassigned++;
+      num_nodes_deassigned += nodes.size();
     }
   }
 
+  RewriteReport::Count("clusters_before", cluster_map.size());
+  RewriteReport::Count("clusters_after",
+                       cluster_map.size() - num_clusters_deassigned);
+  RewriteReport::Count("nodes_deassigned", num_nodes_deassigned);
+
   //
   // At this point we have made our final decision about cluster assignment, so
   // we will log the cluster assignment now.
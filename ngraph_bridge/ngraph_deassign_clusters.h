@@ -26,6 +26,9 @@ namespace ngraph_bridge {
 
 Status DeassignClusters(Graph* graph);
 
+// The number of non-trivial ops a cluster needs to keep its assignment
+int MinNontrivialNodes();
+
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
 
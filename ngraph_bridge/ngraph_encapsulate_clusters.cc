@@ -45,6 +45,8 @@
 #include "ngraph_bridge/ngraph_encapsulate_impl.h"
 #include "ngraph_bridge/ngraph_executable.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/version.h"
 
@@ -76,6 +78,7 @@ void Encapsulator::AddInput(NodeDef* dst, StringPiece src_name, int src_slot) {
 Status EncapsulateClusters(
     Graph* graph, int graph_id,
     const std::unordered_map<std::string, std::string>& device_config) {
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kEncapsulateClusters, graph_id);
   Encapsulator enc(graph);
   NGRAPH_VLOG(3) << "Running AnalysisPass in EncapsulateClusters";
   TF_RETURN_IF_ERROR(enc.AnalysisPass());
@@ -84,6 +87,14 @@ Status EncapsulateClusters(
 
   set<int> newly_created_cluster_ids;
   TF_RETURN_IF_ERROR(enc.GetNewClusterIDs(newly_created_cluster_ids));
+  RewriteReport::Count("encapsulates", newly_created_cluster_ids.size());
+
+  // The cluster graphs are final now; hand them over to this graph id, whose
+  // encapsulate kernels will keep them alive.
+  for (auto& cluster_idx : newly_created_cluster_ids) {
+    TF_RETURN_IF_ERROR(
+        NGraphClusterManager::PublishCluster(cluster_idx, graph_id));
+  }
 
   // Pass 9 (optional, only run if environment variable
   // NGRAPH_TF_DUMP_CLUSTERS is set): validate the graph def, and
@@ -161,6 +172,9 @@ Status Encapsulator::AnalysisPass() {
   std::map<int, int> arg_index_count;
   int count_arg = 0, count_retval = 0, count_both_arg_retval = 0,
       count_free = 0, count_encapsulated = 0, count_tot = 0;
+  // Edges by the clusters at their ends, for the rewrite report
+  int count_control = 0, count_intra_cluster = 0, count_unclustered = 0,
+      count_cross = 0, count_in = 0, count_out = 0;
   for (auto edge : graph->edges()) {
     count_tot++;
     // TODO(amprocte): should actually keep of these. During clustering we
@@ -168,6 +182,7 @@ Status Encapsulator::AnalysisPass() {
     // maintain inter-cluster control deps.
     if (edge->IsControlEdge()) {
       count_free++;
+      count_control++;
       continue;
     }
 
@@ -178,6 +193,7 @@ Status Encapsulator::AnalysisPass() {
     // that what we want to do?
     if (!src->IsOp() || !dst->IsOp()) {
       count_free++;
+      count_unclustered++;
       continue;
     }
 
@@ -193,9 +209,22 @@ Status Encapsulator::AnalysisPass() {
     // both nodes are unclustered; GetNodeCluster gives us -1 in that case.
     if (dst_cluster_idx == src_cluster_idx) {
       count_encapsulated++;
+      if (dst_clustered) {
+        count_intra_cluster++;
+      } else {
+        count_unclustered++;
+      }
       continue;
     }
 
+    if (dst_clustered && src_clustered) {
+      count_cross++;
+    } else if (dst_clustered) {
+      count_in++;
+    } else {
+      count_out++;
+    }
+
     // Some debug logging...
     DataType dt = dst->input_type(edge->dst_input());
     std::string flow_kind = dst_clustered && src_clustered
@@ -292,6 +321,14 @@ Status Encapsulator::AnalysisPass() {
     }
   }
 
+  RewriteReport::Count("edges", count_tot);
+  RewriteReport::Count("edges_control", count_control);
+  RewriteReport::Count("edges_intra_cluster", count_intra_cluster);
+  RewriteReport::Count("edges_unclustered", count_unclustered);
+  RewriteReport::Count("edges_cluster_to_cluster", count_cross);
+  RewriteReport::Count("edges_into_cluster", count_in);
+  RewriteReport::Count("edges_out_of_cluster", count_out);
+
   if (config::IsLoggingPlacement()) {
     int computed_edge_number = count_arg + count_retval +
                                count_both_arg_retval + count_free +
@@ -400,6 +437,14 @@ Status Encapsulator::AnalysisPass() {
     }
   }
 
+  // The functions that the clustered control flow ops call go into the
+  // library of the cluster graph, where their translation looks them up.
+  for (auto& kv : device_name_map) {
+    GraphDef* gdef = NGraphClusterManager::GetClusterGraph(kv.first);
+    *gdef->mutable_library() =
+        graph->flib_def().ReachableDefinitions(*gdef).ToProto();
+  }
+
   analysis_done = true;
 
   return Status::OK();
@@ -456,24 +501,22 @@ Status Encapsulator::RewritePass(
       }
     }
 
-    // Find Static Inputs And Add as an attribute
+    // Find Static Inputs And Add as an attribute. The cluster graph is
+    // complete at this point, so the parsed Graph is kept in the cluster
+    // manager for the encapsulate kernel to reuse.
     vector<int> static_input_indexes;
-    GraphDef* gdef_for_current_encapsulate;
-    gdef_for_current_encapsulate =
-        NGraphClusterManager::GetClusterGraph(cluster_idx);
-    if (gdef_for_current_encapsulate == nullptr) {
+    std::shared_ptr<const Graph> graph_for_current_encapsulate;
+    Status cluster_status = NGraphClusterManager::GetClusterTFGraph(
+        cluster_idx, graph_for_current_encapsulate);
+    if (errors::IsNotFound(cluster_status)) {
       return errors::Internal(
           "Did not find encapsulated graph in cluster manager for node ",
           encap_node_name);
     }
-    GraphConstructorOptions opts;
-    opts.allow_internal_ops = true;
-    Graph graph_for_current_encapsulate(OpRegistry::Global());
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(
-        opts, *gdef_for_current_encapsulate, &graph_for_current_encapsulate));
+    TF_RETURN_IF_ERROR(cluster_status);
 
-    TF_RETURN_IF_ERROR(
-        GetStaticInputs(&graph_for_current_encapsulate, &static_input_indexes));
+    TF_RETURN_IF_ERROR(GetStaticInputs(graph_for_current_encapsulate.get(),
+                                       &static_input_indexes));
     nb.Attr("_ngraph_static_inputs", static_input_indexes);
 
     Status status = nb.Finalize(graph, &n);
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *******************************************************************************/
+#include <algorithm>
 #include <cstdlib>
 #include <mutex>
 #include <utility>
@@ -26,6 +27,8 @@
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_backend_manager.h"
@@ -33,8 +36,10 @@
 #include "ngraph_bridge/ngraph_cluster_manager.h"
 #include "ngraph_bridge/ngraph_encapsulate_impl.h"
 #include "ngraph_bridge/ngraph_encapsulate_op.h"
+#include "ngraph_bridge/ngraph_layer_profiler.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
 #include "ngraph_bridge/ngraph_timer.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
 using namespace std;
@@ -43,9 +48,36 @@ namespace tensorflow {
 namespace ngraph_bridge {
 
 // Ngraph Encapsulate Implementation class for EncapsulateOp class
-NGraphEncapsulateImpl::NGraphEncapsulateImpl() : m_graph(OpRegistry::Global()) {
+NGraphEncapsulateImpl::NGraphEncapsulateImpl()
+    : m_graph(std::make_shared<Graph>(OpRegistry::Global())),
+      m_metrics(new ClusterMetrics(-1)) {
   my_instance_id = s_instance_count;
   s_instance_count++;
+
+  const char* dynamic_dims_env = std::getenv("NGRAPH_TF_DYNAMIC_DIMS");
+  if (dynamic_dims_env != nullptr) {
+    for (const auto& dim :
+         str_util::Split(dynamic_dims_env, ',', str_util::SkipEmpty())) {
+      int32 value;
+      if (!strings::safe_strto32(dim, &value) || value < 0) {
+        NGRAPH_VLOG(0) << "Ignoring invalid dimension in "
+                       << "NGRAPH_TF_DYNAMIC_DIMS: " << dim;
+        continue;
+      }
+      m_dynamic_dims.push_back(value);
+    }
+  }
+}
+
+bool NGraphEncapsulateImpl::UseDynamicDims() {
+  return !m_dynamic_dims.empty() && !m_dynamic_dims_failed &&
+         BackendManager::SupportsDynamicDimensions();
+}
+
+bool NGraphEncapsulateImpl::IsDynamicDim(int input, int dim) const {
+  return !m_input_is_static[input] &&
+         std::find(m_dynamic_dims.begin(), m_dynamic_dims.end(), dim) !=
+             m_dynamic_dims.end();
 }
 
 // Use tensorflow input tensors to get input_shapes, static_input_map
@@ -55,12 +87,18 @@ Status NGraphEncapsulateImpl::ComputeSignature(
     std::vector<TensorShape>& input_shapes,
     std::vector<const Tensor*>& static_input_map,
     std::stringstream& signature_ss) {
-  // Get the inputs
+  // Get the inputs. The dimensions that are translated as dynamic ones are
+  // left out, so that one executable serves all their sizes.
+  bool use_dynamic_dims = UseDynamicDims();
   for (int i = 0; i < tf_input_tensors.size(); i++) {
     const Tensor& input_tensor = tf_input_tensors[i];
     input_shapes.push_back(input_tensor.shape());
-    for (const auto& x : input_tensor.shape()) {
-      signature_ss << x.size << ",";
+    for (int d = 0; d < input_tensor.dims(); d++) {
+      if (use_dynamic_dims && IsDynamicDim(i, d)) {
+        signature_ss << "?,";
+      } else {
+        signature_ss << input_tensor.dim_size(d) << ",";
+      }
     }
     signature_ss << ";";
   }
@@ -79,6 +117,138 @@ Status NGraphEncapsulateImpl::ComputeSignature(
   return Status::OK();
 }
 
+// Estimates the memory an executable compiled from ng_function holds on to:
+// a buffer for the output of every op (an upper bound, since backends reuse
+// buffers), and its constants. Outputs of unknown size are left out.
+static void EstimateFootprint(const ngraph::Function& ng_function,
+                              int64* executable_bytes, int64* constant_bytes) {
+  *executable_bytes = 0;
+  *constant_bytes = 0;
+  for (const auto& node : ng_function.get_ops()) {
+    if (node->is_parameter() || node->is_output()) {
+      continue;
+    }
+    for (size_t i = 0; i < node->get_output_size(); i++) {
+      if (node->get_output_partial_shape(i).is_dynamic()) {
+        continue;
+      }
+      int64 bytes = node->get_output_element_type(i).size() *
+                    ngraph::shape_size(node->get_output_shape(i));
+      *(node->is_constant() ? constant_bytes : executable_bytes) += bytes;
+    }
+  }
+}
+
+void NGraphEncapsulateImpl::ReleaseFootprint(const std::string& signature) {
+  auto it = m_footprints.find(signature);
+  if (it == m_footprints.end()) {
+    return;
+  }
+  m_metrics->executable_bytes->Add(-it->second.executable_bytes);
+  m_metrics->constant_bytes->Add(-it->second.constant_bytes);
+  m_footprints.erase(it);
+}
+
+Status NGraphEncapsulateImpl::GetNgFunction(
+    const std::vector<TensorShape>& input_shapes,
+    const std::vector<const Tensor*>& static_input_map,
+    const std::string& static_signature,
+    std::shared_ptr<ngraph::Function>& ng_function) {
+  if (UseDynamicDims()) {
+    std::vector<PartialTensorShape> dynamic_shapes;
+    for (size_t i = 0; i < input_shapes.size(); i++) {
+      std::vector<int64> dims;
+      for (int d = 0; d < input_shapes[i].dims(); d++) {
+        dims.push_back(IsDynamicDim(i, d) ? -1 : input_shapes[i].dim_size(d));
+      }
+      dynamic_shapes.emplace_back(dims);
+    }
+    Status status = Builder::TranslateGraphTemplate(
+        dynamic_shapes, static_input_map, m_graph.get(), ng_function);
+    if (status.ok()) {
+      Builder::RunPasses(ng_function);
+      return Status::OK();
+    }
+    NGRAPH_VLOG(1) << "Cluster " << m_ngraph_cluster
+                   << " does not translate for dynamic dimensions, compiling "
+                   << "it for every input shape: " << status.error_message();
+    m_dynamic_dims_failed = true;
+  }
+
+  bool have_template = m_template != nullptr &&
+                       static_signature == m_template_static_signature;
+  if (have_template) {
+    Status status =
+        Builder::InstantiateTemplate(*m_template, input_shapes, ng_function);
+    if (status.ok()) {
+      m_metrics->template_instantiations->Increment();
+      return Status::OK();
+    }
+    NGRAPH_VLOG(2) << "Not using the template of cluster " << m_ngraph_cluster
+                   << ": " << status.error_message();
+  }
+
+  // Translate a template in which the dimensions that changed since the last
+  // translation, or that are unknown in the current template, are unknown,
+  // and instantiate it for these shapes. The graph is translated for them
+  // alone only when that fails.
+  bool use_template =
+      !m_template_failed &&
+      std::getenv("NGRAPH_TF_DISABLE_TRANSLATION_TEMPLATES") == nullptr &&
+      static_signature == m_last_static_signature &&
+      input_shapes.size() == m_last_input_shapes.size();
+  std::vector<PartialTensorShape> template_shapes;
+  for (size_t i = 0; use_template && i < input_shapes.size(); i++) {
+    const TensorShape& shape = input_shapes[i];
+    const TensorShape& last_shape = m_last_input_shapes[i];
+    if (shape.dims() != last_shape.dims()) {
+      use_template = false;
+      break;
+    }
+    ngraph::PartialShape template_shape = ngraph::PartialShape::dynamic();
+    if (have_template) {
+      template_shape = m_template->get_parameters()[i]->get_partial_shape();
+    }
+    bool same_template_rank = template_shape.rank() == shape.dims();
+    std::vector<int64> dims;
+    for (int d = 0; d < shape.dims(); d++) {
+      bool unknown = shape.dim_size(d) != last_shape.dim_size(d) ||
+                     (same_template_rank && template_shape[d].is_dynamic());
+      dims.push_back(unknown ? -1 : shape.dim_size(d));
+    }
+    template_shapes.emplace_back(dims);
+  }
+  m_last_input_shapes = input_shapes;
+  m_last_static_signature = static_signature;
+
+  if (use_template) {
+    std::shared_ptr<ngraph::Function> ng_template;
+    Status status = Builder::TranslateGraphTemplate(
+        template_shapes, static_input_map, m_graph.get(), ng_template);
+    if (status.ok()) {
+      m_template = ng_template;
+      m_template_static_signature = static_signature;
+      status =
+          Builder::InstantiateTemplate(*m_template, input_shapes, ng_function);
+      if (status.ok()) {
+        m_metrics->template_instantiations->Increment();
+        return Status::OK();
+      }
+      NGRAPH_VLOG(2) << "Not using the new template of cluster "
+                     << m_ngraph_cluster << ": " << status.error_message();
+    } else {
+      NGRAPH_VLOG(2) << "Cluster " << m_ngraph_cluster
+                     << " does not translate for unknown dimensions: "
+                     << status.error_message();
+      m_template = nullptr;
+      m_template_failed = true;
+    }
+  }
+
+  return Builder::TranslateGraph(input_shapes, static_input_map,
+                                 m_graph.get(), ng_function);
+}
+
 // Calls ComputeSignature and gets ngraph executable
 Status NGraphEncapsulateImpl::GetNgExecutable(
     const std::vector<Tensor>& tf_input_tensors,
@@ -100,15 +270,28 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
 
   // Translate the TensorFlow graph to nGraph.
   if (it == m_ng_exec_map.end()) {
-    // Measure the current total memory usage
-    long vm, rss, vm0, rss0;
-    MemoryProfile(vm0, rss0);
-
     NGRAPH_VLOG(1) << "Compilation cache miss: " << m_name;
-    TF_RETURN_IF_ERROR(Builder::TranslateGraph(input_shapes, static_input_map,
-                                               &m_graph, ng_function));
+    m_metrics->cache_misses->Increment();
+    Timer compile_time;
+    {
+      NGRAPH_TF_TRACE_SCOPE(TraceEvent::kTranslate, m_ngraph_cluster);
+      TF_RETURN_IF_ERROR(GetNgFunction(input_shapes, static_input_map,
+                                       signature.substr(signature.find('/')),
+                                       ng_function));
+    }
     ng_function->set_friendly_name(m_name);
 
+    // The signature of a cluster that just failed to translate for dynamic
+    // dimensions has to name all of them
+    if (m_dynamic_dims_failed && signature.find('?') != string::npos) {
+      std::vector<TensorShape> shapes;
+      std::vector<const Tensor*> statics;
+      std::stringstream static_signature_ss;
+      TF_RETURN_IF_ERROR(ComputeSignature(tf_input_tensors, shapes, statics,
+                                          static_signature_ss));
+      signature = static_signature_ss.str();
+    }
+
     // Serialize to nGraph if needed
     if (std::getenv("NGRAPH_ENABLE_SERIALIZE") != nullptr) {
       NgraphSerialize("tf_function_" + m_name + ".json", ng_function);
@@ -124,16 +307,30 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
     if (m_ng_exec_map.size() >= m_function_cache_depth_in_items) {
       evicted_ng_exec = m_ng_exec_map[m_lru.back()];
       m_ng_exec_map.erase(m_lru.back());
+      ReleaseFootprint(m_lru.back());
 
       // Call delete function here for the erased func
       backend->remove_compiled_function(evicted_ng_exec);
+      LayerProfiler::ForgetExecutable(evicted_ng_exec.get());
 
       m_lru.pop_back();
+      m_metrics->cache_evictions->Increment();
     }  // cache eviction if cache size greater than cache depth
 
-    NG_TRACE("Compile nGraph", m_name, "");
     try {
-      ng_exec = backend->compile(ng_function);
+      NGRAPH_TF_TRACE_SCOPE(TraceEvent::kCompile, m_ngraph_cluster);
+#if defined(ENABLE_OPENVINO)
+      // The backend makes a static clone of a dynamic function per input
+      // shape, and runs the passes skipped on the dynamic function on it
+      if (ng_function->is_dynamic()) {
+        ng_exec = backend->compile_dynamic(ng_function, Builder::RunPasses,
+                                           LayerProfiler::IsEnabled());
+      } else {
+        ng_exec = backend->compile(ng_function, LayerProfiler::IsEnabled());
+      }
+#else
+      ng_exec = backend->compile(ng_function, LayerProfiler::IsEnabled());
+#endif
     } catch (const std::exception& ex) {
       string fn_name = ng_function->get_friendly_name();
       NgraphSerialize("tf_function_" + fn_name + ".json", ng_function);
@@ -142,21 +339,24 @@ Status NGraphEncapsulateImpl::GetNgExecutable(
 
     SetNgExecMap(signature, ng_exec);
     m_lru.push_front(signature);
+    m_metrics->compile_time_us->Record(compile_time.ElapsedInMicroSec());
 
-    // Memory after
-    MemoryProfile(vm, rss);
-    auto delta_vm_mem = vm - vm0;
-    auto delta_res_mem = rss - rss0;
+    Footprint& footprint = m_footprints[signature];
+    EstimateFootprint(*ng_function, &footprint.executable_bytes,
+                      &footprint.constant_bytes);
+    m_metrics->executable_bytes->Add(footprint.executable_bytes);
+    m_metrics->constant_bytes->Add(footprint.constant_bytes);
     NGRAPH_VLOG(1) << "NGRAPH_TF_CACHE_PROFILE: OP_ID: " << my_instance_id
                    << " Cache length: " << m_ng_exec_map.size()
-                   << " Cluster: " << m_name << " Delta VM: " << delta_vm_mem
-                   << " Delta RSS: " << delta_res_mem
-                   << " KB Total RSS: " << rss / (1024 * 1024) << " GB "
-                   << " VM: " << vm / (1024 * 1024) << " GB" << endl;
+                   << " Cluster: " << m_name << " Executable: "
+                   << footprint.executable_bytes / 1024
+                   << " KB Constants: " << footprint.constant_bytes / 1024
+                   << " KB";
   }  // end of input signature not found in m_ng_exec_map
   else {
     // Found the input signature in m_ng_exec_map, use the cached executable
     // Update the m_lru
+    m_metrics->cache_hits->Increment();
     if (signature != m_lru.front()) {
       m_lru.remove(signature);
       m_lru.push_front(signature);
@@ -211,7 +411,13 @@ Status NGraphEncapsulateImpl::ParseNodeAttributes(
 }
 
 void NGraphEncapsulateImpl::NGraphEncapsulateImpl::ClearExecMaps() {
+  for (const auto& kv : m_ng_exec_map) {
+    LayerProfiler::ForgetExecutable(kv.second.get());
+  }
   m_ng_exec_map.clear();
+  while (!m_footprints.empty()) {
+    ReleaseFootprint(m_footprints.begin()->first);
+  }
 }
 
 }  // namespace ngraph_bridge
@@ -28,6 +28,7 @@
 
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/ngraph_executable.h"
+#include "ngraph_bridge/ngraph_metrics.h"
 
 namespace tensorflow {
 namespace ngraph_bridge {
@@ -69,7 +70,12 @@ class NGraphEncapsulateImpl {
 
   const int& GetNgraphCluster() { return m_ngraph_cluster; }
 
-  void SetNgraphCluster(const int& cluster) { m_ngraph_cluster = cluster; }
+  void SetNgraphCluster(const int& cluster) {
+    m_ngraph_cluster = cluster;
+    m_metrics.reset(new ClusterMetrics(cluster));
+  }
+
+  ClusterMetrics& GetMetrics() { return *m_metrics; }
 
   const int& GetFunctionCache() { return m_function_cache_depth_in_items; }
 
@@ -109,8 +115,9 @@ class NGraphEncapsulateImpl {
       const google::protobuf::Map<string, AttrValue>& additional_attributes,
       std::unordered_map<std::string, std::string>* additional_attribute_map);
 
-  // TF Graph for the cluster
-  Graph m_graph;
+  // TF Graph for the cluster. Usually shared with NGraphClusterManager, so it
+  // is never modified.
+  std::shared_ptr<const Graph> m_graph;
 
  private:
   int m_ngraph_cluster{-1};
@@ -122,8 +129,48 @@ class NGraphEncapsulateImpl {
   string m_name;
   std::vector<bool> m_input_is_static;
   std::list<std::string> m_lru;
+  std::unique_ptr<ClusterMetrics> m_metrics;
   static int s_instance_count;
 
+  // Bytes held by a cached executable, as added to the cluster's gauges
+  struct Footprint {
+    int64 executable_bytes;
+    int64 constant_bytes;
+  };
+  std::unordered_map<std::string, Footprint> m_footprints;
+  void ReleaseFootprint(const std::string& signature);
+
+  // Makes the nGraph function for the given inputs, from m_template if they
+  // fit it, and by translating m_graph otherwise. static_signature is the
+  // part of the signature that stands for the static inputs.
+  Status GetNgFunction(const std::vector<TensorShape>& input_shapes,
+                       const std::vector<const Tensor*>& static_input_map,
+                       const std::string& static_signature,
+                       std::shared_ptr<ngraph::Function>& ng_function);
+
+  // A translation of m_graph in which the input dimensions that differed
+  // between translations for the same static inputs are unknown, see
+  // Builder::TranslateGraphTemplate. A new batch size, say, then makes a
+  // clone of it rather than a new translation.
+  std::shared_ptr<ngraph::Function> m_template;
+  std::string m_template_static_signature;
+  // Set once the graph failed to translate for unknown dimensions
+  bool m_template_failed = false;
+  // The inputs of the last translation
+  std::vector<TensorShape> m_last_input_shapes;
+  std::string m_last_static_signature;
+
+  // The dimensions of NGRAPH_TF_DYNAMIC_DIMS, which are translated as
+  // dynamic ones for all non-static inputs if the backend supports that
+  // (see BackendManager::SupportsDynamicDimensions). The executable then
+  // serves every size of them.
+  std::vector<int> m_dynamic_dims;
+  // Set once the graph failed to translate for dynamic dimensions, after
+  // which it is compiled for every input shape
+  bool m_dynamic_dims_failed = false;
+  bool UseDynamicDims();
+  bool IsDynamicDim(int input, int dim) const;
+
   std::unordered_map<std::string, std::shared_ptr<Executable>> m_ng_exec_map;
 };
 
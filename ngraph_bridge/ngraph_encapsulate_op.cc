@@ -36,8 +36,10 @@
 #include "ngraph_bridge/ngraph_encapsulate_impl.h"
 #include "ngraph_bridge/ngraph_encapsulate_op.h"
 #include "ngraph_bridge/ngraph_executable.h"
+#include "ngraph_bridge/ngraph_layer_profiler.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
 #include "ngraph_bridge/ngraph_timer.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
 using namespace std;
@@ -55,23 +57,18 @@ NGraphEncapsulateOp::NGraphEncapsulateOp(OpKernelConstruction* ctx)
   NGRAPH_VLOG(1) << "Create Executor " << name();
   ng_encap_impl_.SetName(name());
 
-  std::ostringstream oss;
-  oss << "Encapsulate_" << ng_encap_impl_.GetInstanceId() << ": " << name();
-
-  NG_TRACE(oss.str(), name(), "");
-
   NGRAPH_VLOG(1) << "NGraphEncapsulateOp: " << ng_encap_impl_.GetInstanceId()
                  << " Name: " << name();
 
-  GraphDef* graph_def;
-
   int cluster{-1};
   OP_REQUIRES_OK(ctx, ctx->GetAttr<int>("ngraph_cluster", &cluster));
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kEncapsulateCreate, cluster);
   ng_encap_impl_.SetNgraphCluster(cluster);
-  graph_def =
-      NGraphClusterManager::GetClusterGraph(ng_encap_impl_.GetNgraphCluster());
+  Status cluster_status = NGraphClusterManager::AcquireCluster(
+      ng_encap_impl_.GetNgraphCluster(), ng_encap_impl_.m_graph);
+  m_cluster_acquired_ = cluster_status.ok();
 
-  if (graph_def == nullptr) {
+  if (errors::IsNotFound(cluster_status)) {
     string flib_key =
         "ngraph_cluster_" + to_string(ng_encap_impl_.GetNgraphCluster());
     // Read graphdef from function library
@@ -92,12 +89,12 @@ NGraphEncapsulateOp::NGraphEncapsulateOp(OpKernelConstruction* ctx)
     if (!status.ok()) {
       NGRAPH_VLOG(2) << "FunctionDefToBodyHelper returned a not ok status.";
     }
-    CopyGraph(*fnbody->graph, &ng_encap_impl_.m_graph);
+    // The graph keeps the library, for the functions of control flow ops
+    auto graph = std::make_shared<Graph>(flib);
+    CopyGraph(*fnbody->graph, graph.get());
+    ng_encap_impl_.m_graph = graph;
   } else {
-    GraphConstructorOptions opts;
-    opts.allow_internal_ops = true;
-    OP_REQUIRES_OK(
-        ctx, ConvertGraphDefToGraph(opts, *graph_def, &ng_encap_impl_.m_graph));
+    OP_REQUIRES_OK(ctx, cluster_status);
   }
 
   int graph_id{-1};
@@ -115,7 +112,7 @@ NGraphEncapsulateOp::NGraphEncapsulateOp(OpKernelConstruction* ctx)
   int32 max_arg_index = -1;
   std::vector<const Node*> arg_nodes;
 
-  for (auto node : ng_encap_impl_.m_graph.nodes()) {
+  for (auto node : ng_encap_impl_.m_graph->nodes()) {
     if (node->type_string() == "_Arg") {
       arg_nodes.push_back(node);
 
@@ -161,18 +158,28 @@ NGraphEncapsulateOp::NGraphEncapsulateOp(OpKernelConstruction* ctx)
   auto node_def = ctx->def();
   OP_REQUIRES_OK(ctx, ng_encap_impl_.ParseNodeAttributes(
                           node_def.attr(), &additional_attribute_map));
+
+  Status capture_status = ClusterCapture::Create(
+      name(), cluster, graph_id, ng_encap_impl_.GetInstanceId(),
+      *ng_encap_impl_.m_graph, ng_encap_impl_.GetStaticInputVector(),
+      &m_capture_);
+  if (!capture_status.ok()) {
+    NGRAPH_VLOG(0) << "Cannot capture " << name() << ": "
+                   << capture_status.error_message();
+  }
 }
 
 //---------------------------------------------------------------------------
 //  ~NGraphEncapsulateOp()
 //---------------------------------------------------------------------------
 NGraphEncapsulateOp::~NGraphEncapsulateOp() {
-  std::ostringstream oss;
-  oss << "Destroy Encapsulate_" << ng_encap_impl_.GetInstanceId() << ": "
-      << name();
-  NG_TRACE(oss.str(), name(), "");
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kEncapsulateDestroy,
+                        ng_encap_impl_.GetNgraphCluster());
   NGRAPH_VLOG(2) << "~NGraphEncapsulateOp::" << name();
   ng_encap_impl_.ClearExecMaps();
+  if (m_cluster_acquired_) {
+    NGraphClusterManager::ReleaseCluster(ng_encap_impl_.GetNgraphCluster());
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -180,16 +187,13 @@ NGraphEncapsulateOp::~NGraphEncapsulateOp() {
 //---------------------------------------------------------------------------
 void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
   NGRAPH_VLOG(1) << "Compute using Executor " << name();
-  std::ostringstream oss;
-  oss << "Execute: Encapsulate_" << ng_encap_impl_.GetInstanceId() << ": "
-      << name();
-  NG_TRACE(oss.str(), name(), "");
+  const int cluster = ng_encap_impl_.GetNgraphCluster();
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kCompute, cluster);
 
-  Timer compute_time;
   std::lock_guard<std::mutex> lock(m_compute_lock_);
   NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute starting for cluster "
                  << ng_encap_impl_.GetNgraphCluster();
-  int time_func_create_or_lookup;
+  ClusterMetrics& metrics = ng_encap_impl_.GetMetrics();
   Timer function_lookup_or_create;
 
   std::vector<TensorShape> input_shapes;
@@ -199,15 +203,28 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
 
   // TF input tensor
   std::vector<Tensor> tf_input_tensors;
+  int64 ng_input_tensor_size_in_bytes = 0;
   int step_id;
   {
-    NG_TRACE("FunctionMaybeCreate", name(), "");
+    NGRAPH_TF_TRACE_SCOPE(TraceEvent::kGetExecutable, cluster);
     for (int i = 0; i < ctx->num_inputs(); i++) {
       tf_input_tensors.push_back(ctx->input(i));
+      ng_input_tensor_size_in_bytes += ctx->input(i).TotalBytes();
     }
 
     step_id = ctx->step_id();
 
+    if (m_capture_ != nullptr) {
+      Status capture_status = m_capture_->AddStep(tf_input_tensors);
+      if (!capture_status.ok()) {
+        NGRAPH_VLOG(0) << "Stopped capturing " << name() << ": "
+                       << capture_status.error_message();
+      }
+      if (!capture_status.ok() || m_capture_->Done()) {
+        m_capture_.reset();
+      }
+    }
+
     // Get ngraph executable and inputs information
     OP_REQUIRES_OK(ctx, ng_encap_impl_.GetNgExecutable(
                             tf_input_tensors, input_shapes, static_input_map,
@@ -218,7 +235,8 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
         << "NGraphEncapsulateOp::Compute got ngraph executable for cluster "
         << ng_encap_impl_.GetNgraphCluster();
 
-    time_func_create_or_lookup = function_lookup_or_create.ElapsedInMS();
+    metrics.lookup_time_us->Record(
+        function_lookup_or_create.ElapsedInMicroSec());
   }
 
   NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute got graph for cluster "
@@ -228,37 +246,30 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
 
   // Allocate tensors for input arguments.
   vector<shared_ptr<ngraph::runtime::Tensor>> ng_inputs;
-  int ng_input_tensor_size_in_bytes = 0;
+  ScopedGaugeAdd held_tensor_bytes(metrics.tensor_bytes);
   {
-    NG_TRACE("Input: maybe create", name(), "");
+    NGRAPH_TF_TRACE_SCOPE(TraceEvent::kInputTensors, cluster);
     OP_REQUIRES_OK(
         ctx, ng_encap_impl_.AllocateNGTensors(tf_input_tensors, ng_inputs));
   }
+  held_tensor_bytes.Add(ng_input_tensor_size_in_bytes);
 
   NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute allocated argument tensors "
                     "for cluster "
                  << ng_encap_impl_.GetNgraphCluster();
-  // Allocate tensors for the output results.
+  // Allocate tensors for the output results. Outputs whose shape depends on
+  // parametric inputs are only known after the call; the backend allocates
+  // those, and they are copied into TF tensors below.
   vector<shared_ptr<ngraph::runtime::Tensor>> ng_outputs;
-  int ng_output_tensor_size_in_bytes = 0;
-  std::vector<Tensor> tf_output_tensors;
+  std::vector<int> dynamic_outputs;
+  int64 ng_output_tensor_size_in_bytes = 0;
   {
-    NG_TRACE("Output: maybe create", name(), "");
+    NGRAPH_TF_TRACE_SCOPE(TraceEvent::kOutputTensors, cluster);
+    auto backend = BackendManager::GetBackend();
     for (auto i = 0; i < ng_exec->get_results().size(); i++) {
       auto ng_element = ng_exec->get_results()[i];
-      auto ng_shape = ng_element->get_shape();
       auto ng_element_type = ng_element->get_element_type();
 
-      // Create the TF output tensor
-      vector<int64> dims;
-      for (auto dim : ng_shape) {
-        dims.push_back(dim);
-      }
-      TensorShape tf_shape(dims);
-      Tensor* output_tensor = nullptr;
-      OP_REQUIRES_OK(ctx, ctx->allocate_output(i, tf_shape, &output_tensor));
-      tf_output_tensors.push_back(*output_tensor);
-
       // Make sure the nGraph-inferred element type agrees with what TensorFlow
       // expected.
       ngraph::element::Type expected_elem_type;
@@ -269,21 +280,39 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
           ctx, ng_element_type == expected_elem_type,
           errors::Internal("Element type inferred by nGraph does not match "
                            "the element type expected by TensorFlow"));
-    }
 
-    OP_REQUIRES_OK(
-        ctx, ng_encap_impl_.AllocateNGTensors(tf_output_tensors, ng_outputs));
+      auto ng_partial_shape = ng_element->get_output_partial_shape(0);
+      if (ng_partial_shape.is_dynamic()) {
+        dynamic_outputs.push_back(i);
+        ng_outputs.push_back(
+            backend->create_dynamic_tensor(ng_element_type, ng_partial_shape));
+        continue;
+      }
+
+      // Create the TF output tensor
+      vector<int64> dims;
+      for (auto dim : ng_partial_shape.to_shape()) {
+        dims.push_back(dim);
+      }
+      TensorShape tf_shape(dims);
+      Tensor* output_tensor = nullptr;
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(i, tf_shape, &output_tensor));
+      ng_output_tensor_size_in_bytes += output_tensor->TotalBytes();
+      OP_REQUIRES_OK(ctx, ng_encap_impl_.AllocateNGTensors({*output_tensor},
+                                                           ng_outputs));
+    }
   }
   NGRAPH_VLOG(4)
       << "NGraphEncapsulateOp::Compute allocated result tensors for cluster "
       << ng_encap_impl_.GetNgraphCluster();
 
-  int time_create_or_lookup_tensors = create_or_lookup_tensors.ElapsedInMS();
+  held_tensor_bytes.Add(ng_output_tensor_size_in_bytes);
+  metrics.tensor_wrap_time_us->Record(
+      create_or_lookup_tensors.ElapsedInMicroSec());
 
   // Execute the nGraph function.
-  int time_execute_function;
   {
-    NG_TRACE("Execute nGraph", name(), "");
+    NGRAPH_TF_TRACE_SCOPE(TraceEvent::kExecute, cluster);
     Timer execute_function;
     {
       NGRAPH_VLOG(4)
@@ -308,18 +337,28 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
         OP_REQUIRES(ctx, false, errors::Internal(status_string));
       }
     }
-    time_execute_function = execute_function.ElapsedInMS();
+    metrics.execute_time_us->Record(execute_function.ElapsedInMicroSec());
   }
 
-  long vm, rss;
-  MemoryProfile(vm, rss);
-  NGRAPH_VLOG(1) << "NGRAPH_TF_MEM_PROFILE:  OP_ID: "
-                 << ng_encap_impl_.GetInstanceId() << " Step_ID: " << step_id
-                 << " Cluster: " << name() << " Input Tensors created: "
-                 << ng_input_tensor_size_in_bytes / (1024 * 1024) << " MB"
-                 << " Output Tensors created: "
-                 << ng_output_tensor_size_in_bytes / (1024 * 1024) << " MB"
-                 << " Total process memory: " << rss / (1024 * 1024) << " GB";
+  if (LayerProfiler::IsEnabled()) {
+    LayerProfiler::Collect(ng_encap_impl_.GetGraphId(), cluster,
+                           *ng_encap_impl_.m_graph, ng_exec);
+  }
+
+  for (auto i : dynamic_outputs) {
+    auto ng_output = ng_outputs[i];
+    vector<int64> dims;
+    for (auto dim : ng_output->get_shape()) {
+      dims.push_back(dim);
+    }
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(i, TensorShape(dims), &output_tensor));
+    ng_output->read(output_tensor->data(), output_tensor->TotalBytes());
+    ng_output_tensor_size_in_bytes += output_tensor->TotalBytes();
+  }
+  metrics.input_bytes->Increment(ng_input_tensor_size_in_bytes);
+  metrics.output_bytes->Increment(ng_output_tensor_size_in_bytes);
 
   NGRAPH_VLOG(4) << "NGraphEncapsulateOp::Compute call done for cluster "
                  << ng_encap_impl_.GetNgraphCluster();
@@ -327,14 +366,6 @@ void NGraphEncapsulateOp::Compute(OpKernelContext* ctx) {
   NGRAPH_VLOG(4)
       << "NGraphEncapsulateOp::Compute done marking fresh for cluster "
       << ng_encap_impl_.GetNgraphCluster();
-  NGRAPH_VLOG(1) << "NGRAPH_TF_TIMING_PROFILE: OP_ID: "
-                 << ng_encap_impl_.GetInstanceId() << " Step_ID: " << step_id
-                 << " Cluster: " << name()
-                 << " Time-Compute: " << compute_time.ElapsedInMS()
-                 << " Function-Create-or-Lookup: " << time_func_create_or_lookup
-                 << " Create-and-copy-tensors: "
-                 << time_create_or_lookup_tensors
-                 << " Execute: " << time_execute_function;
 }  // end compute
 
 int NGraphEncapsulateImpl::s_instance_count = 0;
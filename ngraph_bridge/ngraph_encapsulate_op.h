@@ -26,6 +26,7 @@
 
 #include "logging/ngraph_log.h"
 #include "ngraph/ngraph.hpp"
+#include "ngraph_bridge/ngraph_capture.h"
 #include "ngraph_bridge/ngraph_encapsulate_impl.h"
 
 namespace tensorflow {
@@ -41,6 +42,11 @@ class NGraphEncapsulateOp : public OpKernel {
   static int s_instance_id;
   NGraphEncapsulateImpl ng_encap_impl_;
   std::mutex m_compute_lock_;
+  // Whether the cluster graph was acquired from NGraphClusterManager (as
+  // opposed to rebuilt from the function library) and must be released.
+  bool m_cluster_acquired_ = false;
+  // Set while the inputs of this op are being captured
+  std::unique_ptr<ClusterCapture> m_capture_;
 };
 
 }  // namespace ngraph_bridge
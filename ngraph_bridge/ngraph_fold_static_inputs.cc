@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <deque>
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/eval_const_tensor.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/control_flow.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_api.h"
+#include "ngraph_bridge/ngraph_fold_static_inputs.h"
+#include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+//
+// AssignClusters cuts a cluster wherever a static input is not fed by a Const
+// (the value has to be known when the cluster is compiled). Models that
+// compute their reshape targets from the shapes of other tensors, e.g.
+//
+//   Shape -> StridedSlice -> Pack -> Reshape
+//
+// therefore end up in many small clusters, even though the shapes involved
+// are often fully known before the graph ever runs. This pass uses TF shape
+// inference to evaluate such static inputs, and when that succeeds replaces
+// them with a Const, which AssignClusters happily merges into the cluster.
+//
+// Only inputs in the root frame are folded, and only if the value is small
+// (it is a shape, after all). The pass can be bypassed by setting
+// NGRAPH_TF_DISABLE_FOLD_STATIC_INPUTS=1.
+//
+
+static const int64 MAX_FOLDED_ELEMENTS = 1024;
+
+// Removes the nodes that used to compute the folded inputs, walking up from
+// them for as long as nodes are left without consumers.
+static void RemoveDeadProducers(Graph* graph, const std::vector<int>& node_ids,
+                                const std::set<string>& skip_these_nodes) {
+  std::deque<int> worklist(node_ids.begin(), node_ids.end());
+  while (!worklist.empty()) {
+    Node* node = graph->FindNodeId(worklist.front());
+    worklist.pop_front();
+    if (node == nullptr || !node->IsOp() || node->op_def().is_stateful() ||
+        skip_these_nodes.count(node->name()) != 0) {
+      continue;
+    }
+
+    bool has_consumers = false;
+    for (auto edge : node->out_edges()) {
+      if (!edge->dst()->IsSink()) {
+        has_consumers = true;
+        break;
+      }
+    }
+    if (has_consumers) {
+      continue;
+    }
+
+    for (auto edge : node->in_edges()) {
+      worklist.push_back(edge->src()->id());
+    }
+    NGRAPH_VLOG(5) << "Removing " << node->name()
+                   << " after folding its consumers";
+    graph->RemoveNode(node);
+  }
+}
+
+Status FoldStaticInputs(Graph* graph,
+                        const std::set<string>& skip_these_nodes) {
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kFoldStaticInputs);
+  if (std::getenv("NGRAPH_TF_DISABLE_FOLD_STATIC_INPUTS") != nullptr) {
+    return Status::OK();
+  }
+  // Folded inputs become Consts, which have to go to nGraph along with their
+  // consumer.
+  if (config::GetDisabledOps().count("Const") != 0) {
+    return Status::OK();
+  }
+
+  std::vector<const Edge*> static_edges;
+  for (auto node : graph->op_nodes()) {
+    if (!NodeIsMarkedForClustering(node)) {
+      continue;
+    }
+    std::vector<int32> static_inputs;
+    GetStaticInputs(node, &static_inputs);
+    if (static_inputs.empty()) {
+      continue;
+    }
+    std::vector<const Edge*> in_edges;
+    TF_RETURN_IF_ERROR(node->input_edges(&in_edges));
+    for (auto index : static_inputs) {
+      if (in_edges[index]->src()->type_string() != "Const") {
+        static_edges.push_back(in_edges[index]);
+      }
+    }
+  }
+  if (static_edges.empty()) {
+    return Status::OK();
+  }
+
+  std::vector<ControlFlowInfo> control_flow_info;
+  TF_RETURN_IF_ERROR(BuildControlFlowInfo(graph, &control_flow_info));
+
+  // Nodes whose shape function fails (or whose inputs failed) simply stay
+  // unknown, and anything that depends on them does not get folded.
+  ShapeRefiner refiner(graph->versions(), graph->op_registry());
+  refiner.set_require_shape_inference_fns(false);
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph, &order);
+  for (auto node : order) {
+    Status status = refiner.AddNode(node);
+    if (!status.ok()) {
+      NGRAPH_VLOG(5) << "No shape inference for " << node->name() << ": "
+                     << status.error_message();
+    }
+  }
+
+  std::unordered_map<string, Tensor> cached_values;
+  std::vector<int> folded_producers;
+  for (auto edge : static_edges) {
+    Node* src = edge->src();
+    Node* dst = edge->dst();
+    int src_output = edge->src_output();
+    int dst_input = edge->dst_input();
+
+    if (!control_flow_info[dst->id()].frame_name.empty()) {
+      continue;
+    }
+
+    bool evaluated = false;
+    Tensor result;
+    Status status = EvaluateConstantTensor(
+        OutputTensor(src, src_output), refiner, *graph->op_registry(),
+        graph->versions().producer(), &evaluated, &result,
+        /*graph_runner=*/nullptr, &cached_values);
+    if (!status.ok() || !evaluated ||
+        result.NumElements() > MAX_FOLDED_ELEMENTS) {
+      continue;
+    }
+
+    Node* folded;
+    TF_RETURN_IF_ERROR(
+        NodeBuilder(graph->NewName(dst->name() + "/ngraph_folded"), "Const")
+            .Attr("dtype", result.dtype())
+            .Attr("value", result)
+            .Attr("_ngraph_marked_for_clustering", true)
+            .Device(dst->requested_device())
+            .Finalize(graph, &folded));
+    folded->set_assigned_device_name(dst->assigned_device_name());
+    TF_RETURN_IF_ERROR(graph->UpdateEdge(folded, 0, dst, dst_input));
+
+    NGRAPH_VLOG(4) << "Folded static input " << dst_input << " of "
+                   << dst->name() << " (" << src->name() << ":" << src_output
+                   << ") into " << folded->name();
+    folded_producers.push_back(src->id());
+  }
+
+  RewriteReport::Count("static_inputs_folded", folded_producers.size());
+  RemoveDeadProducers(graph, folded_producers, skip_these_nodes);
+  FixupSourceAndSinkEdges(graph);
+  return Status::OK();
+}
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,38 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_FOLD_STATIC_INPUTS_H_
+#define NGRAPH_TF_BRIDGE_FOLD_STATIC_INPUTS_H_
+#pragma once
+
+#include <set>
+
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+// Replaces static inputs of marked nodes that TF shape inference can
+// evaluate (e.g. Shape -> StridedSlice -> Pack feeding a Reshape) with Consts,
+// and removes whatever computed them if nothing else needs it. Must run after
+// MarkForClustering and before AssignClusters.
+Status FoldStaticInputs(Graph* graph,
+                        const std::set<string>& skip_these_nodes);
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_FOLD_STATIC_INPUTS_H_
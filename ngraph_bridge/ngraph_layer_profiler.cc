@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_layer_profiler.h"
+
+#if defined(ENABLE_OPENVINO)
+#include "ngraph_bridge/ie_executable.h"
+#endif
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+std::map<LayerProfiler::NodeKey, LayerProfiler::NodeTime>
+    LayerProfiler::s_node_times;
+std::map<std::pair<int, int>, std::unordered_map<std::string, std::string>>
+    LayerProfiler::s_op_types;
+std::map<const Executable*, std::unordered_map<std::string, int64>>
+    LayerProfiler::s_last_totals;
+std::mutex LayerProfiler::s_mutex;
+
+static const char* ProfileFile() {
+  return std::getenv("NGRAPH_TF_LAYER_PROFILE");
+}
+
+bool LayerProfiler::IsEnabled() {
+  static bool enabled = []() {
+    if (ProfileFile() == nullptr) {
+      return false;
+    }
+    std::atexit([]() {
+      Status status = DumpReport(ProfileFile());
+      if (!status.ok()) {
+        NGRAPH_VLOG(0) << "Could not write layer profile: "
+                       << status.error_message();
+      }
+    });
+    return true;
+  }();
+  return enabled;
+}
+
+// The TF nodes a layer was translated from. Nodes made by the bridge carry
+// the TF node name as provenance tag, and in their friendly name as
+// "<tf node>/<ng node>", which is also what IE names the layers after.
+static vector<string> TFNodesOf(const LayerSample& sample) {
+  vector<string> tf_nodes;
+  string name = sample.layer;
+  if (sample.node != nullptr) {
+    for (const auto& tag : sample.node->get_provenance_tags()) {
+      tf_nodes.push_back(tag);
+    }
+    name = sample.node->get_friendly_name();
+  }
+  if (tf_nodes.empty()) {
+    auto pos = name.rfind('/');
+    tf_nodes.push_back(pos == string::npos ? name : name.substr(0, pos));
+  }
+  std::sort(tf_nodes.begin(), tf_nodes.end());
+  return tf_nodes;
+}
+
+void LayerProfiler::Collect(int graph_id, int cluster, const Graph& graph,
+                            const shared_ptr<Executable>& ng_exec) {
+  vector<LayerSample> samples;
+#if defined(ENABLE_OPENVINO)
+  auto ie_exec = std::dynamic_pointer_cast<IE_Executable>(ng_exec);
+  if (ie_exec == nullptr) {
+    return;
+  }
+  auto perf_counts = ie_exec->get_performance_counts();
+  if (perf_counts.empty()) {
+    return;
+  }
+  std::unordered_map<string, shared_ptr<const ngraph::Node>> nodes_by_name;
+  for (const auto& node : ie_exec->get_function()->get_ops()) {
+    nodes_by_name[node->get_friendly_name()] = node;
+  }
+  for (const auto& kv : perf_counts) {
+    const auto& info = kv.second;
+    if (info.status != InferenceEngine::InferenceEngineProfileInfo::EXECUTED) {
+      continue;
+    }
+    auto it = nodes_by_name.find(kv.first);
+    samples.push_back({kv.first, info.layer_type,
+                       it == nodes_by_name.end() ? nullptr : it->second,
+                       info.realTime_uSec});
+  }
+#else
+  {
+    std::lock_guard<std::mutex> guard(s_mutex);
+    auto& last_totals = s_last_totals[ng_exec.get()];
+    for (const auto& counter : ng_exec->get_performance_data()) {
+      auto node = counter.get_node();
+      int64 total = counter.total_microseconds();
+      int64& last = last_totals[node->get_name()];
+      int64 delta = total >= last ? total - last : total;
+      last = total;
+      samples.push_back(
+          {node->get_friendly_name(), node->description(), node, delta});
+    }
+  }
+#endif
+  Record(graph_id, cluster, graph, samples);
+}
+
+void LayerProfiler::Record(int graph_id, int cluster, const Graph& graph,
+                           const vector<LayerSample>& samples) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  auto& op_types = s_op_types[std::make_pair(graph_id, cluster)];
+  if (op_types.empty()) {
+    for (const auto* node : graph.op_nodes()) {
+      op_types[node->name()] = node->type_string();
+    }
+  }
+
+  // Add up this step first, so that a node made of several layers counts
+  // as one step
+  std::map<string, int64> step_times;
+  std::map<string, string> layer_types;
+  for (const auto& sample : samples) {
+    auto tf_nodes = TFNodesOf(sample);
+    for (const auto& tf_node : tf_nodes) {
+      step_times[tf_node] += sample.time_us / tf_nodes.size();
+      layer_types.emplace(tf_node, sample.layer_type);
+    }
+  }
+
+  for (const auto& kv : step_times) {
+    NodeTime& node_time =
+        s_node_times[std::make_tuple(graph_id, cluster, kv.first)];
+    if (node_time.steps == 0) {
+      // Nodes outside the cluster (the sources of its inputs) and nodes the
+      // backend made up go by the backend's layer type
+      auto it = op_types.find(kv.first);
+      node_time.op_type = it != op_types.end()
+                              ? it->second
+                              : "(" + layer_types[kv.first] + ")";
+    }
+    node_time.time_us += kv.second;
+    node_time.steps++;
+  }
+}
+
+string LayerProfiler::Report(int max_nodes) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  vector<pair<const NodeKey*, const NodeTime*>> nodes;
+  std::map<string, pair<int64, int>> op_types;
+  int64 total_us = 0;
+  for (const auto& kv : s_node_times) {
+    nodes.emplace_back(&kv.first, &kv.second);
+    auto& op_type = op_types[kv.second.op_type];
+    op_type.first += kv.second.time_us;
+    op_type.second++;
+    total_us += kv.second.time_us;
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const pair<const NodeKey*, const NodeTime*>& a,
+               const pair<const NodeKey*, const NodeTime*>& b) {
+              return a.second->time_us > b.second->time_us;
+            });
+  vector<pair<string, pair<int64, int>>> ranked_op_types(op_types.begin(),
+                                                         op_types.end());
+  std::sort(ranked_op_types.begin(), ranked_op_types.end(),
+            [](const pair<string, pair<int64, int>>& a,
+               const pair<string, pair<int64, int>>& b) {
+              return a.second.first > b.second.first;
+            });
+
+  auto percent = [total_us](int64 time_us) {
+    return total_us == 0 ? 0.0 : 100.0 * time_us / total_us;
+  };
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "Backend time by TF op type (total " << total_us / 1000.0
+      << " ms)\n";
+  out << std::setw(12) << "time (ms)" << std::setw(8) << "%" << std::setw(8)
+      << "nodes"
+      << "  op type\n";
+  for (const auto& op_type : ranked_op_types) {
+    out << std::setw(12) << op_type.second.first / 1000.0 << std::setw(8)
+        << std::setprecision(1) << percent(op_type.second.first)
+        << std::setprecision(3) << std::setw(8) << op_type.second.second
+        << "  " << op_type.first << "\n";
+  }
+
+  out << "\nBackend time by TF node\n";
+  out << std::setw(6) << "rank" << std::setw(12) << "time (ms)"
+      << std::setw(8) << "%" << std::setw(12) << "avg (us)" << std::setw(7)
+      << "graph" << std::setw(9) << "cluster"
+      << "  op type  node\n";
+  int rank = 0;
+  for (const auto& node : nodes) {
+    if (max_nodes > 0 && rank == max_nodes) {
+      break;
+    }
+    const NodeKey& key = *node.first;
+    const NodeTime& node_time = *node.second;
+    out << std::setw(6) << ++rank << std::setw(12)
+        << node_time.time_us / 1000.0 << std::setw(8) << std::setprecision(1)
+        << percent(node_time.time_us) << std::setw(12)
+        << static_cast<double>(node_time.time_us) / node_time.steps
+        << std::setprecision(3) << std::setw(7) << std::get<0>(key)
+        << std::setw(9) << std::get<1>(key) << "  " << node_time.op_type
+        << "  " << std::get<2>(key) << "\n";
+  }
+  return out.str();
+}
+
+void LayerProfiler::ForgetExecutable(const Executable* ng_exec) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_last_totals.erase(ng_exec);
+}
+
+Status LayerProfiler::DumpReport(const string& path) {
+  return WriteStringToFile(Env::Default(), path, Report());
+}
+
+void LayerProfiler::Reset() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_node_times.clear();
+  s_op_types.clear();
+  s_last_totals.clear();
+}
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
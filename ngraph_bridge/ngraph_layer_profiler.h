@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_LAYER_PROFILER_H_
+#define NGRAPH_TF_BRIDGE_LAYER_PROFILER_H_
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+
+#include "ngraph/ngraph.hpp"
+
+#include "ngraph_bridge/ngraph_executable.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+// Time the backend spent in one of its layers during one call. node is the
+// nGraph node the layer came from, if the backend can tell (an IE layer may
+// be the fusion of several nodes, or something IE inserted).
+struct LayerSample {
+  std::string layer;
+  std::string layer_type;
+  std::shared_ptr<const ngraph::Node> node;
+  int64 time_us;
+};
+
+//
+// Collects the per-layer times the backend reports after each call and adds
+// them up by the TF node each layer was translated from (going by the
+// provenance tags Builder::SetTracingInfo puts on every nGraph node). Nodes
+// are told apart by graph id, cluster and name, since cluster indices are
+// reused and node names repeat across graphs.
+//
+// Enabled by NGRAPH_TF_LAYER_PROFILE=<file>, which also makes the bridge
+// compile every cluster with performance data on, and writes Report() to
+// <file> at exit.
+//
+class LayerProfiler {
+ public:
+  static bool IsEnabled();
+
+  // Collects the times of the last call of ng_exec, which was compiled from
+  // the TF graph of cluster.
+  static void Collect(int graph_id, int cluster, const Graph& graph,
+                      const std::shared_ptr<Executable>& ng_exec);
+  static void Record(int graph_id, int cluster, const Graph& graph,
+                     const std::vector<LayerSample>& samples);
+  // Drops what is kept about ng_exec; called when it is evicted.
+  static void ForgetExecutable(const Executable* ng_exec);
+
+  // Ranks the TF op types, and then the TF nodes, by total backend time.
+  // max_nodes limits the number of nodes listed (0 lists all).
+  static std::string Report(int max_nodes = 0);
+  static Status DumpReport(const std::string& path);
+  static void Reset();
+
+ private:
+  struct NodeTime {
+    std::string op_type;
+    int64 time_us = 0;
+    int64 steps = 0;
+  };
+  // (graph id, cluster, TF node name)
+  using NodeKey = std::tuple<int, int, std::string>;
+
+  static std::map<NodeKey, NodeTime> s_node_times;
+  // Op type of every node in every profiled (graph id, cluster)
+  static std::map<std::pair<int, int>,
+                  std::unordered_map<std::string, std::string>>
+      s_op_types;
+  // nGraph backends report running totals, so remember the last ones of
+  // every node of every live executable
+  static std::map<const Executable*, std::unordered_map<std::string, int64>>
+      s_last_totals;
+  static std::mutex s_mutex;
+};
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_LAYER_PROFILER_H_
@@ -19,7 +19,10 @@
 #include "ngraph_bridge/default_opset.h"
 #include "ngraph_bridge/ngraph_api.h"
 #include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_control_flow.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/ngraph_version_utils.h"
 
@@ -107,16 +110,77 @@ static inline void SetStaticInputs(Node* n, std::vector<int32> inputs) {
   n->AddAttr("_ngraph_static_inputs", inputs);
 }
 
+// Whether every op that the output of node reaches inside nGraph translates
+// with inputs of a dynamic shape, which is what parametric inputs give node's
+// output. Ops outside nGraph get the output as a TF tensor of a known shape.
+static bool DynamicOutputShapeOk(const Node* node) {
+  static const std::set<string> dynamic_shape_ops{
+      "Abs", "Acos", "Add", "AddV2", "Asin", "Atan", "Cast", "Ceil", "ConcatV2",
+      "Cos", "Cosh", "Equal", "Erf", "Exp", "Floor", "FloorMod", "Greater",
+      "GreaterEqual", "Identity", "Less", "LessEqual", "Log", "LogicalAnd",
+      "LogicalNot", "LogicalOr", "Maximum", "Minimum", "MirrorPad", "Mod",
+      "Mul", "Neg", "NotEqual", "Pad", "PadV2", "Pow", "PreventGradient",
+      "RealDiv", "Relu", "Reshape", "Sigmoid", "Sign", "Sin", "Sinh",
+      "Snapshot", "Sqrt", "SquaredDifference", "Sub", "Tan", "Tanh", "Tile",
+      "Transpose"};
+
+  std::vector<const Node*> worklist{node};
+  std::set<const Node*> visited{node};
+  while (!worklist.empty()) {
+    const Node* n = worklist.back();
+    worklist.pop_back();
+    for (const Edge* edge : n->out_edges()) {
+      const Node* dst = edge->dst();
+      if (edge->IsControlEdge()) {
+        continue;
+      }
+      // What a function returns has to keep its shape, e.g. across the
+      // iterations of a While
+      if (dst->IsRetval()) {
+        return false;
+      }
+      if (!dst->IsOp() || !NodeIsMarkedForClustering(dst) ||
+          !visited.insert(dst).second) {
+        continue;
+      }
+      if (dynamic_shape_ops.count(dst->type_string()) == 0) {
+        NGRAPH_VLOG(5) << dst->name() << " needs a static shape, so the "
+                       << "inputs of " << node->name() << " stay static";
+        return false;
+      }
+      worklist.push_back(dst);
+    }
+  }
+  return true;
+}
+
 // Marks the input indices given in static_input_indices as static, i.e., inputs
 // that must be driven either by an _Arg or by a Const in the encapsulated
 // graph (meaning that its value must be known at translation-to-nGraph time). A
 // negative value in static_input_indices indicates that the input index is
 // counted from the right.
+//
+// The inputs in parametric_input_indices only determine the shape of the
+// output, and are left dynamic if the backend can cope with that (see
+// BackendAcceptsParametricInputs) and so can the ops the output goes to (see
+// DynamicOutputShapeOk). The latter needs all nodes to be marked already.
 static SetAttributesFunction SetStaticInputs(
-    const std::vector<int32>& static_input_indices = {}) {
-  auto cf = [static_input_indices](Node* n) {
-    // Adjust negative input indices.
+    const std::vector<int32>& static_input_indices = {},
+    const std::vector<int32>& parametric_input_indices = {}) {
+  auto cf = [static_input_indices, parametric_input_indices](Node* n) {
     auto indices = static_input_indices;
+    if (!parametric_input_indices.empty() &&
+        BackendAcceptsParametricInputs() && DynamicOutputShapeOk(n)) {
+      auto is_parametric = [&parametric_input_indices](int32 x) {
+        return std::find(parametric_input_indices.begin(),
+                         parametric_input_indices.end(),
+                         x) != parametric_input_indices.end();
+      };
+      indices.erase(
+          std::remove_if(indices.begin(), indices.end(), is_parametric),
+          indices.end());
+    }
+    // Adjust negative input indices.
     std::transform(indices.begin(), indices.end(), indices.begin(),
                    [n](int x) { return x >= 0 ? x : n->num_inputs() + x; });
     SetStaticInputs(n, indices);
@@ -147,6 +211,14 @@ static ConfirmationFunction FusedBatchNormConfirmationFunction() {
   return cf;
 };
 
+bool BackendAcceptsParametricInputs() {
+  if (std::getenv("NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS") != nullptr) {
+    return false;
+  }
+  auto backend = BackendManager::GetBackend();
+  return backend != nullptr && backend->supports_dynamic_tensors();
+}
+
 // Check if op is supported by backend using is_supported API
 Status IsSupportedByBackend(
     const Node* node, const shared_ptr<Backend> op_backend,
@@ -207,22 +279,22 @@ const std::map<std::string, SetAttributesFunction>& GetAttributeSetters() {
     set_attributes_map["Max"] = SetStaticInputs({1});
     set_attributes_map["Mean"] = SetStaticInputs({1});
     set_attributes_map["Min"] = SetStaticInputs({1});
-    set_attributes_map["MirrorPad"] = SetStaticInputs({1});
+    set_attributes_map["MirrorPad"] = SetStaticInputs({1}, {1});
     set_attributes_map["NonMaxSuppressionV4"] = SetStaticInputs({2, 3, 4});
     set_attributes_map["OneHot"] = SetStaticInputs({1});
-    set_attributes_map["Pad"] = SetStaticInputs({1});
-    set_attributes_map["PadV2"] = SetStaticInputs({1, 2});
+    set_attributes_map["Pad"] = SetStaticInputs({1}, {1});
+    set_attributes_map["PadV2"] = SetStaticInputs({1, 2}, {1});
     set_attributes_map["Prod"] = SetStaticInputs({1});
-    set_attributes_map["Reshape"] = SetStaticInputs({1});
+    set_attributes_map["Reshape"] = SetStaticInputs({1}, {1});
     set_attributes_map["Shape"] = SetStaticInputs({0});
-    set_attributes_map["Slice"] = SetStaticInputs({1, 2});
+    set_attributes_map["Slice"] = SetStaticInputs({1, 2}, {1, 2});
     set_attributes_map["Split"] = SetStaticInputs({0});
     set_attributes_map["SplitV"] = SetStaticInputs({1, 2});
     set_attributes_map["StridedSlice"] = SetStaticInputs({1, 2, 3});
     set_attributes_map["Sum"] = SetStaticInputs({1});
     set_attributes_map["TopKV2"] = SetStaticInputs({1});
-    set_attributes_map["Tile"] = SetStaticInputs({1});
-    set_attributes_map["Transpose"] = SetStaticInputs({1});
+    set_attributes_map["Tile"] = SetStaticInputs({1}, {1});
+    set_attributes_map["Transpose"] = SetStaticInputs({1}, {1});
     initialized = true;
   }
   return set_attributes_map;
@@ -288,6 +360,7 @@ const std::map<std::string, ConfirmationFunction>& GetConfirmationMap() {
       return Status::OK();
     };
     confirmation_function_map["Equal"] = SimpleConfirmationFunction();
+    confirmation_function_map["Erf"] = SimpleConfirmationFunction();
     confirmation_function_map["Exp"] = SimpleConfirmationFunction();
     confirmation_function_map["ExpandDims"] = SimpleConfirmationFunction();
     confirmation_function_map["Fill"] = SimpleConfirmationFunction();
@@ -308,6 +381,7 @@ const std::map<std::string, ConfirmationFunction>& GetConfirmationMap() {
     confirmation_function_map["Greater"] = SimpleConfirmationFunction();
     confirmation_function_map["GreaterEqual"] = SimpleConfirmationFunction();
     confirmation_function_map["Identity"] = SimpleConfirmationFunction();
+    confirmation_function_map["If"] = SimpleConfirmationFunction();
     confirmation_function_map["IsFinite"] = SimpleConfirmationFunction();
     confirmation_function_map["L2Loss"] = SimpleConfirmationFunction();
     confirmation_function_map["LogSoftmax"] = SimpleConfirmationFunction();
@@ -368,6 +442,8 @@ const std::map<std::string, ConfirmationFunction>& GetConfirmationMap() {
         SimpleConfirmationFunction();
     confirmation_function_map["Squeeze"] = SimpleConfirmationFunction();
     confirmation_function_map["StridedSlice"] = SimpleConfirmationFunction();
+    confirmation_function_map["StatelessIf"] = SimpleConfirmationFunction();
+    confirmation_function_map["StatelessWhile"] = SimpleConfirmationFunction();
     confirmation_function_map["Pack"] = SimpleConfirmationFunction();
     confirmation_function_map["Sub"] = SimpleConfirmationFunction();
     confirmation_function_map["Sum"] = SimpleConfirmationFunction();
@@ -385,6 +461,7 @@ const std::map<std::string, ConfirmationFunction>& GetConfirmationMap() {
     };
     confirmation_function_map["Transpose"] = SimpleConfirmationFunction();
     confirmation_function_map["Unpack"] = SimpleConfirmationFunction();
+    confirmation_function_map["While"] = SimpleConfirmationFunction();
     confirmation_function_map["Xdivy"] = SimpleConfirmationFunction();
     confirmation_function_map["ZerosLike"] = SimpleConfirmationFunction();
     initialized = true;
@@ -441,6 +518,7 @@ const TypeConstraintMap& GetTypeConstraintMap() {
     type_constraint_map["DepthToSpace"]["T"] = NGraphDTypes();
     type_constraint_map["DepthwiseConv2dNative"]["T"] = NGraphNumericDTypes();
     type_constraint_map["Equal"]["T"] = NGraphDTypes();
+    type_constraint_map["Erf"]["T"] = NGraphRealDTypes();
     type_constraint_map["Exp"]["T"] = NGraphNumericDTypes();
     type_constraint_map["ExpandDims"]["T"] = NGraphDTypes();
     type_constraint_map["Floor"]["T"] = NGraphNumericDTypes();
@@ -459,6 +537,7 @@ const TypeConstraintMap& GetTypeConstraintMap() {
     type_constraint_map["Greater"]["T"] = NGraphDTypes();
     type_constraint_map["GreaterEqual"]["T"] = NGraphDTypes();
     type_constraint_map["Identity"]["T"] = NGraphDTypes();
+    type_constraint_map["If"]["Tcond"] = NGraphDTypes();
     type_constraint_map["IsFinite"]["T"] = NGraphRealDTypes();
     type_constraint_map["L2Loss"]["T"] = NGraphNumericDTypes();
     type_constraint_map["LogSoftmax"]["T"] = NGraphRealDTypes();
@@ -529,6 +608,7 @@ const TypeConstraintMap& GetTypeConstraintMap() {
     type_constraint_map["Squeeze"]["T"] = NGraphDTypes();
     type_constraint_map["StridedSlice"]["T"] = NGraphDTypes();
     type_constraint_map["StridedSlice"]["Index"] = NGraphIndexDTypes();
+    type_constraint_map["StatelessIf"]["Tcond"] = NGraphDTypes();
     type_constraint_map["Sub"]["T"] = NGraphNumericDTypes();
     type_constraint_map["Sum"]["T"] = NGraphNumericDTypes();
     type_constraint_map["Sum"]["Tidx"] = NGraphIndexDTypes();
@@ -600,6 +680,7 @@ GetTFToNgOpMap() {
         std::make_shared<opset::Concat>(), std::make_shared<opset::Transpose>(),
         constant}},
       {"Equal", {std::make_shared<opset::Equal>()}},
+      {"Erf", {std::make_shared<opset::Erf>()}},
       {"Exp", {std::make_shared<opset::Exp>()}},
       {"ExpandDims", {constant, std::make_shared<opset::Reshape>()}},
       {"Fill", {constant, std::make_shared<opset::Broadcast>()}},
@@ -628,6 +709,9 @@ GetTFToNgOpMap() {
       {"Greater", {std::make_shared<opset::Greater>()}},
       {"GreaterEqual", {std::make_shared<opset::GreaterEqual>()}},
       {"Identity", {}},
+      {"If",
+       {constant, std::make_shared<opset::NotEqual>(),
+        std::make_shared<opset::Select>()}},
       {"IsFinite",
        {constant, std::make_shared<opset::NotEqual>(),
         std::make_shared<opset::Equal>(),
@@ -705,6 +789,10 @@ GetTFToNgOpMap() {
       {"SquaredDifference", {std::make_shared<opset::SquaredDifference>()}},
       {"Squeeze", {std::make_shared<opset::Squeeze>(), constant}},
       {"StridedSlice", {constant, std::make_shared<opset::StridedSlice>()}},
+      {"StatelessIf",
+       {constant, std::make_shared<opset::NotEqual>(),
+        std::make_shared<opset::Select>()}},
+      {"StatelessWhile", {constant, std::make_shared<opset::TensorIterator>()}},
       {"Sub", {std::make_shared<opset::Subtract>()}},
       {"Sum", {std::make_shared<opset::ReduceSum>(), constant}},
       {"Tan", {std::make_shared<opset::Tan>()}},
@@ -719,17 +807,175 @@ GetTFToNgOpMap() {
        {constant, std::make_shared<opset::StridedSlice>(),
         std::make_shared<opset::Reshape>()}},
       {"ZerosLike", {constant}},
+      {"While", {constant, std::make_shared<opset::TensorIterator>()}},
       {"NoOp", {}},
   };
 
   return TFtoNgraphOpMap;
 }
 
+// Checks that the functions a control flow op calls can be translated with
+// it: the op's arguments and results are of types nGraph handles, every op
+// of the functions passes the same checks as the op itself, and takes its
+// static inputs from constants of the function. A While also needs loop
+// counters whose initial values and limits are constants, since a loop that
+// turns out to run more than kMaxWhileTripCount times cannot fall back to TF
+// at run time; the inputs holding them are returned in static_inputs.
+static Status ControlFlowFunctionsOk(
+    Node* node, const FunctionLibraryDefinition& flib,
+    std::map<std::string, ConfirmationFunction>& confirmation_function_map,
+    const TypeConstraintMap& type_constraint_map,
+    const std::map<std::string, SetAttributesFunction>& set_attributes_map,
+    const shared_ptr<Backend>& op_backend,
+    const std::map<std::string, std::set<shared_ptr<ng::Node>>>&
+        TFtoNgraphOpMap,
+    std::vector<int32>* static_inputs, bool& functions_ok) {
+  functions_ok = false;
+  static_inputs->clear();
+
+  // The loop variables of a While, and the arguments and results of an If
+  for (const char* attr : {"T", "Tin", "Tout"}) {
+    DataTypeVector types;
+    if (!GetNodeAttr(node->attrs(), attr, &types).ok()) {
+      continue;
+    }
+    for (auto dt : types) {
+      if (std::find(NGraphDTypes().begin(), NGraphDTypes().end(), dt) ==
+          NGraphDTypes().end()) {
+        NGRAPH_VLOG(5) << node->name() << " has a " << attr << " of type "
+                       << DataTypeString(dt);
+        return Status::OK();
+      }
+    }
+  }
+
+  std::vector<NameAttrList> funcs;
+  TF_RETURN_IF_ERROR(GetCalledFunctions(node, &funcs));
+  std::vector<std::unique_ptr<FunctionBody>> fbodies(funcs.size());
+  for (size_t i = 0; i < funcs.size(); i++) {
+    Status status = GetFunctionBody(flib, funcs[i], &fbodies[i]);
+    if (!status.ok()) {
+      NGRAPH_VLOG(5) << "Cannot instantiate " << funcs[i].name() << ": "
+                     << status.error_message();
+      return Status::OK();
+    }
+
+    Graph* body = fbodies[i]->graph;
+    std::vector<Node*> body_nodes;
+    for (auto body_node : body->op_nodes()) {
+      if (body_node->IsArg() || body_node->IsRetval() ||
+          body_node->type_string() == "NoOp") {
+        continue;
+      }
+      // Lowered control flow is not translated
+      if (body_node->IsControlFlow()) {
+        return Status::OK();
+      }
+
+      bool ok = false;
+      TF_RETURN_IF_ERROR(
+          ConfirmationOk(body_node, confirmation_function_map, ok));
+      if (!ok) {
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(
+          TypeConstraintOk(body_node, type_constraint_map, ok));
+      if (!ok) {
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(
+          IsSupportedByBackend(body_node, op_backend, TFtoNgraphOpMap, ok));
+      if (!ok) {
+        return Status::OK();
+      }
+
+      if (IsFunctionalControlFlow(body_node)) {
+        std::vector<int32> nested_static_inputs;
+        TF_RETURN_IF_ERROR(ControlFlowFunctionsOk(
+            body_node, body->flib_def(), confirmation_function_map,
+            type_constraint_map, set_attributes_map, op_backend,
+            TFtoNgraphOpMap, &nested_static_inputs, ok));
+        if (!ok) {
+          return Status::OK();
+        }
+        SetStaticInputs(body_node, nested_static_inputs);
+      }
+      body_nodes.push_back(body_node);
+    }
+
+    // The whole function is translated, so its ops count as marked for the
+    // attribute setters
+    for (auto body_node : body_nodes) {
+      body_node->AddAttr("_ngraph_marked_for_clustering", true);
+    }
+    for (auto body_node : body_nodes) {
+      if (!IsFunctionalControlFlow(body_node)) {
+        auto it = set_attributes_map.find(body_node->type_string());
+        if (it != set_attributes_map.end()) {
+          TF_RETURN_IF_ERROR(it->second(body_node));
+        }
+      }
+
+      // The function is translated without static inputs of its own
+      std::vector<int32> body_static_inputs;
+      GetStaticInputs(body_node, &body_static_inputs);
+      for (int32 index : body_static_inputs) {
+        const Node* input;
+        if (!body_node->input_node(index, &input).ok() ||
+            input->type_string() != "Const") {
+          NGRAPH_VLOG(5) << "Input " << index << " of " << body_node->name()
+                         << " in " << funcs[i].name() << " is not constant";
+          return Status::OK();
+        }
+      }
+    }
+  }
+
+  if (node->type_string() == "While" ||
+      node->type_string() == "StatelessWhile") {
+    std::vector<LoopCounter> counters;
+    bool found = false;
+    Status status = FindLoopCounters(*fbodies[0]->graph, *fbodies[1]->graph,
+                                     &counters, &found);
+    if (!status.ok() || !found) {
+      NGRAPH_VLOG(5) << "No loop counter found for " << node->name();
+      return Status::OK();
+    }
+    int64 trip_count;
+    bool known;
+    ConstTripCount(node, counters, &trip_count, &known);
+    if (!known) {
+      NGRAPH_VLOG(5) << "The loop counters of " << node->name()
+                     << " do not start from and run to constants";
+      return Status::OK();
+    }
+    if (trip_count > kMaxWhileTripCount) {
+      NGRAPH_VLOG(5) << node->name() << " runs " << trip_count
+                     << " times, more than " << kMaxWhileTripCount;
+      return Status::OK();
+    }
+    for (const auto& counter : counters) {
+      static_inputs->push_back(counter.index);
+      if (counter.limit_index >= 0) {
+        static_inputs->push_back(counter.limit_index);
+      }
+    }
+    std::sort(static_inputs->begin(), static_inputs->end());
+    static_inputs->erase(
+        std::unique(static_inputs->begin(), static_inputs->end()),
+        static_inputs->end());
+  }
+
+  functions_ok = true;
+  return Status::OK();
+}
+
 //
 // Main entry point for the marking pass.
 //
 Status MarkForClustering(Graph* graph,
                          const std::set<string> skip_these_nodes) {
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kMarkForClustering);
   const TypeConstraintMap& type_constraint_map = GetTypeConstraintMap();
 
   // confirmation_function_map is non-const unlike the other maps
@@ -787,6 +1033,7 @@ Status MarkForClustering(Graph* graph,
   std::unordered_map<string, int> fail_confirmation_histogram;
   std::unordered_map<string, int> fail_constraint_histogram;
   vector<Node*> nodes_marked_for_clustering;
+  std::map<Node*, std::vector<int32>> control_flow_static_inputs;
 
   shared_ptr<Backend> op_backend = BackendManager::GetBackend();
   for (auto node : graph->op_nodes()) {
@@ -853,6 +1100,22 @@ Status MarkForClustering(Graph* graph,
         break;
       }
 
+      // A control flow op is translated along with the functions it calls
+      if (IsFunctionalControlFlow(node)) {
+        bool functions_ok = false;
+        std::vector<int32> static_inputs;
+        TF_RETURN_IF_ERROR(ControlFlowFunctionsOk(
+            node, graph->flib_def(), confirmation_function_map,
+            type_constraint_map, set_attributes_map, op_backend,
+            TFtoNgraphOpMap, &static_inputs, functions_ok));
+        if (!functions_ok) {
+          NGRAPH_VLOG(5) << "Functions cannot be translated: " << node->name();
+          fail_confirmation_histogram[node->type_string()]++;
+          break;
+        }
+        control_flow_static_inputs[node] = static_inputs;
+      }
+
       // if all constraints are met, mark for clustering
       mark_for_clustering = true;
     } while (false);
@@ -883,13 +1146,22 @@ Status MarkForClustering(Graph* graph,
     std::cout << "\n";
   }
 
+  RewriteReport::Count("nodes", graph->num_op_nodes());
+  RewriteReport::Count("nodes_marked", nodes_marked_for_clustering.size());
+
   for (auto node : nodes_marked_for_clustering) {
     // TODO(amprocte): move attr name to a constant
     node->AddAttr("_ngraph_marked_for_clustering", true);
+  }
+  for (auto node : nodes_marked_for_clustering) {
     auto it = set_attributes_map.find(node->type_string());
     if (it != set_attributes_map.end()) {
       TF_RETURN_IF_ERROR(it->second(node));
     }
+    auto cf_it = control_flow_static_inputs.find(node);
+    if (cf_it != control_flow_static_inputs.end()) {
+      SetStaticInputs(node, cf_it->second);
+    }
   }
 
   return Status::OK();
@@ -916,7 +1188,8 @@ bool InputIsStatic(const Node* node, int index) {
   return std::find(inputs.begin(), inputs.end(), index) != inputs.end();
 }
 
-Status GetStaticInputs(Graph* graph, std::vector<int32>* static_input_indexes) {
+Status GetStaticInputs(const Graph* graph,
+                       std::vector<int32>* static_input_indexes) {
   static_input_indexes->clear();
   for (auto node : graph->nodes()) {
     if (node->type_string() == "_Arg") {
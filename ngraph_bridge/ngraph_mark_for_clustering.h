@@ -41,11 +41,19 @@ bool NodeIsMarkedForClustering(const Node* node);
 void GetStaticInputs(const Node* node,
                      std::vector<int32>* static_input_indexes);
 
+// Returns true if inputs that only determine the shape of an op's output
+// (e.g. the shape of a Reshape or the paddings of a Pad) can be fed to the
+// backend at run time rather than baked into the compiled function. Such
+// inputs are then not static, so changing their value does not force a
+// recompile. Can be turned off with NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS.
+bool BackendAcceptsParametricInputs();
+
 // Returns True if the index-th input is static
 bool InputIsStatic(const Node* node, int index);
 
 // Returns the static input indexes of the graph in vector static_input_indexes
-Status GetStaticInputs(Graph* graph, std::vector<int32>* static_input_indexes);
+Status GetStaticInputs(const Graph* graph,
+                       std::vector<int32>* static_input_indexes);
 
 using SetAttributesFunction = std::function<Status(Node*)>;
 const std::map<std::string, SetAttributesFunction>& GetAttributeSetters();
@@ -0,0 +1,432 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_metrics.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+constexpr int Counter::kNumShards;
+constexpr int Histogram::kSubBuckets;
+constexpr int Histogram::kMaxExponent;
+constexpr int Histogram::kNumBuckets;
+
+std::map<std::string, MetricsRegistry::Family> MetricsRegistry::s_families;
+std::map<int, int> MetricsRegistry::s_cluster_users;
+std::mutex MetricsRegistry::s_mutex;
+
+// Threads are handed out shards round-robin, on first use.
+static int ThreadShard(int num_shards) {
+  static std::atomic<int> next_shard{0};
+  static thread_local int shard = next_shard++;
+  return shard % num_shards;
+}
+
+void Counter::Increment(int64 delta) {
+  m_shards[ThreadShard(kNumShards)].value.fetch_add(delta,
+                                                    std::memory_order_relaxed);
+}
+
+int64 Counter::Value() const {
+  int64 value = 0;
+  for (const auto& shard : m_shards) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+void Counter::Reset() {
+  for (auto& shard : m_shards) {
+    shard.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Gauge::Add(int64 delta) {
+  m_value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+void Gauge::Set(int64 value) {
+  m_value.store(value, std::memory_order_relaxed);
+}
+
+int64 Gauge::Value() const { return m_value.load(std::memory_order_relaxed); }
+
+int Histogram::BucketIndex(int64 value) {
+  if (value < kSubBuckets) {
+    return std::max<int64>(value, 0);
+  }
+  int exponent = 63 - __builtin_clzll(value);
+  if (exponent >= kMaxExponent) {
+    return kNumBuckets - 1;
+  }
+  int sub_bucket = (value >> (exponent - 3)) - kSubBuckets;
+  return kSubBuckets + (exponent - 3) * kSubBuckets + sub_bucket;
+}
+
+int64 Histogram::BucketUpperBound(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int exponent = 3 + (index - kSubBuckets) / kSubBuckets;
+  int sub_bucket = (index - kSubBuckets) % kSubBuckets;
+  int64 width = int64{1} << (exponent - 3);
+  return (kSubBuckets + sub_bucket) * width + width - 1;
+}
+
+void Histogram::Record(int64 value) {
+  m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  int64 max = m_max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+int64 Histogram::Count() const {
+  int64 count = 0;
+  for (const auto& bucket : m_buckets) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+int64 Histogram::Sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+int64 Histogram::Quantile(double q) const {
+  // Take a snapshot first, so that the rank is consistent with the buckets
+  // we walk even while other threads keep recording.
+  int64 snapshot[kNumBuckets];
+  int64 count = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    snapshot[i] = m_buckets[i].load(std::memory_order_relaxed);
+    count += snapshot[i];
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  int64 rank = std::max<int64>(1, std::ceil(q * count));
+  int64 seen = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    seen += snapshot[i];
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i),
+                      m_max.load(std::memory_order_relaxed));
+    }
+  }
+  return m_max.load(std::memory_order_relaxed);
+}
+
+void Histogram::Reset() {
+  for (auto& bucket : m_buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  m_sum.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+}
+
+MetricsRegistry::Family& MetricsRegistry::GetFamily(const string& name,
+                                                    const string& help,
+                                                    Kind kind) {
+  auto it = s_families.find(name);
+  if (it == s_families.end()) {
+    it = s_families.emplace(name, Family()).first;
+    it->second.help = help;
+    it->second.kind = kind;
+  }
+  return it->second;
+}
+
+Counter* MetricsRegistry::GetCounter(const string& name, const string& help,
+                                     int cluster) {
+  MaybeStartDumper();
+  std::lock_guard<std::mutex> guard(s_mutex);
+  auto& counter = GetFamily(name, help, Kind::kCounter).counters[cluster];
+  if (counter == nullptr) {
+    counter.reset(new Counter());
+  }
+  return counter.get();
+}
+
+Gauge* MetricsRegistry::GetGauge(const string& name, const string& help,
+                                 int cluster) {
+  MaybeStartDumper();
+  std::lock_guard<std::mutex> guard(s_mutex);
+  auto& gauge = GetFamily(name, help, Kind::kGauge).gauges[cluster];
+  if (gauge == nullptr) {
+    gauge.reset(new Gauge());
+  }
+  return gauge.get();
+}
+
+Histogram* MetricsRegistry::GetHistogram(const string& name,
+                                         const string& help, int cluster) {
+  MaybeStartDumper();
+  std::lock_guard<std::mutex> guard(s_mutex);
+  auto& histogram = GetFamily(name, help, Kind::kHistogram).histograms[cluster];
+  if (histogram == nullptr) {
+    histogram.reset(new Histogram());
+  }
+  return histogram.get();
+}
+
+static string Labels(int cluster, const string& extra = "") {
+  std::vector<string> labels;
+  if (cluster >= 0) {
+    labels.push_back(strings::StrCat("cluster=\"", cluster, "\""));
+  }
+  if (!extra.empty()) {
+    labels.push_back(extra);
+  }
+  if (labels.empty()) {
+    return "";
+  }
+  return "{" + str_util::Join(labels, ",") + "}";
+}
+
+static const std::pair<const char*, double> kQuantiles[] = {
+    {"0.5", 0.5}, {"0.99", 0.99}, {"0.999", 0.999}};
+
+string MetricsRegistry::ToText() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  std::ostringstream out;
+  for (const auto& kv : s_families) {
+    const string& name = kv.first;
+    const Family& family = kv.second;
+    out << "# HELP " << name << " " << family.help << "\n";
+    if (family.kind == Kind::kCounter) {
+      out << "# TYPE " << name << " counter\n";
+      for (const auto& counter : family.counters) {
+        out << name << Labels(counter.first) << " " << counter.second->Value()
+            << "\n";
+      }
+      continue;
+    }
+    if (family.kind == Kind::kGauge) {
+      out << "# TYPE " << name << " gauge\n";
+      for (const auto& gauge : family.gauges) {
+        out << name << Labels(gauge.first) << " " << gauge.second->Value()
+            << "\n";
+      }
+      continue;
+    }
+
+    out << "# TYPE " << name << " summary\n";
+    for (const auto& histogram : family.histograms) {
+      int cluster = histogram.first;
+      const Histogram& h = *histogram.second;
+      for (const auto& q : kQuantiles) {
+        out << name
+            << Labels(cluster, strings::StrCat("quantile=\"", q.first, "\""))
+            << " " << h.Quantile(q.second) << "\n";
+      }
+      out << name << "_sum" << Labels(cluster) << " " << h.Sum() << "\n";
+      out << name << "_count" << Labels(cluster) << " " << h.Count() << "\n";
+    }
+  }
+  return out.str();
+}
+
+Status MetricsRegistry::DumpToFile(const string& path) {
+  Env* env = Env::Default();
+  string tmp_path = strings::StrCat(path, ".tmp");
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_path, ToText()));
+  return env->RenameFile(tmp_path, path);
+}
+
+void MetricsRegistry::Reset() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  for (auto& kv : s_families) {
+    for (auto& counter : kv.second.counters) {
+      counter.second->Reset();
+    }
+    for (auto& histogram : kv.second.histograms) {
+      histogram.second->Reset();
+    }
+  }
+}
+
+int MetricsRegistry::AcquireCluster(int cluster) {
+  if (cluster >= 0) {
+    std::lock_guard<std::mutex> guard(s_mutex);
+    s_cluster_users[cluster]++;
+  }
+  return cluster;
+}
+
+void MetricsRegistry::ReleaseCluster(int cluster) {
+  if (cluster < 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(s_mutex);
+  auto it = s_cluster_users.find(cluster);
+  if (it == s_cluster_users.end() || --it->second > 0) {
+    return;
+  }
+  s_cluster_users.erase(it);
+  for (auto& kv : s_families) {
+    kv.second.counters.erase(cluster);
+    kv.second.gauges.erase(cluster);
+    kv.second.histograms.erase(cluster);
+  }
+}
+
+void MetricsRegistry::MaybeStartDumper() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    const char* path_env = std::getenv("NGRAPH_TF_METRICS_FILE");
+    if (path_env == nullptr) {
+      return;
+    }
+    string path(path_env);
+    int interval = 10;
+    const char* interval_env = std::getenv("NGRAPH_TF_METRICS_INTERVAL");
+    if (interval_env != nullptr) {
+      interval = std::max(1, atoi(interval_env));
+    }
+    NGRAPH_VLOG(1) << "Dumping metrics to " << path << " every " << interval
+                   << "s";
+    std::thread([path, interval]() {
+      while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(interval));
+        Status status = DumpToFile(path);
+        if (!status.ok()) {
+          NGRAPH_VLOG(0) << "Could not dump metrics to " << path << ": "
+                         << status.error_message();
+        }
+      }
+    })
+        .detach();
+  });
+}
+
+// Virtual and resident size of the process, from /proc/self/statm (in
+// pages), which unlike /proc/self/stat needs no splitting
+static bool ReadProcessMemory(int64* vm_bytes, int64* rss_bytes) {
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return false;
+  }
+  long vm_pages, rss_pages;
+  bool ok = fscanf(statm, "%ld %ld", &vm_pages, &rss_pages) == 2;
+  fclose(statm);
+  if (ok) {
+    int64 page_size = sysconf(_SC_PAGE_SIZE);
+    *vm_bytes = vm_pages * page_size;
+    *rss_bytes = rss_pages * page_size;
+  }
+  return ok;
+}
+
+void MetricsRegistry::MaybeStartMemorySampler() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    const char* interval_env = std::getenv("NGRAPH_TF_MEM_SAMPLE_INTERVAL_MS");
+    if (interval_env == nullptr) {
+      return;
+    }
+    int interval_ms = std::max(1, atoi(interval_env));
+    NGRAPH_VLOG(1) << "Sampling process memory every " << interval_ms << "ms";
+    Gauge* rss = GetGauge("ngraph_tf_process_rss_bytes",
+                          "Resident size of the process, in bytes");
+    Gauge* peak_rss = GetGauge(
+        "ngraph_tf_process_peak_rss_bytes",
+        "Largest resident size of the process seen so far, in bytes");
+    Gauge* vm = GetGauge("ngraph_tf_process_vm_bytes",
+                         "Virtual size of the process, in bytes");
+    std::thread([interval_ms, rss, peak_rss, vm]() {
+      while (true) {
+        int64 vm_bytes, rss_bytes;
+        if (ReadProcessMemory(&vm_bytes, &rss_bytes)) {
+          rss->Set(rss_bytes);
+          peak_rss->Set(std::max(peak_rss->Value(), rss_bytes));
+          vm->Set(vm_bytes);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+      }
+    })
+        .detach();
+  });
+}
+
+ClusterMetrics::ClusterMetrics(int cluster_idx)
+    : cluster(MetricsRegistry::AcquireCluster(cluster_idx)),
+      compile_time_us(MetricsRegistry::GetHistogram(
+          "ngraph_tf_compile_time_us",
+          "Time to translate and compile a cluster, in microseconds", cluster)),
+      lookup_time_us(MetricsRegistry::GetHistogram(
+          "ngraph_tf_lookup_time_us",
+          "Time to find (or build) the executable for a step, in microseconds",
+          cluster)),
+      tensor_wrap_time_us(MetricsRegistry::GetHistogram(
+          "ngraph_tf_tensor_wrap_time_us",
+          "Time to wrap TF tensors as nGraph tensors, in microseconds",
+          cluster)),
+      execute_time_us(MetricsRegistry::GetHistogram(
+          "ngraph_tf_execute_time_us",
+          "Time spent in the backend executing a step, in microseconds",
+          cluster)),
+      cache_hits(MetricsRegistry::GetCounter(
+          "ngraph_tf_cache_hits_total",
+          "Steps that found a compiled executable in the cache", cluster)),
+      cache_misses(MetricsRegistry::GetCounter(
+          "ngraph_tf_cache_misses_total",
+          "Steps that had to compile a new executable", cluster)),
+      cache_evictions(MetricsRegistry::GetCounter(
+          "ngraph_tf_cache_evictions_total",
+          "Executables dropped from a full cache", cluster)),
+      template_instantiations(MetricsRegistry::GetCounter(
+          "ngraph_tf_template_instantiations_total",
+          "Cache misses that reused the translation of earlier input shapes",
+          cluster)),
+      input_bytes(MetricsRegistry::GetCounter(
+          "ngraph_tf_input_bytes_total",
+          "Bytes passed from TF into the cluster", cluster)),
+      output_bytes(MetricsRegistry::GetCounter(
+          "ngraph_tf_output_bytes_total",
+          "Bytes passed from the cluster back to TF", cluster)),
+      executable_bytes(MetricsRegistry::GetGauge(
+          "ngraph_tf_executable_bytes",
+          "Estimated bytes of intermediate results of the cached executables",
+          cluster)),
+      constant_bytes(MetricsRegistry::GetGauge(
+          "ngraph_tf_constant_bytes",
+          "Bytes of the constants of the cached executables", cluster)),
+      tensor_bytes(MetricsRegistry::GetGauge(
+          "ngraph_tf_tensor_bytes",
+          "Bytes of the nGraph tensors of the running steps", cluster)) {
+  MetricsRegistry::MaybeStartMemorySampler();
+}
+
+ClusterMetrics::~ClusterMetrics() { MetricsRegistry::ReleaseCluster(cluster); }
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_METRICS_H_
+#define NGRAPH_TF_BRIDGE_METRICS_H_
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+// A monotonic counter. Increments go to one of a few shards picked by the
+// calling thread, so concurrent clusters do not fight over one cache line.
+class Counter {
+ public:
+  void Increment(int64 delta = 1);
+  int64 Value() const;
+  void Reset();
+
+ private:
+  static constexpr int kNumShards = 8;
+  struct Shard {
+    std::atomic<int64> value{0};
+    char padding[64 - sizeof(std::atomic<int64>)];
+  };
+  Shard m_shards[kNumShards];
+};
+
+// A value that goes up and down, like the bytes a cluster holds on to.
+// Updates are rare enough (compilations, evictions, steps) for one atomic.
+class Gauge {
+ public:
+  void Add(int64 delta);
+  void Set(int64 value);
+  int64 Value() const;
+
+ private:
+  std::atomic<int64> m_value{0};
+};
+
+// Adds to a gauge for as long as it lives
+class ScopedGaugeAdd {
+ public:
+  explicit ScopedGaugeAdd(Gauge* gauge) : m_gauge(gauge) {}
+  ~ScopedGaugeAdd() { m_gauge->Add(-m_delta); }
+  void Add(int64 delta) {
+    m_gauge->Add(delta);
+    m_delta += delta;
+  }
+
+ private:
+  Gauge* m_gauge;
+  int64 m_delta = 0;
+};
+
+// A histogram of non-negative values (latencies in microseconds, mostly).
+// Values are counted in log-linear buckets: 8 buckets per power of two,
+// which bounds the relative error of a quantile by 12.5%. Recording is a
+// handful of relaxed atomic increments.
+class Histogram {
+ public:
+  void Record(int64 value);
+  int64 Count() const;
+  int64 Sum() const;
+  // Returns an upper bound of the q-th quantile (0 < q <= 1) of the recorded
+  // values, or 0 if nothing was recorded.
+  int64 Quantile(double q) const;
+  void Reset();
+
+ private:
+  static constexpr int kSubBuckets = 8;
+  // Values at or above 2^36 (about 19 hours in microseconds) share the last
+  // bucket.
+  static constexpr int kMaxExponent = 36;
+  static constexpr int kNumBuckets =
+      kSubBuckets + (kMaxExponent - 3) * kSubBuckets;
+
+  static int BucketIndex(int64 value);
+  static int64 BucketUpperBound(int index);
+
+  std::atomic<int64> m_buckets[kNumBuckets] = {};
+  std::atomic<int64> m_sum{0};
+  std::atomic<int64> m_max{0};
+};
+
+//
+// Process-wide registry of the bridge's metrics. Metrics are created on first
+// use, so callers can (and on hot paths should) hold on to the returned
+// pointers. Every metric carries a cluster label; -1 stands for metrics that
+// do not belong to a cluster. Those are never destroyed. The metrics of a
+// cluster are destroyed once the last ClusterMetrics of the cluster is, since
+// cluster indices are reused by later graphs and the series would otherwise
+// pile up in long-running processes.
+//
+// If NGRAPH_TF_METRICS_FILE is set, a background thread rewrites that file
+// with the output of ToText() every NGRAPH_TF_METRICS_INTERVAL seconds
+// (default 10).
+//
+// If NGRAPH_TF_MEM_SAMPLE_INTERVAL_MS is set, another background thread
+// samples the size of the process that often, into the
+// ngraph_tf_process_{rss,peak_rss,vm}_bytes gauges.
+//
+class MetricsRegistry {
+ public:
+  static Counter* GetCounter(const std::string& name, const std::string& help,
+                             int cluster = -1);
+  static Gauge* GetGauge(const std::string& name, const std::string& help,
+                         int cluster = -1);
+  static Histogram* GetHistogram(const std::string& name,
+                                 const std::string& help, int cluster = -1);
+
+  // Renders all metrics in the Prometheus text exposition format. Histograms
+  // are rendered as summaries with their p50, p99 and p999.
+  static std::string ToText();
+  // Writes ToText() to path, atomically.
+  static Status DumpToFile(const std::string& path);
+  // Zeroes all counters and histograms. Gauges keep their values, since
+  // they stand for what is held right now. Pointers handed out stay valid.
+  static void Reset();
+
+  // Starts the memory sampler, if NGRAPH_TF_MEM_SAMPLE_INTERVAL_MS is set
+  static void MaybeStartMemorySampler();
+
+  // Counts a user of the metrics of cluster, and returns cluster
+  static int AcquireCluster(int cluster);
+  // Drops the metrics of cluster when its last user is gone. Pointers to
+  // them are invalid from then on.
+  static void ReleaseCluster(int cluster);
+
+ private:
+  enum class Kind { kCounter, kGauge, kHistogram };
+
+  struct Family {
+    std::string help;
+    Kind kind;
+    std::map<int, std::unique_ptr<Counter>> counters;
+    std::map<int, std::unique_ptr<Gauge>> gauges;
+    std::map<int, std::unique_ptr<Histogram>> histograms;
+  };
+
+  static Family& GetFamily(const std::string& name, const std::string& help,
+                           Kind kind);
+  static void MaybeStartDumper();
+
+  static std::map<std::string, Family> s_families;
+  static std::map<int, int> s_cluster_users;
+  static std::mutex s_mutex;
+};
+
+// The metrics kept for every cluster, looked up once per encapsulate kernel.
+// They live as long as some ClusterMetrics of the cluster does.
+struct ClusterMetrics {
+  explicit ClusterMetrics(int cluster);
+  ~ClusterMetrics();
+  ClusterMetrics(const ClusterMetrics&) = delete;
+  ClusterMetrics& operator=(const ClusterMetrics&) = delete;
+
+  // Initialized first, so that the metrics below are not dropped by another
+  // user's release while they are looked up
+  const int cluster;
+
+  Histogram* compile_time_us;
+  Histogram* lookup_time_us;
+  Histogram* tensor_wrap_time_us;
+  Histogram* execute_time_us;
+  Counter* cache_hits;
+  Counter* cache_misses;
+  Counter* cache_evictions;
+  // Cache misses served by instantiating the translated template of the
+  // cluster rather than translating its graph
+  Counter* template_instantiations;
+  Counter* input_bytes;
+  Counter* output_bytes;
+  // What the cluster holds on to. The executable and constant bytes are
+  // estimated from the cached nGraph functions: the sizes of the outputs of
+  // all their ops, and of their constants. The tensor bytes are those of
+  // the nGraph tensors of the steps that are running.
+  Gauge* executable_bytes;
+  Gauge* constant_bytes;
+  Gauge* tensor_bytes;
+};
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_METRICS_H_
@@ -0,0 +1,346 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_api.h"
+#include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_cluster_manager.h"
+#include "ngraph_bridge/ngraph_deassign_clusters.h"
+#include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_cache.h"
+#include "ngraph_bridge/ngraph_utils.h"
+#include "ngraph_bridge/version.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+static const char* const kEncapsulateOp = "NGraphEncapsulate";
+
+static int RewriteCacheDepth() {
+  int depth = 8;
+  const char* depth_env = std::getenv("NGRAPH_TF_REWRITE_CACHE_DEPTH");
+  if (depth_env != nullptr) {
+    depth = std::max(1, atoi(depth_env));
+  }
+  return depth;
+}
+
+static string RewriteCacheDir() {
+  const char* dir_env = std::getenv("NGRAPH_TF_REWRITE_CACHE_DIR");
+  return dir_env == nullptr ? "" : dir_env;
+}
+
+static string ClusterFileName(int cluster_idx) {
+  return strings::StrCat("cluster_", cluster_idx, ".pb");
+}
+
+// Environment variables that change what the rewrite phases produce
+static const char* const kRewriteSettings[] = {
+    "NGRAPH_TF_DISABLE_DEASSIGN_CLUSTERS",
+    "NGRAPH_TF_DISABLE_FOLD_STATIC_INPUTS",
+    "NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS",
+};
+
+// Everything besides the graph that decides the result of marking, folding,
+// assigning and deassigning: the settings above, and what they are combined
+// with (the backend's support for dynamic tensors decides which inputs are
+// static, and the deassignment threshold and deadness check are compiled in).
+static string RewriteSettings() {
+  std::stringstream ss;
+  for (const char* name : kRewriteSettings) {
+    const char* value = std::getenv(name);
+    ss << name << "=" << (value == nullptr ? "<unset>" : value) << ",";
+  }
+  ss << "parametric_inputs=" << BackendAcceptsParametricInputs()
+     << ",min_nontrivial_nodes=" << MinNontrivialNodes() << ",deadness_check="
+#if defined(NGRAPH_TF_DISABLE_DEADNESS_CHECK)
+     << 0;
+#else
+     << 1;
+#endif
+  return ss.str();
+}
+
+// Node order in a GraphDef depends on how the graph was built and is not
+// meaningful, so sort nodes (and library functions) by name before hashing.
+static void CanonicalizeGraphDef(GraphDef* graph_def) {
+  auto* nodes = graph_def->mutable_node();
+  std::sort(nodes->begin(), nodes->end(),
+            [](const NodeDef& a, const NodeDef& b) {
+              return a.name() < b.name();
+            });
+  auto* functions = graph_def->mutable_library()->mutable_function();
+  std::sort(functions->begin(), functions->end(),
+            [](const FunctionDef& a, const FunctionDef& b) {
+              return a.signature().name() < b.signature().name();
+            });
+}
+
+// Registers the clusters of entry with the cluster manager and returns the
+// entry's graph with every NGraphEncapsulate node (and every reference to it)
+// switched over to the new cluster indices.
+static Status RewireClusters(const RewriteCacheEntry& entry, int graph_id,
+                             GraphDef* output) {
+  *output = entry.graph;
+
+  std::map<string, string> renamed;
+  for (auto& node : *output->mutable_node()) {
+    if (node.op() != kEncapsulateOp) {
+      continue;
+    }
+    int old_idx;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(AttrSlice(node), "ngraph_cluster", &old_idx));
+    auto it = entry.clusters.find(old_idx);
+    if (it == entry.clusters.end()) {
+      return errors::Internal("Rewrite cache entry has no graph for cluster ",
+                              old_idx, " used by ", node.name());
+    }
+
+    size_t new_idx;
+    TF_RETURN_IF_ERROR(NGraphClusterManager::NewCluster(new_idx));
+    *NGraphClusterManager::GetClusterGraph(new_idx) = it->second;
+    TF_RETURN_IF_ERROR(NGraphClusterManager::PublishCluster(new_idx, graph_id));
+
+    SetAttrValue(static_cast<int>(new_idx),
+                 &((*node.mutable_attr())["ngraph_cluster"]));
+    SetAttrValue(graph_id, &((*node.mutable_attr())["ngraph_graph_id"]));
+
+    string new_name = strings::StrCat("ngraph_cluster_", new_idx);
+    renamed[node.name()] = new_name;
+    node.set_name(new_name);
+  }
+
+  for (auto& node : *output->mutable_node()) {
+    for (auto& input : *node.mutable_input()) {
+      TensorId tensor_id = ParseTensorName(input);
+      auto it = renamed.find(string(tensor_id.first));
+      if (it == renamed.end()) {
+        continue;
+      }
+      if (tensor_id.second == Graph::kControlSlot) {
+        input = strings::StrCat("^", it->second);
+      } else if (tensor_id.second == 0) {
+        input = it->second;
+      } else {
+        input = strings::StrCat(it->second, ":", tensor_id.second);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+NgraphDataCache<string, shared_ptr<RewriteCacheEntry>>&
+NGraphRewriteCache::MemoryCache() {
+  static NgraphDataCache<string, shared_ptr<RewriteCacheEntry>> cache(
+      RewriteCacheDepth());
+  return cache;
+}
+
+bool NGraphRewriteCache::IsEnabled() {
+  if (std::getenv("NGRAPH_TF_DISABLE_REWRITE_CACHE") != nullptr) {
+    return false;
+  }
+  // A cache hit skips the intermediate phases, so anything that wants to
+  // observe them has to take the slow path.
+  return !(DumpMarkedGraphs() || DumpClusteredGraphs() ||
+           DumpDeclusteredGraphs() || config::IsLoggingPlacement() ||
+           std::getenv("NGRAPH_TF_DUMP_CLUSTERS") != nullptr);
+}
+
+Status NGraphRewriteCache::ComputeKey(
+    const GraphDef& graph_def, const std::set<string>& skip_these_nodes,
+    const std::unordered_map<string, string>& device_config, string& key) {
+  GraphDef canonical = graph_def;
+  CanonicalizeGraphDef(&canonical);
+
+  string serialized;
+  if (!SerializeToStringDeterministic(canonical, &serialized)) {
+    return errors::Internal("Failed to serialize graph for rewrite cache key");
+  }
+
+  string backend_name;
+  TF_RETURN_IF_ERROR(BackendManager::GetBackendName(backend_name));
+
+  std::stringstream ss;
+  ss << serialized << "\nversion=" << ngraph_tf_version()
+     << "\nbackend=" << backend_name << "\nsettings=" << RewriteSettings()
+     << "\ndisabled=";
+  for (const auto& op : config::GetDisabledOps()) {
+    ss << op << ",";
+  }
+  ss << "\nskip=";
+  for (const auto& node : skip_these_nodes) {
+    ss << node << ",";
+  }
+  ss << "\nconfig=";
+  std::map<string, string> sorted_config(device_config.begin(),
+                                         device_config.end());
+  for (const auto& kv : sorted_config) {
+    ss << kv.first << "=" << kv.second << ",";
+  }
+
+  Fprint128 fp = Fingerprint128(ss.str());
+  std::stringstream key_ss;
+  key_ss << std::hex << std::setfill('0') << std::setw(16) << fp.high64
+         << std::setw(16) << fp.low64;
+  key = key_ss.str();
+  return Status::OK();
+}
+
+Status NGraphRewriteCache::Lookup(const string& key, int graph_id,
+                                  GraphDef* output, bool& cache_hit) {
+  cache_hit = false;
+  bool in_memory = false;
+  auto status_entry = MemoryCache().LookUpOrCreate(
+      key,
+      [](string k) {
+        shared_ptr<RewriteCacheEntry> entry;
+        Status status = LoadFromDisk(k, entry);
+        return std::make_pair(status, entry);
+      },
+      in_memory);
+
+  if (errors::IsNotFound(status_entry.first)) {
+    NGRAPH_VLOG(1) << "Rewrite cache miss for " << key;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(status_entry.first);
+
+  NGRAPH_VLOG(1) << "Rewrite cache hit for " << key
+                 << (in_memory ? " (memory)" : " (disk)");
+  TF_RETURN_IF_ERROR(RewireClusters(*status_entry.second, graph_id, output));
+  cache_hit = true;
+  return Status::OK();
+}
+
+Status NGraphRewriteCache::Insert(const string& key,
+                                  const GraphDef& encapsulated) {
+  auto entry = make_shared<RewriteCacheEntry>();
+  entry->graph = encapsulated;
+  for (const auto& node : encapsulated.node()) {
+    if (node.op() != kEncapsulateOp) {
+      continue;
+    }
+    int cluster_idx;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(AttrSlice(node), "ngraph_cluster", &cluster_idx));
+    GraphDef* cluster_graph =
+        NGraphClusterManager::GetClusterGraph(cluster_idx);
+    if (cluster_graph == nullptr) {
+      return errors::Internal("Did not find cluster ", cluster_idx,
+                              " in cluster manager for node ", node.name());
+    }
+    entry->clusters[cluster_idx] = *cluster_graph;
+  }
+
+  bool cache_hit;
+  auto status_entry = MemoryCache().LookUpOrCreate(
+      key,
+      [&entry](string) { return std::make_pair(Status::OK(), entry); },
+      cache_hit);
+  TF_RETURN_IF_ERROR(status_entry.first);
+
+  if (!RewriteCacheDir().empty()) {
+    TF_RETURN_IF_ERROR(SaveToDisk(key, *entry));
+  }
+  return Status::OK();
+}
+
+void NGraphRewriteCache::Clear() {
+  MemoryCache().RemoveAll([](shared_ptr<RewriteCacheEntry>) {});
+}
+
+Status NGraphRewriteCache::LoadFromDisk(const string& key,
+                                        shared_ptr<RewriteCacheEntry>& entry) {
+  string dir = RewriteCacheDir();
+  if (dir.empty()) {
+    return errors::NotFound("No rewrite cache directory");
+  }
+  Env* env = Env::Default();
+  string entry_dir = io::JoinPath(dir, key);
+  string graph_file = io::JoinPath(entry_dir, "graph.pb");
+  if (!env->FileExists(graph_file).ok()) {
+    return errors::NotFound("No rewrite cache entry at ", entry_dir);
+  }
+
+  auto loaded = make_shared<RewriteCacheEntry>();
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, graph_file, &loaded->graph));
+  for (const auto& node : loaded->graph.node()) {
+    if (node.op() != kEncapsulateOp) {
+      continue;
+    }
+    int cluster_idx;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(AttrSlice(node), "ngraph_cluster", &cluster_idx));
+    TF_RETURN_IF_ERROR(ReadBinaryProto(
+        env, io::JoinPath(entry_dir, ClusterFileName(cluster_idx)),
+        &loaded->clusters[cluster_idx]));
+  }
+  entry = loaded;
+  return Status::OK();
+}
+
+Status NGraphRewriteCache::SaveToDisk(const string& key,
+                                      const RewriteCacheEntry& entry) {
+  Env* env = Env::Default();
+  string dir = RewriteCacheDir();
+  string entry_dir = io::JoinPath(dir, key);
+  if (env->FileExists(entry_dir).ok()) {
+    return Status::OK();
+  }
+
+  // Write into a private directory and rename it into place, so that readers
+  // in other processes never see a half-written entry.
+  string tmp_dir =
+      io::JoinPath(dir, strings::StrCat(key, ".tmp", env->NowMicros()));
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(tmp_dir));
+  TF_RETURN_IF_ERROR(
+      WriteBinaryProto(env, io::JoinPath(tmp_dir, "graph.pb"), entry.graph));
+  for (const auto& kv : entry.clusters) {
+    TF_RETURN_IF_ERROR(WriteBinaryProto(
+        env, io::JoinPath(tmp_dir, ClusterFileName(kv.first)), kv.second));
+  }
+
+  Status status = env->RenameFile(tmp_dir, entry_dir);
+  if (!status.ok()) {
+    // Most likely another process got there first.
+    int64 undeleted_files, undeleted_dirs;
+    env->DeleteRecursively(tmp_dir, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+    NGRAPH_VLOG(1) << "Could not publish rewrite cache entry " << entry_dir
+                   << ": " << status.error_message();
+  }
+  return Status::OK();
+}
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_REWRITE_CACHE_H_
+#define NGRAPH_TF_BRIDGE_REWRITE_CACHE_H_
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+#include "ngraph_bridge/ngraph_data_cache.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+// The result of one run of the rewrite pipeline (mark, assign, deassign,
+// encapsulate): the encapsulated graph and the cluster graphs its
+// NGraphEncapsulate nodes refer to, keyed by their original cluster index.
+struct RewriteCacheEntry {
+  GraphDef graph;
+  std::map<int, GraphDef> clusters;
+};
+
+//
+// Cache of rewritten graphs, so that reloading an identical GraphDef (e.g.
+// when a model is served again after a version bump or a new replica comes
+// up) does not rerun the whole rewrite pipeline.
+//
+// The key is a fingerprint of the canonicalized input GraphDef, the backend
+// name, the settings that change the rewrite (the NGRAPH_TF_DISABLE_* switches
+// of its phases and whether the backend takes parametric inputs), the set of
+// disabled ops, the nodes the caller wants skipped and the device config
+// attached to the encapsulates.
+//
+// Entries are kept in memory (NGRAPH_TF_REWRITE_CACHE_DEPTH entries, default
+// 8) and, if NGRAPH_TF_REWRITE_CACHE_DIR is set, also written to that
+// directory so that they survive process restarts. The cache can be turned
+// off altogether with NGRAPH_TF_DISABLE_REWRITE_CACHE.
+//
+class NGraphRewriteCache {
+ public:
+  // Returns false if the cache is disabled, or if the caller asked for
+  // something that only a full rewrite produces (intermediate graph dumps,
+  // placement logs).
+  static bool IsEnabled();
+
+  // Computes the cache key for graph_def.
+  static Status ComputeKey(
+      const GraphDef& graph_def, const std::set<std::string>& skip_these_nodes,
+      const std::unordered_map<std::string, std::string>& device_config,
+      std::string& key);
+
+  // Looks up key in memory, then on disk. On a hit the cached clusters are
+  // registered with NGraphClusterManager under fresh indices, and output is
+  // filled with the encapsulated graph rewired to those indices and tagged
+  // with graph_id.
+  static Status Lookup(const std::string& key, int graph_id, GraphDef* output,
+                       bool& cache_hit);
+
+  // Stores the encapsulated graph under key, along with copies of the
+  // cluster graphs it refers to.
+  static Status Insert(const std::string& key, const GraphDef& encapsulated);
+
+  // Drops all in-memory entries. Entries on disk are left alone.
+  static void Clear();
+
+ private:
+  static Status LoadFromDisk(const std::string& key,
+                             std::shared_ptr<RewriteCacheEntry>& entry);
+  static Status SaveToDisk(const std::string& key,
+                           const RewriteCacheEntry& entry);
+  static NgraphDataCache<std::string, std::shared_ptr<RewriteCacheEntry>>&
+  MemoryCache();
+};
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_REWRITE_CACHE_H_
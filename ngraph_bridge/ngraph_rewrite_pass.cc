@@ -20,6 +20,7 @@
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
 
 #include "logging/ngraph_log.h"
 #include "logging/tf_graph_writer.h"
@@ -28,7 +29,11 @@
 #include "ngraph_bridge/ngraph_cluster_manager.h"
 #include "ngraph_bridge/ngraph_deassign_clusters.h"
 #include "ngraph_bridge/ngraph_encapsulate_clusters.h"
+#include "ngraph_bridge/ngraph_fold_static_inputs.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "ngraph_bridge/ngraph_rewrite_cache.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 
 using namespace std;
@@ -65,6 +70,10 @@ mutex NGraphRewritePass::s_serial_counter_mutex;
 //   3. Cluster Deassignment [ngraph_deassign_clusters.cc]
 //   4. Cluster Encapsulation [ngraph_encapsulate_clusters.cc]
 //
+// If the same graph has been rewritten before (in this process, or in any
+// process sharing NGRAPH_TF_REWRITE_CACHE_DIR), all four phases are skipped
+// and the cached result is used instead [ngraph_rewrite_cache.cc].
+//
 // Between phases, graph dumps (in both .dot and .pbtxt format) may be
 // requested by setting the following environment variables:
 //
@@ -75,6 +84,9 @@ mutex NGraphRewritePass::s_serial_counter_mutex;
 //   NGRAPH_TF_DUMP_ENCAPSULATED_GRAPHS=1  dumps graphs after phase 4
 //   NGRAPH_TF_DUMP_GRAPHS=1               all of the above
 //
+// The time and counts of every phase go into a rewrite report for idx
+// [ngraph_rewrite_report.cc].
+//
 class NGraphEncapsulationPass : public NGraphRewritePass {
  public:
   Status Run(const GraphOptimizationPassOptions& options) override {
@@ -88,6 +100,7 @@ class NGraphEncapsulationPass : public NGraphRewritePass {
     // arbitrary integer to avoid filename collisions resulting from subsequent
     // runs of this pass.
     int idx = FreshIndex();
+    NGRAPH_TF_TRACE_SCOPE(TraceEvent::kRewritePass, idx);
 
     // If requested, dump unmarked graphs.
     if (DumpUnmarkedGraphs()) {
@@ -107,36 +120,85 @@ class NGraphEncapsulationPass : public NGraphRewritePass {
       NGRAPH_VLOG(1) << std::string("Rewrite pass will not run because ") +
                             (already_processed ? "graph is already preprocessed"
                                                : "ngraph is disabled");
-      NGraphClusterManager::EvictAllClusters();
       return Status::OK();
     }
 
     // Now Process the Graph
-
-    // 1. Mark for clustering then, if requested, dump the graphs.
     std::set<string> skip_these_nodes = {};
-    TF_RETURN_IF_ERROR(
-        MarkForClustering(options.graph->get(), skip_these_nodes));
+    std::unordered_map<std::string, std::string> config_map;
+    RewriteReport report(idx);
+
+    // 0. Reuse an earlier rewrite of the same graph, if there is one.
+    string cache_key;
+    if (NGraphRewriteCache::IsEnabled()) {
+      GraphDef input_graph_def;
+      options.graph->get()->ToGraphDef(&input_graph_def);
+      Status status = NGraphRewriteCache::ComputeKey(
+          input_graph_def, skip_these_nodes, config_map, cache_key);
+      if (!status.ok()) {
+        NGRAPH_VLOG(0) << "Rewrite cache disabled for this graph: "
+                       << status.error_message();
+        cache_key.clear();
+      }
+    }
+    if (!cache_key.empty()) {
+      GraphDef cached_graph_def;
+      bool cache_hit = false;
+      Status status = NGraphRewriteCache::Lookup(cache_key, idx,
+                                                 &cached_graph_def, cache_hit);
+      if (!status.ok()) {
+        NGRAPH_VLOG(0) << "Rewrite cache lookup failed: "
+                       << status.error_message();
+      } else if (cache_hit) {
+        GraphConstructorOptions opts;
+        opts.allow_internal_ops = true;
+        opts.expect_device_spec = true;
+        std::unique_ptr<Graph> cached_graph(new Graph(OpRegistry::Global()));
+        TF_RETURN_IF_ERROR(
+            ConvertGraphDefToGraph(opts, cached_graph_def, cached_graph.get()));
+        options.graph->swap(cached_graph);
+
+        if (DumpEncapsulatedGraphs()) {
+          DumpGraphs(options, idx, "encapsulated",
+                     "Graph with Clusters Encapsulated");
+        }
+        report.Finish(/*cache_hit=*/true);
+        return Status::OK();
+      }
+    }
+
+    // 1. Mark for clustering and fold the static inputs we can evaluate
+    //    then, if requested, dump the graphs.
+    Graph* graph = options.graph->get();
+    TF_RETURN_IF_ERROR(report.RunPhase("mark", [&]() {
+      return MarkForClustering(graph, skip_these_nodes);
+    }));
+    TF_RETURN_IF_ERROR(report.RunPhase("fold_static_inputs", [&]() {
+      return FoldStaticInputs(graph, skip_these_nodes);
+    }));
     if (DumpMarkedGraphs()) {
       DumpGraphs(options, idx, "marked", "Graph Marked for Clustering");
     }
 
     // 2. Assign clusters then, if requested, dump the graphs.
-    TF_RETURN_IF_ERROR(AssignClusters(options.graph->get()));
+    TF_RETURN_IF_ERROR(
+        report.RunPhase("assign", [&]() { return AssignClusters(graph); }));
     if (DumpClusteredGraphs()) {
       DumpGraphs(options, idx, "clustered", "Graph with Clusters Assigned");
     }
 
     // 3. Deassign trivial clusters then, if requested, dump the graphs.
-    TF_RETURN_IF_ERROR(DeassignClusters(options.graph->get()));
+    TF_RETURN_IF_ERROR(
+        report.RunPhase("deassign", [&]() { return DeassignClusters(graph); }));
     if (DumpDeclusteredGraphs()) {
       DumpGraphs(options, idx, "declustered",
                  "Graph with Trivial Clusters De-Assigned");
     }
 
     // 4. Encapsulate clusters then, if requested, dump the graphs.
-    std::unordered_map<std::string, std::string> config_map;
-    auto status = EncapsulateClusters(options.graph->get(), idx, config_map);
+    auto status = report.RunPhase("encapsulate", [&]() {
+      return EncapsulateClusters(graph, idx, config_map);
+    });
     if (status != Status::OK()) {
       return status;
     }
@@ -145,6 +207,17 @@ class NGraphEncapsulationPass : public NGraphRewritePass {
       DumpGraphs(options, idx, "encapsulated",
                  "Graph with Clusters Encapsulated");
     }
+
+    if (!cache_key.empty()) {
+      GraphDef output_graph_def;
+      options.graph->get()->ToGraphDef(&output_graph_def);
+      status = NGraphRewriteCache::Insert(cache_key, output_graph_def);
+      if (!status.ok()) {
+        NGRAPH_VLOG(0) << "Failed to cache rewritten graph: "
+                       << status.error_message();
+      }
+    }
+    report.Finish();
     return Status::OK();
   }
 };
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <cstdlib>
+#include <sstream>
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_metrics.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+constexpr int RewriteReport::kMaxReports;
+
+std::map<int, std::string> RewriteReport::s_reports;
+std::mutex RewriteReport::s_mutex;
+
+// The report whose phase is running on this thread
+static thread_local RewriteReport* s_current_report = nullptr;
+
+RewriteReport::RewriteReport(int graph_id) : m_graph_id(graph_id) {}
+
+RewriteReport::~RewriteReport() {
+  if (!m_finished) {
+    m_failed = true;
+    Finish();
+  }
+}
+
+Status RewriteReport::RunPhase(const string& phase,
+                               const std::function<Status()>& run_phase) {
+  m_phases.push_back({phase, 0, {}});
+  RewriteReport* outer_report = s_current_report;
+  s_current_report = this;
+  Timer phase_time;
+  Status status = run_phase();
+  m_phases.back().time_us = phase_time.ElapsedInMicroSec();
+  s_current_report = outer_report;
+  if (!status.ok()) {
+    m_failed = true;
+  }
+  return status;
+}
+
+void RewriteReport::Count(const string& name, int64 value) {
+  if (s_current_report != nullptr) {
+    s_current_report->AddCount(name, value);
+  }
+}
+
+void RewriteReport::AddCount(const string& name, int64 value) {
+  auto& counts = m_phases.back().counts;
+  for (auto& count : counts) {
+    if (count.first == name) {
+      count.second += value;
+      return;
+    }
+  }
+  counts.emplace_back(name, value);
+}
+
+void RewriteReport::RecordMetrics() const {
+  MetricsRegistry::GetCounter("ngraph_tf_rewrites_total",
+                              "Number of graphs rewritten")
+      ->Increment();
+  if (m_cache_hit) {
+    MetricsRegistry::GetCounter(
+        "ngraph_tf_rewrite_cache_hits_total",
+        "Number of graph rewrites taken from the rewrite cache")
+        ->Increment();
+  }
+  MetricsRegistry::GetHistogram("ngraph_tf_rewrite_time_us",
+                                "Wall time of a graph rewrite, in microseconds")
+      ->Record(m_total_us);
+  for (const auto& phase : m_phases) {
+    MetricsRegistry::GetHistogram(
+        strings::StrCat("ngraph_tf_rewrite_", phase.name, "_time_us"),
+        strings::StrCat("Wall time of the ", phase.name,
+                        " rewrite phase, in microseconds"))
+        ->Record(phase.time_us);
+    for (const auto& count : phase.counts) {
+      MetricsRegistry::GetCounter(
+          strings::StrCat("ngraph_tf_rewrite_", count.first, "_total"),
+          strings::StrCat("Sum of ", count.first, " over all ", phase.name,
+                          " rewrite phases"))
+          ->Increment(count.second);
+    }
+  }
+}
+
+void RewriteReport::Finish(bool cache_hit) {
+  m_finished = true;
+  m_cache_hit = cache_hit;
+  m_total_us = m_total_time.ElapsedInMicroSec();
+
+  if (m_failed) {
+    MetricsRegistry::GetCounter("ngraph_tf_rewrite_failures_total",
+                                "Number of graph rewrites that failed")
+        ->Increment();
+  } else {
+    RecordMetrics();
+  }
+
+  string json = ToJson();
+  NGRAPH_VLOG(1) << "Rewrite report: " << json;
+  {
+    std::lock_guard<std::mutex> guard(s_mutex);
+    s_reports[m_graph_id] = json;
+    while (s_reports.size() > static_cast<size_t>(kMaxReports)) {
+      s_reports.erase(s_reports.begin());
+    }
+  }
+
+  const char* dir_env = std::getenv("NGRAPH_TF_REWRITE_REPORT_DIR");
+  if (dir_env != nullptr) {
+    string path = io::JoinPath(
+        dir_env, strings::StrCat("ngtf_rewrite_", m_graph_id, ".json"));
+    Status status = WriteStringToFile(Env::Default(), path, json + "\n");
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "Could not write rewrite report: "
+                     << status.error_message();
+    }
+  }
+}
+
+string RewriteReport::ToJson() const {
+  std::ostringstream out;
+  out << "{\"graph_id\":" << m_graph_id
+      << ",\"cache_hit\":" << (m_cache_hit ? "true" : "false")
+      << ",\"failed\":" << (m_failed ? "true" : "false")
+      << ",\"time_us\":" << m_total_us << ",\"phases\":[";
+  for (size_t i = 0; i < m_phases.size(); i++) {
+    const Phase& phase = m_phases[i];
+    out << (i == 0 ? "" : ",") << "{\"name\":\"" << phase.name
+        << "\",\"time_us\":" << phase.time_us << ",\"counts\":{";
+    for (size_t j = 0; j < phase.counts.size(); j++) {
+      out << (j == 0 ? "" : ",") << "\"" << phase.counts[j].first
+          << "\":" << phase.counts[j].second;
+    }
+    out << "}}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+string RewriteReport::Get(int graph_id) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  if (graph_id != -1) {
+    auto it = s_reports.find(graph_id);
+    return it == s_reports.end() ? "" : it->second;
+  }
+  string reports = "[";
+  for (const auto& kv : s_reports) {
+    reports += (reports.size() == 1 ? "" : ",") + kv.second;
+  }
+  return reports + "]";
+}
+
+void RewriteReport::Reset() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_reports.clear();
+}
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
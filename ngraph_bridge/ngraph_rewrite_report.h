@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_REWRITE_REPORT_H_
+#define NGRAPH_TF_BRIDGE_REWRITE_REPORT_H_
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+#include "ngraph_bridge/ngraph_timer.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+//
+// Wall time and counts of every phase of one graph rewrite (marking, static
+// input folding, cluster assignment, deassignment and encapsulation).
+//
+// The rewrite passes run each phase through RunPhase(). The phases report
+// their counts (nodes marked, contraction iterations, edges by type, ...)
+// with Count(), which does nothing outside of RunPhase(), so the phases can
+// still be run on their own.
+//
+// Finish() adds the times and counts to the metrics
+// (ngraph_tf_rewrite_<phase>_time_us and ngraph_tf_rewrite_<count>_total),
+// and keeps the report as JSON, to be had from Get(graph_id). A report with
+// a failed phase is kept with "failed":true, and only counts towards
+// ngraph_tf_rewrite_failures_total, so that the metrics of the rewrites are
+// not skewed by the ones that stopped half way. If
+// NGRAPH_TF_REWRITE_REPORT_DIR is set, it is also written to
+// <dir>/ngtf_rewrite_<graph_id>.json.
+//
+class RewriteReport {
+ public:
+  explicit RewriteReport(int graph_id);
+  ~RewriteReport();
+
+  // Runs (and times) one phase of the rewrite. Counts reported while it
+  // runs on this thread go to this phase.
+  Status RunPhase(const std::string& phase,
+                  const std::function<Status()>& run_phase);
+  // Adds to a count of the phase that is running on this thread, if any.
+  static void Count(const std::string& name, int64 value);
+
+  // cache_hit tells that the rewrite was taken from the rewrite cache
+  // rather than run. A report that is not finished when it goes away (a
+  // phase failed) is finished then, as failed.
+  void Finish(bool cache_hit = false);
+  std::string ToJson() const;
+
+  // The report of graph_id as JSON, or a JSON array of all the reports kept
+  // if graph_id is -1. Empty if there is no such report. Only the reports of
+  // the last kMaxReports rewrites are kept.
+  static std::string Get(int graph_id = -1);
+  static void Reset();
+
+  static constexpr int kMaxReports = 256;
+
+ private:
+  struct Phase {
+    std::string name;
+    int64 time_us;
+    std::vector<std::pair<std::string, int64>> counts;
+  };
+
+  void AddCount(const std::string& name, int64 value);
+  void RecordMetrics() const;
+
+  int m_graph_id;
+  Timer m_total_time;
+  int64 m_total_us = 0;
+  bool m_cache_hit = false;
+  bool m_failed = false;
+  bool m_finished = false;
+  std::vector<Phase> m_phases;
+
+  static std::map<int, std::string> s_reports;
+  static std::mutex s_mutex;
+};
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_REWRITE_REPORT_H_
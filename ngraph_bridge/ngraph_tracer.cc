@@ -0,0 +1,253 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_tracer.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+std::atomic<bool> Tracer::s_enabled{false};
+std::vector<std::unique_ptr<Tracer::ThreadBuffer>> Tracer::s_buffers;
+std::mutex Tracer::s_mutex;
+
+struct TraceEventInfo {
+  const char* name;
+  const char* category;
+};
+
+// Indexed by TraceEvent
+static const TraceEventInfo kTraceEvents[] = {
+    {"NGraphRewritePass", "rewrite"},
+    {"NgraphOptimizer", "rewrite"},
+    {"MarkForClustering", "rewrite"},
+    {"FoldStaticInputs", "rewrite"},
+    {"AssignClusters", "rewrite"},
+    {"DeassignClusters", "rewrite"},
+    {"EncapsulateClusters", "rewrite"},
+    {"Create Encapsulate", "encapsulate"},
+    {"Destroy Encapsulate", "encapsulate"},
+    {"Compute", "encapsulate"},
+    {"Get Executable", "compile"},
+    {"Translate Graph", "compile"},
+    {"nGraph Pass", "compile"},
+    {"Compile nGraph", "compile"},
+    {"Input Tensors", "execute"},
+    {"Output Tensors", "execute"},
+    {"Execute nGraph", "execute"},
+    {"Tensor Read D2H", "execute"},
+    {"Tensor Write H2D", "execute"},
+};
+static_assert(sizeof(kTraceEvents) / sizeof(kTraceEvents[0]) ==
+                  static_cast<size_t>(TraceEvent::kNumEvents),
+              "Every TraceEvent needs a name");
+
+static std::atomic<bool> s_flush_requested{false};
+
+static void RequestFlush(int) {
+  s_flush_requested.store(true, std::memory_order_relaxed);
+}
+
+static string DefaultTracePath() {
+  const char* path_env = std::getenv("NGRAPH_TF_TRACE_FILE");
+  if (path_env != nullptr) {
+    return path_env;
+  }
+  return strings::StrCat("ngtf_trace_", getpid(), ".json");
+}
+
+static size_t TraceBufferSize() {
+  size_t size = 16384;
+  const char* size_env = std::getenv("NGRAPH_TF_TRACE_BUFFER_SIZE");
+  if (size_env != nullptr) {
+    size = std::max(1, atoi(size_env));
+  }
+  return size;
+}
+
+void Tracer::Enable() {
+  StartFlushThread();
+  s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Disable() { s_enabled.store(false, std::memory_order_relaxed); }
+
+int64 Tracer::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Tracer::ThreadBuffer* Tracer::NewThreadBuffer() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  // Buffers outlive their threads, so that a flush at exit still sees what
+  // finished threads recorded.
+  s_buffers.emplace_back(new ThreadBuffer());
+  ThreadBuffer* buffer = s_buffers.back().get();
+  buffer->tid = s_buffers.size();
+  buffer->size = TraceBufferSize();
+  buffer->slots.reset(new TraceSlot[buffer->size]);
+  return buffer;
+}
+
+void Tracer::Record(TraceEvent event, int64 arg, const char* detail,
+                    int64 start_ns, int64 end_ns) {
+  static thread_local ThreadBuffer* buffer = NewThreadBuffer();
+  uint64 head = buffer->head.load(std::memory_order_relaxed);
+  TraceSlot& slot = buffer->slots[head % buffer->size];
+  slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.start_ns.store(start_ns, std::memory_order_relaxed);
+  slot.end_ns.store(end_ns, std::memory_order_relaxed);
+  slot.arg.store(arg, std::memory_order_relaxed);
+  slot.detail.store(detail, std::memory_order_relaxed);
+  slot.event.store(static_cast<uint8>(event), std::memory_order_relaxed);
+  slot.seq.store(2 * head + 2, std::memory_order_release);
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Tracer::TraceSlot::Read(uint64 n, TraceRecord& record) const {
+  uint64 before = seq.load(std::memory_order_acquire);
+  if (before != 2 * n + 2) {
+    return false;
+  }
+  record.start_ns = start_ns.load(std::memory_order_relaxed);
+  record.end_ns = end_ns.load(std::memory_order_relaxed);
+  record.arg = arg.load(std::memory_order_relaxed);
+  record.detail = detail.load(std::memory_order_relaxed);
+  record.event = static_cast<TraceEvent>(event.load(std::memory_order_relaxed));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return seq.load(std::memory_order_relaxed) == before;
+}
+
+Status Tracer::Flush(const string& path) {
+  string trace_path = path.empty() ? DefaultTracePath() : path;
+  int pid = getpid();
+
+  std::ostringstream out;
+  // Chrome wants microseconds; keep the nanoseconds as decimals.
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> guard(s_mutex);
+  for (const auto& buffer : s_buffers) {
+    uint64 size = buffer->size;
+    uint64 head = buffer->head.load(std::memory_order_acquire);
+    uint64 begin = buffer->start.load(std::memory_order_relaxed);
+    if (head > size) {
+      begin = std::max(begin, head - size);
+    }
+    // The owning thread keeps recording while we copy; the records it
+    // overwrites in the meantime are dropped.
+    std::vector<TraceRecord> records;
+    TraceRecord copy;
+    for (uint64 i = begin; i < head; i++) {
+      if (buffer->slots[i % size].Read(i, copy)) {
+        records.push_back(copy);
+      }
+    }
+
+    for (const TraceRecord& record : records) {
+      const TraceEventInfo& info =
+          kTraceEvents[static_cast<int>(record.event)];
+      out << (first ? "" : ",") << "\n{\"name\":\"" << info.name
+          << "\",\"cat\":\"" << info.category << "\",\"ph\":\"X\""
+          << ",\"ts\":" << record.start_ns / 1000.0
+          << ",\"dur\":" << (record.end_ns - record.start_ns) / 1000.0
+          << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+          << ",\"args\":{\"id\":" << record.arg;
+      if (record.detail != nullptr) {
+        out << ",\"detail\":\"" << record.detail << "\"";
+      }
+      out << "}}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+
+  NGRAPH_VLOG(1) << "Writing trace to " << trace_path;
+  return WriteStringToFile(Env::Default(), trace_path, out.str());
+}
+
+void Tracer::Clear() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  for (auto& buffer : s_buffers) {
+    buffer->start.store(buffer->head.load(std::memory_order_acquire),
+                        std::memory_order_relaxed);
+  }
+}
+
+// Flushes on SIGUSR2, and at exit unless tracing was turned off. The signal
+// handler only sets a flag; the actual work happens on a background thread.
+void Tracer::StartFlushThread() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    struct sigaction action = {};
+    action.sa_handler = RequestFlush;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, nullptr);
+
+    std::thread([]() {
+      while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (s_flush_requested.exchange(false)) {
+          Status status = Flush();
+          if (!status.ok()) {
+            NGRAPH_VLOG(0) << "Could not write trace: "
+                           << status.error_message();
+          }
+        }
+      }
+    })
+        .detach();
+
+    std::atexit([]() {
+      if (!IsEnabled()) {
+        return;
+      }
+      Status status = Flush();
+      if (!status.ok()) {
+        NGRAPH_VLOG(0) << "Could not write trace: " << status.error_message();
+      }
+    });
+  });
+}
+
+static bool s_trace_from_env = []() {
+  const char* trace_env = std::getenv("NGRAPH_TF_TRACE");
+  if (trace_env == nullptr || string(trace_env) == "0") {
+    return false;
+  }
+  Tracer::Enable();
+  return true;
+}();
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
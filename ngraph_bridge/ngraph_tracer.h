@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_TRACER_H_
+#define NGRAPH_TF_BRIDGE_TRACER_H_
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+
+// Everything the bridge can trace. The names (and categories) that show up
+// in the trace are in ngraph_tracer.cc.
+enum class TraceEvent : uint8 {
+  // Rewrite passes
+  kRewritePass,
+  kGrapplerPass,
+  kMarkForClustering,
+  kFoldStaticInputs,
+  kAssignClusters,
+  kDeassignClusters,
+  kEncapsulateClusters,
+  // Encapsulate kernel
+  kEncapsulateCreate,
+  kEncapsulateDestroy,
+  kCompute,
+  kGetExecutable,
+  kTranslate,
+  kNgraphPass,
+  kCompile,
+  kInputTensors,
+  kOutputTensors,
+  kExecute,
+  kTensorRead,
+  kTensorWrite,
+  kNumEvents
+};
+
+//
+// A tracer meant to stay compiled in: when tracing is off, a trace scope
+// costs one relaxed atomic load. When it is on, each thread appends
+// fixed-size records to its own ring buffer (NGRAPH_TF_TRACE_BUFFER_SIZE
+// records, default 16384), without taking any lock, so the buffers hold
+// the most recent events of every thread. Each record carries a sequence
+// number, seqlock-style, so that a flush skips the records that are
+// overwritten while it copies them.
+//
+// Tracing is turned on by NGRAPH_TF_TRACE=1 or Enable(). The buffers are
+// written out as Chrome trace JSON (chrome://tracing) by Flush(), on
+// SIGUSR2 and at exit, to NGRAPH_TF_TRACE_FILE (default
+// ngtf_trace_<pid>.json) unless a path is given.
+//
+class Tracer {
+ public:
+  static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+  static void Enable();
+  static void Disable();
+
+  static int64 NowNs();
+  // detail, if given, must outlive the tracer (i.e. be a literal).
+  static void Record(TraceEvent event, int64 arg, const char* detail,
+                     int64 start_ns, int64 end_ns);
+
+  static Status Flush(const std::string& path = "");
+  // Drops everything recorded so far.
+  static void Clear();
+
+ private:
+  struct TraceRecord {
+    int64 start_ns;
+    int64 end_ns;
+    int64 arg;
+    const char* detail;
+    TraceEvent event;
+  };
+
+  // A slot of a ring buffer. The n-th record of the thread is being written
+  // while seq is 2n+1, and is complete once seq is 2n+2. The fields are
+  // atomics so that a flush may read them while they are written.
+  struct TraceSlot {
+    std::atomic<uint64> seq{0};
+    std::atomic<int64> start_ns{0};
+    std::atomic<int64> end_ns{0};
+    std::atomic<int64> arg{0};
+    std::atomic<const char*> detail{nullptr};
+    std::atomic<uint8> event{0};
+
+    // Copies the n-th record into record, unless the slot holds another one
+    // or is overwritten during the copy
+    bool Read(uint64 n, TraceRecord& record) const;
+  };
+
+  struct ThreadBuffer {
+    int tid;
+    uint64 size;
+    std::unique_ptr<TraceSlot[]> slots;
+    // Only the owning thread writes head; start is moved by Clear().
+    std::atomic<uint64> head{0};
+    std::atomic<uint64> start{0};
+  };
+
+  static ThreadBuffer* NewThreadBuffer();
+  static void StartFlushThread();
+
+  static std::atomic<bool> s_enabled;
+  static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+  static std::mutex s_mutex;
+};
+
+// Records event for as long as it is in scope.
+class TraceScope {
+ public:
+  explicit TraceScope(TraceEvent event, int64 arg = -1,
+                      const char* detail = nullptr)
+      : m_event(event),
+        m_arg(arg),
+        m_detail(detail),
+        m_start_ns(Tracer::IsEnabled() ? Tracer::NowNs() : -1) {}
+  ~TraceScope() {
+    if (m_start_ns >= 0) {
+      Tracer::Record(m_event, m_arg, m_detail, m_start_ns, Tracer::NowNs());
+    }
+  }
+
+ private:
+  TraceEvent m_event;
+  int64 m_arg;
+  const char* m_detail;
+  int64 m_start_ns;
+};
+
+#define NGRAPH_TF_TRACE_CONCAT_(a, b) a##b
+#define NGRAPH_TF_TRACE_CONCAT(a, b) NGRAPH_TF_TRACE_CONCAT_(a, b)
+
+// Traces the rest of the enclosing scope, e.g.
+//   NGRAPH_TF_TRACE_SCOPE(TraceEvent::kExecute, cluster_id);
+#define NGRAPH_TF_TRACE_SCOPE(...)                                       \
+  ::tensorflow::ngraph_bridge::TraceScope NGRAPH_TF_TRACE_CONCAT(        \
+      ngraph_tf_trace_scope_, __LINE__) {                                \
+    __VA_ARGS__                                                          \
+  }
+
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_TRACER_H_
@@ -29,6 +29,7 @@
 #include "tensorflow/core/platform/default/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 
+#include "ngraph_bridge/ngraph_tracer.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "ngraph_bridge/version.h"
 
@@ -111,7 +112,7 @@ bool IsNGSupportedType(string node_type) {
 // Read from this ng_tensor into tf_tensor
 void ReadNGTensor(shared_ptr<ng::runtime::Tensor> ng_tensor,
                   Tensor* tf_tensor) {
-  NG_TRACE("Tensor Read D2H", "", "");
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kTensorRead);
   void* tf_src_ptr = (void*)DMAHelper::base(tf_tensor);
   ng_tensor->read(tf_src_ptr, ng_tensor->get_element_count() *
                                   ng_tensor->get_element_type().size());
@@ -120,7 +121,7 @@ void ReadNGTensor(shared_ptr<ng::runtime::Tensor> ng_tensor,
 // Write into this ng_tensor from tf_tensor
 void WriteNGTensor(shared_ptr<ng::runtime::Tensor> ng_tensor,
                    Tensor* tf_tensor) {
-  NG_TRACE("Tensor Write H2D", "", "");
+  NGRAPH_TF_TRACE_SCOPE(TraceEvent::kTensorWrite);
   void* tf_src_ptr = (void*)DMAHelper::base(tf_tensor);
   ng_tensor->write(tf_src_ptr, ng_tensor->get_element_count() *
                                    ng_tensor->get_element_type().size());
@@ -453,29 +454,6 @@ Status StringToFile(const std::string& file_name, const std::string& contents,
   return Status::OK();
 }
 
-void MemoryProfile(long& vm_usage, long& resident_set) {
-  vm_usage = 0;
-  resident_set = 0;
-
-  // Get the two fields we want
-  long vsize;
-  long rss;
-
-  std::ifstream ifs("/proc/self/stat", std::ios_base::in);
-  std::string mem_in;
-  getline(ifs, mem_in);
-  if (mem_in != "") {
-    vector<string> mem_str = ng::split(mem_in, ' ');
-    vsize = std::stol(mem_str[22]);
-    rss = std::stol(mem_str[23]);
-
-    long page_size_kb = sysconf(_SC_PAGE_SIZE) /
-                        1024;  // in case x86-64 is configured to use 2MB pages
-    vm_usage = vsize / 1024;   // unit kb
-    resident_set = rss * page_size_kb;
-  }
-}
-
 std::string DotFilename(std::string kind, int idx) {
   return GraphFilenamePrefix(kind, idx) + ".dot";
 }
@@ -346,9 +346,6 @@ Status StringToFile(const std::string&, const std::string&,
 // Remove '/' from file name (which might appear due to say, tf scopes)
 string SanitizeFileName(const string file_name);
 
-// Collect the total memory usage through /proc/self/stat
-void MemoryProfile(long&, long&);
-
 std::string DotFilename(std::string, int);
 
 std::string DotFilename(std::string kind, int idx, int sub_idx);
@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <sstream>
+#include <unordered_map>
+
+#include "ngraph/op/util/arithmetic_reductions_keep_dims.hpp"
+#include "ngraph/op/util/logical_reduction_keep_dims.hpp"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/default_opset.h"
+#include "ngraph_bridge/pass/common_subexpression_elimination.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+static void WriteVector(ostream& key, const vector<int64_t>& values) {
+  key << "{";
+  for (auto value : values) {
+    key << value << ",";
+  }
+  key << "}";
+}
+
+// Writes the attributes of node to key. Returns false for ops whose
+// attributes are not known here, which are never merged. Element types
+// that are attributes (Convert, ShapeOf) are told apart by the output
+// types, which are part of the key anyway.
+static bool WriteAttributes(const shared_ptr<ngraph::Node>& node,
+                            ostream& key) {
+  if (node->is_unary_elementwise_arithmetic() ||
+      ngraph::is_type<opset::Convert>(node) ||
+      ngraph::is_type<opset::LogicalNot>(node) ||
+      ngraph::is_type<opset::Transpose>(node) ||
+      ngraph::is_type<opset::ShapeOf>(node) ||
+      ngraph::is_type<opset::Squeeze>(node) ||
+      ngraph::is_type<opset::Unsqueeze>(node) ||
+      ngraph::is_type<opset::Gather>(node) ||
+      ngraph::is_type<opset::VariadicSplit>(node)) {
+    return true;
+  }
+  if (node->is_binary_elementwise_arithmetic() ||
+      node->is_binary_elementwise_comparison() ||
+      node->is_binary_elementwise_logical()) {
+    const auto& autob = node->get_autob();
+    key << static_cast<int>(autob.m_type) << "," << autob.m_axis;
+    if (auto divide = ngraph::as_type_ptr<opset::Divide>(node)) {
+      key << "," << divide->is_pythondiv();
+    }
+    return true;
+  }
+  if (auto reshape = ngraph::as_type_ptr<opset::Reshape>(node)) {
+    key << reshape->get_special_zero();
+    return true;
+  }
+  if (auto concat = ngraph::as_type_ptr<opset::Concat>(node)) {
+    key << concat->get_concatenation_axis();
+    return true;
+  }
+  if (auto reduction = dynamic_pointer_cast<
+          ngraph::op::util::ArithmeticReductionKeepDims>(node)) {
+    key << reduction->get_keep_dims();
+    return true;
+  }
+  if (auto reduction =
+          dynamic_pointer_cast<ngraph::op::util::LogicalReductionKeepDims>(
+              node)) {
+    key << reduction->get_keep_dims();
+    return true;
+  }
+  if (auto split = ngraph::as_type_ptr<opset::Split>(node)) {
+    key << split->get_num_splits();
+    return true;
+  }
+  if (auto slice = ngraph::as_type_ptr<opset::StridedSlice>(node)) {
+    WriteVector(key, slice->get_begin_mask());
+    WriteVector(key, slice->get_end_mask());
+    WriteVector(key, slice->get_new_axis_mask());
+    WriteVector(key, slice->get_shrink_axis_mask());
+    WriteVector(key, slice->get_ellipsis_mask());
+    return true;
+  }
+  if (auto softmax = ngraph::as_type_ptr<opset::Softmax>(node)) {
+    key << softmax->get_axis();
+    return true;
+  }
+  return false;
+}
+
+bool CommonSubexpressionElimination::run_on_function(
+    shared_ptr<ngraph::Function> f) {
+  // The key of an op is its type, its inputs, its output types and its
+  // attributes. Inputs are the (node, output) they come from; since the ops
+  // are visited in topological order, the inputs of an op are merged before
+  // the op is keyed.
+  unordered_map<string, shared_ptr<ngraph::Node>> ops;
+  size_t merged = 0;
+  for (const auto& node : f->get_ordered_ops()) {
+    if (!node->get_control_dependencies().empty()) {
+      continue;
+    }
+    ostringstream key;
+    key << node->get_type_info().name << "." << node->get_type_info().version
+        << "(";
+    for (const auto& input : node->input_values()) {
+      key << static_cast<const void*>(input.get_node()) << ":"
+          << input.get_index() << ",";
+    }
+    key << ")";
+    for (const auto& output : node->outputs()) {
+      key << output.get_element_type() << ",";
+    }
+    key << "[";
+    if (!WriteAttributes(node, key)) {
+      continue;
+    }
+    key << "]";
+
+    auto it = ops.find(key.str());
+    if (it == ops.end()) {
+      ops.emplace(key.str(), node);
+      continue;
+    }
+    NGRAPH_VLOG(4) << "Replacing " << node->get_name() << " with "
+                   << it->second->get_name();
+    ngraph::replace_node(node, it->second);
+    merged++;
+  }
+  NGRAPH_VLOG(2) << "CommonSubexpressionElimination: merged " << merged
+                 << " ops";
+  return merged > 0;
+}
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
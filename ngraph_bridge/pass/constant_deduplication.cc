@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <cstring>
+#include <map>
+#include <tuple>
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/default_opset.h"
+#include "ngraph_bridge/pass/constant_deduplication.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+static size_t DataSize(const opset::Constant& constant) {
+  return ngraph::shape_size(constant.get_shape()) *
+         constant.get_element_type().size();
+}
+
+// FNV-1a over the data of constant
+static uint64_t HashData(const opset::Constant& constant) {
+  auto data = static_cast<const unsigned char*>(constant.get_data_ptr());
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < DataSize(constant); i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool ConstantDeduplication::run_on_function(shared_ptr<ngraph::Function> f) {
+  using Key = tuple<ngraph::element::Type, ngraph::Shape, uint64_t>;
+  map<Key, vector<shared_ptr<opset::Constant>>> constants;
+  size_t removed = 0;
+  for (const auto& node : f->get_ordered_ops()) {
+    auto constant = ngraph::as_type_ptr<opset::Constant>(node);
+    // constants of less than a byte per element are packed
+    if (!constant || constant->get_element_type().bitwidth() < 8) {
+      continue;
+    }
+    auto& candidates =
+        constants[Key(constant->get_element_type(), constant->get_shape(),
+                      HashData(*constant))];
+    bool replaced = false;
+    for (const auto& candidate : candidates) {
+      if (memcmp(candidate->get_data_ptr(), constant->get_data_ptr(),
+                 DataSize(*constant)) == 0) {
+        NGRAPH_VLOG(4) << "Replacing " << constant->get_name() << " with "
+                       << candidate->get_name();
+        ngraph::replace_node(constant, candidate);
+        removed++;
+        replaced = true;
+        break;
+      }
+    }
+    if (!replaced) {
+      candidates.push_back(constant);
+    }
+  }
+  NGRAPH_VLOG(2) << "ConstantDeduplication: removed " << removed
+                 << " constants";
+  return removed > 0;
+}
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,379 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <cmath>
+
+#include "ngraph/pattern/matcher.hpp"
+#include "ngraph/pattern/op/label.hpp"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/default_opset.h"
+#include "ngraph_bridge/pass/fusions.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+using ngraph::pattern::op::Label;
+
+// A label for any value but a constant, so that the operands of commutative
+// ops only match one way. The shapes of the labels only need to let the
+// pattern validate; the matcher does not look at them.
+static shared_ptr<Label> AnyValue(const ngraph::Shape& shape) {
+  ngraph::pattern::op::NodePredicate not_constant =
+      [](shared_ptr<ngraph::Node> node) {
+        return !ngraph::is_type<opset::Constant>(node);
+      };
+  return make_shared<Label>(ngraph::element::f32, shape, not_constant);
+}
+
+static shared_ptr<Label> AnyConstant(const ngraph::element::Type& type,
+                                     const ngraph::Shape& shape) {
+  return make_shared<Label>(type, shape,
+                            ngraph::pattern::has_class<opset::Constant>());
+}
+
+// A label that matches what node matches, so that the match is in the
+// pattern map
+static shared_ptr<Label> Wrap(const shared_ptr<ngraph::Node>& node) {
+  return make_shared<Label>(node, nullptr, ngraph::NodeVector{node});
+}
+
+// Whether value is a constant with all its elements close to expected. The
+// translation fills some constants to the shape of the other operand, so
+// the callbacks check the shape of the result instead.
+static bool IsConstantValue(const ngraph::Output<ngraph::Node>& value,
+                            double expected) {
+  auto constant =
+      ngraph::as_type_ptr<opset::Constant>(value.get_node_shared_ptr());
+  if (!constant || ngraph::shape_size(constant->get_shape()) == 0) {
+    return false;
+  }
+  for (auto element : constant->cast_vector<double>()) {
+    if (std::abs(element - expected) > 1e-5 * std::abs(expected) + 1e-7) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void Replace(const shared_ptr<ngraph::Node>& node,
+                    const shared_ptr<ngraph::Node>& replacement) {
+  NGRAPH_VLOG(4) << "Replacing " << node->get_name() << " with "
+                 << replacement->get_name();
+  replacement->set_friendly_name(node->get_friendly_name());
+  replacement->add_provenance_tags(node->get_provenance_tags());
+  ngraph::replace_node(node, replacement);
+}
+
+ConvBatchNormFusion::ConvBatchNormFusion() {
+  for (bool with_bias : {false, true}) {
+    auto input = AnyValue({1, 3, 5, 5});
+    auto filter = AnyConstant(ngraph::element::f32, {4, 3, 3, 3});
+    auto conv = Wrap(make_shared<opset::Convolution>(
+        input, filter, ngraph::Strides{1, 1}, ngraph::CoordinateDiff{0, 0},
+        ngraph::CoordinateDiff{0, 0}, ngraph::Strides{1, 1}));
+    auto bias = AnyConstant(ngraph::element::f32, {1, 4, 1, 1});
+    auto bn_input =
+        with_bias ? Wrap(make_shared<opset::Add>(conv, bias)) : conv;
+    auto gamma = AnyConstant(ngraph::element::f32, {4});
+    auto beta = AnyConstant(ngraph::element::f32, {4});
+    auto mean = AnyConstant(ngraph::element::f32, {4});
+    auto variance = AnyConstant(ngraph::element::f32, {4});
+    auto bn = make_shared<opset::BatchNormInference>(bn_input, gamma, beta,
+                                                     mean, variance, 0.001);
+
+    ngraph::graph_rewrite_callback callback = [=](
+        ngraph::pattern::Matcher& m) {
+      auto pattern_map = m.get_pattern_value_map();
+      auto bn_node = ngraph::as_type_ptr<opset::BatchNormInference>(
+          m.get_match_root());
+      auto conv_node = pattern_map[conv].get_node_shared_ptr();
+      // the convolution and its bias must not be used elsewhere
+      if (conv_node->get_users().size() != 1 ||
+          pattern_map[bn_input].get_node_shared_ptr()->get_users().size() !=
+              1) {
+        return false;
+      }
+
+      auto as_constant = [&pattern_map](const shared_ptr<Label>& label) {
+        return ngraph::as_type_ptr<opset::Constant>(
+            pattern_map[label].get_node_shared_ptr());
+      };
+      auto filter_const = as_constant(filter);
+      vector<shared_ptr<opset::Constant>> constants{
+          filter_const, as_constant(gamma), as_constant(beta),
+          as_constant(mean), as_constant(variance)};
+      if (with_bias) {
+        constants.push_back(as_constant(bias));
+      }
+      auto out_shape = conv_node->get_output_shape(0);
+      size_t channels = out_shape.at(1);
+      for (size_t i = 0; i < constants.size(); i++) {
+        if (constants[i]->get_element_type() != ngraph::element::f32) {
+          return false;
+        }
+        // the filter and the batch norm parameters are per channel
+        if (i > 0 && i < 5 &&
+            ngraph::shape_size(constants[i]->get_shape()) != channels) {
+          return false;
+        }
+      }
+      if (filter_const->get_shape().at(0) != channels) {
+        return false;
+      }
+
+      vector<float> conv_bias(channels, 0.0f);
+      if (with_bias) {
+        auto bias_shape = constants.back()->get_shape();
+        auto bias_values = constants.back()->cast_vector<float>();
+        if (bias_values.size() == 1) {
+          conv_bias.assign(channels, bias_values[0]);
+        } else {
+          if (bias_shape.size() > out_shape.size()) {
+            return false;
+          }
+          bias_shape.insert(bias_shape.begin(),
+                            out_shape.size() - bias_shape.size(), 1);
+          for (size_t i = 0; i < bias_shape.size(); i++) {
+            if (bias_shape[i] != (i == 1 ? channels : 1)) {
+              return false;
+            }
+          }
+          conv_bias = bias_values;
+        }
+      }
+
+      // y = gamma * (conv(x, W) + b - mean) / sqrt(variance + eps) + beta
+      //   = conv(x, W * scale) + (b - mean) * scale + beta
+      // with scale = gamma / sqrt(variance + eps), per output channel
+      auto eps = bn_node->get_eps_value();
+      auto gamma_values = constants[1]->cast_vector<float>();
+      auto beta_values = constants[2]->cast_vector<float>();
+      auto mean_values = constants[3]->cast_vector<float>();
+      auto variance_values = constants[4]->cast_vector<float>();
+      auto filter_values = filter_const->cast_vector<float>();
+      size_t per_channel = filter_values.size() / channels;
+      vector<float> new_bias(channels);
+      for (size_t c = 0; c < channels; c++) {
+        float scale = gamma_values[c] / std::sqrt(variance_values[c] + eps);
+        for (size_t j = 0; j < per_channel; j++) {
+          filter_values[c * per_channel + j] *= scale;
+        }
+        new_bias[c] = (conv_bias[c] - mean_values[c]) * scale + beta_values[c];
+      }
+
+      auto new_filter = make_shared<opset::Constant>(
+          ngraph::element::f32, filter_const->get_shape(), filter_values);
+      auto new_conv = conv_node->copy_with_new_inputs(
+          {conv_node->input_value(0), new_filter});
+      new_conv->set_friendly_name(conv_node->get_friendly_name());
+      ngraph::Shape bias_shape(out_shape.size(), 1);
+      bias_shape[1] = channels;
+      auto new_add = make_shared<opset::Add>(
+          new_conv, make_shared<opset::Constant>(ngraph::element::f32,
+                                                 bias_shape, new_bias));
+      Replace(bn_node, new_add);
+      return true;
+    };
+    add_matcher(
+        make_shared<ngraph::pattern::Matcher>(bn, "ConvBatchNormFusion"),
+        callback, ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE);
+  }
+}
+
+LayerNormFusion::LayerNormFusion() {
+  // the square is either Square, which the translation turns into a
+  // Multiply, or SquaredDifference
+  for (bool squared_difference : {false, true}) {
+    auto input = AnyValue({2, 4});
+    auto mean_axes = AnyConstant(ngraph::element::i64, {1});
+    auto mean =
+        Wrap(make_shared<opset::ReduceMean>(input, mean_axes, true));
+    auto centered = make_shared<opset::Subtract>(input, mean);
+    shared_ptr<ngraph::Node> squared;
+    if (squared_difference) {
+      squared = make_shared<opset::SquaredDifference>(input, mean);
+    } else {
+      squared = make_shared<opset::Multiply>(centered, centered);
+    }
+    auto variance_axes = AnyConstant(ngraph::element::i64, {1});
+    auto variance =
+        Wrap(make_shared<opset::ReduceMean>(squared, variance_axes, true));
+    auto epsilon = AnyConstant(ngraph::element::f32, {});
+    auto exponent = AnyConstant(ngraph::element::f32, {});
+    auto rsqrt = make_shared<opset::Power>(
+        make_shared<opset::Add>(variance, epsilon), exponent);
+    auto layer_norm = make_shared<opset::Multiply>(centered, rsqrt);
+
+    ngraph::graph_rewrite_callback callback = [=](
+        ngraph::pattern::Matcher& m) {
+      auto pattern_map = m.get_pattern_value_map();
+      auto x = pattern_map[input];
+      auto mean_node = ngraph::as_type_ptr<opset::ReduceMean>(
+          pattern_map[mean].get_node_shared_ptr());
+      auto variance_node = ngraph::as_type_ptr<opset::ReduceMean>(
+          pattern_map[variance].get_node_shared_ptr());
+      if (!x.get_element_type().is_real() || !mean_node->get_keep_dims() ||
+          !variance_node->get_keep_dims() ||
+          !mean_node->reduction_axes_constant() ||
+          !variance_node->reduction_axes_constant() ||
+          mean_node->get_reduction_axes() !=
+              variance_node->get_reduction_axes() ||
+          !IsConstantValue(pattern_map[exponent], -0.5) ||
+          m.get_match_root()->get_output_shape(0) != x.get_shape()) {
+        return false;
+      }
+      // MVN adds its eps to the standard deviation, not to the variance, so
+      // only a layer norm without one computes the same
+      auto epsilon_const = ngraph::as_type_ptr<opset::Constant>(
+          pattern_map[epsilon].get_node_shared_ptr());
+      if (ngraph::shape_size(epsilon_const->get_shape()) != 1 ||
+          epsilon_const->cast_vector<double>()[0] != 0.0) {
+        return false;
+      }
+      auto mvn = make_shared<opset::MVN>(x, mean_node->get_reduction_axes(),
+                                         true, 0.0);
+      Replace(m.get_match_root(), mvn);
+      return true;
+    };
+    add_matcher(
+        make_shared<ngraph::pattern::Matcher>(layer_norm, "LayerNormFusion"),
+        callback, ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE);
+  }
+}
+
+GeluFusion::GeluFusion() {
+  // x / sqrt(2) or x * (1 / sqrt(2)), and (0.5 * x) * cdf (Keras) or
+  // x * (0.5 * cdf) (BERT)
+  for (bool divide : {true, false}) {
+    for (bool half_times_input : {true, false}) {
+      auto input = AnyValue({2, 4});
+      auto scale = AnyConstant(ngraph::element::f32, {});
+      auto half = AnyConstant(ngraph::element::f32, {});
+      auto one = AnyConstant(ngraph::element::f32, {});
+      shared_ptr<ngraph::Node> scaled;
+      if (divide) {
+        scaled = make_shared<opset::Divide>(input, scale);
+      } else {
+        scaled = make_shared<opset::Multiply>(input, scale);
+      }
+      auto cdf =
+          make_shared<opset::Add>(make_shared<opset::Erf>(scaled), one);
+      shared_ptr<ngraph::Node> gelu;
+      if (half_times_input) {
+        gelu = make_shared<opset::Multiply>(
+            make_shared<opset::Multiply>(input, half), cdf);
+      } else {
+        gelu = make_shared<opset::Multiply>(
+            input, make_shared<opset::Multiply>(half, cdf));
+      }
+
+      ngraph::graph_rewrite_callback callback = [=](
+          ngraph::pattern::Matcher& m) {
+        auto pattern_map = m.get_pattern_value_map();
+        auto x = pattern_map[input];
+        double expected_scale = divide ? std::sqrt(2.0) : std::sqrt(0.5);
+        if (!x.get_element_type().is_real() ||
+            !IsConstantValue(pattern_map[scale], expected_scale) ||
+            !IsConstantValue(pattern_map[half], 0.5) ||
+            !IsConstantValue(pattern_map[one], 1.0) ||
+            m.get_match_root()->get_output_shape(0) != x.get_shape()) {
+          return false;
+        }
+        Replace(m.get_match_root(), make_shared<opset::Gelu>(x));
+        return true;
+      };
+      add_matcher(make_shared<ngraph::pattern::Matcher>(gelu, "GeluFusion"),
+                  callback, ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE);
+    }
+  }
+}
+
+SoftmaxFusion::SoftmaxFusion() {
+  auto input = AnyValue({2, 4});
+  auto exp = make_shared<opset::Exp>(input);
+  auto axes = AnyConstant(ngraph::element::i64, {1});
+  auto sum = Wrap(make_shared<opset::ReduceSum>(exp, axes, true));
+  auto softmax = make_shared<opset::Divide>(exp, sum);
+
+  ngraph::graph_rewrite_callback callback = [=](ngraph::pattern::Matcher& m) {
+    auto pattern_map = m.get_pattern_value_map();
+    auto x = pattern_map[input];
+    auto sum_node = ngraph::as_type_ptr<opset::ReduceSum>(
+        pattern_map[sum].get_node_shared_ptr());
+    if (!x.get_element_type().is_real() || !sum_node->get_keep_dims() ||
+        !sum_node->reduction_axes_constant() ||
+        sum_node->get_reduction_axes().size() != 1) {
+      return false;
+    }
+    auto sum_axes = sum_node->get_reduction_axes();
+
+    // Softmax subtracts the max itself
+    auto sub = ngraph::as_type_ptr<opset::Subtract>(x.get_node_shared_ptr());
+    if (sub) {
+      auto max = ngraph::as_type_ptr<opset::ReduceMax>(
+          sub->input_value(1).get_node_shared_ptr());
+      if (max && max->get_keep_dims() && max->reduction_axes_constant() &&
+          max->get_reduction_axes() == sum_axes &&
+          max->input_value(0) == sub->input_value(0)) {
+        x = sub->input_value(0);
+      }
+    }
+    Replace(m.get_match_root(),
+            make_shared<opset::Softmax>(x, *sum_axes.begin()));
+    return true;
+  };
+  add_matcher(make_shared<ngraph::pattern::Matcher>(softmax, "SoftmaxFusion"),
+              callback, ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE);
+}
+
+XdivyFusion::XdivyFusion() {
+  auto input = AnyValue({2, 4});
+  auto zero = AnyConstant(ngraph::element::f32, {});
+  auto divisor = AnyConstant(ngraph::element::f32, {4});
+  auto quotient = Wrap(make_shared<opset::Divide>(input, divisor));
+  auto xdivy = make_shared<opset::Select>(
+      make_shared<opset::Equal>(input, zero), input, quotient);
+
+  ngraph::graph_rewrite_callback callback = [=](ngraph::pattern::Matcher& m) {
+    auto pattern_map = m.get_pattern_value_map();
+    auto quotient_node = pattern_map[quotient].get_node_shared_ptr();
+    if (!pattern_map[input].get_element_type().is_real() ||
+        !IsConstantValue(pattern_map[zero], 0.0) ||
+        m.get_match_root()->get_output_shape(0) !=
+            quotient_node->get_output_shape(0)) {
+      return false;
+    }
+    auto divisor_const = ngraph::as_type_ptr<opset::Constant>(
+        pattern_map[divisor].get_node_shared_ptr());
+    for (auto value : divisor_const->cast_vector<double>()) {
+      if (value == 0 || !std::isfinite(value)) {
+        return false;
+      }
+    }
+    Replace(m.get_match_root(), quotient_node);
+    return true;
+  };
+  add_matcher(make_shared<ngraph::pattern::Matcher>(xdivy, "XdivyFusion"),
+              callback, ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE);
+}
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#pragma once
+
+#include "ngraph/ngraph.hpp"
+#include "ngraph/pass/graph_rewrite.hpp"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+// Pattern based fusions of the subgraphs the translation emits for common
+// TF idioms. Each one is a pass of its own, so that Builder::TranslateGraph
+// can switch them separately through PassConfig.
+
+// Convolution -> [Add(bias)] -> BatchNormInference, with constant filter,
+// bias and batch norm parameters, becomes Convolution -> Add, with the
+// batch norm folded into the filter and the bias.
+class ConvBatchNormFusion : public ngraph::pass::GraphRewrite {
+ public:
+  ConvBatchNormFusion();
+};
+
+// (x - mean(x)) * (mean((x - mean(x))^2) + eps)^-0.5, with both means over
+// the same axes, becomes MVN(x) when eps is 0. MVN computes
+// (x - mean(x)) / (sqrt(variance) + eps), so with any other eps the
+// subgraph is left alone.
+class LayerNormFusion : public ngraph::pass::GraphRewrite {
+ public:
+  LayerNormFusion();
+};
+
+// 0.5 * x * (1 + erf(x / sqrt(2))) becomes Gelu(x).
+class GeluFusion : public ngraph::pass::GraphRewrite {
+ public:
+  GeluFusion();
+};
+
+// exp(x) / sum(exp(x)) over one axis becomes Softmax(x). If x is y - max(y)
+// over the same axis, it becomes Softmax(y).
+class SoftmaxFusion : public ngraph::pass::GraphRewrite {
+ public:
+  SoftmaxFusion();
+};
+
+// The Select(x == 0, x, x / y) of Xdivy becomes x / y when y is a constant
+// with no zero, infinite or NaN values, since x / y is then already 0 where
+// x is.
+class XdivyFusion : public ngraph::pass::GraphRewrite {
+ public:
+  XdivyFusion();
+};
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,218 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <cstdlib>
+#include <set>
+#include <unordered_map>
+
+#include "ngraph/pass/constant_folding.hpp"
+#include "ngraph/pass/manager.hpp"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/default_opset.h"
+#include "ngraph_bridge/ngraph_metrics.h"
+#include "ngraph_bridge/pass/guarded_constant_folding.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+// Values of up to this size are folded whatever they are computed from
+static const size_t kAlwaysFoldBytes = 4096;
+
+static size_t MaxBytesFromEnv() {
+  size_t max_bytes = 64 << 20;
+  const char* env = std::getenv("NGRAPH_TF_CONSTANT_FOLDING_MAX_BYTES");
+  if (env != nullptr) {
+    max_bytes = strtoull(env, nullptr, 10);
+  }
+  return max_bytes;
+}
+
+static double MaxGrowthFromEnv() {
+  double max_growth = 4.0;
+  const char* env = std::getenv("NGRAPH_TF_CONSTANT_FOLDING_MAX_GROWTH");
+  if (env != nullptr) {
+    max_growth = atof(env);
+  }
+  return max_growth;
+}
+
+GuardedConstantFolding::GuardedConstantFolding()
+    : GuardedConstantFolding(MaxBytesFromEnv(), MaxGrowthFromEnv()) {}
+
+GuardedConstantFolding::GuardedConstantFolding(size_t max_bytes,
+                                               double max_growth)
+    : m_max_bytes(max_bytes), m_max_growth(max_growth) {
+  set_property(ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE, true);
+}
+
+static size_t OutputBytes(const ngraph::Output<ngraph::Node>& output) {
+  return ngraph::shape_size(output.get_shape()) *
+         output.get_element_type().size();
+}
+
+static size_t OutputBytes(ngraph::Node* node) {
+  size_t bytes = 0;
+  for (const auto& output : node->outputs()) {
+    bytes += OutputBytes(output);
+  }
+  return bytes;
+}
+
+// Whether node could be folded if its inputs were constants
+static bool IsFoldable(const shared_ptr<ngraph::Node>& node) {
+  if (node->get_input_size() == 0 || ngraph::is_type<opset::Result>(node) ||
+      ngraph::is_type<opset::Assign>(node) ||
+      ngraph::is_type<opset::ReadValue>(node) ||
+      !node->get_control_dependencies().empty()) {
+    return false;
+  }
+  for (const auto& output : node->outputs()) {
+    if (output.get_partial_shape().is_dynamic() ||
+        output.get_element_type().is_dynamic()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The shape a ShapeOf reads, if it is static
+static shared_ptr<opset::Constant> FoldShapeOf(
+    const shared_ptr<ngraph::Node>& node) {
+  if ((!ngraph::is_type<opset::ShapeOf>(node) &&
+       !ngraph::is_type<ngraph::op::v0::ShapeOf>(node)) ||
+      node->get_input_partial_shape(0).is_dynamic()) {
+    return nullptr;
+  }
+  auto shape = node->get_input_shape(0);
+  return opset::Constant::create(node->get_output_element_type(0),
+                                 ngraph::Shape{shape.size()}, shape);
+}
+
+bool GuardedConstantFolding::run_on_function(shared_ptr<ngraph::Function> f) {
+  m_stats = Stats();
+
+  // The nodes to fold, with the constants each of them is computed from
+  unordered_map<ngraph::Node*, set<ngraph::Node*>> folded;
+  auto ops = f->get_ordered_ops();
+  for (const auto& node : ops) {
+    if (auto constant = FoldShapeOf(node)) {
+      constant->set_friendly_name(node->get_friendly_name());
+      ngraph::replace_node(node, constant);
+      m_stats.folded_nodes++;
+      m_stats.folded_bytes += OutputBytes(constant.get());
+      continue;
+    }
+    if (!IsFoldable(node)) {
+      continue;
+    }
+
+    set<ngraph::Node*> sources;
+    bool constant_inputs = true;
+    for (const auto& input : node->input_values()) {
+      auto input_node = input.get_node();
+      auto it = folded.find(input_node);
+      if (ngraph::is_type<opset::Constant>(input_node)) {
+        sources.insert(input_node);
+      } else if (it != folded.end()) {
+        sources.insert(it->second.begin(), it->second.end());
+      } else {
+        constant_inputs = false;
+        break;
+      }
+    }
+    if (!constant_inputs) {
+      continue;
+    }
+
+    size_t source_bytes = 0;
+    for (auto source : sources) {
+      source_bytes += OutputBytes(source);
+    }
+    size_t bytes = OutputBytes(node.get());
+    if (bytes > m_max_bytes ||
+        (bytes > kAlwaysFoldBytes && bytes > m_max_growth * source_bytes)) {
+      NGRAPH_VLOG(4) << "Not folding " << node->get_name() << ": " << bytes
+                     << " bytes, computed from " << source_bytes << " bytes";
+      m_stats.skipped_nodes++;
+      continue;
+    }
+    folded.emplace(node.get(), move(sources));
+  }
+
+  // Fold the values that are used by nodes that are not folded, in a
+  // function of their own. ConstantFolding replaces them in f too, since
+  // the nodes are shared.
+  ngraph::ResultVector results;
+  for (const auto& node : ops) {
+    if (folded.find(node.get()) == folded.end()) {
+      continue;
+    }
+    for (const auto& output : node->outputs()) {
+      for (const auto& target : output.get_target_inputs()) {
+        if (folded.find(target.get_node()) == folded.end()) {
+          results.push_back(make_shared<opset::Result>(output));
+          break;
+        }
+      }
+    }
+  }
+  if (!results.empty()) {
+    auto folding = make_shared<ngraph::Function>(results,
+                                                 ngraph::ParameterVector{});
+    ngraph::pass::Manager passes;
+    passes.register_pass<ngraph::pass::ConstantFolding>();
+    passes.run_passes(folding);
+
+    // ConstantFolding does not know every op
+    size_t not_folded = 0;
+    for (const auto& node : folding->get_ordered_ops()) {
+      if (!ngraph::is_type<opset::Constant>(node) &&
+          !ngraph::is_type<opset::Result>(node)) {
+        NGRAPH_VLOG(4) << "Could not fold " << node->get_name();
+        not_folded++;
+      }
+    }
+    m_stats.folded_nodes += folded.size() - not_folded;
+    for (const auto& result : results) {
+      if (ngraph::is_type<opset::Constant>(result->get_input_node_ptr(0))) {
+        m_stats.folded_bytes += OutputBytes(result->input_value(0));
+      }
+    }
+  }
+
+  NGRAPH_VLOG(2) << "GuardedConstantFolding: folded " << m_stats.folded_nodes
+                 << " nodes into " << m_stats.folded_bytes << " bytes, left "
+                 << m_stats.skipped_nodes << " nodes because of their size";
+  MetricsRegistry::GetCounter("ngraph_tf_constant_folding_nodes_total",
+                              "Number of nodes removed by constant folding")
+      ->Increment(m_stats.folded_nodes);
+  MetricsRegistry::GetCounter("ngraph_tf_constant_folding_bytes_total",
+                              "Bytes of the constants made by constant folding")
+      ->Increment(m_stats.folded_bytes);
+  MetricsRegistry::GetCounter(
+      "ngraph_tf_constant_folding_skipped_total",
+      "Number of nodes constant folding left because of their size")
+      ->Increment(m_stats.skipped_nodes);
+  return m_stats.folded_nodes > 0;
+}
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#pragma once
+
+#include "ngraph/ngraph.hpp"
+#include "ngraph/pass/pass.hpp"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+// Constant folding that leaves alone what would take too much memory.
+//
+// The subgraphs of a function that only depend on constants (and on the
+// static shapes ShapeOf reads) are folded with nGraph's ConstantFolding,
+// except for values larger than max_bytes, or larger than max_growth times
+// the constants they are computed from. Those are the broadcasts and tiles
+// of small constants, which are cheaper to compute on every call than to
+// hold on to. Values of up to 4 KiB, which covers the shape arithmetic, are
+// always folded.
+//
+// The defaults come from NGRAPH_TF_CONSTANT_FOLDING_MAX_BYTES (64 MiB) and
+// NGRAPH_TF_CONSTANT_FOLDING_MAX_GROWTH (4). What was folded, and what was
+// left because of the guard, is counted in the ngraph_tf_constant_folding_*
+// metrics.
+class GuardedConstantFolding : public ngraph::pass::FunctionPass {
+ public:
+  struct Stats {
+    size_t folded_nodes = 0;
+    size_t folded_bytes = 0;
+    size_t skipped_nodes = 0;
+  };
+
+  GuardedConstantFolding();
+  GuardedConstantFolding(size_t max_bytes, double max_growth);
+  bool run_on_function(std::shared_ptr<ngraph::Function> function) override;
+
+  // What the last run_on_function did
+  const Stats& get_stats() const { return m_stats; }
+
+ private:
+  size_t m_max_bytes;
+  double m_max_growth;
+  Stats m_stats;
+};
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,379 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <map>
+
+#include "ngraph/ngraph.hpp"
+
+#include "logging/ngraph_log.h"
+#include "ngraph_bridge/default_opset.h"
+#include "ngraph_bridge/pass/layout_assignment.h"
+#include "ngraph_bridge/pass/transpose_util.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+// A layout is a permutation of the dimensions of a tensor: dimension i of a
+// tensor in layout L is dimension L[i] of the tensor in default layout.
+using Layout = ngraph::AxisVector;
+
+static bool IsDefault(const Layout& layout) {
+  for (size_t i = 0; i < layout.size(); i++) {
+    if (layout[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static Layout Inverse(const Layout& layout) {
+  Layout inverse(layout.size());
+  for (size_t i = 0; i < layout.size(); i++) {
+    inverse[layout[i]] = i;
+  }
+  return inverse;
+}
+
+namespace {
+
+// Where the value of each output of the function is now, and in which
+// layout. Outputs that are not in the map are where they are, in default
+// layout.
+class LayoutAssigner {
+ public:
+  void Visit(const shared_ptr<ngraph::Node>& node);
+
+ private:
+  struct Placement {
+    ngraph::Output<ngraph::Node> value;
+    Layout layout;
+  };
+
+  Placement Get(const ngraph::Output<ngraph::Node>& output) const;
+  // The value of output in default layout, transposing it if need be
+  ngraph::Output<ngraph::Node> Materialize(
+      const ngraph::Output<ngraph::Node>& output);
+  // Records that the value of node is that of new_node, in layout
+  void Replace(const shared_ptr<ngraph::Node>& node,
+               const shared_ptr<ngraph::Node>& new_node, const Layout& layout);
+
+  bool VisitTranspose(const shared_ptr<opset::Transpose>& transpose);
+  bool VisitUnary(const shared_ptr<ngraph::Node>& node);
+  bool VisitBinary(const shared_ptr<ngraph::Node>& node);
+  bool VisitConcat(const shared_ptr<opset::Concat>& concat);
+  bool VisitPad(const shared_ptr<opset::Pad>& pad);
+  template <typename TReduction>
+  bool VisitReduction(const shared_ptr<ngraph::Node>& node);
+
+  std::map<ngraph::Output<ngraph::Node>, Placement> m_placements;
+  // Transposes back to default layout, by value and the layout it is in, so
+  // that a value is transposed back once however many ops need it
+  std::map<std::pair<ngraph::Output<ngraph::Node>, Layout>,
+           ngraph::Output<ngraph::Node>>
+      m_materialized;
+};
+
+LayoutAssigner::Placement LayoutAssigner::Get(
+    const ngraph::Output<ngraph::Node>& output) const {
+  auto it = m_placements.find(output);
+  if (it != m_placements.end()) {
+    return it->second;
+  }
+  return {output, ngraph::get_default_order(output.get_shape())};
+}
+
+ngraph::Output<ngraph::Node> LayoutAssigner::Materialize(
+    const ngraph::Output<ngraph::Node>& output) {
+  Placement placement = Get(output);
+  if (IsDefault(placement.layout)) {
+    return placement.value;
+  }
+  auto key = std::make_pair(placement.value, placement.layout);
+  auto it = m_materialized.find(key);
+  if (it != m_materialized.end()) {
+    return it->second;
+  }
+
+  auto order = Inverse(placement.layout);
+  shared_ptr<ngraph::Node> transpose;
+  if (auto constant = ngraph::as_type_ptr<opset::Constant>(
+          placement.value.get_node_shared_ptr())) {
+    transpose = TransposeConstant(constant, order);
+  } else {
+    auto ng_order = make_shared<opset::Constant>(
+        ngraph::element::u64, ngraph::Shape{order.size()}, order);
+    transpose = make_shared<opset::Transpose>(placement.value, ng_order);
+  }
+  transpose->add_provenance_tags(output.get_node()->get_provenance_tags());
+  NGRAPH_VLOG(4) << "LayoutAssignment: transposing "
+                 << output.get_node()->get_name() << " back by "
+                 << ngraph::join(order);
+  m_materialized[key] = transpose->output(0);
+  return transpose->output(0);
+}
+
+void LayoutAssigner::Replace(const shared_ptr<ngraph::Node>& node,
+                             const shared_ptr<ngraph::Node>& new_node,
+                             const Layout& layout) {
+  new_node->set_friendly_name(node->get_friendly_name());
+  new_node->add_provenance_tags(node->get_provenance_tags());
+  for (size_t i = 0; i < node->get_output_size(); i++) {
+    m_placements[node->output(i)] = {new_node->output(i), layout};
+  }
+  NGRAPH_VLOG(4) << "LayoutAssignment: " << node->get_name() << " runs in "
+                 << ngraph::join(layout);
+}
+
+bool LayoutAssigner::VisitTranspose(
+    const shared_ptr<opset::Transpose>& transpose) {
+  auto ng_order = ngraph::as_type_ptr<opset::Constant>(
+      transpose->input_value(1).get_node_shared_ptr());
+  if (ng_order == nullptr) {
+    return false;
+  }
+  auto order = ng_order->get_axis_vector_val();
+  Placement input = Get(transpose->input_value(0));
+
+  // A constant (typically a filter) is transposed once, here
+  if (auto constant = ngraph::as_type_ptr<opset::Constant>(
+          input.value.get_node_shared_ptr())) {
+    auto input_order = Inverse(input.layout);
+    ngraph::AxisVector folded_order(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      folded_order[i] = input_order[order[i]];
+    }
+    auto folded = TransposeConstant(constant, folded_order);
+    Replace(transpose, folded, ngraph::get_default_order(order.size()));
+    return true;
+  }
+
+  // Otherwise the transpose only changes the layout of its input
+  auto inverse_order = Inverse(order);
+  Layout layout(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    layout[i] = inverse_order[input.layout[i]];
+  }
+  m_placements[transpose->output(0)] = {input.value, layout};
+  return true;
+}
+
+bool LayoutAssigner::VisitUnary(const shared_ptr<ngraph::Node>& node) {
+  Placement input = Get(node->input_value(0));
+  if (IsDefault(input.layout)) {
+    return false;
+  }
+  Replace(node, node->copy_with_new_inputs({input.value}), input.layout);
+  return true;
+}
+
+bool LayoutAssigner::VisitBinary(const shared_ptr<ngraph::Node>& node) {
+  Placement left = Get(node->input_value(0));
+  Placement right = Get(node->input_value(1));
+  if (IsDefault(left.layout) && IsDefault(right.layout)) {
+    return false;
+  }
+  if (left.layout == right.layout) {
+    Replace(node, node->copy_with_new_inputs({left.value, right.value}),
+            left.layout);
+    return true;
+  }
+
+  // A constant operand (a bias, a scale) is brought into the layout of the
+  // other one, broadcasting it to its rank first
+  bool left_is_placed = !IsDefault(left.layout);
+  Placement& placed = left_is_placed ? left : right;
+  Placement& other = left_is_placed ? right : left;
+  auto constant =
+      ngraph::as_type_ptr<opset::Constant>(other.value.get_node_shared_ptr());
+  size_t rank = placed.layout.size();
+  if (constant == nullptr || !IsDefault(other.layout) ||
+      other.layout.size() > rank) {
+    return false;
+  }
+  ngraph::Shape shape = constant->get_shape();
+  shape.insert(shape.begin(), rank - shape.size(), 1);
+  auto broadcast = make_shared<opset::Constant>(
+      constant->get_element_type(), shape, constant->get_data_ptr());
+  other.value = TransposeConstant(broadcast, placed.layout);
+  Replace(node, node->copy_with_new_inputs({left.value, right.value}),
+          placed.layout);
+  return true;
+}
+
+bool LayoutAssigner::VisitConcat(const shared_ptr<opset::Concat>& concat) {
+  vector<Placement> inputs;
+  Layout layout;
+  for (const auto& input : concat->input_values()) {
+    inputs.push_back(Get(input));
+    if (!IsDefault(inputs.back().layout)) {
+      layout = inputs.back().layout;
+    }
+  }
+  if (layout.empty()) {
+    return false;
+  }
+
+  // Constant inputs are brought into the layout of the others
+  ngraph::OutputVector values;
+  for (auto& input : inputs) {
+    if (input.layout != layout) {
+      auto constant = ngraph::as_type_ptr<opset::Constant>(
+          input.value.get_node_shared_ptr());
+      if (constant == nullptr || !IsDefault(input.layout)) {
+        return false;
+      }
+      input.value = TransposeConstant(constant, layout);
+    }
+    values.push_back(input.value);
+  }
+  int64_t axis = Inverse(layout)[concat->get_concatenation_axis()];
+  Replace(concat, make_shared<opset::Concat>(values, axis), layout);
+  return true;
+}
+
+bool LayoutAssigner::VisitPad(const shared_ptr<opset::Pad>& pad) {
+  Placement input = Get(pad->input_value(0));
+  if (IsDefault(input.layout) ||
+      !ngraph::is_type<opset::Constant>(pad->get_input_node_ptr(1)) ||
+      !ngraph::is_type<opset::Constant>(pad->get_input_node_ptr(2))) {
+    return false;
+  }
+  auto pads_begin = pad->get_pads_begin();
+  auto pads_end = pad->get_pads_end();
+  vector<int64_t> new_begin(pads_begin.size()), new_end(pads_end.size());
+  for (size_t i = 0; i < input.layout.size(); i++) {
+    new_begin[i] = pads_begin[input.layout[i]];
+    new_end[i] = pads_end[input.layout[i]];
+  }
+  auto ng_begin = make_shared<opset::Constant>(
+      ngraph::element::i64, ngraph::Shape{new_begin.size()}, new_begin);
+  auto ng_end = make_shared<opset::Constant>(
+      ngraph::element::i64, ngraph::Shape{new_end.size()}, new_end);
+  shared_ptr<ngraph::Node> new_pad;
+  if (pad->get_input_size() > 3) {
+    new_pad = make_shared<opset::Pad>(input.value, ng_begin, ng_end,
+                                      pad->input_value(3), pad->get_pad_mode());
+  } else {
+    new_pad = make_shared<opset::Pad>(input.value, ng_begin, ng_end,
+                                      pad->get_pad_mode());
+  }
+  Replace(pad, new_pad, input.layout);
+  return true;
+}
+
+template <typename TReduction>
+bool LayoutAssigner::VisitReduction(const shared_ptr<ngraph::Node>& node) {
+  auto reduction = ngraph::as_type_ptr<TReduction>(node);
+  Placement input = Get(node->input_value(0));
+  if (IsDefault(input.layout) || !reduction->reduction_axes_constant()) {
+    return false;
+  }
+  auto axes = reduction->get_reduction_axes();
+  auto inverse_layout = Inverse(input.layout);
+  vector<int64_t> new_axes;
+  for (auto axis : axes) {
+    new_axes.push_back(inverse_layout[axis]);
+  }
+  auto ng_axes = make_shared<opset::Constant>(
+      ngraph::element::i64, ngraph::Shape{new_axes.size()}, new_axes);
+  bool keep_dims = reduction->get_keep_dims();
+
+  // Without keep_dims the dimensions that are left keep their order
+  Layout layout = input.layout;
+  if (!keep_dims) {
+    layout.clear();
+    for (auto dim : input.layout) {
+      if (axes.count(dim) == 0) {
+        size_t dims_before = 0;
+        for (auto other : input.layout) {
+          dims_before += (axes.count(other) == 0 && other < dim) ? 1 : 0;
+        }
+        layout.push_back(dims_before);
+      }
+    }
+  }
+  Replace(node, make_shared<TReduction>(input.value, ng_axes, keep_dims),
+          layout);
+  return true;
+}
+
+void LayoutAssigner::Visit(const shared_ptr<ngraph::Node>& node) {
+  bool assigned = false;
+  if (auto transpose = ngraph::as_type_ptr<opset::Transpose>(node)) {
+    assigned = VisitTranspose(transpose);
+  } else if (node->is_unary_elementwise_arithmetic() ||
+             ngraph::is_type<opset::Convert>(node) ||
+             ngraph::is_type<opset::LogicalNot>(node)) {
+    assigned = VisitUnary(node);
+  } else if (node->is_binary_elementwise_arithmetic() ||
+             node->is_binary_elementwise_comparison() ||
+             node->is_binary_elementwise_logical()) {
+    assigned = VisitBinary(node);
+  } else if (auto concat = ngraph::as_type_ptr<opset::Concat>(node)) {
+    assigned = VisitConcat(concat);
+  } else if (auto pad = ngraph::as_type_ptr<opset::Pad>(node)) {
+    assigned = VisitPad(pad);
+  } else if (ngraph::is_type<opset::ReduceSum>(node)) {
+    assigned = VisitReduction<opset::ReduceSum>(node);
+  } else if (ngraph::is_type<opset::ReduceMean>(node)) {
+    assigned = VisitReduction<opset::ReduceMean>(node);
+  } else if (ngraph::is_type<opset::ReduceMax>(node)) {
+    assigned = VisitReduction<opset::ReduceMax>(node);
+  } else if (ngraph::is_type<opset::ReduceMin>(node)) {
+    assigned = VisitReduction<opset::ReduceMin>(node);
+  } else if (ngraph::is_type<opset::ReduceProd>(node)) {
+    assigned = VisitReduction<opset::ReduceProd>(node);
+  }
+  if (assigned) {
+    return;
+  }
+
+  // Everything else (and Results) takes its inputs in default layout
+  for (auto& input : node->inputs()) {
+    auto value = Materialize(input.get_source_output());
+    if (value != input.get_source_output()) {
+      input.replace_source_output(value);
+    }
+  }
+}
+
+}  // namespace
+
+static size_t CountTransposes(const shared_ptr<ngraph::Function>& f) {
+  size_t count = 0;
+  for (const auto& node : f->get_ordered_ops()) {
+    count += ngraph::is_type<opset::Transpose>(node) ? 1 : 0;
+  }
+  return count;
+}
+
+bool LayoutAssignment::run_on_function(shared_ptr<ngraph::Function> f) {
+  size_t transposes_before = CountTransposes(f);
+  LayoutAssigner assigner;
+  for (const auto& node : f->get_ordered_ops()) {
+    assigner.Visit(node);
+  }
+  NGRAPH_VLOG(2) << "LayoutAssignment: " << transposes_before
+                 << " transposes before, " << CountTransposes(f) << " after";
+  return true;
+}
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#pragma once
+
+#include "ngraph/ngraph.hpp"
+#include "ngraph/pass/pass.hpp"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+// Keeps the tensors of a function in the layout its layout-sensitive ops
+// (Convolution, pooling, BatchNorm, ...) work in, rather than going back to
+// the TF layout after each of them.
+//
+// The translation wraps every NHWC op in NHWC->NCHW and NCHW->NHWC
+// transposes. This pass tracks for each tensor the layout it is actually
+// in, so a transpose becomes a change of layout rather than a copy, and
+// layout-agnostic ops (elementwise, Concat, Pad, reductions) run on the
+// tensors in whatever layout they are in, with their axes remapped. A
+// tensor is transposed back only where an op needs it in its own layout,
+// which for a function of NHWC convolutions and the ops between them means
+// at its Parameters and Results. Transposes of constants (filters, and
+// constant operands of elementwise ops) are done on the data.
+class LayoutAssignment : public ngraph::pass::FunctionPass {
+ public:
+  LayoutAssignment() {
+    set_property(ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE, true);
+  }
+  bool run_on_function(std::shared_ptr<ngraph::Function> function) override;
+};
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -27,6 +27,7 @@
 #include "logging/ngraph_log.h"
 #include "ngraph_bridge/default_opset.h"
 #include "ngraph_bridge/pass/transpose_sinking.h"
+#include "ngraph_bridge/pass/transpose_util.h"
 
 using namespace std;
 
@@ -46,6 +47,16 @@ static ngraph::CoordinateDiff apply_permutation(ngraph::CoordinateDiff input,
   return output;
 }
 
+template <typename T>
+static vector<T> permute(const vector<T>& input,
+                         const ngraph::AxisVector& order) {
+  vector<T> output(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    output[i] = input.at(order.at(i));
+  }
+  return output;
+}
+
 template <typename T>
 static string describe(shared_ptr<ngraph::Node> node) {
   // ensure that it's either a reshape or a transpose
@@ -69,7 +80,7 @@ static string describe(shared_ptr<ngraph::Node> node) {
 }
 
 static shared_ptr<opset::Transpose> make_transpose(
-    shared_ptr<ngraph::Node> arg, const ngraph::AxisVector& input_order) {
+    ngraph::Output<ngraph::Node> arg, const ngraph::AxisVector& input_order) {
   auto ng_input_order = std::make_shared<opset::Constant>(
       ngraph::element::u64, ngraph::Shape{input_order.size()}, input_order);
   auto transpose = make_shared<opset::Transpose>(arg, ng_input_order);
@@ -78,7 +89,7 @@ static shared_ptr<opset::Transpose> make_transpose(
 }
 
 static shared_ptr<opset::Reshape> make_reshape(
-    shared_ptr<ngraph::Node> arg, const ngraph::AxisVector& input_order) {
+    ngraph::Output<ngraph::Node> arg, const ngraph::AxisVector& input_order) {
   auto ng_input_order = std::make_shared<opset::Constant>(
       ngraph::element::u64, ngraph::Shape{input_order.size()}, input_order);
   auto transpose = make_shared<opset::Reshape>(arg, ng_input_order, false);
@@ -114,8 +125,7 @@ static shared_ptr<opset::Transpose> combine_transposes(
       ngraph::apply_permutation(default_order, t1_const->get_axis_vector_val());
   auto perm_t2 =
       ngraph::apply_permutation(perm_t1, t2_const->get_axis_vector_val());
-  auto combined =
-      make_transpose(t2->input_value(0).get_node_shared_ptr(), perm_t2);
+  auto combined = make_transpose(t2->input_value(0), perm_t2);
   NGRAPH_VLOG(4) << "Combining " << describe<opset::Transpose>(t1) << " and "
                  << describe<opset::Transpose>(t2) << " into "
                  << describe<opset::Transpose>(combined);
@@ -131,8 +141,7 @@ static void insert_transpose(shared_ptr<ngraph::Node> target,
   NGRAPH_VLOG(4) << "Arg shape: " << arg.get_shape();
   auto new_order = ngraph::as_type_ptr<opset::Constant>(
       transpose->input_value(1).get_node_shared_ptr());
-  auto new_transpose = make_transpose(arg.get_node_shared_ptr(),
-                                      new_order->get_axis_vector_val());
+  auto new_transpose = make_transpose(arg, new_order->get_axis_vector_val());
   NGRAPH_VLOG(4) << "Inserting transpose "
                  << describe<opset::Transpose>(new_transpose) << " at input "
                  << target->get_name() << " input index " << input_index;
@@ -164,9 +173,10 @@ static void insert_transpose(shared_ptr<ngraph::Node> target,
 
 static void delete_transpose(shared_ptr<ngraph::Node> transpose) {
   NGRAPH_VLOG(4) << "Removing transpose " << transpose->get_name();
-  if (!transpose->get_users().empty()) {
-    ngraph::replace_node(transpose,
-                         transpose->input_value(0).get_node_shared_ptr());
+  // the input may be any output of a multi-output op such as Split, so the
+  // users are moved to it rather than to its node's first output
+  for (auto& input : transpose->output(0).get_target_inputs()) {
+    input.replace_source_output(transpose->input_value(0));
   }
 }
 
@@ -178,6 +188,23 @@ static void mark_transpose_for_deletion(
   transposes_to_delete.insert(transpose);
 }
 
+static ngraph::AxisVector get_order(shared_ptr<opset::Transpose> transpose) {
+  return ngraph::as_type_ptr<opset::Constant>(
+             transpose->input_value(1).get_node_shared_ptr())
+      ->get_axis_vector_val();
+}
+
+// A label of the shape arg has once the pending transpose arg_transpose is
+// taken off it. New ops are built on it to get the right output shape, and
+// it is then replaced with arg itself.
+static shared_ptr<ngraph::pattern::op::Label> make_label(
+    shared_ptr<opset::Transpose> arg_transpose,
+    const ngraph::AxisVector& def_order) {
+  return make_shared<ngraph::pattern::op::Label>(
+      arg_transpose->get_element_type(),
+      ngraph::apply_permutation(arg_transpose->get_shape(), def_order));
+}
+
 static shared_ptr<opset::Transpose> create_default_transpose(
     ngraph::Output<ngraph::Node> n) {
   auto default_order = ngraph::get_default_order(n.get_shape());
@@ -198,7 +225,7 @@ static void convert_binary_to_default_order(
     shared_ptr<ngraph::Node> binary, const ngraph::Input<ngraph::Node>& input,
     ngraph::Output<ngraph::Node> right, TransposeMap& reorders,
     set<shared_ptr<ngraph::Node>>& transposes_to_delete) {
-  auto left = input.get_source_output().get_node_shared_ptr();
+  auto left = input.get_source_output();
   auto right_t = read_transposemap(reorders, right);
   auto right_const = ngraph::as_type_ptr<opset::Constant>(
       right_t->input_value(1).get_node_shared_ptr());
@@ -209,8 +236,18 @@ static void convert_binary_to_default_order(
   // if right input is being implicitly broadcasted, insert a reshape
   // instead of a transpose
   shared_ptr<ngraph::Node> new_node;
-  auto left_shape = left->get_shape();
-  if (left_shape.size() < perm_to_def.size()) {
+  auto left_shape = left.get_shape();
+  auto left_constant =
+      ngraph::as_type_ptr<opset::Constant>(left.get_node_shared_ptr());
+  if (left_constant && left_shape.size() <= perm_to_def.size()) {
+    // a constant is transposed on its data, which saves the copy at runtime
+    left_shape.insert(left_shape.begin(),
+                      perm_to_def.size() - left_shape.size(), 1);
+    auto broadcast_constant = make_shared<opset::Constant>(
+        left_constant->get_element_type(), left_shape,
+        left_constant->get_data_ptr());
+    new_node = TransposeConstant(broadcast_constant, perm_to_def);
+  } else if (left_shape.size() < perm_to_def.size()) {
     left_shape.insert(left_shape.begin(),
                       perm_to_def.size() - left_shape.size(), 1);
     auto new_shape = ngraph::apply_permutation(left_shape, perm_to_def);
@@ -370,8 +407,7 @@ static void sink_pad(
   auto new_pad =
       make_shared<opset::Pad>(dummy_correct_shape, new_begin, new_end,
                               n->input_value(3), n->get_pad_mode());
-  ngraph::replace_node(dummy_correct_shape,
-                       n->input_value(0).get_node_shared_ptr());
+  new_pad->input(0).replace_source_output(n->input_value(0));
   NGRAPH_VLOG(4) << "Replacing " << n->get_name() << " with "
                  << new_pad->get_name();
   ngraph::replace_node(n, new_pad);
@@ -384,41 +420,41 @@ static void sink_pad(
 static void sink_concat(shared_ptr<opset::Concat> n, TransposeMap& reorders,
                         set<shared_ptr<ngraph::Node>>& transposes_to_delete,
                         TransposeMap& reuse_map) {
-  auto n_in = n->input_value(0);
-  auto arg_transpose = read_transposemap(reorders, n_in);
-  auto arg_transpose_order = ngraph::as_type_ptr<opset::Constant>(
-      arg_transpose->input_value(1).get_node_shared_ptr());
-  auto order = arg_transpose_order->get_axis_vector_val();
+  // the order of the first input that has a pending transpose; constants in
+  // default order are transposed on their data to match it
+  auto order = get_order(read_transposemap(reorders, n->input_value(0)));
+  for (size_t i = 0; i < n->get_input_size(); i++) {
+    auto iorder = get_order(read_transposemap(reorders, n->input_value(i)));
+    if (iorder != ngraph::get_default_order(iorder.size())) {
+      order = iorder;
+      break;
+    }
+  }
   // we need the correct input shape to produce the right output shape
   // we are going to create a label of the right input shape,
   // so a new concat will have the right shape
   auto def_order = ngraph::get_permutation_to_default_order(order);
-  auto input_shape =
-      ngraph::apply_permutation(arg_transpose->get_shape(), def_order);
-  auto dummy_correct_shape = make_shared<ngraph::pattern::op::Label>(
-      arg_transpose->get_element_type(), input_shape);
-
   ngraph::NodeVector new_args;
-  new_args.push_back(dummy_correct_shape);
-
-  for (size_t i = 1; i < n->get_input_size(); i++) {
+  ngraph::OutputVector orig_args;
+  for (size_t i = 0; i < n->get_input_size(); i++) {
     auto iarg = n->input_value(i);
     auto iarg_transpose = read_transposemap(reorders, iarg);
-    auto iarg_transpose_order = ngraph::as_type_ptr<opset::Constant>(
-        iarg_transpose->input_value(1).get_node_shared_ptr());
-    auto iorder = iarg_transpose_order->get_axis_vector_val();
-    if (iorder != order) {
+    auto iorder = get_order(iarg_transpose);
+    auto iconstant =
+        ngraph::as_type_ptr<opset::Constant>(iarg.get_node_shared_ptr());
+    if (iorder != order && iconstant &&
+        iorder == ngraph::get_default_order(iorder.size())) {
+      NGRAPH_VLOG(4) << "Transposing constant " << iconstant->get_name()
+                     << " at " << i << "-th arg";
+      iarg = TransposeConstant(iconstant, def_order);
+    } else if (iorder != order) {
       NGRAPH_VLOG(4) << " input order at " << i
                      << "-th arg is different from first arg";
       materialize_shapes(n, reorders, transposes_to_delete, reuse_map);
       return;
     }
-
-    auto iinput_shape =
-        ngraph::apply_permutation(iarg_transpose->get_shape(), def_order);
-    auto idummy_correct_shape = make_shared<ngraph::pattern::op::Label>(
-        iarg_transpose->get_element_type(), iinput_shape);
-    new_args.push_back(idummy_correct_shape);
+    new_args.push_back(make_label(iarg_transpose, def_order));
+    orig_args.push_back(iarg);
   }
 
   auto new_axis = order.at(n->get_concatenation_axis());
@@ -427,7 +463,7 @@ static void sink_concat(shared_ptr<opset::Concat> n, TransposeMap& reorders,
   for (size_t i = 0; i < new_concat->get_input_size(); i++) {
     NGRAPH_VLOG(4) << "Replacing " << new_concat->get_name() << " input " << i
                    << " with " << n->get_name() << " input " << i;
-    new_concat->input(i).replace_source_output(n->input_value(i));
+    new_concat->input(i).replace_source_output(orig_args[i]);
   }
   NGRAPH_VLOG(4) << "Replacing " << n->get_name() << " with "
                  << new_concat->get_name();
@@ -439,6 +475,151 @@ static void sink_concat(shared_ptr<opset::Concat> n, TransposeMap& reorders,
   write_transposemap(reorders, new_concat, new_transpose);
 }
 
+// Only slices that keep the rank are sunk; their bounds are padded to the
+// rank and permuted like the dimensions
+static void sink_strided_slice(
+    shared_ptr<opset::StridedSlice> n, TransposeMap& reorders,
+    set<shared_ptr<ngraph::Node>>& transposes_to_delete,
+    TransposeMap& reuse_map) {
+  auto is_zero = [](const vector<int64_t>& mask) {
+    return all_of(mask.begin(), mask.end(), [](int64_t m) { return m == 0; });
+  };
+  if (n->get_input_size() < 4) {
+    materialize_shapes(n, reorders, transposes_to_delete, reuse_map);
+    return;
+  }
+  auto begin_const = ngraph::as_type_ptr<opset::Constant>(
+      n->input_value(1).get_node_shared_ptr());
+  auto end_const = ngraph::as_type_ptr<opset::Constant>(
+      n->input_value(2).get_node_shared_ptr());
+  auto strides_const = ngraph::as_type_ptr<opset::Constant>(
+      n->input_value(3).get_node_shared_ptr());
+  auto arg_transpose = read_transposemap(reorders, n->input_value(0));
+  auto order = get_order(arg_transpose);
+  if (!begin_const || !end_const || !strides_const ||
+      !is_zero(n->get_new_axis_mask()) ||
+      !is_zero(n->get_shrink_axis_mask()) ||
+      !is_zero(n->get_ellipsis_mask()) ||
+      begin_const->get_shape().at(0) > order.size()) {
+    materialize_shapes(n, reorders, transposes_to_delete, reuse_map);
+    return;
+  }
+
+  auto begin = begin_const->cast_vector<int64_t>();
+  auto end = end_const->cast_vector<int64_t>();
+  auto strides = strides_const->cast_vector<int64_t>();
+  auto begin_mask = n->get_begin_mask();
+  auto end_mask = n->get_end_mask();
+  // dimensions the bounds leave out are taken whole
+  begin_mask.resize(begin.size(), 0);
+  end_mask.resize(end.size(), 0);
+  begin.resize(order.size(), 0);
+  end.resize(order.size(), 0);
+  strides.resize(order.size(), 1);
+  begin_mask.resize(order.size(), 1);
+  end_mask.resize(order.size(), 1);
+
+  auto def_order = ngraph::get_permutation_to_default_order(order);
+  auto make_bounds = [&def_order](const vector<int64_t>& bounds) {
+    auto new_bounds = permute(bounds, def_order);
+    return make_shared<opset::Constant>(
+        ngraph::element::i64, ngraph::Shape{new_bounds.size()}, new_bounds);
+  };
+  auto new_slice = make_shared<opset::StridedSlice>(
+      make_label(arg_transpose, def_order), make_bounds(begin),
+      make_bounds(end), make_bounds(strides), permute(begin_mask, def_order),
+      permute(end_mask, def_order));
+  new_slice->input(0).replace_source_output(n->input_value(0));
+  NGRAPH_VLOG(4) << "Replacing " << n->get_name() << " with "
+                 << new_slice->get_name();
+  ngraph::replace_node(n, new_slice);
+  auto new_transpose = make_transpose(new_slice, order);
+  NGRAPH_VLOG(4) << "Propagating " << describe<opset::Transpose>(new_transpose)
+                 << " for " << n->get_name();
+  write_transposemap(reorders, new_slice, new_transpose);
+}
+
+template <typename T>
+static void sink_reduction(shared_ptr<T> n, TransposeMap& reorders,
+                           set<shared_ptr<ngraph::Node>>& transposes_to_delete,
+                           TransposeMap& reuse_map) {
+  if (!n->reduction_axes_constant()) {
+    materialize_shapes(n, reorders, transposes_to_delete, reuse_map);
+    return;
+  }
+  auto arg_transpose = read_transposemap(reorders, n->input_value(0));
+  auto order = get_order(arg_transpose);
+  auto axes = n->get_reduction_axes();
+  vector<int64_t> new_axes;
+  for (auto axis : axes) {
+    new_axes.push_back(order.at(axis));
+  }
+  auto def_order = ngraph::get_permutation_to_default_order(order);
+  auto new_reduction = make_shared<T>(
+      make_label(arg_transpose, def_order),
+      make_shared<opset::Constant>(ngraph::element::i64,
+                                   ngraph::Shape{new_axes.size()}, new_axes),
+      n->get_keep_dims());
+  new_reduction->input(0).replace_source_output(n->input_value(0));
+  NGRAPH_VLOG(4) << "Replacing " << n->get_name() << " with "
+                 << new_reduction->get_name();
+  ngraph::replace_node(n, new_reduction);
+
+  // without keep_dims, the dimensions that are left keep their relative
+  // order on both sides of the transpose
+  auto new_order = order;
+  if (!n->get_keep_dims()) {
+    new_order.clear();
+    for (size_t i = 0; i < order.size(); i++) {
+      if (axes.count(i) == 0) {
+        size_t dims_before = 0;
+        for (size_t j = 0; j < order.at(i); j++) {
+          auto is_reduced = count(new_axes.begin(), new_axes.end(),
+                                  static_cast<int64_t>(j)) != 0;
+          dims_before += is_reduced ? 0 : 1;
+        }
+        new_order.push_back(dims_before);
+      }
+    }
+  }
+  auto new_transpose = make_transpose(new_reduction, new_order);
+  NGRAPH_VLOG(4) << "Propagating " << describe<opset::Transpose>(new_transpose)
+                 << " for " << n->get_name();
+  write_transposemap(reorders, new_reduction, new_transpose);
+}
+
+// Split and VariadicSplit: every output gets the transpose of the input
+static void sink_split(shared_ptr<ngraph::Node> n, TransposeMap& reorders,
+                       set<shared_ptr<ngraph::Node>>& transposes_to_delete,
+                       TransposeMap& reuse_map) {
+  auto axis_const = ngraph::as_type_ptr<opset::Constant>(
+      n->input_value(1).get_node_shared_ptr());
+  if (!axis_const) {
+    materialize_shapes(n, reorders, transposes_to_delete, reuse_map);
+    return;
+  }
+  auto arg_transpose = read_transposemap(reorders, n->input_value(0));
+  auto order = get_order(arg_transpose);
+  int64_t axis = axis_const->cast_vector<int64_t>().at(0);
+  if (axis < 0) {
+    axis += order.size();
+  }
+  auto def_order = ngraph::get_permutation_to_default_order(order);
+  auto new_inputs = n->input_values();
+  new_inputs[0] = make_label(arg_transpose, def_order);
+  new_inputs[1] = make_shared<opset::Constant>(
+      ngraph::element::i64, ngraph::Shape{},
+      vector<int64_t>{static_cast<int64_t>(order.at(axis))});
+  auto new_split = n->copy_with_new_inputs(new_inputs);
+  new_split->input(0).replace_source_output(n->input_value(0));
+  NGRAPH_VLOG(4) << "Replacing " << n->get_name() << " with "
+                 << new_split->get_name();
+  ngraph::replace_node(n, new_split);
+  for (auto& output : new_split->outputs()) {
+    write_transposemap(reorders, new_split, make_transpose(output, order));
+  }
+}
+
 // The goal of TransposeSinking is to remove
 // round-trip transposes(i.e. nhwc->nchw(nchw-only-op)->nhwc)
 // around nchw-only-op (e.g.Convolution, Batchnorm, Avg/MaxPool)
@@ -470,6 +651,21 @@ bool TransposeSinking::run_on_function(shared_ptr<ngraph::Function> f) {
       sink_pad(pad, reorders, transposes_to_delete);
     } else if (auto concat = ngraph::as_type_ptr<opset::Concat>(n)) {
       sink_concat(concat, reorders, transposes_to_delete, reuse_map);
+    } else if (auto slice = ngraph::as_type_ptr<opset::StridedSlice>(n)) {
+      sink_strided_slice(slice, reorders, transposes_to_delete, reuse_map);
+    } else if (auto sum = ngraph::as_type_ptr<opset::ReduceSum>(n)) {
+      sink_reduction(sum, reorders, transposes_to_delete, reuse_map);
+    } else if (auto mean = ngraph::as_type_ptr<opset::ReduceMean>(n)) {
+      sink_reduction(mean, reorders, transposes_to_delete, reuse_map);
+    } else if (auto max = ngraph::as_type_ptr<opset::ReduceMax>(n)) {
+      sink_reduction(max, reorders, transposes_to_delete, reuse_map);
+    } else if (auto min = ngraph::as_type_ptr<opset::ReduceMin>(n)) {
+      sink_reduction(min, reorders, transposes_to_delete, reuse_map);
+    } else if (auto prod = ngraph::as_type_ptr<opset::ReduceProd>(n)) {
+      sink_reduction(prod, reorders, transposes_to_delete, reuse_map);
+    } else if (ngraph::is_type<opset::Split>(n) ||
+               ngraph::is_type<opset::VariadicSplit>(n)) {
+      sink_split(n, reorders, transposes_to_delete, reuse_map);
     } else {
       materialize_shapes(n, reorders, transposes_to_delete, reuse_map);
     }
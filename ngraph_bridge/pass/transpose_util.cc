@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <cstring>
+
+#include "ngraph_bridge/pass/transpose_util.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+shared_ptr<opset::Constant> TransposeConstant(
+    const shared_ptr<opset::Constant>& constant,
+    const ngraph::AxisVector& order) {
+  const auto& shape = constant->get_shape();
+  ngraph::Shape transposed_shape(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    transposed_shape[i] = shape[order[i]];
+  }
+  vector<size_t> strides(shape.size(), 1);
+  for (size_t i = shape.size(); i-- > 1;) {
+    strides[i - 1] = strides[i] * shape[i];
+  }
+
+  size_t element_size = constant->get_element_type().size();
+  size_t count = ngraph::shape_size(shape);
+  const char* src = static_cast<const char*>(constant->get_data_ptr());
+  vector<char> data(count * element_size);
+  vector<size_t> index(order.size(), 0);
+  for (size_t dst = 0; dst < count; dst++) {
+    size_t offset = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+      offset += index[i] * strides[order[i]];
+    }
+    memcpy(&data[dst * element_size], src + offset * element_size,
+           element_size);
+    for (size_t i = order.size(); i-- > 0;) {
+      if (++index[i] < transposed_shape[i]) {
+        break;
+      }
+      index[i] = 0;
+    }
+  }
+  return make_shared<opset::Constant>(constant->get_element_type(),
+                                      transposed_shape, data.data());
+}
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,37 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#pragma once
+
+#include <memory>
+
+#include "ngraph/ngraph.hpp"
+
+#include "ngraph_bridge/default_opset.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace pass {
+
+// A constant with the data of constant transposed, so that dimension i of
+// the result is dimension order[i] of constant. Passes use it instead of a
+// Transpose node where the input is known.
+std::shared_ptr<opset::Constant> TransposeConstant(
+    const std::shared_ptr<opset::Constant>& constant,
+    const ngraph::AxisVector& order);
+
+}  // namespace pass
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
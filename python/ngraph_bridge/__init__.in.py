@@ -19,6 +19,7 @@ from __future__ import division
 from __future__ import print_function
 
 import importlib
+import json
 import os
 import sys
 import time
@@ -48,6 +49,10 @@ __all__ = [
     'is_grappler_enabled', 'update_config',
     'set_disabled_ops', 'get_disabled_ops',
     'is_openvino_enabled',
+    'get_metrics', 'reset_metrics', 'dump_metrics',
+    'enable_tracing', 'disable_tracing', 'flush_trace',
+    'get_layer_profile', 'reset_layer_profile',
+    'get_rewrite_report',
 ]
 
 ext = 'dylib' if system() == 'Darwin' else 'so'
@@ -128,6 +133,16 @@ if ngraph_classic_loaded:
     ngraph_bridge_lib.ngraph_set_disabled_ops.argtypes = [ctypes.c_char_p]
     ngraph_bridge_lib.ngraph_get_disabled_ops.restype = ctypes.c_char_p
     ngraph_bridge_lib.ngraph_tf_is_openvino_enabled.restype = ctypes.c_bool
+    ngraph_bridge_lib.ngraph_get_metrics.argtypes = [ctypes.POINTER(ctypes.c_char_p)]
+    ngraph_bridge_lib.ngraph_get_metrics.restype = ctypes.c_bool
+    ngraph_bridge_lib.ngraph_dump_metrics.argtypes = [ctypes.c_char_p]
+    ngraph_bridge_lib.ngraph_dump_metrics.restype = ctypes.c_bool
+    ngraph_bridge_lib.ngraph_flush_trace.argtypes = [ctypes.c_char_p]
+    ngraph_bridge_lib.ngraph_flush_trace.restype = ctypes.c_bool
+    ngraph_bridge_lib.ngraph_get_layer_profile.argtypes = [ctypes.POINTER(ctypes.c_char_p)]
+    ngraph_bridge_lib.ngraph_get_layer_profile.restype = ctypes.c_bool
+    ngraph_bridge_lib.ngraph_get_rewrite_report.argtypes = [ctypes.c_int, ctypes.POINTER(ctypes.c_char_p)]
+    ngraph_bridge_lib.ngraph_get_rewrite_report.restype = ctypes.c_bool
 
     def enable():
         ngraph_bridge_lib.ngraph_enable()
@@ -218,6 +233,59 @@ if ngraph_classic_loaded:
     def get_disabled_ops():
         return ngraph_bridge_lib.ngraph_get_disabled_ops()
 
+    def get_metrics(as_text = False):
+        result = ctypes.c_char_p()
+        if not ngraph_bridge_lib.ngraph_get_metrics(ctypes.byref(result)):
+            raise Exception("Cannot get metrics")
+        text = result.value.decode("utf-8")
+        if as_text:
+            return text
+        # Map each sample, e.g. 'ngraph_tf_cache_hits_total{cluster="3"}',
+        # to its value
+        metrics = {}
+        for line in text.splitlines():
+            if line and not line.startswith('#'):
+                name, value = line.rsplit(' ', 1)
+                metrics[name] = float(value)
+        return metrics
+
+    def reset_metrics():
+        ngraph_bridge_lib.ngraph_reset_metrics()
+
+    def dump_metrics(path):
+        if not ngraph_bridge_lib.ngraph_dump_metrics(path.encode("utf-8")):
+            raise Exception("Cannot dump metrics to " + path)
+
+    def enable_tracing():
+        ngraph_bridge_lib.ngraph_enable_tracing()
+
+    def disable_tracing():
+        ngraph_bridge_lib.ngraph_disable_tracing()
+
+    # Writes the trace as Chrome trace JSON; by default to NGRAPH_TF_TRACE_FILE
+    def flush_trace(path = ""):
+        if not ngraph_bridge_lib.ngraph_flush_trace(path.encode("utf-8")):
+            raise Exception("Cannot write trace to " + path)
+
+    # Ranks TF ops by backend time; needs NGRAPH_TF_LAYER_PROFILE to be set
+    def get_layer_profile():
+        result = ctypes.c_char_p()
+        if not ngraph_bridge_lib.ngraph_get_layer_profile(ctypes.byref(result)):
+            raise Exception("Cannot get layer profile")
+        return result.value.decode("utf-8")
+
+    def reset_layer_profile():
+        ngraph_bridge_lib.ngraph_reset_layer_profile()
+
+    # Time and counts of every rewrite phase of graph_id, or a list of the
+    # reports of all graphs rewritten so far if graph_id is -1
+    def get_rewrite_report(graph_id = -1):
+        result = ctypes.c_char_p()
+        if not ngraph_bridge_lib.ngraph_get_rewrite_report(
+                graph_id, ctypes.byref(result)):
+            raise Exception("No rewrite report for graph " + str(graph_id))
+        return json.loads(result.value.decode("utf-8"))
+
     __version__ = \
     "nGraph bridge version: " + str(ngraph_bridge_lib.ngraph_tf_version()) + "\n" + \
     "nGraph version used for this build: " + str(ngraph_bridge_lib.ngraph_lib_version()) + "\n" + \
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor.h"
+
+#include "ngraph_bridge/ngraph_api.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+// Session::Run of a graph that becomes a single cluster of range(1) layers
+// of Relu(y + x), on inputs of range(0) floats. Whatever NGRAPH_TF_BACKEND
+// says runs it (e.g. INTERPRETER or CPU).
+static void BM_Compute(benchmark::State& state) {
+  int64 elements = state.range(0);
+  int num_layers = state.range(1);
+  config::Enable();
+
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  Output y = x;
+  for (int i = 0; i < num_layers; i++) {
+    y = ops::Relu(root, ops::Add(root, y, x));
+  }
+  ClientSession session(root);
+
+  Tensor x_value(DT_FLOAT, TensorShape{elements});
+  x_value.flat<float>().setConstant(0.5f);
+  vector<Tensor> outputs;
+  // The first run rewrites the graph and compiles the cluster
+  Status status = session.Run({{x, x_value}}, {y}, &outputs);
+  if (!status.ok()) {
+    state.SkipWithError(status.error_message().c_str());
+    return;
+  }
+
+  for (auto _ : state) {
+    status = session.Run({{x, x_value}}, {y}, &outputs);
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      return;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * elements * sizeof(float));
+}
+BENCHMARK(BM_Compute)
+    ->Args({16, 4})
+    ->Args({16, 16})
+    ->Args({1 << 16, 16})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "tensorflow/core/lib/strings/strcat.h"
+
+#include "ngraph_bridge/ngraph_data_cache.h"
+#include "ngraph_bridge/thread_safe_queue.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+// Lookups that hit, from several threads at once, of range(0) keys in a
+// cache deep enough to hold them all
+static void BM_DataCacheLookup(benchmark::State& state) {
+  static NgraphDataCache<string, int> cache(64);
+  int num_keys = state.range(0);
+  vector<string> keys;
+  for (int i = 0; i < num_keys; i++) {
+    keys.push_back(strings::StrCat("signature_", i, ";8,8,;/"));
+  }
+  auto create = [](string) { return std::make_pair(Status::OK(), 1); };
+
+  int i = state.thread_index;
+  for (auto _ : state) {
+    bool cache_hit;
+    auto status_value =
+        cache.LookUpOrCreate(keys[i++ % num_keys], create, cache_hit);
+    benchmark::DoNotOptimize(status_value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DataCacheLookup)
+    ->Arg(1)
+    ->Arg(16)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->UseRealTime();
+
+// Add() with a consumer thread draining the queue at the same time
+static void BM_ThreadSafeQueueThroughput(benchmark::State& state) {
+  ThreadSafeQueue<int> queue;
+  thread consumer([&queue]() {
+    while (queue.GetNextAvailable() >= 0) {
+    }
+  });
+
+  int i = 0;
+  for (auto _ : state) {
+    queue.Add(i++);
+  }
+  queue.Add(-1);
+  consumer.join();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ThreadSafeQueueThroughput)->UseRealTime();
+
+// Add() and GetNextAvailable() on one thread, i.e. without contention
+static void BM_ThreadSafeQueueRoundTrip(benchmark::State& state) {
+  ThreadSafeQueue<int> queue;
+  int i = 0;
+  for (auto _ : state) {
+    queue.Add(i++);
+    benchmark::DoNotOptimize(queue.GetNextAvailable());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ThreadSafeQueueRoundTrip);
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <sstream>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "tensorflow/core/framework/tensor.h"
+
+#include "ngraph_bridge/ngraph_encapsulate_impl.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+// Signature of range(0) [8, 8] float inputs, plus one static int32 input of
+// range(1) elements (if range(1) > 0), whose values go into the signature.
+static void BM_ComputeSignature(benchmark::State& state) {
+  int num_inputs = state.range(0);
+  int static_elements = state.range(1);
+
+  NGraphEncapsulateImpl ng_encap_impl;
+  vector<Tensor> input_tensors;
+  for (int i = 0; i < num_inputs; i++) {
+    Tensor input(DT_FLOAT, TensorShape{8, 8});
+    input.flat<float>().setZero();
+    input_tensors.push_back(input);
+  }
+  ng_encap_impl.ResizeStaticInputVector(num_inputs + 1);
+  for (int i = 0; i < num_inputs; i++) {
+    ng_encap_impl.SetStaticInputVector(i, false);
+  }
+  Tensor static_input(DT_INT32, TensorShape{static_elements});
+  static_input.flat<int32>().setConstant(7);
+  input_tensors.push_back(static_input);
+  ng_encap_impl.SetStaticInputVector(num_inputs, static_elements > 0);
+
+  for (auto _ : state) {
+    vector<TensorShape> input_shapes;
+    vector<const Tensor*> static_input_map;
+    std::stringstream signature_ss;
+    Status status = ng_encap_impl.ComputeSignature(
+        input_tensors, input_shapes, static_input_map, signature_ss);
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      return;
+    }
+    benchmark::DoNotOptimize(signature_ss);
+  }
+  state.SetItemsProcessed(state.iterations() * (num_inputs + 1));
+}
+BENCHMARK(BM_ComputeSignature)
+    ->Args({1, 0})
+    ->Args({8, 0})
+    ->Args({64, 0})
+    ->Args({8, 4})
+    ->Args({8, 64})
+    ->Args({8, 1024})
+    ->Args({8, 16384});
+
+// Wrapping range(0) TF tensors of range(1) floats each as nGraph tensors
+static void BM_AllocateNGTensors(benchmark::State& state) {
+  int num_tensors = state.range(0);
+  int64 elements = state.range(1);
+
+  NGraphEncapsulateImpl ng_encap_impl;
+  vector<Tensor> tf_tensors;
+  for (int i = 0; i < num_tensors; i++) {
+    Tensor tensor(DT_FLOAT, TensorShape{elements});
+    tensor.flat<float>().setZero();
+    tf_tensors.push_back(tensor);
+  }
+
+  for (auto _ : state) {
+    vector<shared_ptr<ngraph::runtime::Tensor>> ng_tensors;
+    Status status = ng_encap_impl.AllocateNGTensors(tf_tensors, ng_tensors);
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      return;
+    }
+    benchmark::DoNotOptimize(ng_tensors);
+  }
+  state.SetItemsProcessed(state.iterations() * num_tensors);
+}
+BENCHMARK(BM_AllocateNGTensors)
+    ->Args({1, 256})
+    ->Args({8, 256})
+    ->Args({64, 256})
+    ->Args({8, 1 << 20});
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+#include "test/benchmarks/bench_graphs.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+Status BuildSyntheticGraph(Graph* graph, int num_layers, int width,
+                           bool as_cluster) {
+  TensorShape shape{16, 16};
+  Tensor value(DT_FLOAT, shape);
+  value.flat<float>().setConstant(0.5f);
+
+  vector<Node*> branches(width);
+  for (int b = 0; b < width; b++) {
+    string name = strings::StrCat("input_", b);
+    if (as_cluster) {
+      TF_RETURN_IF_ERROR(NodeBuilder(name, "_Arg")
+                             .Attr("T", DT_FLOAT)
+                             .Attr("index", b)
+                             .Finalize(graph, &branches[b]));
+    } else {
+      TF_RETURN_IF_ERROR(NodeBuilder(name, "Placeholder")
+                             .Attr("dtype", DT_FLOAT)
+                             .Attr("shape", shape)
+                             .Finalize(graph, &branches[b]));
+    }
+  }
+
+  for (int layer = 0; layer < num_layers; layer++) {
+    vector<Node*> next(width);
+    for (int b = 0; b < width; b++) {
+      Node* other;
+      if (layer % 2 == 0) {
+        TF_RETURN_IF_ERROR(
+            NodeBuilder(strings::StrCat("const_", layer, "_", b), "Const")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("value", value)
+                .Finalize(graph, &other));
+      } else {
+        other = branches[(b + 1) % width];
+      }
+      Node* add;
+      TF_RETURN_IF_ERROR(
+          NodeBuilder(strings::StrCat("add_", layer, "_", b), "Add")
+              .Input(branches[b], 0)
+              .Input(other, 0)
+              .Attr("T", DT_FLOAT)
+              .Finalize(graph, &add));
+      TF_RETURN_IF_ERROR(
+          NodeBuilder(strings::StrCat("relu_", layer, "_", b), "Relu")
+              .Input(add, 0)
+              .Attr("T", DT_FLOAT)
+              .Finalize(graph, &next[b]));
+    }
+    branches = next;
+  }
+
+  for (int b = 0; b < width; b++) {
+    Node* output;
+    string name = strings::StrCat("output_", b);
+    if (as_cluster) {
+      TF_RETURN_IF_ERROR(NodeBuilder(name, "_Retval")
+                             .Input(branches[b], 0)
+                             .Attr("T", DT_FLOAT)
+                             .Attr("index", b)
+                             .Finalize(graph, &output));
+    } else {
+      TF_RETURN_IF_ERROR(NodeBuilder(name, "Identity")
+                             .Input(branches[b], 0)
+                             .Attr("T", DT_FLOAT)
+                             .Finalize(graph, &output));
+    }
+  }
+
+  FixupSourceAndSinkEdges(graph);
+  return Status::OK();
+}
+
+Status BuildSequenceGraph(Graph* graph, int num_steps) {
+  Tensor value(DT_FLOAT, TensorShape{8, 16});
+  value.flat<float>().setConstant(0.5f);
+
+  Node* input;
+  TF_RETURN_IF_ERROR(NodeBuilder("input", "_Arg")
+                         .Attr("T", DT_FLOAT)
+                         .Attr("index", 0)
+                         .Finalize(graph, &input));
+  Node* unpack;
+  TF_RETURN_IF_ERROR(NodeBuilder("unpack", "Unpack")
+                         .Input(input, 0)
+                         .Attr("T", DT_FLOAT)
+                         .Attr("num", num_steps)
+                         .Attr("axis", 0)
+                         .Finalize(graph, &unpack));
+  Node* c;
+  TF_RETURN_IF_ERROR(NodeBuilder("c", "Const")
+                         .Attr("dtype", DT_FLOAT)
+                         .Attr("value", value)
+                         .Finalize(graph, &c));
+
+  vector<NodeBuilder::NodeOut> steps;
+  for (int step = 0; step < num_steps; step++) {
+    Node* add;
+    TF_RETURN_IF_ERROR(NodeBuilder(strings::StrCat("add_", step), "Add")
+                           .Input(unpack, step)
+                           .Input(c, 0)
+                           .Attr("T", DT_FLOAT)
+                           .Finalize(graph, &add));
+    Node* tanh;
+    TF_RETURN_IF_ERROR(NodeBuilder(strings::StrCat("tanh_", step), "Tanh")
+                           .Input(add, 0)
+                           .Attr("T", DT_FLOAT)
+                           .Finalize(graph, &tanh));
+    steps.emplace_back(tanh, 0);
+  }
+
+  Node* pack;
+  TF_RETURN_IF_ERROR(NodeBuilder("pack", "Pack")
+                         .Input(steps)
+                         .Attr("T", DT_FLOAT)
+                         .Attr("N", num_steps)
+                         .Attr("axis", 0)
+                         .Finalize(graph, &pack));
+  Node* output;
+  TF_RETURN_IF_ERROR(NodeBuilder("output", "_Retval")
+                         .Input(pack, 0)
+                         .Attr("T", DT_FLOAT)
+                         .Attr("index", 0)
+                         .Finalize(graph, &output));
+
+  FixupSourceAndSinkEdges(graph);
+  return Status::OK();
+}
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
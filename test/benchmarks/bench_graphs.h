@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#ifndef NGRAPH_TF_BRIDGE_BENCH_GRAPHS_H_
+#define NGRAPH_TF_BRIDGE_BENCH_GRAPHS_H_
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+// Builds width branches of num_layers layers each, on [16, 16] float
+// tensors. Even layers compute Relu(x + c) for a Const c, odd layers
+// Relu(x + y) where y is the neighbouring branch, so the whole graph ends up
+// in one cluster. That is 2 * num_layers * width ops, plus the Consts.
+//
+// The inputs and outputs of the branches are Placeholders and Identities, or
+// _Args and _Retvals if as_cluster is set, i.e. the graph is then what
+// TranslateGraph gets to see.
+Status BuildSyntheticGraph(Graph* graph, int num_layers, int width,
+                           bool as_cluster = false);
+
+// Builds what an unrolled RNN over a [num_steps, 8, 16] float tensor looks
+// like to TranslateGraph: an _Arg unpacked into num_steps steps, a Tanh(x +
+// c) on each, and a Pack of the results into a _Retval.
+Status BuildSequenceGraph(Graph* graph, int num_steps);
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
+
+#endif  // NGRAPH_TF_BRIDGE_BENCH_GRAPHS_H_
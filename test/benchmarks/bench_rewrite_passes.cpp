@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "benchmark/benchmark.h"
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+
+#include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "ngraph_bridge/ngraph_cluster_manager.h"
+#include "ngraph_bridge/ngraph_deassign_clusters.h"
+#include "ngraph_bridge/ngraph_encapsulate_clusters.h"
+#include "ngraph_bridge/ngraph_mark_for_clustering.h"
+#include "test/benchmarks/bench_graphs.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+enum class Phase { kMark, kAssign, kDeassign, kEncapsulate };
+
+// Times one rewrite phase on a synthetic graph of range(0) layers by range(1)
+// branches. Every iteration starts from a fresh copy of the graph, and runs
+// the phases before the timed one untimed.
+static void BM_RewritePhase(benchmark::State& state, Phase phase) {
+  int num_layers = state.range(0);
+  int width = state.range(1);
+  Graph base(OpRegistry::Global());
+  Status status = BuildSyntheticGraph(&base, num_layers, width);
+  if (status.ok() && phase != Phase::kMark) {
+    status = MarkForClustering(&base, {});
+  }
+  if (!status.ok()) {
+    state.SkipWithError(status.error_message().c_str());
+    return;
+  }
+
+  std::unordered_map<string, string> device_config;
+  for (auto _ : state) {
+    state.PauseTiming();
+    NGraphClusterManager::EvictAllClusters();
+    Graph graph(OpRegistry::Global());
+    CopyGraph(base, &graph);
+    if (phase > Phase::kAssign) {
+      status = AssignClusters(&graph);
+    }
+    if (status.ok() && phase > Phase::kDeassign) {
+      status = DeassignClusters(&graph);
+    }
+    state.ResumeTiming();
+
+    if (status.ok()) {
+      switch (phase) {
+        case Phase::kMark:
+          status = MarkForClustering(&graph, {});
+          break;
+        case Phase::kAssign:
+          status = AssignClusters(&graph);
+          break;
+        case Phase::kDeassign:
+          status = DeassignClusters(&graph);
+          break;
+        case Phase::kEncapsulate:
+          status = EncapsulateClusters(&graph, 0, device_config);
+          break;
+      }
+    }
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      break;
+    }
+  }
+  NGraphClusterManager::EvictAllClusters();
+  state.SetItemsProcessed(state.iterations() * base.num_op_nodes());
+}
+
+#define BENCHMARK_REWRITE_PHASE(phase)                       \
+  BENCHMARK_CAPTURE(BM_RewritePhase, phase, Phase::k##phase) \
+      ->Args({16, 16})                                       \
+      ->Args({64, 64})                                       \
+      ->Args({256, 64})                                      \
+      ->Unit(benchmark::kMillisecond)
+
+BENCHMARK_REWRITE_PHASE(Mark);
+BENCHMARK_REWRITE_PHASE(Assign);
+BENCHMARK_REWRITE_PHASE(Deassign);
+BENCHMARK_REWRITE_PHASE(Encapsulate);
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
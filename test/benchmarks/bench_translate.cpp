@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+
+#include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_builder.h"
+#include "test/benchmarks/bench_graphs.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace benchmarks {
+
+// Translation of a synthetic cluster of range(0) layers by range(1) branches
+static void BM_TranslateGraph(benchmark::State& state) {
+  int num_layers = state.range(0);
+  int width = state.range(1);
+  Graph graph(OpRegistry::Global());
+  Status status = BuildSyntheticGraph(&graph, num_layers, width, true);
+  if (!status.ok()) {
+    state.SkipWithError(status.error_message().c_str());
+    return;
+  }
+  vector<TensorShape> input_shapes(width, TensorShape{16, 16});
+  vector<const Tensor*> static_input_map(width, nullptr);
+
+  for (auto _ : state) {
+    shared_ptr<ngraph::Function> ng_function;
+    status = Builder::TranslateGraph(input_shapes, static_input_map, &graph,
+                                     ng_function);
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      return;
+    }
+    benchmark::DoNotOptimize(ng_function);
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_layers * width);
+}
+BENCHMARK(BM_TranslateGraph)
+    ->Args({4, 4})
+    ->Args({32, 8})
+    ->Args({128, 16})
+    ->Unit(benchmark::kMillisecond);
+
+// Translation and compilation of an unrolled RNN of range(0) steps. The
+// ng_ops counter is the size of the translated function.
+static void BM_TranslateSequence(benchmark::State& state) {
+  int num_steps = state.range(0);
+  Graph graph(OpRegistry::Global());
+  Status status = BuildSequenceGraph(&graph, num_steps);
+  if (!status.ok()) {
+    state.SkipWithError(status.error_message().c_str());
+    return;
+  }
+  vector<TensorShape> input_shapes{TensorShape{num_steps, 8, 16}};
+  vector<const Tensor*> static_input_map{nullptr};
+  auto backend = BackendManager::GetBackend();
+
+  size_t num_ops = 0;
+  for (auto _ : state) {
+    shared_ptr<ngraph::Function> ng_function;
+    status = Builder::TranslateGraph(input_shapes, static_input_map, &graph,
+                                     ng_function);
+    if (!status.ok()) {
+      state.SkipWithError(status.error_message().c_str());
+      return;
+    }
+    num_ops = ng_function->get_ops().size();
+    benchmark::DoNotOptimize(backend->compile(ng_function));
+  }
+  state.counters["ng_ops"] = num_ops;
+  state.SetItemsProcessed(state.iterations() * num_steps);
+}
+BENCHMARK(BM_TranslateSequence)
+    ->Arg(16)
+    ->Arg(128)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace benchmarks
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
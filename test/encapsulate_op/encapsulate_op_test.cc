@@ -70,6 +70,36 @@ TEST(EncapsulateOp, ComputeSignature) {
   ASSERT_EQ(signature_ss.str(), "0,;2,;6,10,;10,10,10,;/");
 }
 
+// Test: Dimensions of NGRAPH_TF_DYNAMIC_DIMS are left out of the signature
+// of non-static inputs, if the backend compiles them
+TEST(EncapsulateOp, ComputeSignatureDynamicDims) {
+  auto env_map = StoreEnv({"NGRAPH_TF_DYNAMIC_DIMS"});
+  SetEnvVariable("NGRAPH_TF_DYNAMIC_DIMS", "0,2");
+  NGraphEncapsulateImpl ng_encap_impl;
+  RestoreEnv(env_map);
+
+  std::vector<tensorflow::Tensor> input_tensors;
+  input_tensors.emplace_back(DT_FLOAT, TensorShape({4, 6, 10}));
+  input_tensors.emplace_back(DT_INT32, TensorShape({2}));
+  AssignInputValues<int32>(input_tensors[1], {3, 5});
+  ng_encap_impl.ResizeStaticInputVector(2);
+  ng_encap_impl.SetStaticInputVector(0, false);
+  ng_encap_impl.SetStaticInputVector(1, true);
+
+  std::vector<tensorflow::TensorShape> input_shapes;
+  std::vector<const Tensor*> static_input_map;
+  std::stringstream signature_ss;
+  ASSERT_OK(ng_encap_impl.ComputeSignature(input_tensors, input_shapes,
+                                           static_input_map, signature_ss));
+  string signature = signature_ss.str();
+  if (BackendManager::SupportsDynamicDimensions()) {
+    ASSERT_EQ(signature.substr(0, signature.find('/')), "?,6,?,;2,;");
+  } else {
+    ASSERT_EQ(signature.substr(0, signature.find('/')), "4,6,10,;2,;");
+  }
+  ASSERT_EQ(input_shapes[0], TensorShape({4, 6, 10}));
+}
+
 // Test: Create backend and get ngraph executable
 TEST(EncapsulateOp, GetNgExecutable) {
   NGraphEncapsulateImpl ng_encap_impl;
@@ -31,6 +31,13 @@ namespace tensorflow {
 namespace ngraph_bridge {
 namespace testing {
 
+// Creates an empty cluster and returns its index
+static int NewCluster() {
+  size_t idx = 0;
+  EXPECT_EQ(NGraphClusterManager::NewCluster(idx), Status::OK());
+  return static_cast<int>(idx);
+}
+
 // Test that calls the functions of encapsulator in the wrong order
 // Non-OK statuses are expected
 TEST(EncapsulateClusters, EncapsulatorFail) {
@@ -66,8 +73,7 @@ TEST(EncapsulateClusters, EncapsulatorPass) {
   t_input_1.flat<int32>().data()[0] = 3;
   t_input_1.flat<int32>().data()[1] = 2;
 
-  int cluster_idx_0 = NGraphClusterManager::NewCluster();
-  ;
+  int cluster_idx_0 = NewCluster();
 
   Node* node1;
   ASSERT_OK(NodeBuilder("node1", "Const")
@@ -77,7 +83,7 @@ TEST(EncapsulateClusters, EncapsulatorPass) {
                 .Attr("_ngraph_cluster", cluster_idx_0)
                 .Finalize(&g, &node1));
 
-  int cluster_idx_1 = NGraphClusterManager::NewCluster();
+  int cluster_idx_1 = NewCluster();
   ASSERT_EQ(num_graphs_in_cluster_manager(), 2);
 
   Node* node2;
@@ -205,6 +211,15 @@ TEST(EncapsulateClusters, EncapsulatorPass) {
   ASSERT_EQ(NGraphClusterManager::GetClusterGraph(0)->node_size(), 2);
   ASSERT_EQ(NGraphClusterManager::GetClusterGraph(1)->node_size(), 4);
 
+  // RewritePass parsed the cluster graphs, and the parsed graph is shared
+  // rather than rebuilt on every request
+  std::shared_ptr<const Graph> parsed_0, parsed_1;
+  ASSERT_OK(NGraphClusterManager::GetClusterTFGraph(1, parsed_0));
+  ASSERT_OK(NGraphClusterManager::GetClusterTFGraph(1, parsed_1));
+  ASSERT_EQ(parsed_0, parsed_1);
+  ASSERT_EQ(parsed_0->num_op_nodes(), 4);
+  ASSERT_NOT_OK(NGraphClusterManager::GetClusterTFGraph(2, parsed_0));
+
   // The graph structure should have changed after RewritePass
   ASSERT_EQ(g.num_edges(), 6);
   ASSERT_EQ(g.num_op_nodes(), 3);
@@ -221,7 +236,7 @@ TEST(EncapsulateClusters, PopulateLibrary) {
   t_input_1.flat<int32>().data()[0] = 3;
   t_input_1.flat<int32>().data()[1] = 2;
 
-  int cluster_idx = NGraphClusterManager::NewCluster();
+  int cluster_idx = NewCluster();
 
   Node* node1;
   ASSERT_OK(NodeBuilder("node1", "Const")
@@ -275,6 +290,74 @@ TEST(EncapsulateClusters, PopulateLibrary) {
   // No Add or Const nodes left in the graph
   ASSERT_EQ(num_tf_nodes, 0);
 }
+
+// Published clusters belong to their graph id and go away once the last
+// kernel using them is released
+TEST(EncapsulateClusters, ClusterLifetime) {
+  NGraphClusterManager::EvictAllClusters();
+
+  int cluster_a = NewCluster();
+  int cluster_b = NewCluster();
+  int cluster_c = NewCluster();
+  ASSERT_OK(NGraphClusterManager::PublishCluster(cluster_a, 1));
+  ASSERT_OK(NGraphClusterManager::PublishCluster(cluster_b, 1));
+  ASSERT_OK(NGraphClusterManager::PublishCluster(cluster_c, 2));
+  ASSERT_NOT_OK(NGraphClusterManager::PublishCluster(cluster_a, 1));
+
+  std::shared_ptr<const Graph> graph_a, graph_b, graph_c;
+  ASSERT_OK(NGraphClusterManager::AcquireCluster(cluster_a, graph_a));
+  ASSERT_OK(NGraphClusterManager::AcquireCluster(cluster_b, graph_b));
+  ASSERT_OK(NGraphClusterManager::AcquireCluster(cluster_c, graph_c));
+
+  // Graph 1 is still in use by the kernel for cluster_b
+  NGraphClusterManager::ReleaseCluster(cluster_a);
+  ASSERT_NE(NGraphClusterManager::GetClusterGraph(cluster_a), nullptr);
+
+  // Last user of graph 1 is gone, graph 2 is unaffected
+  NGraphClusterManager::ReleaseCluster(cluster_b);
+  ASSERT_EQ(NGraphClusterManager::GetClusterGraph(cluster_a), nullptr);
+  ASSERT_EQ(NGraphClusterManager::GetClusterGraph(cluster_b), nullptr);
+  ASSERT_NE(NGraphClusterManager::GetClusterGraph(cluster_c), nullptr);
+
+  // Kernels keep their graphs even after the manager dropped them
+  ASSERT_NE(graph_a, nullptr);
+  ASSERT_EQ(graph_a->num_op_nodes(), 0);
+
+  // Deassigned clusters can be dropped right away
+  NGraphClusterManager::EvictCluster(cluster_c);
+  ASSERT_EQ(NGraphClusterManager::GetClusterGraph(cluster_c), nullptr);
+  NGraphClusterManager::ReleaseCluster(cluster_c);
+}
+
+// Indices of freed clusters are handed out again, but not while a kernel
+// still holds them, and EvictAllClusters leaves the clusters in use alone
+TEST(EncapsulateClusters, ClusterIndexReuse) {
+  NGraphClusterManager::EvictAllClusters();
+
+  int cluster_a = NewCluster();
+  int cluster_b = NewCluster();
+  ASSERT_OK(NGraphClusterManager::PublishCluster(cluster_a, 1));
+  ASSERT_OK(NGraphClusterManager::PublishCluster(cluster_b, 2));
+  std::shared_ptr<const Graph> graph_a, graph_b;
+  ASSERT_OK(NGraphClusterManager::AcquireCluster(cluster_a, graph_a));
+  ASSERT_OK(NGraphClusterManager::AcquireCluster(cluster_b, graph_b));
+
+  // Graph 2 is still in use, so its cluster survives
+  NGraphClusterManager::ReleaseCluster(cluster_a);
+  NGraphClusterManager::EvictAllClusters();
+  ASSERT_NE(NGraphClusterManager::GetClusterGraph(cluster_b), nullptr);
+
+  // The index of the freed cluster_a is taken first
+  ASSERT_EQ(NewCluster(), cluster_a);
+
+  // An evicted cluster keeps its index until its kernel is released
+  NGraphClusterManager::EvictCluster(cluster_b);
+  ASSERT_NE(NewCluster(), cluster_b);
+  NGraphClusterManager::ReleaseCluster(cluster_b);
+  ASSERT_EQ(NewCluster(), cluster_b);
+
+  NGraphClusterManager::EvictAllClusters();
+}
 }
 }
 }
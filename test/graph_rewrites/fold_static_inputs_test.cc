@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "ngraph_bridge/ngraph_fold_static_inputs.h"
+#include "ngraph_bridge/ngraph_utils.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Builds
+//
+//   x(Placeholder) -----------------------> reshape
+//     \                                      ^*
+//      --> shape --> slice --> concat -------|
+//
+// i.e. reshape(x, [shape(x)[0], -1]), where the starred input is static.
+static void BuildShapeChain(Graph* g, const PartialTensorShape& x_shape,
+                            Node** x, Node** shape, Node** reshape) {
+  ASSERT_OK(NodeBuilder("x", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("shape", x_shape)
+                .Finalize(g, x));
+
+  ASSERT_OK(NodeBuilder("shape", "Shape")
+                .Input(*x, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("out_type", DT_INT32)
+                .Attr("_ngraph_marked_for_clustering", true)
+                .Finalize(g, shape));
+
+  Tensor t_begin(DT_INT32, TensorShape{1});
+  t_begin.flat<int32>()(0) = 0;
+  Tensor t_size(DT_INT32, TensorShape{1});
+  t_size.flat<int32>()(0) = 1;
+  Node *begin, *size;
+  ASSERT_OK(NodeBuilder("begin", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_begin)
+                .Finalize(g, &begin));
+  ASSERT_OK(NodeBuilder("size", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_size)
+                .Finalize(g, &size));
+
+  Node* slice;
+  ASSERT_OK(NodeBuilder("slice", "Slice")
+                .Input(*shape, 0)
+                .Input(begin, 0)
+                .Input(size, 0)
+                .Attr("T", DT_INT32)
+                .Attr("Index", DT_INT32)
+                .Finalize(g, &slice));
+
+  Tensor t_minus_one(DT_INT32, TensorShape{1});
+  t_minus_one.flat<int32>()(0) = -1;
+  Node* minus_one;
+  ASSERT_OK(NodeBuilder("minus_one", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_minus_one)
+                .Finalize(g, &minus_one));
+
+  Node* concat;
+  ASSERT_OK(NodeBuilder("concat", "ConcatV2")
+                .Input(std::vector<NodeBuilder::NodeOut>{{slice, 0},
+                                                         {minus_one, 0}})
+                .Input(begin, 0)
+                .Attr("N", 2)
+                .Attr("T", DT_INT32)
+                .Attr("Tidx", DT_INT32)
+                .Finalize(g, &concat));
+
+  ASSERT_OK(NodeBuilder("reshape", "Reshape")
+                .Input(*x, 0)
+                .Input(concat, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("Tshape", DT_INT32)
+                .Attr("_ngraph_marked_for_clustering", true)
+                .Attr("_ngraph_static_inputs", std::vector<int32>{1})
+                .Finalize(g, reshape));
+
+  g->AddEdge(*reshape, Graph::kControlSlot, g->sink_node(),
+             Graph::kControlSlot);
+}
+
+// With x fully known the shape chain is folded into a Const and removed
+TEST(FoldStaticInputs, FoldsKnownShape) {
+  Graph g(OpRegistry::Global());
+  Node *x, *shape, *reshape;
+  BuildShapeChain(&g, PartialTensorShape({4, 3, 2}), &x, &shape, &reshape);
+
+  ASSERT_OK(FoldStaticInputs(&g, {}));
+
+  const Edge* shape_edge;
+  ASSERT_OK(reshape->input_edge(1, &shape_edge));
+  Node* folded = shape_edge->src();
+  ASSERT_EQ(folded->type_string(), "Const");
+  bool marked;
+  ASSERT_OK(GetNodeAttr(folded->attrs(), "_ngraph_marked_for_clustering",
+                        &marked));
+  ASSERT_TRUE(marked);
+
+  Tensor value;
+  ASSERT_OK(GetNodeAttr(folded->attrs(), "value", &value));
+  ASSERT_EQ(value.NumElements(), 2);
+  ASSERT_EQ(value.flat<int32>()(0), 4);
+  ASSERT_EQ(value.flat<int32>()(1), -1);
+
+  for (auto node : g.op_nodes()) {
+    ASSERT_NE(node->name(), "shape");
+    ASSERT_NE(node->name(), "slice");
+    ASSERT_NE(node->name(), "concat");
+  }
+
+  // The Reshape and its (now constant) shape land in the same cluster
+  ASSERT_OK(AssignClusters(&g));
+  int folded_cluster, reshape_cluster;
+  ASSERT_OK(GetNodeCluster(folded, &folded_cluster));
+  ASSERT_OK(GetNodeCluster(reshape, &reshape_cluster));
+  ASSERT_EQ(folded_cluster, reshape_cluster);
+}
+
+// Nothing can be done if the shape is only known at run time
+TEST(FoldStaticInputs, KeepsUnknownShape) {
+  Graph g(OpRegistry::Global());
+  Node *x, *shape, *reshape;
+  BuildShapeChain(&g, PartialTensorShape(), &x, &shape, &reshape);
+
+  ASSERT_OK(FoldStaticInputs(&g, {}));
+
+  const Edge* shape_edge;
+  ASSERT_OK(reshape->input_edge(1, &shape_edge));
+  ASSERT_EQ(shape_edge->src()->name(), "concat");
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
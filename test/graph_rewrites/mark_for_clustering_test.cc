@@ -16,10 +16,12 @@
 
 #include "gtest/gtest.h"
 
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/node_builder.h"
 
 #include "logging/tf_graph_writer.h"
+#include "ngraph_bridge/ngraph_control_flow.h"
 #include "ngraph_bridge/ngraph_mark_for_clustering.h"
 #include "ngraph_bridge/ngraph_utils.h"
 #include "test/test_utilities.h"
@@ -87,6 +89,261 @@ TEST(MarkForClustering, SimpleTest) {
     ASSERT_FALSE(NodeIsMarkedForClustering(node));
   }
 }
+
+// The shape input of a Reshape is static only if the backend cannot take it
+// at run time, while the axis of a ConcatV2 is always static
+TEST(MarkForClustering, ParametricInputs) {
+  auto env_map = StoreEnv({"NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS"});
+  Graph g(OpRegistry::Global());
+
+  Node* input;
+  ASSERT_OK(NodeBuilder("input", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Finalize(&g, &input));
+  Node* shape;
+  ASSERT_OK(NodeBuilder("shape", "Placeholder")
+                .Attr("dtype", DT_INT32)
+                .Finalize(&g, &shape));
+  Node* reshape;
+  ASSERT_OK(NodeBuilder("reshape", "Reshape")
+                .Input(input, 0)
+                .Input(shape, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("Tshape", DT_INT32)
+                .Finalize(&g, &reshape));
+
+  Tensor t_axis(DT_INT32, TensorShape{});
+  t_axis.scalar<int32>()() = 0;
+  Node* axis;
+  ASSERT_OK(NodeBuilder("axis", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_axis)
+                .Finalize(&g, &axis));
+  Node* concat;
+  ASSERT_OK(NodeBuilder("concat", "ConcatV2")
+                .Input(std::vector<NodeBuilder::NodeOut>{{reshape, 0},
+                                                         {reshape, 0}})
+                .Input(axis, 0)
+                .Attr("N", 2)
+                .Attr("T", DT_FLOAT)
+                .Attr("Tidx", DT_INT32)
+                .Finalize(&g, &concat));
+  g.AddEdge(concat, Graph::kControlSlot, g.sink_node(), Graph::kControlSlot);
+
+  ASSERT_OK(MarkForClustering(&g, {}));
+  ASSERT_TRUE(NodeIsMarkedForClustering(reshape));
+  ASSERT_EQ(InputIsStatic(reshape, 1), !BackendAcceptsParametricInputs());
+  ASSERT_TRUE(InputIsStatic(concat, 2));
+
+  ResetMarkForClustering(&g);
+  SetEnvVariable("NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS", "1");
+  ASSERT_FALSE(BackendAcceptsParametricInputs());
+  ASSERT_OK(MarkForClustering(&g, {}));
+  ASSERT_TRUE(InputIsStatic(reshape, 1));
+
+  UnsetEnvVariable("NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS");
+  RestoreEnv(env_map);
+}
+
+// A Reshape only takes its shape at run time if every op it feeds in nGraph
+// can cope with a dynamic shape: Relu can, Softmax cannot
+TEST(MarkForClustering, ParametricInputsNeedDynamicConsumers) {
+  auto env_map = StoreEnv({"NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS"});
+  Graph g(OpRegistry::Global());
+
+  Node* input;
+  ASSERT_OK(NodeBuilder("input", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Finalize(&g, &input));
+  Node* shape;
+  ASSERT_OK(NodeBuilder("shape", "Placeholder")
+                .Attr("dtype", DT_INT32)
+                .Finalize(&g, &shape));
+
+  std::vector<Node*> reshapes;
+  for (const string consumer : {"Relu", "Softmax"}) {
+    Node* reshape;
+    ASSERT_OK(NodeBuilder(consumer + "_reshape", "Reshape")
+                  .Input(input, 0)
+                  .Input(shape, 0)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("Tshape", DT_INT32)
+                  .Finalize(&g, &reshape));
+    Node* consumer_node;
+    ASSERT_OK(NodeBuilder(consumer, consumer)
+                  .Input(reshape, 0)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(&g, &consumer_node));
+    g.AddEdge(consumer_node, Graph::kControlSlot, g.sink_node(),
+              Graph::kControlSlot);
+    reshapes.push_back(reshape);
+  }
+
+  ASSERT_OK(MarkForClustering(&g, {}));
+  ASSERT_TRUE(NodeIsMarkedForClustering(reshapes[0]));
+  ASSERT_TRUE(NodeIsMarkedForClustering(reshapes[1]));
+  ASSERT_EQ(InputIsStatic(reshapes[0], 1), !BackendAcceptsParametricInputs());
+  ASSERT_TRUE(InputIsStatic(reshapes[1], 1));
+
+  RestoreEnv(env_map);
+}
+
+// A While whose loop counter is compared with a constant limit is marked,
+// with the initial value of the counter as a static input. A loop without a
+// counter is not, and neither is one whose counter starts from a value fed
+// at run time, or one that runs more than kMaxWhileTripCount times.
+TEST(MarkForClustering, While) {
+  using FDH = FunctionDefHelper;
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = FDH::Create(
+      "body", {"i: int32", "x: float"}, {"i_out: int32", "x_out: float"}, {},
+      {FDH::Const("one", 1),
+       {{"next_i"}, "Add", {"i", "one:output:0"}, {{"T", DT_INT32}}},
+       {{"next_x"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}}},
+      {{"i_out", "next_i:z:0"}, {"x_out", "next_x:z:0"}});
+  *fdef_lib.add_function() = FDH::Create(
+      "counter_cond", {"i: int32", "x: float"}, {"p: bool"}, {},
+      {FDH::Const("limit", 10),
+       {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}}},
+      {{"p", "less:z:0"}});
+  *fdef_lib.add_function() = FDH::Create(
+      "value_cond", {"i: int32", "x: float"}, {"p: bool"}, {},
+      {FDH::Const("limit", 10.0f),
+       {{"less"}, "Less", {"x", "limit:output:0"}, {{"T", DT_FLOAT}}}},
+      {{"p", "less:z:0"}});
+
+  Graph g(OpRegistry::Global());
+  ASSERT_OK(g.AddFunctionLibrary(fdef_lib));
+
+  Tensor t_i(DT_INT32, TensorShape{});
+  t_i.scalar<int32>()() = 0;
+  Node* i;
+  ASSERT_OK(NodeBuilder("i", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_i)
+                .Finalize(&g, &i));
+  Tensor t_far(DT_INT32, TensorShape{});
+  t_far.scalar<int32>()() = 10 - (kMaxWhileTripCount + 1);
+  Node* far;
+  ASSERT_OK(NodeBuilder("far", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_far)
+                .Finalize(&g, &far));
+  Node* fed;
+  ASSERT_OK(NodeBuilder("fed", "Placeholder")
+                .Attr("dtype", DT_INT32)
+                .Finalize(&g, &fed));
+  Node* x;
+  ASSERT_OK(NodeBuilder("x", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Finalize(&g, &x));
+
+  NameAttrList body;
+  body.set_name("body");
+  std::vector<Node*> loops;
+  std::vector<std::pair<string, Node*>> conds_and_inits{
+      {"counter_cond", i}, {"value_cond", i}, {"counter_cond", far},
+      {"counter_cond", fed}};
+  for (const auto& cond_and_init : conds_and_inits) {
+    NameAttrList cond;
+    cond.set_name(cond_and_init.first);
+    Node* loop;
+    ASSERT_OK(NodeBuilder(cond_and_init.first + "_" +
+                              cond_and_init.second->name() + "_while",
+                          "While")
+                  .Input(std::vector<NodeBuilder::NodeOut>{
+                      {cond_and_init.second, 0}, {x, 0}})
+                  .Attr("T", DataTypeVector{DT_INT32, DT_FLOAT})
+                  .Attr("cond", cond)
+                  .Attr("body", body)
+                  .Finalize(&g, &loop));
+    g.AddEdge(loop, Graph::kControlSlot, g.sink_node(), Graph::kControlSlot);
+    loops.push_back(loop);
+  }
+
+  ASSERT_OK(MarkForClustering(&g, {}));
+  ASSERT_TRUE(NodeIsMarkedForClustering(loops[0]));
+  ASSERT_TRUE(InputIsStatic(loops[0], 0));
+  ASSERT_FALSE(InputIsStatic(loops[0], 1));
+  ASSERT_FALSE(NodeIsMarkedForClustering(loops[1]));
+  ASSERT_FALSE(NodeIsMarkedForClustering(loops[2]));
+  ASSERT_FALSE(NodeIsMarkedForClustering(loops[3]));
+}
+
+// A While with a string loop variable, and an If with a string argument,
+// are not marked, though their functions only compute on the other values
+TEST(MarkForClustering, ControlFlowTypes) {
+  using FDH = FunctionDefHelper;
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = FDH::Create(
+      "body", {"i: int32", "s: string"}, {"i_out: int32", "s_out: string"},
+      {},
+      {FDH::Const("one", 1),
+       {{"next_i"}, "Add", {"i", "one:output:0"}, {{"T", DT_INT32}}}},
+      {{"i_out", "next_i:z:0"}, {"s_out", "s"}});
+  *fdef_lib.add_function() = FDH::Create(
+      "cond", {"i: int32", "s: string"}, {"p: bool"}, {},
+      {FDH::Const("limit", 10),
+       {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}}},
+      {{"p", "less:z:0"}});
+  *fdef_lib.add_function() = FDH::Create(
+      "branch", {"x: float", "s: string"}, {"y: float"}, {},
+      {{{"neg"}, "Neg", {"x"}, {{"T", DT_FLOAT}}}}, {{"y", "neg:y:0"}});
+
+  Graph g(OpRegistry::Global());
+  ASSERT_OK(g.AddFunctionLibrary(fdef_lib));
+
+  Tensor t_i(DT_INT32, TensorShape{});
+  t_i.scalar<int32>()() = 0;
+  Node* i;
+  ASSERT_OK(NodeBuilder("i", "Const")
+                .Attr("dtype", DT_INT32)
+                .Attr("value", t_i)
+                .Finalize(&g, &i));
+  Tensor t_pred(DT_BOOL, TensorShape{});
+  t_pred.scalar<bool>()() = true;
+  Node* pred;
+  ASSERT_OK(NodeBuilder("pred", "Const")
+                .Attr("dtype", DT_BOOL)
+                .Attr("value", t_pred)
+                .Finalize(&g, &pred));
+  Node* s;
+  ASSERT_OK(NodeBuilder("s", "Placeholder")
+                .Attr("dtype", DT_STRING)
+                .Finalize(&g, &s));
+  Node* x;
+  ASSERT_OK(NodeBuilder("x", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Finalize(&g, &x));
+
+  NameAttrList cond, body, branch;
+  cond.set_name("cond");
+  body.set_name("body");
+  branch.set_name("branch");
+  Node* loop;
+  ASSERT_OK(NodeBuilder("while", "While")
+                .Input(std::vector<NodeBuilder::NodeOut>{{i, 0}, {s, 0}})
+                .Attr("T", DataTypeVector{DT_INT32, DT_STRING})
+                .Attr("cond", cond)
+                .Attr("body", body)
+                .Finalize(&g, &loop));
+  g.AddEdge(loop, Graph::kControlSlot, g.sink_node(), Graph::kControlSlot);
+  Node* if_node;
+  ASSERT_OK(NodeBuilder("if", "If")
+                .Input(pred)
+                .Input(std::vector<NodeBuilder::NodeOut>{{x, 0}, {s, 0}})
+                .Attr("Tin", DataTypeVector{DT_FLOAT, DT_STRING})
+                .Attr("Tout", DataTypeVector{DT_FLOAT})
+                .Attr("then_branch", branch)
+                .Attr("else_branch", branch)
+                .Finalize(&g, &if_node));
+  g.AddEdge(if_node, Graph::kControlSlot, g.sink_node(),
+            Graph::kControlSlot);
+
+  ASSERT_OK(MarkForClustering(&g, {}));
+  ASSERT_FALSE(NodeIsMarkedForClustering(loop));
+  ASSERT_FALSE(NodeIsMarkedForClustering(if_node));
+}
 }
 }
 }
\ No newline at end of file
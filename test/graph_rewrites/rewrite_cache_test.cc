@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def_util.h"
+
+#include "ngraph_bridge/ngraph_api.h"
+#include "ngraph_bridge/ngraph_cluster_manager.h"
+#include "ngraph_bridge/ngraph_rewrite_cache.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Creates an empty cluster and returns its index
+static int NewCluster() {
+  size_t idx = 0;
+  EXPECT_EQ(NGraphClusterManager::NewCluster(idx), Status::OK());
+  return static_cast<int>(idx);
+}
+
+static void AddNode(GraphDef* gdef, const string& name, const string& op,
+                    const vector<string>& inputs) {
+  NodeDef* node = gdef->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  for (const auto& input : inputs) {
+    node->add_input(input);
+  }
+}
+
+// The key must not depend on node order, but must depend on the disabled ops
+TEST(RewriteCache, KeyIsCanonical) {
+  GraphDef g1, g2;
+  AddNode(&g1, "a", "Const", {});
+  AddNode(&g1, "b", "Abs", {"a"});
+  AddNode(&g2, "b", "Abs", {"a"});
+  AddNode(&g2, "a", "Const", {});
+
+  string key1, key2, key3;
+  ASSERT_OK(NGraphRewriteCache::ComputeKey(g1, {}, {}, key1));
+  ASSERT_OK(NGraphRewriteCache::ComputeKey(g2, {}, {}, key2));
+  ASSERT_EQ(key1, key2);
+
+  config::SetDisabledOps("Abs");
+  ASSERT_OK(NGraphRewriteCache::ComputeKey(g1, {}, {}, key3));
+  ASSERT_NE(key1, key3);
+
+  // Clean up
+  config::ngraph_set_disabled_ops("");
+}
+
+// Settings that change the rewritten graph are part of the key
+TEST(RewriteCache, KeyDependsOnSettings) {
+  const list<string> settings{"NGRAPH_TF_DISABLE_DEASSIGN_CLUSTERS",
+                              "NGRAPH_TF_DISABLE_FOLD_STATIC_INPUTS",
+                              "NGRAPH_TF_DISABLE_PARAMETRIC_INPUTS"};
+  auto env_map = StoreEnv(settings);
+  GraphDef g;
+  AddNode(&g, "a", "Const", {});
+  AddNode(&g, "b", "Abs", {"a"});
+
+  std::set<string> keys;
+  string key;
+  ASSERT_OK(NGraphRewriteCache::ComputeKey(g, {}, {}, key));
+  keys.insert(key);
+  for (const auto& name : settings) {
+    SetEnvVariable(name, "1");
+    ASSERT_OK(NGraphRewriteCache::ComputeKey(g, {}, {}, key));
+    ASSERT_TRUE(keys.insert(key).second) << name;
+  }
+
+  for (const auto& name : settings) {
+    UnsetEnvVariable(name);
+  }
+  RestoreEnv(env_map);
+}
+
+// A hit registers fresh clusters and rewires the encapsulate and its users
+TEST(RewriteCache, LookupRewiresClusters) {
+  NGraphRewriteCache::Clear();
+  NGraphClusterManager::EvictAllClusters();
+
+  int cluster_idx = NewCluster();
+  AddNode(NGraphClusterManager::GetClusterGraph(cluster_idx), "ngraph_input_0",
+          "_Arg", {});
+
+  GraphDef encapsulated;
+  AddNode(&encapsulated, "x", "Placeholder", {});
+  string encap_name = "ngraph_cluster_" + to_string(cluster_idx);
+  AddNode(&encapsulated, encap_name, "NGraphEncapsulate", {"x"});
+  auto* encap_attr = encapsulated.mutable_node(1)->mutable_attr();
+  SetAttrValue(cluster_idx, &(*encap_attr)["ngraph_cluster"]);
+  AddNode(&encapsulated, "y", "Abs", {encap_name + ":1", "^" + encap_name});
+
+  ASSERT_OK(NGraphRewriteCache::Insert("test_key", encapsulated));
+
+  GraphDef output;
+  bool cache_hit;
+  ASSERT_OK(NGraphRewriteCache::Lookup("missing_key", 0, &output, cache_hit));
+  ASSERT_FALSE(cache_hit);
+  ASSERT_OK(NGraphRewriteCache::Lookup("test_key", 7, &output, cache_hit));
+  ASSERT_TRUE(cache_hit);
+
+  int new_idx;
+  ASSERT_OK(GetNodeAttr(AttrSlice(output.node(1)), "ngraph_cluster", &new_idx));
+  ASSERT_NE(new_idx, cluster_idx);
+  int graph_id;
+  ASSERT_OK(
+      GetNodeAttr(AttrSlice(output.node(1)), "ngraph_graph_id", &graph_id));
+  ASSERT_EQ(graph_id, 7);
+  ASSERT_EQ(NGraphClusterManager::GetClusterGraph(new_idx)->node_size(), 1);
+
+  string new_name = "ngraph_cluster_" + to_string(new_idx);
+  ASSERT_EQ(output.node(1).name(), new_name);
+  ASSERT_EQ(output.node(2).input(0), new_name + ":1");
+  ASSERT_EQ(output.node(2).input(1), "^" + new_name);
+
+  NGraphRewriteCache::Clear();
+  NGraphClusterManager::EvictAllClusters();
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
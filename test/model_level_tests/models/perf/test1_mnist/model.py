@@ -0,0 +1,54 @@
+#==============================================================================
+#  Copyright 2019-2020 Intel Corporation
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# =============================================================================
+
+# The deep MNIST network that test/models/mnist trains, with the weights as
+# constants, as in a frozen inference graph
+
+import numpy as np
+import tensorflow as tf
+
+BATCH = 32
+
+
+def build():
+    random = np.random.RandomState(0)
+
+    def weight(shape):
+        return tf.constant(
+            random.normal(scale=0.1, size=shape).astype(np.float32))
+
+    def conv_pool(x, in_channels, out_channels):
+        w = weight([5, 5, in_channels, out_channels])
+        b = weight([out_channels])
+        conv = tf.nn.conv2d(x, w, strides=[1, 1, 1, 1], padding='SAME')
+        return tf.nn.max_pool(
+            tf.nn.relu(conv + b),
+            ksize=[1, 2, 2, 1],
+            strides=[1, 2, 2, 1],
+            padding='SAME')
+
+    x = tf.compat.v1.placeholder(tf.float32, [BATCH, 784], name='x')
+    x_image = tf.reshape(x, [-1, 28, 28, 1])
+    h_pool1 = conv_pool(x_image, 1, 32)
+    h_pool2 = conv_pool(h_pool1, 32, 64)
+    h_pool2_flat = tf.reshape(h_pool2, [-1, 7 * 7 * 64])
+    h_fc1 = tf.nn.relu(
+        tf.matmul(h_pool2_flat, weight([7 * 7 * 64, 1024])) + weight([1024]))
+    y = tf.matmul(h_fc1, weight([1024, 10])) + weight([10])
+    probabilities = tf.nn.softmax(y, name='probabilities')
+
+    feed_dict = {x: random.rand(BATCH, 784).astype(np.float32)}
+    return feed_dict, [probabilities]
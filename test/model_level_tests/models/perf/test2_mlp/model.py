@@ -0,0 +1,41 @@
+#==============================================================================
+#  Copyright 2019-2020 Intel Corporation
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# =============================================================================
+
+# A 4 layer MLP, with the weights as constants
+
+import numpy as np
+import tensorflow as tf
+
+BATCH = 64
+LAYERS = [512, 1024, 1024, 256, 10]
+
+
+def build():
+    random = np.random.RandomState(0)
+    x = tf.compat.v1.placeholder(tf.float32, [BATCH, LAYERS[0]], name='x')
+    h = x
+    for i in range(1, len(LAYERS)):
+        w = tf.constant(
+            random.normal(scale=0.05, size=[LAYERS[i - 1],
+                                            LAYERS[i]]).astype(np.float32))
+        b = tf.constant(np.zeros(LAYERS[i], dtype=np.float32))
+        h = tf.nn.bias_add(tf.matmul(h, w), b)
+        if i < len(LAYERS) - 1:
+            h = tf.nn.relu(h)
+    logits = tf.identity(h, name='logits')
+
+    feed_dict = {x: random.rand(BATCH, LAYERS[0]).astype(np.float32)}
+    return feed_dict, [logits]
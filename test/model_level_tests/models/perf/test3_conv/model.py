@@ -0,0 +1,57 @@
+#==============================================================================
+#  Copyright 2019-2020 Intel Corporation
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# =============================================================================
+
+# A stack of conv, batch norm and relu blocks with residual adds, the
+# pattern most image models are made of
+
+import numpy as np
+import tensorflow as tf
+
+BATCH = 8
+CHANNELS = 32
+BLOCKS = 4
+
+
+def build():
+    random = np.random.RandomState(0)
+
+    def constant(shape, scale=0.1):
+        return tf.constant(
+            random.normal(scale=scale, size=shape).astype(np.float32))
+
+    def conv_bn(x, relu):
+        w = constant([3, 3, CHANNELS, CHANNELS])
+        conv = tf.nn.conv2d(x, w, strides=[1, 1, 1, 1], padding='SAME')
+        y, _, _ = tf.compat.v1.nn.fused_batch_norm(
+            conv,
+            scale=constant([CHANNELS], 1.0),
+            offset=constant([CHANNELS]),
+            mean=constant([CHANNELS]),
+            variance=tf.constant(
+                1.0 + random.rand(CHANNELS).astype(np.float32)),
+            data_format='NHWC',
+            is_training=False)
+        return tf.nn.relu(y) if relu else y
+
+    x = tf.compat.v1.placeholder(tf.float32, [BATCH, 56, 56, 3], name='x')
+    w_in = constant([3, 3, 3, CHANNELS])
+    h = tf.nn.relu(tf.nn.conv2d(x, w_in, strides=[1, 1, 1, 1], padding='SAME'))
+    for _ in range(BLOCKS):
+        h = tf.nn.relu(h + conv_bn(conv_bn(h, True), False))
+    pooled = tf.reduce_mean(h, axis=[1, 2], name='pooled')
+
+    feed_dict = {x: random.rand(BATCH, 56, 56, 3).astype(np.float32)}
+    return feed_dict, [pooled]
@@ -0,0 +1,169 @@
+#==============================================================================
+#  Copyright 2019-2020 Intel Corporation
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+# =============================================================================
+
+# Runs one model for a fixed number of iterations and writes its performance
+# numbers to a json file. test_main.py runs it in a process of its own for
+# each model, so that compile time and peak RSS are those of that model
+# alone.
+#
+# The model is either a pb/pbtxt (whose Placeholders must have static shapes,
+# and whose fetches are the nodes nothing consumes) or a python file with a
+# build() function, which builds the model in the default graph and returns
+# (feed_dict, fetches).
+
+import argparse, json, os, platform, resource, time
+import importlib.util
+
+import numpy as np
+import tensorflow as tf
+tf.compat.v1.disable_eager_execution()
+import ngraph_bridge
+
+from google.protobuf import text_format
+
+
+def build_from_graphdef(model_file):
+    graph_def = tf.compat.v1.GraphDef()
+    if model_file.endswith('.pbtxt'):
+        with open(model_file) as f:
+            text_format.Merge(f.read(), graph_def)
+    else:
+        with open(model_file, 'rb') as f:
+            graph_def.ParseFromString(f.read())
+    tf.import_graph_def(graph_def, name='')
+
+    graph = tf.compat.v1.get_default_graph()
+    ops = graph.get_operations()
+    consumed = set(
+        [inp.op.name for op in ops for inp in op.inputs] +
+        [ctrl.name for op in ops for ctrl in op.control_inputs])
+    random = np.random.RandomState(0)
+    feed_dict = {}
+    for op in ops:
+        if op.type == 'Placeholder':
+            tensor = op.outputs[0]
+            assert tensor.shape.is_fully_defined(
+            ), 'Placeholder ' + op.name + ' needs a static shape'
+            feed_dict[tensor] = random.rand(*tensor.shape.as_list()).astype(
+                tensor.dtype.as_numpy_dtype)
+    fetches = [
+        op.outputs[0]
+        for op in ops
+        if op.name not in consumed and len(op.outputs) > 0
+    ]
+    return feed_dict, fetches
+
+
+def build_from_python(model_file):
+    spec = importlib.util.spec_from_file_location('perf_model', model_file)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.build()
+
+
+# Sum of the compile times of all clusters, from the bridge's metrics
+def compile_time_ms():
+    metrics = ngraph_bridge.get_metrics()
+    return sum([
+        v for k, v in metrics.items()
+        if k.startswith('ngraph_tf_compile_time_us_sum')
+    ]) / 1000.0
+
+
+def cpu_model():
+    try:
+        with open('/proc/cpuinfo') as f:
+            for line in f:
+                if line.startswith('model name'):
+                    return line.split(':', 1)[1].strip()
+    except IOError:
+        pass
+    return platform.processor()
+
+
+# What the numbers were measured on, to be recorded with a baseline
+def environment(backend, iterations):
+    return {
+        'host': platform.node(),
+        'cpu': cpu_model(),
+        'cpu_count': os.cpu_count(),
+        'os': platform.platform(),
+        'tensorflow': tf.version.VERSION,
+        'ngraph_bridge': ngraph_bridge.__version__,
+        'backend': backend,
+        'iterations': iterations
+    }
+
+
+def run_model(model_file, backend, iterations):
+    ngraph_bridge.set_backend(backend)
+    if model_file.endswith('.py'):
+        feed_dict, fetches = build_from_python(model_file)
+    else:
+        feed_dict, fetches = build_from_graphdef(model_file)
+
+    config = tf.compat.v1.ConfigProto(
+        allow_soft_placement=True, inter_op_parallelism_threads=1)
+    config = ngraph_bridge.update_config(config, backend_name=backend)
+    with tf.compat.v1.Session(config=config) as sess:
+        sess.run(tf.compat.v1.global_variables_initializer())
+        ngraph_bridge.reset_metrics()
+
+        # The first run rewrites the graph and compiles the clusters
+        tstart = time.time()
+        sess.run(fetches, feed_dict=feed_dict)
+        first_inference_ms = (time.time() - tstart) * 1000
+
+        latencies = []
+        for _ in range(iterations):
+            tstart = time.time()
+            sess.run(fetches, feed_dict=feed_dict)
+            latencies.append((time.time() - tstart) * 1000)
+
+    # ru_maxrss is in KB on Linux
+    peak_rss_mb = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024.0
+    return {
+        'compile_time_ms': compile_time_ms(),
+        'first_inference_ms': first_inference_ms,
+        'steady_state_ms': float(np.median(latencies)),
+        'peak_rss_mb': peak_rss_mb,
+        'environment': environment(backend, iterations)
+    }
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Run one model and measure its performance')
+    parser.add_argument(
+        '--model', type=str, required=True, help='pb, pbtxt or python file')
+    parser.add_argument(
+        '--backend', type=str, default='CPU', help='nGraph backend to run on')
+    parser.add_argument(
+        '--iterations',
+        type=int,
+        default=20,
+        help='Number of runs after the first one')
+    parser.add_argument(
+        '--result_file',
+        type=str,
+        required=True,
+        help='json file to write the numbers to')
+    args = parser.parse_args()
+
+    result = run_model(
+        os.path.abspath(args.model), args.backend, args.iterations)
+    with open(args.result_file, 'w') as f:
+        json.dump(result, f, sort_keys=True)
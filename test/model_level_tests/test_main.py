@@ -16,7 +16,7 @@
 
 import pdb, time
 from subprocess import check_output, call, Popen, PIPE
-import json, os, argparse, sys
+import json, os, argparse, sys, tempfile, datetime
 import sys
 # expects tools to be present at this relative location. Need access to build_utils
 sys.path.insert(0, os.path.abspath('../../tools'))
@@ -24,6 +24,9 @@ from build_utils import download_repo
 from log_parser import parse_logs, compare_parsed_values
 import atexit
 
+perf_runner = os.path.abspath(
+    os.path.join(os.path.dirname(__file__), 'perf_runner.py'))
+
 
 def get_expected_from_json(json_file_name, configuration, strict):
     with open(json_file_name) as f:
@@ -211,8 +214,11 @@ def run_test_suite(model_dir, configuration, disabled, print_parsed,
                             model_format = 'savedmodel'
                         elif split_on_dot[1] in ['pb', 'pbtxt']:
                             model_format = split_on_dot[1]
+                        elif split_on_dot[1] == 'py':
+                            # Builds the model, see perf_runner.py
+                            model_format = 'python'
                         else:
-                            assert False, "Unknown input format. Expected savedmodel, pb or pbtxt"
+                            assert False, "Unknown input format. Expected savedmodel, pb, pbtxt or py"
 
                     expected_json_file = sub_test_dir + '/expected.json'
                     expected_json_present = os.path.isfile(expected_json_file)
@@ -307,6 +313,146 @@ def run_test_suite(model_dir, configuration, disabled, print_parsed,
             command_executor('rm -rf ' + repo_dl_loc)
 
 
+def get_perf_baseline(json_file_name, configuration):
+    with open(json_file_name) as f:
+        baseline = json.load(f).get(configuration)
+    if baseline is None:
+        return None
+    possible_keys = set(['backend', 'iterations', 'metrics', 'reference'])
+    for k in baseline:
+        assert k in possible_keys, "Got unexpected key in json: " + k + ". Expected: " + str(
+            possible_keys)
+    for k in baseline['metrics']:
+        assert k in perf_metrics(), "Got unexpected metric in json: " + k + ". Expected: " + ','.join(
+            perf_metrics())
+    return baseline
+
+
+# The numbers perf_runner.py measures. For all of them lower is better
+def perf_metrics():
+    return [
+        'compile_time_ms', 'first_inference_ms', 'steady_state_ms',
+        'peak_rss_mb'
+    ]
+
+
+# A baseline only gates when its values come from a recorded reference run
+# (see --update_perf_baselines). Otherwise the numbers are only reported.
+def perf_baseline_gates(baseline):
+    return 'reference' in baseline and all(
+        'value' in m for m in baseline['metrics'].values())
+
+
+# Returns a help string for each metric that is more than its tolerance
+# (relative, by default 0.25) above the baseline
+def compare_perf_values(measured, baseline_metrics):
+    regressions = []
+    for metric in baseline_metrics:
+        actual = measured[metric]
+        if 'value' not in baseline_metrics[metric]:
+            print('\t{:<20} {:>12.3f} {:>12}'.format(metric, actual, '-'))
+            continue
+        expected = baseline_metrics[metric]['value']
+        tolerance = baseline_metrics[metric].get('tolerance', 0.25)
+        status = 'ok'
+        if actual > expected * (1 + tolerance):
+            status = 'REGRESSION'
+            regressions.append(metric + ' is ' + str(actual) +
+                               ', baseline ' + str(expected) +
+                               ' with tolerance ' + str(tolerance))
+        elif actual < expected * (1 - tolerance):
+            # Not a failure, but the baseline should be brought down
+            status = 'improved'
+        print('\t{:<20} {:>12.3f} {:>12.3f}  {}'.format(
+            metric, actual, expected, status))
+    return regressions
+
+
+def run_perf_model(model_file, backend, iterations):
+    with tempfile.NamedTemporaryFile(suffix='.json') as result_file:
+        command_executor(
+            ' '.join([
+                sys.executable, perf_runner, '--model', model_file,
+                '--backend', backend, '--iterations',
+                str(iterations), '--result_file', result_file.name
+            ]),
+            msg='Running perf test on ' + backend + ': ',
+            stdout=PIPE,
+            stderr=PIPE)
+        return json.load(result_file)
+
+
+# Runs the sub-tests that have a perf_baseline.json with an entry for
+# configuration. Each model runs in a process of its own.
+def run_perf_suite(model_dir, configuration, disabled, update_baselines,
+                   require_reference):
+    model_dir = os.path.abspath(model_dir)
+    passed_tests = []
+    failed_tests = []
+    skipped_tests = []
+    ungated_tests = []
+    for flname in sorted(os.listdir(model_dir)):
+        sub_test_dir = model_dir + '/' + flname
+        baseline_file = sub_test_dir + '/perf_baseline.json'
+        if not (flname.startswith('test') and os.path.isfile(baseline_file)):
+            continue
+        if 'disabled' in flname or flname in disabled:
+            skipped_tests.append(flname)
+            continue
+        baseline = get_perf_baseline(baseline_file, configuration)
+        if baseline is None:
+            skipped_tests.append(flname)
+            continue
+        model = [
+            i for i in os.listdir(sub_test_dir)
+            if i.split('.')[-1] in ['pb', 'pbtxt', 'py']
+        ]
+        assert len(model) == 1, "Expected one pb, pbtxt or py model in " + sub_test_dir
+        try:
+            measured = run_perf_model(sub_test_dir + '/' + model[0],
+                                      baseline.get('backend', 'CPU'),
+                                      baseline.get('iterations', 20))
+        except Exception as e:
+            print(e)
+            failed_tests.append(flname)
+            continue
+        print('\t{:<20} {:>12} {:>12}'.format('metric', 'measured',
+                                               'baseline'))
+        regressions = compare_perf_values(measured, baseline['metrics'])
+        if update_baselines:
+            with open(baseline_file) as f:
+                all_baselines = json.load(f)
+            for metric in all_baselines[configuration]['metrics']:
+                all_baselines[configuration]['metrics'][metric][
+                    'value'] = round(measured[metric], 3)
+            reference = measured['environment']
+            reference['date'] = datetime.date.today().isoformat()
+            all_baselines[configuration]['reference'] = reference
+            with open(baseline_file, 'w') as f:
+                f.write(
+                    json.dumps(
+                        all_baselines,
+                        sort_keys=True,
+                        indent=4,
+                        separators=(',', ': ')) + '\n')
+            print('Updated ' + baseline_file)
+        elif not perf_baseline_gates(baseline):
+            print('Perf test ' + flname +
+                  ' has no reference baseline, so it is not gated')
+            if require_reference:
+                failed_tests.append(flname)
+            else:
+                ungated_tests.append(flname)
+            continue
+        elif len(regressions) > 0:
+            print('Failed in perf test ' + flname + '. Help message: ' +
+                  '; '.join(regressions))
+            failed_tests.append(flname)
+            continue
+        passed_tests.append(flname)
+    return passed_tests, failed_tests, skipped_tests, ungated_tests
+
+
 def dump_commands_in_shellscript(dir):
     with open(dir + '/dump.sh', 'w') as f:
         f.write(command_executor.commands)
@@ -381,6 +527,24 @@ if __name__ == '__main__':
         '--run_functional_tests',
         action='store_true',
         help='Perform type B tests (functional, random input)')
+    parser.add_argument(
+        '--run_perf_tests',
+        action='store_true',
+        help=
+        'Perform performance tests: run the sub-tests that have a perf_baseline.json and fail on regressions against baselines from a reference run'
+    )
+    parser.add_argument(
+        '--update_perf_baselines',
+        action='store_true',
+        help=
+        'With --run_perf_tests, write the measured values, and the machine and config they were measured on, to perf_baseline.json instead of failing on regressions'
+    )
+    parser.add_argument(
+        '--require_perf_reference',
+        action='store_true',
+        help=
+        'With --run_perf_tests, fail the perf tests whose baseline has no reference run instead of only reporting their numbers'
+    )
     # TODO: if needed we can pass an arg here that indicates the dir where all the test-suites are. Currently its assumed to be `models`
     parser.add_argument(
         '--models',
@@ -438,8 +602,9 @@ if __name__ == '__main__':
         exit(0)
 
     assert (
-        args.run_basic_tests or args.run_functional_tests
-    ), 'No type of test enabled. Please choose --run_basic_tests, --run_functional_tests or both'
+        args.run_basic_tests or args.run_functional_tests or
+        args.run_perf_tests
+    ), 'No type of test enabled. Please choose --run_basic_tests, --run_functional_tests, --run_perf_tests or a combination'
 
     ignore_test = [] if (
         args.ignore_test is None) else args.ignore_test.split(',')
@@ -461,6 +626,7 @@ if __name__ == '__main__':
     passed_tests = {}
     failed_tests = {}
     skipped_tests = {}
+    ungated_tests = {}
     for test_suite in requested_test_suites:
         print('\n' + '=' * 20 + 'Testing model/test-suite: ' + test_suite +
               '=' * 20)
@@ -475,11 +641,28 @@ if __name__ == '__main__':
                 skipped_tests[test_suite] = skipped_tests_in_suite
             if args.run_functional_tests:
                 assert False, 'Functional tests not implemented yet!!'
+            if args.run_perf_tests:
+                passed_perf, failed_perf, skipped_perf, ungated_perf = run_perf_suite(
+                    './models/' + test_suite, args.configuration,
+                    disabled_sub_test.get(test_suite, []),
+                    args.update_perf_baselines, args.require_perf_reference)
+                tag = lambda l: [i + ' (perf)' for i in l]
+                passed_tests[test_suite] = passed_tests.get(
+                    test_suite, []) + tag(passed_perf)
+                failed_tests[test_suite] = failed_tests.get(
+                    test_suite, []) + tag(failed_perf)
+                skipped_tests[test_suite] = skipped_tests.get(
+                    test_suite, []) + tag(skipped_perf)
+                ungated_tests[test_suite] = tag(ungated_perf)
     print_format = lambda d: '\n'.join(
         ['\n\t'.join([k] + d[k]) for k in d if len(d[k]) > 0])
     print('Passed:\n' + '\033[92m' + print_format(passed_tests) + '\033[0m')
     print('Skipped:\n' + '\033[93m' + print_format(skipped_tests) + '\033[0m')
     print('Failed:\n' + '\033[91m' + print_format(failed_tests) + '\033[0m')
+    if any([len(ungated_tests[k]) > 0 for k in ungated_tests]):
+        print('Not gated, no reference baseline (the perf gate is off for ' +
+              'these until one is recorded with --update_perf_baselines):\n' +
+              '\033[93m' + print_format(ungated_tests) + '\033[0m')
     all_tests_passed = all([len(failed_tests[k]) == 0 for k in failed_tests])
     exit(0 if all_tests_passed else 1)
 
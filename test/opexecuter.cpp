@@ -14,7 +14,18 @@
  * limitations under the License.
  *******************************************************************************/
 #include "test/opexecuter.h"
+
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+#include "ngraph_bridge/ngraph_timer.h"
 
 using namespace std;
 namespace ng = ngraph;
@@ -83,6 +94,195 @@ void OpExecuter::RunTest(float rtol, float atol) {
   }
 
   Compare(tf_outputs, ngraph_outputs, rtol, atol);
+
+  if (IsBenchmarking()) {
+    RunBenchmark();
+  }
+}
+
+// One row of the benchmark table
+struct BenchmarkResult {
+  string op;
+  string shapes;
+  double tf_us;
+  double ngraph_us;
+};
+
+static vector<BenchmarkResult> s_benchmark_results;
+
+static double Speedup(const BenchmarkResult& result) {
+  return result.tf_us / std::max(result.ngraph_us, 1.0);
+}
+
+static void ReportBenchmarks() {
+  if (s_benchmark_results.empty()) {
+    return;
+  }
+  size_t op_width = 4, shapes_width = 8;
+  for (const auto& result : s_benchmark_results) {
+    op_width = std::max(op_width, result.op.size() + 2);
+    shapes_width = std::max(shapes_width, result.shapes.size() + 2);
+  }
+
+  std::ostringstream table;
+  table << std::fixed << std::setprecision(1);
+  table << "\nOp benchmark (median time of a run, in us)\n" << std::left
+        << std::setw(op_width) << "op" << std::setw(shapes_width) << "inputs"
+        << std::right << std::setw(12) << "TF" << std::setw(12) << "nGraph"
+        << std::setw(10) << "speedup\n";
+  for (const auto& result : s_benchmark_results) {
+    table << std::left << std::setw(op_width) << result.op
+          << std::setw(shapes_width) << result.shapes << std::right
+          << std::setw(12) << result.tf_us << std::setw(12)
+          << result.ngraph_us << std::setw(9) << std::setprecision(2)
+          << Speedup(result) << std::setprecision(1) << "\n";
+  }
+  std::cout << table.str();
+
+  const char* csv_path = std::getenv("NGRAPH_TF_UTEST_BENCHMARK_FILE");
+  if (csv_path != nullptr) {
+    std::ofstream csv(csv_path);
+    csv << "op,inputs,tf_us,ngraph_us,speedup\n";
+    for (const auto& result : s_benchmark_results) {
+      csv << result.op << ",\"" << result.shapes << "\"," << result.tf_us
+          << "," << result.ngraph_us << "," << Speedup(result) << "\n";
+    }
+  }
+}
+
+static void RecordBenchmark(const BenchmarkResult& result) {
+  static bool report_at_exit = (std::atexit(ReportBenchmarks), true);
+  (void)report_at_exit;
+  s_benchmark_results.push_back(result);
+}
+
+static int BenchmarkIterations() {
+  const char* iterations_env = std::getenv("NGRAPH_TF_UTEST_BENCHMARK");
+  return iterations_env == nullptr ? 0 : std::atoi(iterations_env);
+}
+
+bool OpExecuter::IsBenchmarking() { return BenchmarkIterations() > 0; }
+
+void OpExecuter::RunBenchmark() {
+  vector<int> scales;
+  const char* scales_env = std::getenv("NGRAPH_TF_UTEST_BENCHMARK_SCALES");
+  for (const auto& scale : ng::split(scales_env ? scales_env : "1", ',')) {
+    if (std::atoi(scale.c_str()) > 0) {
+      scales.push_back(std::atoi(scale.c_str()));
+    }
+  }
+
+  GraphDef graph_def;
+  TF_CHECK_OK(tf_scope_.ToGraphDef(&graph_def));
+  for (int scale : scales) {
+    GraphDef scaled_graph_def = graph_def;
+    BenchmarkResult result{test_op_type_, "", 0, 0};
+    Status status = ScaleInputs(scaled_graph_def, scale, result.shapes);
+    if (status.ok()) {
+      status = TimeGraph(scaled_graph_def, false, BenchmarkIterations(),
+                         result.tf_us);
+    }
+    if (status.ok()) {
+      status = TimeGraph(scaled_graph_def, true, BenchmarkIterations(),
+                         result.ngraph_us);
+    }
+    ActivateNGraph();
+    if (!status.ok()) {
+      NGRAPH_VLOG(0) << "Not benchmarking " << test_op_type_ << " at scale "
+                     << scale << ": " << status.error_message();
+      continue;
+    }
+    RecordBenchmark(result);
+  }
+}
+
+Status OpExecuter::ScaleInputs(GraphDef& graph_def, int scale,
+                               string& shapes) {
+  map<string, NodeDef*> nodes;
+  NodeDef* test_op = nullptr;
+  for (auto& node : *graph_def.mutable_node()) {
+    nodes[node.name()] = &node;
+    if (node.op() == test_op_type_) {
+      test_op = &node;
+    }
+  }
+  if (test_op == nullptr) {
+    return errors::NotFound("No ", test_op_type_, " in the graph");
+  }
+
+  vector<string> shape_strings;
+  TensorShape first_shape;
+  for (const string& input : test_op->input()) {
+    if (input.empty() || input[0] == '^') {
+      continue;
+    }
+    NodeDef* node = nodes[input.substr(0, input.find(':'))];
+    if (node == nullptr || node->op() != "Const") {
+      return errors::InvalidArgument("Input ", input, " is not a Const");
+    }
+    Tensor value;
+    if (!value.FromProto(node->attr().at("value").tensor())) {
+      return errors::Internal("Cannot parse the value of ", node->name());
+    }
+    bool is_first = shape_strings.empty();
+    if (is_first) {
+      first_shape = value.shape();
+    }
+
+    // Tile the value along its first dimension
+    bool scalable = value.dims() > 0 && value.shape() == first_shape &&
+                    DataTypeCanUseMemcpy(value.dtype());
+    if (is_first && scale > 1 && !scalable) {
+      return errors::InvalidArgument("Cannot scale ", input);
+    }
+    TensorShape shape = value.shape();
+    if (scale > 1 && scalable) {
+      shape.set_dim(0, shape.dim_size(0) * scale);
+    }
+    // A Const that feeds several inputs reads back scaled the second time,
+    // and so is not scaled again
+    if (shape != value.shape()) {
+      Tensor scaled(value.dtype(), shape);
+      StringPiece data = value.tensor_data();
+      char* scaled_data = const_cast<char*>(scaled.tensor_data().data());
+      for (int i = 0; i < scale; i++) {
+        std::memcpy(scaled_data + i * data.size(), data.data(), data.size());
+      }
+      scaled.AsProtoTensorContent(
+          (*node->mutable_attr())["value"].mutable_tensor());
+    }
+    shape_strings.push_back(shape.DebugString());
+  }
+  shapes = ng::join(shape_strings, " ");
+  return Status::OK();
+}
+
+Status OpExecuter::TimeGraph(const GraphDef& graph_def, bool on_ngraph,
+                             int iterations, double& median_us) {
+  if (on_ngraph) {
+    ActivateNGraph();
+  } else {
+    DeactivateNGraph();
+  }
+  std::unique_ptr<Session> session(NewSession(GetSessionOptions()));
+  TF_RETURN_IF_ERROR(session->Create(graph_def));
+  vector<string> fetch_names;
+  for (const auto& output : sess_run_fetchoutputs_) {
+    fetch_names.push_back(strings::StrCat(output.name(), ":", output.index()));
+  }
+
+  // The first run rewrites (and, on nGraph, compiles) the graph
+  vector<Tensor> outputs;
+  TF_RETURN_IF_ERROR(session->Run({}, fetch_names, {}, &outputs));
+  vector<int64> run_times;
+  for (int i = 0; i < iterations; i++) {
+    Timer run_time;
+    TF_RETURN_IF_ERROR(session->Run({}, fetch_names, {}, &outputs));
+    run_times.push_back(run_time.ElapsedInMicroSec());
+  }
+  std::sort(run_times.begin(), run_times.end());
+  median_us = run_times[run_times.size() / 2];
+  return session->Close();
 }
 
 // Uses tf_scope to execute on TF
@@ -76,16 +76,36 @@ class OpExecuter {
   // Returns outputs
   void ExecuteOnTF(vector<Tensor>& outputs);
 
-  // Executes on NGraph backend, then executes on TF, and compares the results
+  // Executes on NGraph backend, then executes on TF, and compares the results.
+  // In benchmark mode, also runs RunBenchmark().
   void RunTest(float rtol = static_cast<float>(1e-05),
                float atol = static_cast<float>(1e-08));
 
+  // Benchmark mode, turned on by NGRAPH_TF_UTEST_BENCHMARK=<iterations>:
+  // times the graph on TF and on nGraph, for every scale in
+  // NGRAPH_TF_UTEST_BENCHMARK_SCALES (e.g. "1,4,16", default "1"). A scale
+  // multiplies the first dimension of the first input of the test op, and of
+  // the inputs of the same shape; scales the op rejects are skipped.
+  //
+  // The median times and the speedup of nGraph over TF, per op and input
+  // shapes, are printed as a table at exit, and written as CSV to
+  // NGRAPH_TF_UTEST_BENCHMARK_FILE if that is set.
+  static bool IsBenchmarking();
+  void RunBenchmark();
+
  private:
   Scope tf_scope_;
   const string test_op_type_;
   const std::vector<Output> sess_run_fetchoutputs_;
 
   void ValidateGraph(const Graph& graph, const vector<string> allowed_nodes);
+
+  // Makes the inputs of the test op in graph_def scale times as large, and
+  // returns their shapes
+  Status ScaleInputs(GraphDef& graph_def, int scale, string& shapes);
+  // Runs graph_def on TF or on nGraph, and returns the median time of a run
+  Status TimeGraph(const GraphDef& graph_def, bool on_ngraph, int iterations,
+                   double& median_us);
 };
 
 }  // namespace testing
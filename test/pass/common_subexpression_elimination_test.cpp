@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "ngraph/ngraph.hpp"
+#include "ngraph/opsets/opset3.hpp"
+#include "ngraph/pass/manager.hpp"
+
+#include "ngraph_bridge/pass/common_subexpression_elimination.h"
+#include "ngraph_bridge/pass/constant_deduplication.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(CommonSubexpressionElimination, PassProperty) {
+  auto pass = make_shared<pass::CommonSubexpressionElimination>();
+  ASSERT_TRUE(
+      pass->get_property(ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE));
+}
+
+// Three Abs -> Transpose -> ReduceSum -> Reshape chains of X, each with
+// constants of its own, feed a Concat. The first and the last chain are
+// equal once their constants are merged. The middle one shares Abs and
+// Transpose with them, but its ReduceSum drops the reduced axis.
+TEST(CommonSubexpressionElimination, MergeChains) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{2, 3, 4});
+  auto chain = [&X](bool keep_dims) {
+    auto abs = make_shared<ng::opset3::Abs>(X);
+    auto order =
+        ng::opset3::Constant::create(ng::element::i64, {3}, {2, 0, 1});
+    auto transpose = make_shared<ng::opset3::Transpose>(abs, order);
+    auto axes = ng::opset3::Constant::create(ng::element::i64, {1}, {0});
+    auto sum = make_shared<ng::opset3::ReduceSum>(transpose, axes, keep_dims);
+    auto shape = ng::opset3::Constant::create(ng::element::i64, {2}, {2, 3});
+    return make_shared<ng::opset3::Reshape>(sum, shape, false);
+  };
+  auto concat = make_shared<ng::opset3::Concat>(
+      ng::OutputVector{chain(true), chain(false), chain(true)}, 0);
+  auto func = make_shared<ng::Function>(concat, ng::ParameterVector{X});
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::ConstantDeduplication>();
+  pass_manager.register_pass<pass::CommonSubexpressionElimination>();
+  pass_manager.run_passes(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Abs>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Transpose>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::ReduceSum>(func), 2);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Reshape>(func), 2);
+  ASSERT_EQ(concat->get_input_node_ptr(0), concat->get_input_node_ptr(2));
+  ASSERT_NE(concat->get_input_node_ptr(0), concat->get_input_node_ptr(1));
+}
+
+// Parameters are never merged, and neither is what is computed from them
+TEST(CommonSubexpressionElimination, Parameters) {
+  auto X =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{2, 3});
+  auto Y =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{2, 3});
+  auto add = make_shared<ng::opset3::Add>(make_shared<ng::opset3::Relu>(X),
+                                          make_shared<ng::opset3::Relu>(Y));
+  auto func = make_shared<ng::Function>(add, ng::ParameterVector{X, Y});
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::CommonSubexpressionElimination>();
+  pass_manager.run_passes(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Relu>(func), 2);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "ngraph/ngraph.hpp"
+#include "ngraph/opsets/opset3.hpp"
+#include "ngraph/pass/manager.hpp"
+
+#include "ngraph_bridge/pass/constant_deduplication.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(ConstantDeduplication, PassProperty) {
+  auto pass = make_shared<pass::ConstantDeduplication>();
+  ASSERT_TRUE(
+      pass->get_property(ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE));
+}
+
+// Constants are merged if their element type, shape and data are the same
+TEST(ConstantDeduplication, Merge) {
+  auto X =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{2, 3});
+  auto make_add = [](const ng::Output<ng::Node>& arg,
+                     const shared_ptr<ng::Node>& constant) {
+    return make_shared<ng::opset3::Add>(arg, constant);
+  };
+  auto c1 = ng::opset3::Constant::create(ng::element::f32, {3}, {1, 2, 3});
+  auto c2 = ng::opset3::Constant::create(ng::element::f32, {3}, {1, 2, 3});
+  // other data, shape and type
+  auto c3 = ng::opset3::Constant::create(ng::element::f32, {3}, {1, 2, 4});
+  auto c4 = ng::opset3::Constant::create(ng::element::f32, {1, 3}, {1, 2, 3});
+  auto c5 = ng::opset3::Constant::create(ng::element::i32, {3}, {1, 2, 3});
+  auto add1 = make_add(X, c1);
+  auto add2 = make_add(add1, c2);
+  auto add3 = make_add(add2, c3);
+  auto add4 = make_add(add3, c4);
+  auto convert = make_shared<ng::opset3::Convert>(add4, ng::element::i32);
+  auto add5 = make_add(convert, c5);
+  auto func = make_shared<ng::Function>(add5, ng::ParameterVector{X});
+
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Constant>(func), 5);
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::ConstantDeduplication>();
+  pass_manager.run_passes(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Constant>(func), 4);
+  ASSERT_EQ(add1->get_input_node_ptr(1), add2->get_input_node_ptr(1));
+  ASSERT_NE(add1->get_input_node_ptr(1), add3->get_input_node_ptr(1));
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,222 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "ngraph/graph_util.hpp"
+#include "ngraph/ngraph.hpp"
+#include "ngraph/opsets/opset3.hpp"
+#include "ngraph/pass/manager.hpp"
+
+#include "ngraph_bridge/pass/fusions.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+static shared_ptr<ng::opset3::Constant> MakeScalar(float value) {
+  return ng::opset3::Constant::create(ng::element::f32, {}, {value});
+}
+
+// Runs TPass on func and checks that it still computes the same
+template <typename TPass>
+static void RunPassAndCompare(const shared_ptr<ng::Function>& func) {
+  vector<float> input(
+      ng::shape_size(func->get_parameters()[0]->get_shape()));
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = 0.05f * (i % 41) - 1.0f;
+  }
+  auto expected = Run(ng::clone_function(*func), input);
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<TPass>();
+  pass_manager.run_passes(func);
+
+  auto actual = Run(func, input);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); i++) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-4) << "at " << i;
+  }
+}
+
+//   X    Const
+//   |   /
+//   Conv
+//   |  Const
+//   | /
+//   Add
+//   |
+//   BatchNormInference (Consts)
+//   |
+//   Result
+TEST(Fusions, ConvBatchNorm) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{1, 3, 5, 5});
+  auto conv = make_shared<ng::opset3::Convolution>(
+      X, MakeConstant({4, 3, 3, 3}), ng::Strides{1, 1},
+      ng::CoordinateDiff{1, 1}, ng::CoordinateDiff{1, 1}, ng::Strides{1, 1});
+  auto bias = make_shared<ng::opset3::Add>(conv, MakeConstant({1, 4, 1, 1}));
+  auto bn = make_shared<ng::opset3::BatchNormInference>(
+      bias, MakeConstant({4}, 0.5f), MakeConstant({4}), MakeConstant({4}),
+      MakeConstant({4}, 0.2f), 0.001);
+  auto func = make_shared<ng::Function>(bn, ng::ParameterVector{X});
+
+  RunPassAndCompare<pass::ConvBatchNormFusion>(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::BatchNormInference>(func), 0);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Convolution>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Add>(func), 1);
+}
+
+// A convolution whose output is used elsewhere keeps its batch norm
+TEST(Fusions, ConvBatchNormSharedConv) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{1, 3, 5, 5});
+  auto conv = make_shared<ng::opset3::Convolution>(
+      X, MakeConstant({4, 3, 3, 3}), ng::Strides{1, 1},
+      ng::CoordinateDiff{1, 1}, ng::CoordinateDiff{1, 1}, ng::Strides{1, 1});
+  auto bn = make_shared<ng::opset3::BatchNormInference>(
+      conv, MakeConstant({4}, 0.5f), MakeConstant({4}), MakeConstant({4}),
+      MakeConstant({4}, 0.2f), 0.001);
+  auto add = make_shared<ng::opset3::Add>(bn, conv);
+  auto func = make_shared<ng::Function>(add, ng::ParameterVector{X});
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::ConvBatchNormFusion>();
+  pass_manager.run_passes(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::BatchNormInference>(func), 1);
+}
+
+// (x - mean(x)) * rsqrt(mean(square(x - mean(x))) + eps), the way the
+// translation builds it from TF's Mean, Sub, Square, Add and Rsqrt
+static shared_ptr<ng::Function> MakeLayerNorm(float epsilon) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{2, 3, 8});
+  auto axes = ng::opset3::Constant::create(ng::element::i64, {1}, {2});
+  auto mean = make_shared<ng::opset3::ReduceMean>(X, axes, true);
+  auto centered = make_shared<ng::opset3::Subtract>(X, mean);
+  auto square = make_shared<ng::opset3::Multiply>(centered, centered);
+  auto variance = make_shared<ng::opset3::ReduceMean>(square, axes, true);
+  auto rsqrt = make_shared<ng::opset3::Power>(
+      make_shared<ng::opset3::Add>(variance, MakeScalar(epsilon)),
+      ng::opset3::Constant::create(ng::element::f32, {2, 3, 1}, {-0.5f}));
+  auto norm = make_shared<ng::opset3::Multiply>(centered, rsqrt);
+  auto scaled = make_shared<ng::opset3::Multiply>(norm, MakeConstant({8}));
+  return make_shared<ng::Function>(scaled, ng::ParameterVector{X});
+}
+
+// Without an eps the layer norm is MVN
+TEST(Fusions, LayerNorm) {
+  auto func = MakeLayerNorm(0.0f);
+  RunPassAndCompare<pass::LayerNormFusion>(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::MVN>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::ReduceMean>(func), 0);
+}
+
+// MVN adds its eps outside the square root, so a layer norm with an eps is
+// left alone, and computes the same
+TEST(Fusions, LayerNormEpsilon) {
+  auto func = MakeLayerNorm(1e-3f);
+  RunPassAndCompare<pass::LayerNormFusion>(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::MVN>(func), 0);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::ReduceMean>(func), 2);
+}
+
+// Keras' 0.5 * x * (1 + erf(x / sqrt(2)))
+TEST(Fusions, Gelu) {
+  auto X =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{4, 10});
+  auto erf = make_shared<ng::opset3::Erf>(
+      make_shared<ng::opset3::Divide>(X, MakeScalar(1.4142135f)));
+  auto cdf = make_shared<ng::opset3::Add>(MakeScalar(1.0f), erf);
+  auto gelu = make_shared<ng::opset3::Multiply>(
+      make_shared<ng::opset3::Multiply>(MakeScalar(0.5f), X), cdf);
+  auto func = make_shared<ng::Function>(gelu, ng::ParameterVector{X});
+
+  RunPassAndCompare<pass::GeluFusion>(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Gelu>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Erf>(func), 0);
+}
+
+// BERT's x * 0.5 * (1 + erf(x * (1 / sqrt(2)))); a wrong constant is left
+// alone
+TEST(Fusions, GeluBert) {
+  for (float half : {0.5f, 0.6f}) {
+    auto X =
+        make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{4, 10});
+    auto erf = make_shared<ng::opset3::Erf>(
+        make_shared<ng::opset3::Multiply>(X, MakeScalar(0.70710678f)));
+    auto cdf = make_shared<ng::opset3::Multiply>(
+        MakeScalar(half), make_shared<ng::opset3::Add>(erf, MakeScalar(1.0f)));
+    auto gelu = make_shared<ng::opset3::Multiply>(X, cdf);
+    auto func = make_shared<ng::Function>(gelu, ng::ParameterVector{X});
+
+    RunPassAndCompare<pass::GeluFusion>(func);
+    ASSERT_EQ(count_ops_of_type<ng::opset3::Gelu>(func), half == 0.5f ? 1 : 0);
+  }
+}
+
+// exp(x - max(x)) / sum(exp(x - max(x))) over the last axis
+TEST(Fusions, Softmax) {
+  auto X =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{3, 7});
+  auto axes = ng::opset3::Constant::create(ng::element::i64, {1}, {1});
+  auto max = make_shared<ng::opset3::ReduceMax>(X, axes, true);
+  auto exp = make_shared<ng::opset3::Exp>(
+      make_shared<ng::opset3::Subtract>(X, max));
+  auto sum = make_shared<ng::opset3::ReduceSum>(exp, axes, true);
+  auto softmax = make_shared<ng::opset3::Divide>(exp, sum);
+  auto func = make_shared<ng::Function>(softmax, ng::ParameterVector{X});
+
+  RunPassAndCompare<pass::SoftmaxFusion>(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Softmax>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Exp>(func), 0);
+  // the max is taken off too
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Subtract>(func), 0);
+}
+
+// Xdivy by a constant with no zeros is a plain division; by a parameter it
+// is left alone
+TEST(Fusions, Xdivy) {
+  auto X =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{2, 5});
+  auto xdivy = [&X](const ng::Output<ng::Node>& y) {
+    auto is_zero = make_shared<ng::opset3::Equal>(X, MakeScalar(0.0f));
+    return make_shared<ng::opset3::Select>(
+        is_zero, X, make_shared<ng::opset3::Divide>(X, y));
+  };
+  auto func = make_shared<ng::Function>(xdivy(MakeConstant({5}, 0.05f)),
+                                        ng::ParameterVector{X});
+  RunPassAndCompare<pass::XdivyFusion>(func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Select>(func), 0);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Divide>(func), 1);
+
+  auto func2 = make_shared<ng::Function>(
+      xdivy(make_shared<ng::opset3::Abs>(X)), ng::ParameterVector{X});
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::XdivyFusion>();
+  pass_manager.run_passes(func2);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Select>(func2), 1);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
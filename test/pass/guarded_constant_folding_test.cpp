@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "ngraph/graph_util.hpp"
+#include "ngraph/ngraph.hpp"
+#include "ngraph/opsets/opset3.hpp"
+
+#include "ngraph_bridge/pass/guarded_constant_folding.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(GuardedConstantFolding, PassProperty) {
+  auto pass = make_shared<pass::GuardedConstantFolding>();
+  ASSERT_TRUE(
+      pass->get_property(ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE));
+}
+
+//   Const   Order        X
+//     |    /             |
+//   Transpose         ShapeOf   Const
+//     |                  |     /
+//     |    X          Multiply
+//     |   /              |
+//     Add -----------  Reshape
+//
+// The transpose of the constant and the shape arithmetic are folded
+TEST(GuardedConstantFolding, Fold) {
+  auto X =
+      make_shared<ng::opset3::Parameter>(ng::element::f32, ng::Shape{2, 3});
+  auto order = ng::opset3::Constant::create(ng::element::i64, {2}, {1, 0});
+  auto transpose =
+      make_shared<ng::opset3::Transpose>(MakeConstant({3, 2}), order);
+  auto add = make_shared<ng::opset3::Add>(X, transpose);
+  auto shape = make_shared<ng::opset3::Multiply>(
+      make_shared<ng::opset3::ShapeOf>(X),
+      ng::opset3::Constant::create(ng::element::i64, {1}, {1}));
+  auto reshape = make_shared<ng::opset3::Reshape>(add, shape, false);
+  auto func = make_shared<ng::Function>(reshape, ng::ParameterVector{X});
+
+  vector<float> input(6);
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = 0.5f * i;
+  }
+  auto expected = Run(ng::clone_function(*func), input);
+
+  pass::GuardedConstantFolding folding(64 << 20, 4.0);
+  ASSERT_TRUE(folding.run_on_function(func));
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Transpose>(func), 0);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::ShapeOf>(func), 0);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Multiply>(func), 0);
+  ASSERT_EQ(folding.get_stats().folded_nodes, 3);
+  // the transposed constant, the shape, and the shape times one
+  ASSERT_EQ(folding.get_stats().folded_bytes, 6 * 4 + 2 * 8 + 2 * 8);
+  ASSERT_EQ(folding.get_stats().skipped_nodes, 0);
+
+  auto actual = Run(func, input);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); i++) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-6) << "at " << i;
+  }
+}
+
+// A broadcast of a scalar is left alone, and so is what is computed from it.
+// So is a transpose of a constant larger than the limit.
+TEST(GuardedConstantFolding, Guard) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{64, 64});
+  auto target_shape =
+      ng::opset3::Constant::create(ng::element::i64, {2}, {64, 64});
+  auto broadcast =
+      make_shared<ng::opset3::Broadcast>(MakeConstant({}), target_shape);
+  auto relu = make_shared<ng::opset3::Relu>(broadcast);
+  auto order = ng::opset3::Constant::create(ng::element::i64, {2}, {1, 0});
+  auto transpose =
+      make_shared<ng::opset3::Transpose>(MakeConstant({64, 64}), order);
+  auto add = make_shared<ng::opset3::Add>(
+      make_shared<ng::opset3::Add>(X, relu), transpose);
+  auto func = make_shared<ng::Function>(add, ng::ParameterVector{X});
+
+  pass::GuardedConstantFolding folding(8192, 4.0);
+  ASSERT_FALSE(folding.run_on_function(func));
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Broadcast>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Relu>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Transpose>(func), 1);
+  ASSERT_EQ(folding.get_stats().skipped_nodes, 2);
+
+  // Without the limit the transpose is folded, but not the broadcast
+  pass::GuardedConstantFolding folding2(64 << 20, 4.0);
+  ASSERT_TRUE(folding2.run_on_function(func));
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Broadcast>(func), 1);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Transpose>(func), 0);
+  ASSERT_EQ(folding2.get_stats().folded_nodes, 1);
+  ASSERT_EQ(folding2.get_stats().skipped_nodes, 1);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "ngraph/graph_util.hpp"
+#include "ngraph/ngraph.hpp"
+#include "ngraph/opsets/opset3.hpp"
+#include "ngraph/pass/manager.hpp"
+
+#include "ngraph_bridge/pass/layout_assignment.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+TEST(LayoutAssignment, PassProperty) {
+  auto pass = make_shared<pass::LayoutAssignment>();
+  ASSERT_TRUE(
+      pass->get_property(ngraph::pass::PassProperty::REQUIRE_STATIC_SHAPE));
+}
+
+//            X (NHWC)
+//            |
+//          Conv  (Transposes around it, and on its filter)
+//            |   Const (C)
+//            |  /
+//           Add
+//            |
+//          Relu      Const (NHWC)
+//            |      /
+//          Concat (C)
+//            |
+//           Pad
+//            |
+//          Conv
+//            |
+//         ReduceMean (H, W)
+//            |
+//          Result
+//
+// Everything after the first transpose of X runs in NCHW, the constants
+// included. The mean over H and W leaves NC, which is the same in both
+// layouts, so the transpose of X is the only one left.
+TEST(LayoutAssignment, ConvChain) {
+  ng::Shape input_shape{2, 5, 5, 3};
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32, input_shape);
+  auto conv1 = MakeConv(MakeTranspose(X, {0, 3, 1, 2}), 3, 4, 3, true);
+  auto add = make_shared<ng::opset3::Add>(conv1, MakeConstant({4}));
+  auto relu = make_shared<ng::opset3::Relu>(add);
+  auto concat = make_shared<ng::opset3::Concat>(
+      ng::OutputVector{relu, MakeConstant({2, 5, 5, 2})}, 3);
+  auto pads_begin = ng::opset3::Constant::create(ng::element::i64, {4},
+                                                 {0, 1, 0, 0});
+  auto pads_end = ng::opset3::Constant::create(ng::element::i64, {4},
+                                               {0, 0, 1, 0});
+  auto pad = make_shared<ng::opset3::Pad>(concat, pads_begin, pads_end,
+                                          ng::op::PadMode::EDGE);
+  auto conv2 = MakeConv(MakeTranspose(pad, {0, 3, 1, 2}), 6, 4, 3, true);
+  auto axes = ng::opset3::Constant::create(ng::element::i64, {2}, {1, 2});
+  auto mean = make_shared<ng::opset3::ReduceMean>(conv2, axes, false);
+  auto func = make_shared<ng::Function>(mean, ng::ParameterVector{X});
+
+  vector<float> input(ng::shape_size(input_shape));
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = 0.01f * i;
+  }
+  auto expected = Run(ng::clone_function(*func), input);
+
+  ASSERT_EQ(ng::count_ops_of_type<ng::opset3::Transpose>(func), 6);
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::LayoutAssignment>();
+  pass_manager.run_passes(func);
+  ASSERT_EQ(ng::count_ops_of_type<ng::opset3::Transpose>(func), 1);
+  ASSERT_EQ(func->get_output_shape(0), (ng::Shape{2, 4}));
+
+  // The filters are transposed on the data
+  for (const auto& node : func->get_ordered_ops()) {
+    if (auto conv = ng::as_type_ptr<ng::opset3::Convolution>(node)) {
+      ASSERT_TRUE(ng::is_type<ng::opset3::Constant>(
+          conv->get_input_node_ptr(1)));
+      ASSERT_EQ(conv->get_input_shape(1)[2], 3);
+    }
+  }
+
+  auto actual = Run(func, input);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); i++) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-4) << "at " << i;
+  }
+}
+
+// A value that an op needs in its own layout is transposed back once,
+// however many ops need it
+TEST(LayoutAssignment, MaterializeOnce) {
+  ng::Shape input_shape{1, 4, 4, 2};
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32, input_shape);
+  auto conv = MakeConv(MakeTranspose(X, {0, 3, 1, 2}), 2, 2, 3, true);
+  auto relu = make_shared<ng::opset3::Relu>(conv);
+  auto shape = ng::opset3::Constant::create(ng::element::i64, {2}, {1, 32});
+  auto reshape1 = make_shared<ng::opset3::Reshape>(relu, shape, false);
+  auto reshape2 = make_shared<ng::opset3::Reshape>(relu, shape, false);
+  auto add = make_shared<ng::opset3::Add>(reshape1, reshape2);
+  auto func = make_shared<ng::Function>(add, ng::ParameterVector{X});
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::LayoutAssignment>();
+  pass_manager.run_passes(func);
+  // One at X, one shared by the reshapes
+  ASSERT_EQ(ng::count_ops_of_type<ng::opset3::Transpose>(func), 2);
+  ASSERT_EQ(reshape1->get_input_node_ptr(0), reshape2->get_input_node_ptr(0));
+  ASSERT_EQ(reshape1->get_input_shape(0), (ng::Shape{1, 4, 4, 2}));
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
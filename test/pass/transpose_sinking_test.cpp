@@ -22,6 +22,7 @@
 
 #include "gtest/gtest.h"
 
+#include "ngraph/graph_util.hpp"
 #include "ngraph/ngraph.hpp"
 #include "ngraph/opsets/opset3.hpp"
 #include "ngraph/pass/manager.hpp"
@@ -51,8 +52,8 @@ TEST(TransposeSinking, PassProperty) {
 }
 
 TEST(TransposeSinking, EdgeSplitting) {
-  // checks if Transpose is pushed through ng::opset3::Abs, but stopped by
-  // ReduceSum
+  // checks if Transpose is pushed through ng::opset3::Abs and
+  // ng::opset3::ReduceSum, and put back before each result
   ng::Shape shape_nhwc{16, 28, 28, 1};
   ng::Shape shape_nchw{16, 1, 28, 28};
 
@@ -72,7 +73,12 @@ TEST(TransposeSinking, EdgeSplitting) {
   ng::pass::Manager pass_manager;
   pass_manager.register_pass<pass::TransposeSinking>();
   pass_manager.run_passes(func);
-  ASSERT_EQ(func->get_results().at(1)->get_argument(0), sum);
+  auto sum_transpose = ng::as_type_ptr<ng::opset3::Transpose>(
+      func->get_results().at(1)->get_argument(0));
+  ASSERT_TRUE(sum_transpose);
+  ASSERT_TRUE(ng::is_type<ng::opset3::ReduceSum>(
+      sum_transpose->get_input_node_ptr(0)));
+  ASSERT_EQ(sum_transpose->get_output_shape(0), (ng::Shape{1, 1, 1, 1}));
   auto new_transpose = ng::as_type_ptr<ng::opset3::Transpose>(
       func->get_results().at(0)->get_argument(0));
   ASSERT_TRUE(new_transpose);
@@ -285,7 +291,7 @@ TEST(TransposeSinking, Concat_DummyShape) {
   ASSERT_EQ(result->get_output_shape(0), expected_shape);
 }
 
-// The Transpose should sink through Pad op but stopped by ReduceSum
+// The Transpose should sink through Pad and ReduceSum ops
 TEST(TransposeSinking, Pad) {
   ng::Shape shape_nhwc{100, 8, 8, 1};
 
@@ -333,9 +339,10 @@ TEST(TransposeSinking, Pad) {
   auto result = f->get_results().at(0)->get_argument(0);
   ng::Shape expected_shape{1, 1, 1, 1};
   ASSERT_EQ(result->get_output_shape(0), expected_shape);
-  auto out = ng::as_type_ptr<ng::opset3::ReduceSum>(
+  auto out = ng::as_type_ptr<ng::opset3::Transpose>(
       f->get_results().at(0)->get_argument(0));
   ASSERT_TRUE(out);
+  ASSERT_TRUE(ng::is_type<ng::opset3::ReduceSum>(out->get_input_node_ptr(0)));
 }
 
 TEST(TransposeSinking, SimpleUnary) {
@@ -367,6 +374,194 @@ TEST(TransposeSinking, SimpleUnary) {
   EXPECT_EQ(after_count, 0);
 }
 
+// Runs TransposeSinking on func, checks that it leaves fewer transposes and
+// computes the same, and prints the transpose counts and run times
+static void CheckAndBenchmark(const string& name,
+                              const shared_ptr<ng::Function>& func) {
+  auto input_shape = func->get_parameters()[0]->get_shape();
+  vector<float> input(ng::shape_size(input_shape));
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = 0.01f * (i % 97) - 0.4f;
+  }
+  int before_us = 0;
+  auto expected = RunAndTime(ng::clone_function(*func), input, before_us);
+  size_t before_count = count_ops_of_type<ng::opset3::Transpose>(func);
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::TransposeSinking>();
+  pass_manager.run_passes(func);
+  size_t after_count = count_ops_of_type<ng::opset3::Transpose>(func);
+  int after_us = 0;
+  auto actual = RunAndTime(func, input, after_us);
+
+  cout << name << ": transposes " << before_count << " -> " << after_count
+       << ", " << before_us << " us -> " << after_us << " us per run" << endl;
+  ASSERT_LT(after_count, before_count);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); i++) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-4) << "at " << i;
+  }
+}
+
+//            X (NHWC) ----+
+//            |            |
+//          Conv           |   (Transposes around it)
+//            |            |
+//      Multiply, Add      |   (BatchNorm, constants in C)
+//            |            |
+//          Relu           |
+//            |            |
+//          Conv           |
+//            |            |
+//           Add ----------+
+//            |
+//           Pad
+//            |
+//       StridedSlice
+//            |
+//        ReduceMean (H, W)
+//            |
+//          Result
+//
+// Only the transposes of X into NCHW are left
+TEST(TransposeSinking, ResNetBlock) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{1, 8, 8, 4});
+  auto conv1 = MakeConv(MakeTranspose(X, {0, 3, 1, 2}), 4, 4, 3);
+  auto scale = make_shared<ng::opset3::Multiply>(conv1, MakeConstant({4}));
+  auto shift = make_shared<ng::opset3::Add>(scale, MakeConstant({4}));
+  auto relu = make_shared<ng::opset3::Relu>(shift);
+  auto conv2 = MakeConv(MakeTranspose(relu, {0, 3, 1, 2}), 4, 4, 3);
+  auto residual = make_shared<ng::opset3::Add>(conv2, X);
+  auto pads = ng::opset3::Constant::create(ng::element::i64, {4},
+                                           {0, 1, 1, 0});
+  auto pad_value = ng::opset3::Constant::create(ng::element::f32, {}, {0});
+  auto pad = make_shared<ng::opset3::Pad>(residual, pads, pads, pad_value,
+                                          ng::op::PadMode::REFLECT);
+  auto begin = ng::opset3::Constant::create(ng::element::i64, {3},
+                                            {0, 1, 1});
+  auto end = ng::opset3::Constant::create(ng::element::i64, {3},
+                                          {0, 9, 9});
+  auto strides = ng::opset3::Constant::create(ng::element::i64, {3},
+                                              {1, 1, 1});
+  auto slice = make_shared<ng::opset3::StridedSlice>(
+      pad, begin, end, strides, vector<int64_t>{1, 0, 0},
+      vector<int64_t>{1, 0, 0});
+  auto axes = ng::opset3::Constant::create(ng::element::i64, {2}, {1, 2});
+  auto mean = make_shared<ng::opset3::ReduceMean>(slice, axes, false);
+  auto func = make_shared<ng::Function>(mean, ng::ParameterVector{X});
+
+  CheckAndBenchmark("ResNetBlock", func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Transpose>(func), 2);
+  ASSERT_EQ(func->get_output_shape(0), (ng::Shape{1, 4}));
+}
+
+//                  X (NHWC)
+//                  |
+//     +------------+------------+
+//     |            |            |
+//  Conv 1x1     Conv 3x3     MaxPool    Const (NHWC)
+//     |            |            |         |
+//     +------------+------------+---------+
+//                  |
+//                Concat (C)
+//                  |   Const (C)
+//                 Add
+//                  |
+//                Split (C)
+//                 | |
+//              Relu |
+//                 | |
+//                 Add
+//                  |
+//           ReduceMean (H, W)
+//                  |
+//                Result
+//
+// The three branches share one transpose of X, and the other one is put
+// back before the result
+TEST(TransposeSinking, InceptionBlock) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{1, 6, 6, 4});
+  auto X_nchw = MakeTranspose(X, {0, 3, 1, 2});
+  auto branch1 = MakeConv(X_nchw, 4, 2, 1);
+  auto branch2 = MakeConv(X_nchw, 4, 3, 3);
+  auto branch3 = MakeTranspose(
+      make_shared<ng::opset3::MaxPool>(
+          X_nchw, ng::Strides{1, 1}, ng::Shape{1, 1}, ng::Shape{1, 1},
+          ng::Shape{3, 3}, ng::op::RoundingType::FLOOR,
+          ng::op::PadType::EXPLICIT),
+      {0, 2, 3, 1});
+  auto concat = make_shared<ng::opset3::Concat>(
+      ng::OutputVector{branch1, branch2, branch3, MakeConstant({1, 6, 6, 1})},
+      3);
+  auto bias = make_shared<ng::opset3::Add>(concat, MakeConstant({10}));
+  auto axis = ng::opset3::Constant::create(ng::element::i64, {}, {3});
+  auto split = make_shared<ng::opset3::Split>(bias, axis, 2);
+  auto relu = make_shared<ng::opset3::Relu>(split->output(0));
+  auto add = make_shared<ng::opset3::Add>(relu, split->output(1));
+  auto axes = ng::opset3::Constant::create(ng::element::i64, {2}, {1, 2});
+  auto mean = make_shared<ng::opset3::ReduceMean>(add, axes, true);
+  auto func = make_shared<ng::Function>(mean, ng::ParameterVector{X});
+
+  CheckAndBenchmark("InceptionBlock", func);
+  ASSERT_EQ(count_ops_of_type<ng::opset3::Transpose>(func), 2);
+  ASSERT_EQ(func->get_output_shape(0), (ng::Shape{1, 1, 1, 5}));
+}
+
+//                  X (NHWC)
+//                  |
+//               Conv 1x1
+//                  |
+//          VariadicSplit (C, 1/2/3)
+//           |      |      |
+//         Relu     |     Conv
+//           |      |      |
+//        Result  Result  Result
+//
+// The pending transpose of each split output is put back on that output,
+// not on the first one, whether a result or a convolution takes it
+TEST(TransposeSinking, SplitOutputs) {
+  auto X = make_shared<ng::opset3::Parameter>(ng::element::f32,
+                                              ng::Shape{1, 4, 4, 6});
+  auto conv1 = MakeConv(MakeTranspose(X, {0, 3, 1, 2}), 6, 6, 1);
+  auto axis = ng::opset3::Constant::create(ng::element::i64, {}, {3});
+  auto lengths = ng::opset3::Constant::create(ng::element::i64, {3},
+                                              {1, 2, 3});
+  auto split = make_shared<ng::opset3::VariadicSplit>(conv1, axis, lengths);
+  auto relu = make_shared<ng::opset3::Relu>(split->output(0));
+  // the NHWC slice taken as NCHW, with C = 4
+  auto conv2 = make_shared<ng::opset3::Convolution>(
+      split->output(2), MakeConstant({2, 4, 1, 1}), ng::Strides{1, 1},
+      ng::CoordinateDiff{0, 0}, ng::CoordinateDiff{0, 0}, ng::Strides{1, 1});
+  auto func = make_shared<ng::Function>(
+      ng::OutputVector{relu, split->output(1), conv2},
+      ng::ParameterVector{X});
+
+  vector<float> input(ng::shape_size(X->get_shape()));
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = 0.01f * (i % 97) - 0.4f;
+  }
+  auto expected = RunOutputs(ng::clone_function(*func), input);
+
+  ng::pass::Manager pass_manager;
+  pass_manager.register_pass<pass::TransposeSinking>();
+  pass_manager.run_passes(func);
+
+  ASSERT_EQ(func->get_output_shape(0), (ng::Shape{1, 4, 4, 1}));
+  ASSERT_EQ(func->get_output_shape(1), (ng::Shape{1, 4, 4, 2}));
+  ASSERT_EQ(func->get_output_shape(2), (ng::Shape{1, 2, 4, 3}));
+  auto actual = RunOutputs(func, input);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t k = 0; k < actual.size(); k++) {
+    ASSERT_EQ(actual[k].size(), expected[k].size()) << "output " << k;
+    for (size_t i = 0; i < actual[k].size(); i++) {
+      ASSERT_NEAR(actual[k][i], expected[k][i], 1e-4)
+          << "output " << k << " at " << i;
+    }
+  }
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
\ No newline at end of file
@@ -824,6 +824,29 @@ TEST(ArrayOps, SplitVPositiveSizeSplits) {
   }
 }  // end of op SplitVPositiveSizeSplits
 
+// Test SplitV op with the -1 as its first size split
+TEST(ArrayOps, SplitVNegSizeSplitFirst) {
+  std::vector<int64> size_splits = {-1, 2, 1};
+  int64_t num_splits = 3;
+
+  Tensor axis(DT_INT32, TensorShape({}));
+  AssignInputValues<int>(axis, 2);
+
+  Scope root = Scope::NewRootScope();
+
+  Tensor input_data(DT_FLOAT, TensorShape({1, 2, 6, 1}));
+  AssignInputValuesRandom<float>(input_data, -10.0f, 10.0f);
+  Tensor size_tensor(DT_INT64, TensorShape({3}));
+  AssignInputValues(size_tensor, size_splits);
+
+  auto R = ops::SplitV(root, input_data, size_tensor, axis, num_splits);
+
+  std::vector<Output> sess_run_fetchoutputs = {R[0], R[1], R[2]};
+  OpExecuter opexecuter(root, "SplitV", sess_run_fetchoutputs);
+
+  opexecuter.RunTest();
+}  // end of op SplitVNegSizeSplitFirst
+
 // Test SplitVZeroSizeSplit op
 // fails with opset3 upgrade on CPU/Interpreter
 TEST(ArrayOps, DISABLED_SplitVZeroSizeSplit) {
@@ -984,6 +1007,44 @@ TEST(ArrayOps, Unpack) {
   }  // end of for loop
 }  // end of testing Unpack
 
+// Unpacks the last dimension, given as a negative axis
+TEST(ArrayOps, UnpackNegativeAxis) {
+  Scope root = Scope::NewRootScope();
+
+  Tensor input_data(DT_FLOAT, TensorShape({2, 3, 4}));
+  AssignInputValuesRandom<float>(input_data, -20, 50);
+
+  auto R = ops::Unstack(root, input_data, 4, ops::Unstack::Axis(-1));
+
+  std::vector<Output> sess_run_fetchoutputs = {R[0], R[1], R[2], R[3]};
+  OpExecuter opexecuter(root, "Unpack", sess_run_fetchoutputs);
+
+  opexecuter.RunTest();
+}  // end of testing UnpackNegativeAxis
+
+// Packs rank R tensors into a rank (R+1) tensor along the given dimension
+TEST(ArrayOps, Pack) {
+  std::vector<int64> axes({0, 1, 2, -1, -3});
+
+  for (auto axis : axes) {
+    Scope root = Scope::NewRootScope();
+
+    Tensor A(DT_FLOAT, TensorShape({2, 4}));
+    Tensor B(DT_FLOAT, TensorShape({2, 4}));
+    Tensor C(DT_FLOAT, TensorShape({2, 4}));
+    AssignInputValuesRandom<float>(A, -20, 50);
+    AssignInputValuesRandom<float>(B, -20, 50);
+    AssignInputValuesRandom<float>(C, -20, 50);
+
+    auto R = ops::Stack(root, {A, B, C}, ops::Stack::Axis(axis));
+
+    std::vector<Output> sess_run_fetchoutputs = {R};
+    OpExecuter opexecuter(root, "Pack", sess_run_fetchoutputs);
+
+    opexecuter.RunTest();
+  }
+}  // end of testing Pack
+
 // Test op: ZerosLike
 // Returns a tensor of zeros of the same shape and type as the input tensor
 TEST(ArrayOps, ZerosLike) {
@@ -0,0 +1,192 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/cc/ops/functional_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/tensor.h"
+
+#include "test/opexecuter.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+
+namespace ngraph_bridge {
+
+namespace testing {
+
+// Test(TestCaseName, TestName)
+// Please ensure
+// Neither TestCaseName nor TestName should contain underscore
+// https://github.com/google/googletest/blob/master/googletest/docs/primer.md
+// Use only Tensors and ops::Const() to provide input to the test op
+// Please ensure the alphabetical order while adding the test functions
+
+using FDH = FunctionDefHelper;
+
+// Branches of an If on x and y: x + y, and x * y
+static FunctionDefLibrary IfBranches() {
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = FDH::Create(
+      "then_branch", {"x: float", "y: float"}, {"z: float"}, {},
+      {{{"add"}, "Add", {"x", "y"}, {{"T", DT_FLOAT}}}}, {{"z", "add:z:0"}});
+  *fdef_lib.add_function() = FDH::Create(
+      "else_branch", {"x: float", "y: float"}, {"z: float"}, {},
+      {{{"mul"}, "Mul", {"x", "y"}, {{"T", DT_FLOAT}}}}, {{"z", "mul:z:0"}});
+  return fdef_lib;
+}
+
+// Runs an If, or a StatelessIf, with the given predicate
+static void RunIf(const string& op_type, bool predicate) {
+  Scope root = Scope::NewRootScope();
+  ASSERT_OK(root.graph()->AddFunctionLibrary(IfBranches()));
+
+  Tensor cond(DT_BOOL, TensorShape({}));
+  cond.scalar<bool>()() = predicate;
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  Tensor y(DT_FLOAT, TensorShape({2, 3}));
+  AssignInputValuesRandom<float>(x, -10.0f, 10.0f);
+  AssignInputValuesRandom<float>(y, -10.0f, 10.0f);
+
+  NameAttrList then_branch, else_branch;
+  then_branch.set_name("then_branch");
+  else_branch.set_name("else_branch");
+  OutputList outputs;
+  if (op_type == "If") {
+    outputs = ops::If(root, cond, {x, y}, {DT_FLOAT}, then_branch, else_branch)
+                  .output;
+  } else {
+    outputs = ops::StatelessIf(root, cond, {x, y}, {DT_FLOAT}, then_branch,
+                               else_branch)
+                  .output;
+  }
+
+  std::vector<Output> sess_run_fetchoutputs = {outputs[0]};
+  OpExecuter opexecuter(root, op_type, sess_run_fetchoutputs);
+  opexecuter.RunTest();
+}
+
+// A loop body that applies step_op with step to the counter i, passes n
+// through, and adds 0.5 to x
+static FunctionDef WhileBody(const string& step_op, int32 step) {
+  return FDH::Create(
+      "body", {"i: int32", "n: int32", "x: float"},
+      {"i_out: int32", "n_out: int32", "x_out: float"}, {},
+      {FDH::Const("step", step),
+       {{"next_i"}, step_op, {"i", "step:output:0"}, {{"T", DT_INT32}}},
+       FDH::Const("half", 0.5f),
+       {{"next_x"}, "Add", {"x", "half:output:0"}, {{"T", DT_FLOAT}}}},
+      {{"i_out", "next_i:z:0"}, {"n_out", "n"}, {"x_out", "next_x:z:0"}});
+}
+
+// A loop condition that compares lhs with rhs, each of which is i, n, or
+// limit:output:0 for a constant of 5
+static FunctionDef WhileCond(const string& compare_op, const string& lhs,
+                             const string& rhs) {
+  return FDH::Create(
+      "cond", {"i: int32", "n: int32", "x: float"}, {"p: bool"}, {},
+      {FDH::Const("limit", 5),
+       {{"compare"}, compare_op, {lhs, rhs}, {{"T", DT_INT32}}}},
+      {{"p", "compare:z:0"}});
+}
+
+// Runs a While, or a StatelessWhile, over the counter i (starting at init),
+// the limit n and the value x
+static void RunWhile(const string& op_type, const FunctionDef& cond,
+                     const FunctionDef& body, int32 init, int32 n) {
+  Scope root = Scope::NewRootScope();
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = cond;
+  *fdef_lib.add_function() = body;
+  ASSERT_OK(root.graph()->AddFunctionLibrary(fdef_lib));
+
+  Tensor i(DT_INT32, TensorShape({}));
+  i.scalar<int32>()() = init;
+  Tensor limit(DT_INT32, TensorShape({}));
+  limit.scalar<int32>()() = n;
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  AssignInputValuesRandom<float>(x, -10.0f, 10.0f);
+
+  NameAttrList cond_func, body_func;
+  cond_func.set_name("cond");
+  body_func.set_name("body");
+  OutputList outputs;
+  if (op_type == "While") {
+    outputs = ops::While(root, {i, limit, x}, cond_func, body_func).output;
+  } else {
+    outputs =
+        ops::StatelessWhile(root, {i, limit, x}, cond_func, body_func).output;
+  }
+
+  std::vector<Output> sess_run_fetchoutputs = {outputs[0], outputs[2]};
+  OpExecuter opexecuter(root, op_type, sess_run_fetchoutputs);
+  opexecuter.RunTest();
+}
+
+TEST(ControlFlowOps, IfFalse) { RunIf("If", false); }
+
+TEST(ControlFlowOps, IfTrue) { RunIf("If", true); }
+
+TEST(ControlFlowOps, StatelessIfFalse) { RunIf("StatelessIf", false); }
+
+TEST(ControlFlowOps, StatelessIfTrue) { RunIf("StatelessIf", true); }
+
+// 5 > i, with the counter on the right hand side
+TEST(ControlFlowOps, StatelessWhileCounterOnRight) {
+  RunWhile("StatelessWhile", WhileCond("Greater", "limit:output:0", "i"),
+           WhileBody("Add", 1), 0, 0);
+}
+
+// i < n, with the limit passed as a loop variable
+TEST(ControlFlowOps, StatelessWhileLimitVariable) {
+  RunWhile("StatelessWhile", WhileCond("Less", "i", "n"), WhileBody("Add", 1),
+           1, 7);
+}
+
+// i < 5
+TEST(ControlFlowOps, WhileLess) {
+  RunWhile("While", WhileCond("Less", "i", "limit:output:0"),
+           WhileBody("Add", 1), 0, 0);
+}
+
+// i <= 5, with i += 2
+TEST(ControlFlowOps, WhileLessEqual) {
+  RunWhile("While", WhileCond("LessEqual", "i", "limit:output:0"),
+           WhileBody("AddV2", 2), 1, 0);
+}
+
+// i > 5, with i -= 3
+TEST(ControlFlowOps, WhileSub) {
+  RunWhile("While", WhileCond("Greater", "i", "limit:output:0"),
+           WhileBody("Sub", 3), 17, 0);
+}
+
+// i < 5, with i starting at 8: the body never runs
+TEST(ControlFlowOps, WhileZeroTripCount) {
+  RunWhile("While", WhileCond("Less", "i", "limit:output:0"),
+           WhileBody("Add", 1), 8, 0);
+}
+
+}  // namespace testing
+
+}  // namespace ngraph_bridge
+
+}  // namespace tensorflow
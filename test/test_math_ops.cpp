@@ -812,6 +812,24 @@ TEST(MathOps, Exp2D) {
   opexecuter.RunTest();
 }  // end of test op Exp
 
+// Test op: Erf
+TEST(MathOps, Erf) {
+  Scope root = Scope::NewRootScope();
+  int dim1 = 2;
+  int dim2 = 3;
+
+  Tensor A(DT_FLOAT, TensorShape({dim1, dim2}));
+
+  AssignInputValues<float>(A, {-2.0f, -0.5f, 0.0f, 0.3f, 1.0f, 3.0f});
+
+  auto R = ops::Erf(root, A);
+
+  std::vector<Output> sess_run_fetchoutputs = {R};
+  OpExecuter opexecuter(root, "Erf", sess_run_fetchoutputs);
+
+  opexecuter.RunTest();
+}  // end of test op Erf
+
 // Test op: FloorDiv
 TEST(MathOps, FloorDiv) {
   Scope root = Scope::NewRootScope();
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/io/path.h"
+
+#include "ngraph_bridge/ngraph_capture.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// A capture holds the cluster graph and the inputs of the first calls, and
+// reads back as written
+TEST(ClusterCapture, WritesAndReadsBack) {
+  auto env_map = StoreEnv({"NGRAPH_TF_CAPTURE_CLUSTERS",
+                           "NGRAPH_TF_CAPTURE_STEPS", "NGRAPH_TF_CAPTURE_DIR"});
+  SetEnvVariable("NGRAPH_TF_CAPTURE_CLUSTERS", "3,7");
+  SetEnvVariable("NGRAPH_TF_CAPTURE_STEPS", "2");
+  SetEnvVariable("NGRAPH_TF_CAPTURE_DIR", ::testing::TempDir());
+
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto shape = ops::Placeholder(root.WithOpName("shape"), DT_INT32);
+  ops::Reshape(root.WithOpName("reshape"), x, shape);
+  Graph graph(OpRegistry::Global());
+  ASSERT_OK(root.ToGraph(&graph));
+
+  unique_ptr<ClusterCapture> capture;
+  ASSERT_OK(ClusterCapture::Create("ngraph_cluster_5", 5, 1, 0, graph,
+                                   {false, true}, &capture));
+  ASSERT_EQ(capture, nullptr);
+  ASSERT_OK(ClusterCapture::Create("ngraph_cluster_7", 7, 1, 0, graph,
+                                   {false, true}, &capture));
+  ASSERT_NE(capture, nullptr);
+
+  vector<vector<Tensor>> steps;
+  for (int i = 0; i < 3; i++) {
+    Tensor x_value(DT_FLOAT, TensorShape({2, 2}));
+    x_value.flat<float>().setConstant(i);
+    Tensor shape_value(DT_INT32, TensorShape({1}));
+    shape_value.flat<int32>()(0) = 4;
+    steps.push_back({x_value, shape_value});
+    // The capture is done after two steps, and ignores the third one
+    ASSERT_EQ(capture->Done(), i == 2);
+    ASSERT_OK(capture->AddStep(steps.back()));
+  }
+  ASSERT_TRUE(capture->Done());
+  capture.reset();
+
+  CapturedCluster captured;
+  ASSERT_OK(ClusterCapture::Read(
+      io::JoinPath(::testing::TempDir(), "ngtf_capture_7_0.tfrecord"),
+      &captured));
+  ASSERT_EQ(captured.name, "ngraph_cluster_7");
+  ASSERT_EQ(captured.cluster, 7);
+  ASSERT_EQ(captured.graph_id, 1);
+  ASSERT_EQ(captured.input_is_static, vector<bool>({false, true}));
+  ASSERT_EQ(captured.graph_def.node_size(), graph.num_op_nodes());
+  ASSERT_EQ(captured.steps.size(), 2u);
+  for (int i = 0; i < 2; i++) {
+    Compare(captured.steps[i], steps[i]);
+  }
+
+  RestoreEnv(env_map);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,237 @@
+/*******************************************************************************
+ * Copyright 2017-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "ngraph_bridge/ngraph_control_flow.h"
+
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+using FDH = FunctionDefHelper;
+
+static LoopCounter Counter(int64 step, bool inclusive) {
+  return LoopCounter{0, step, -1, 0, inclusive};
+}
+
+// Counters going up or down, with and without their limit, and ones that
+// start past it
+TEST(NgraphControlFlow, TripCount) {
+  ASSERT_EQ(TripCount(Counter(1, false), 0, 10), 10);
+  ASSERT_EQ(TripCount(Counter(1, true), 0, 10), 11);
+  ASSERT_EQ(TripCount(Counter(3, false), 0, 10), 4);
+  ASSERT_EQ(TripCount(Counter(3, false), 0, 9), 3);
+  ASSERT_EQ(TripCount(Counter(3, true), 0, 9), 4);
+  ASSERT_EQ(TripCount(Counter(-2, false), 10, 0), 5);
+  ASSERT_EQ(TripCount(Counter(-2, true), 10, 0), 6);
+  ASSERT_EQ(TripCount(Counter(-1, false), -3, -5), 2);
+
+  ASSERT_EQ(TripCount(Counter(1, false), 10, 10), 0);
+  ASSERT_EQ(TripCount(Counter(1, true), 10, 10), 1);
+  ASSERT_EQ(TripCount(Counter(1, false), 12, 10), 0);
+  ASSERT_EQ(TripCount(Counter(1, true), 12, 10), 0);
+  ASSERT_EQ(TripCount(Counter(-1, false), 0, 5), 0);
+}
+
+// A loop body that applies step_op with step to the counter i, passes n
+// through (or doubles it), and adds one to x
+static FunctionDef Body(const string& name, const string& step_op,
+                        int32 step, bool change_n = false) {
+  return FDH::Create(
+      name, {"i: int32", "n: int32", "x: float"},
+      {"i_out: int32", "n_out: int32", "x_out: float"}, {},
+      {FDH::Const("step", step),
+       {{"next_i"}, step_op, {"i", "step:output:0"}, {{"T", DT_INT32}}},
+       {{"next_n"}, "Add", {"n", "n"}, {{"T", DT_INT32}}},
+       FDH::Const("one", 1.0f),
+       {{"next_x"}, "Add", {"x", "one:output:0"}, {{"T", DT_FLOAT}}}},
+      {{"i_out", "next_i:z:0"},
+       {"n_out", change_n ? "next_n:z:0" : "n"},
+       {"x_out", "next_x:z:0"}});
+}
+
+// A loop condition that compares lhs with rhs, each of which is one of the
+// loop variables i, n and x, or limit:output:0 for a constant of 10
+static FunctionDef Cond(const string& name, const string& compare_op,
+                        const string& lhs, const string& rhs,
+                        DataType type = DT_INT32) {
+  return FDH::Create(
+      name, {"i: int32", "n: int32", "x: float"}, {"p: bool"}, {},
+      {FDH::Const("limit", 10),
+       {{"compare"}, compare_op, {lhs, rhs}, {{"T", type}}}},
+      {{"p", "compare:z:0"}});
+}
+
+static Status FindCounters(const FunctionDef& cond, const FunctionDef& body,
+                           vector<LoopCounter>* counters, bool* found) {
+  FunctionDefLibrary fdef_lib;
+  *fdef_lib.add_function() = cond;
+  *fdef_lib.add_function() = body;
+  FunctionLibraryDefinition flib(OpRegistry::Global(), fdef_lib);
+  std::unique_ptr<FunctionBody> cond_fbody, body_fbody;
+  NameAttrList func;
+  func.set_name(cond.signature().name());
+  TF_RETURN_IF_ERROR(GetFunctionBody(flib, func, &cond_fbody));
+  func.set_name(body.signature().name());
+  TF_RETURN_IF_ERROR(GetFunctionBody(flib, func, &body_fbody));
+  return FindLoopCounters(*cond_fbody->graph, *body_fbody->graph, counters,
+                          found);
+}
+
+TEST(NgraphControlFlow, FindLoopCounters) {
+  vector<LoopCounter> counters;
+  bool found;
+
+  // i < 10, with i += 2
+  ASSERT_OK(FindCounters(Cond("cond", "Less", "i", "limit:output:0"),
+                         Body("body", "Add", 2), &counters, &found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(counters.size(), 1u);
+  ASSERT_EQ(counters[0].index, 0);
+  ASSERT_EQ(counters[0].step, 2);
+  ASSERT_EQ(counters[0].limit_index, -1);
+  ASSERT_EQ(counters[0].limit, 10);
+  ASSERT_FALSE(counters[0].inclusive);
+
+  // i <= 10
+  ASSERT_OK(FindCounters(Cond("cond", "LessEqual", "i", "limit:output:0"),
+                         Body("body", "AddV2", 1), &counters, &found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(counters.size(), 1u);
+  ASSERT_EQ(counters[0].step, 1);
+  ASSERT_TRUE(counters[0].inclusive);
+
+  // i >= 10, with i -= 3
+  ASSERT_OK(FindCounters(Cond("cond", "GreaterEqual", "i", "limit:output:0"),
+                         Body("body", "Sub", 3), &counters, &found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(counters.size(), 1u);
+  ASSERT_EQ(counters[0].step, -3);
+  ASSERT_TRUE(counters[0].inclusive);
+
+  // 10 > i, the counter on the right hand side
+  ASSERT_OK(FindCounters(Cond("cond", "Greater", "limit:output:0", "i"),
+                         Body("body", "Add", 1), &counters, &found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(counters.size(), 1u);
+  ASSERT_EQ(counters[0].index, 0);
+  ASSERT_EQ(counters[0].limit, 10);
+  ASSERT_EQ(TripCount(counters[0], 0, counters[0].limit), 10);
+
+  // i < n, the limit passed as a loop variable
+  ASSERT_OK(FindCounters(Cond("cond", "Less", "i", "n"),
+                         Body("body", "Add", 1), &counters, &found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(counters.size(), 1u);
+  ASSERT_EQ(counters[0].index, 0);
+  ASSERT_EQ(counters[0].limit_index, 1);
+
+  // A counter that moves away from its limit
+  ASSERT_OK(FindCounters(Cond("cond", "Less", "i", "limit:output:0"),
+                         Body("body", "Sub", 1), &counters, &found));
+  ASSERT_FALSE(found);
+  ASSERT_TRUE(counters.empty());
+
+  // A limit the body changes
+  ASSERT_OK(FindCounters(Cond("cond", "Less", "i", "n"),
+                         Body("body", "Add", 1, true), &counters, &found));
+  ASSERT_FALSE(found);
+
+  // A condition on a value that is not a counter
+  ASSERT_OK(FindCounters(Cond("cond", "Less", "x", "x", DT_FLOAT),
+                         Body("body", "Add", 1), &counters, &found));
+  ASSERT_FALSE(found);
+}
+
+// Both counters of a LogicalAnd are found
+TEST(NgraphControlFlow, FindLoopCountersLogicalAnd) {
+  FunctionDef cond = FDH::Create(
+      "cond", {"i: int32", "n: int32", "x: float"}, {"p: bool"}, {},
+      {FDH::Const("limit", 10),
+       {{"less"}, "Less", {"i", "limit:output:0"}, {{"T", DT_INT32}}},
+       {{"less_n"}, "Less", {"i", "n"}, {{"T", DT_INT32}}},
+       {{"both"}, "LogicalAnd", {"less:z:0", "less_n:z:0"}}},
+      {{"p", "both:z:0"}});
+  vector<LoopCounter> counters;
+  bool found;
+  ASSERT_OK(FindCounters(cond, Body("body", "Add", 1), &counters, &found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(counters.size(), 2u);
+  ASSERT_EQ(counters[0].limit_index, -1);
+  ASSERT_EQ(counters[1].limit_index, 1);
+}
+
+// The trip count of a While is known when its counter and limit inputs are
+// Consts
+TEST(NgraphControlFlow, ConstTripCount) {
+  Graph g(OpRegistry::Global());
+  auto add_const = [&g](const string& name, int32 value) {
+    Tensor t(DT_INT32, TensorShape{});
+    t.scalar<int32>()() = value;
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(name, "Const")
+                    .Attr("dtype", DT_INT32)
+                    .Attr("value", t)
+                    .Finalize(&g, &node));
+    return node;
+  };
+  Node* i = add_const("i", 2);
+  Node* n = add_const("n", 9);
+  Node* x;
+  ASSERT_OK(NodeBuilder("x", "Placeholder")
+                .Attr("dtype", DT_FLOAT)
+                .Finalize(&g, &x));
+  NameAttrList cond, body;
+  cond.set_name("cond");
+  body.set_name("body");
+  Node* loop;
+  ASSERT_OK(
+      NodeBuilder("while", "While")
+          .Input(vector<NodeBuilder::NodeOut>{{i, 0}, {n, 0}, {x, 0}})
+          .Attr("T", DataTypeVector{DT_INT32, DT_INT32, DT_FLOAT})
+          .Attr("cond", cond)
+          .Attr("body", body)
+          .Finalize(&g, &loop));
+
+  // i < n and i < 10, with i += 2
+  LoopCounter to_n{0, 2, 1, 0, false};
+  LoopCounter to_ten{0, 2, -1, 10, false};
+  int64 trip_count;
+  bool known;
+  ConstTripCount(loop, {to_n, to_ten}, &trip_count, &known);
+  ASSERT_TRUE(known);
+  ASSERT_EQ(trip_count, 4);
+
+  // x is not a Const
+  LoopCounter to_x{0, 2, 2, 0, false};
+  ConstTripCount(loop, {to_ten, to_x}, &trip_count, &known);
+  ASSERT_FALSE(known);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
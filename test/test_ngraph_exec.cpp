@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  *******************************************************************************/
+#include <map>
 #include <regex>
 #include "gtest/gtest.h"
 
@@ -23,6 +24,7 @@
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/platform/env.h"
 
 #include "ngraph_bridge/ngraph_backend_manager.h"
@@ -232,6 +234,129 @@ TEST_F(NGraphExecTest, Axpy) {
   RestoreEnv(env_map);
 }
 
+// A template translated for an unknown batch size is instantiated for any
+// batch size, and computes what the translation for that batch size does
+TEST_F(NGraphExecTest, TranslationTemplate) {
+  Graph input_graph(OpRegistry::Global());
+  ASSERT_OK(LoadGraph("test_axpy_launchop.pbtxt", &input_graph));
+
+  vector<PartialTensorShape> template_shapes{PartialTensorShape({-1, 3}),
+                                             PartialTensorShape({-1, 3})};
+  vector<const Tensor*> static_input_map(2, nullptr);
+  shared_ptr<ng::Function> ng_template;
+  ASSERT_OK(Builder::TranslateGraphTemplate(template_shapes, static_input_map,
+                                            &input_graph, ng_template));
+
+  auto backend = BackendManager::GetBackend();
+  auto run = [&backend](const shared_ptr<ng::Function>& ng_function) {
+    vector<shared_ptr<ng::runtime::Tensor>> inputs;
+    for (const auto& param : ng_function->get_parameters()) {
+      vector<float> values(ng::shape_size(param->get_shape()));
+      for (size_t i = 0; i < values.size(); i++) {
+        values[i] = 0.5f * i + inputs.size();
+      }
+      inputs.push_back(
+          backend->create_tensor(ng::element::f32, param->get_shape()));
+      inputs.back()->write(values.data(), values.size() * sizeof(float));
+    }
+    vector<shared_ptr<ng::runtime::Tensor>> outputs;
+    vector<vector<float>> results;
+    for (size_t i = 0; i < ng_function->get_output_size(); i++) {
+      outputs.push_back(backend->create_tensor(
+          ng::element::f32, ng_function->get_output_shape(i)));
+    }
+    backend->compile(ng_function)->call(outputs, inputs);
+    for (const auto& output : outputs) {
+      vector<float> result(ng::shape_size(output->get_shape()));
+      output->read(result.data(), result.size() * sizeof(float));
+      results.push_back(result);
+    }
+    return results;
+  };
+
+  for (int64 batch : {1, 4, 7}) {
+    vector<TensorShape> input_shapes{TensorShape({batch, 3}),
+                                     TensorShape({batch, 3})};
+    shared_ptr<ng::Function> ng_instance;
+    ASSERT_OK(
+        Builder::InstantiateTemplate(*ng_template, input_shapes, ng_instance));
+    ASSERT_EQ(ng_instance->get_output_shape(0), (ng::Shape{size_t(batch), 3}));
+
+    shared_ptr<ng::Function> ng_function;
+    ASSERT_OK(TranslateTFGraphNoStatic(input_shapes, input_graph, ng_function));
+    ASSERT_EQ(run(ng_instance), run(ng_function));
+  }
+
+  // The known dimension has to match
+  vector<TensorShape> input_shapes{TensorShape({2, 4}), TensorShape({2, 4})};
+  shared_ptr<ng::Function> ng_instance;
+  ASSERT_NOT_OK(
+      Builder::InstantiateTemplate(*ng_template, input_shapes, ng_instance));
+}
+
+// A function with a dynamic batch dimension is compiled once and called for
+// several batch sizes, with outputs whose shapes are only known after the call
+TEST_F(NGraphExecTest, DynamicDimensions) {
+  if (!BackendManager::SupportsDynamicDimensions()) {
+    return;
+  }
+  Graph input_graph(OpRegistry::Global());
+  ASSERT_OK(LoadGraph("test_axpy_launchop.pbtxt", &input_graph));
+
+  vector<PartialTensorShape> dynamic_shapes{PartialTensorShape({-1, 3}),
+                                            PartialTensorShape({-1, 3})};
+  vector<const Tensor*> static_input_map(2, nullptr);
+  shared_ptr<ng::Function> ng_function;
+  ASSERT_OK(Builder::TranslateGraphTemplate(dynamic_shapes, static_input_map,
+                                            &input_graph, ng_function));
+  Builder::RunPasses(ng_function);
+  ASSERT_TRUE(ng_function->is_dynamic());
+
+  auto backend = BackendManager::GetBackend();
+  auto ng_exec = backend->compile(ng_function);
+  for (size_t batch : {1, 4, 7}) {
+    ng::Shape shape{batch, 3};
+    vector<float> values(ng::shape_size(shape));
+    for (size_t i = 0; i < values.size(); i++) {
+      values[i] = 0.5f * i;
+    }
+    vector<shared_ptr<ng::runtime::Tensor>> inputs;
+    for (int i = 0; i < 2; i++) {
+      inputs.push_back(backend->create_tensor(ng::element::f32, shape));
+      inputs.back()->write(values.data(), values.size() * sizeof(float));
+    }
+    vector<shared_ptr<ng::runtime::Tensor>> outputs;
+    for (size_t i = 0; i < ng_function->get_output_size(); i++) {
+      outputs.push_back(backend->create_dynamic_tensor(
+          ng::element::f32, ng_function->get_output_partial_shape(i)));
+    }
+    ng_exec->call(outputs, inputs);
+
+    // The same as the function translated for this batch size
+    shared_ptr<ng::Function> ng_static_function;
+    vector<TensorShape> input_shapes{TensorShape({int64(batch), 3}),
+                                     TensorShape({int64(batch), 3})};
+    ASSERT_OK(TranslateTFGraphNoStatic(input_shapes, input_graph,
+                                       ng_static_function));
+    vector<shared_ptr<ng::runtime::Tensor>> expected_outputs;
+    for (size_t i = 0; i < ng_static_function->get_output_size(); i++) {
+      expected_outputs.push_back(backend->create_tensor(
+          ng::element::f32, ng_static_function->get_output_shape(i)));
+    }
+    backend->compile(ng_static_function)->call(expected_outputs, inputs);
+
+    for (size_t i = 0; i < outputs.size(); i++) {
+      ASSERT_EQ(outputs[i]->get_shape(), expected_outputs[i]->get_shape());
+      vector<float> result(ng::shape_size(outputs[i]->get_shape()));
+      outputs[i]->read(result.data(), result.size() * sizeof(float));
+      vector<float> expected(result.size());
+      expected_outputs[i]->read(expected.data(),
+                                expected.size() * sizeof(float));
+      ASSERT_EQ(result, expected);
+    }
+  }
+}
+
 TEST_F(NGraphExecTest, Axpy8bit) {
   auto env_map = StoreEnv({"NGRAPH_TF_BACKEND"});
   SetBackendUsingEnvVar("CPU");
@@ -438,6 +563,65 @@ TEST_F(NGraphExecTest, NGraphPassConstantFolding2) {
   expect_const_count_ngfunc(*pgraph_new, 3);
 }
 
+// Unpacking a sequence of T steps takes one Split and T Squeezes, and
+// packing them back one Concat, whatever T is
+TEST_F(NGraphExecTest, UnpackPackNodeCount) {
+  const int num_steps = 64;
+  Graph input_graph(OpRegistry::Global());
+  Node* input;
+  ASSERT_OK(NodeBuilder("input", "_Arg")
+                .Attr("T", DT_FLOAT)
+                .Attr("index", 0)
+                .Finalize(&input_graph, &input));
+  Node* unpack;
+  ASSERT_OK(NodeBuilder("unpack", "Unpack")
+                .Input(input, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("num", num_steps)
+                .Attr("axis", 0)
+                .Finalize(&input_graph, &unpack));
+  vector<NodeBuilder::NodeOut> steps;
+  for (int step = 0; step < num_steps; step++) {
+    Node* tanh;
+    ASSERT_OK(NodeBuilder("tanh_" + to_string(step), "Tanh")
+                  .Input(unpack, step)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(&input_graph, &tanh));
+    steps.emplace_back(tanh, 0);
+  }
+  Node* pack;
+  ASSERT_OK(NodeBuilder("pack", "Pack")
+                .Input(steps)
+                .Attr("T", DT_FLOAT)
+                .Attr("N", num_steps)
+                .Attr("axis", 0)
+                .Finalize(&input_graph, &pack));
+  Node* output;
+  ASSERT_OK(NodeBuilder("output", "_Retval")
+                .Input(pack, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("index", 0)
+                .Finalize(&input_graph, &output));
+  FixupSourceAndSinkEdges(&input_graph);
+
+  shared_ptr<ng::Function> ng_function;
+  ASSERT_OK(TranslateTFGraphNoStatic({TensorShape{num_steps, 8, 16}},
+                                     input_graph, ng_function));
+  std::map<string, int> op_counts;
+  for (const auto& node : ng_function->get_ops()) {
+    op_counts[node->description()]++;
+  }
+  ASSERT_EQ(op_counts["StridedSlice"], 0);
+  ASSERT_EQ(op_counts["Split"], 1);
+  ASSERT_EQ(op_counts["Squeeze"], num_steps);
+  ASSERT_EQ(op_counts["Tanh"], num_steps);
+  ASSERT_EQ(op_counts["Concat"], 1);
+  ASSERT_EQ(op_counts["Reshape"], 1);
+  // Parameter, Result, and the axis and shape Constants of Split, Squeeze
+  // and Reshape
+  ASSERT_LE(ng_function->get_ops().size(), 2u * num_steps + 8);
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/graph/graph.h"
+
+#include "ngraph_bridge/default_opset.h"
+#include "ngraph_bridge/ngraph_builder.h"
+#include "ngraph_bridge/ngraph_layer_profiler.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+namespace ng = ngraph;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Layer times are attributed to TF nodes through the provenance tags set by
+// the builder, or failing that through the layer names
+TEST(LayerProfiler, AttributesLayersToTFNodes) {
+  Scope root = Scope::NewRootScope();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto relu = ops::Relu(root.WithOpName("relu"), x);
+  auto add = ops::Add(root.WithOpName("add"), relu, relu);
+  Graph graph(OpRegistry::Global());
+  ASSERT_OK(root.ToGraph(&graph));
+
+  auto ng_x = make_shared<opset::Parameter>(ng::element::f32, ng::Shape{2});
+  Builder::SetTracingInfo("x", ng_x);
+  auto ng_relu = make_shared<opset::Relu>(ng_x);
+  Builder::SetTracingInfo("relu", ng_relu);
+  auto ng_add = make_shared<opset::Add>(ng_relu, ng_relu);
+  Builder::SetTracingInfo("add", ng_add);
+
+  vector<LayerSample> samples{
+      {"x", "Input", ng_x, 0},
+      {"relu", "Relu", ng_relu, 30},
+      {"add", "Eltwise", ng_add, 10},
+      // A layer the backend inserted after add
+      {ng_add->get_friendly_name() + "_reorder", "Reorder", nullptr, 5},
+      {"convert", "Convert", nullptr, 1}};
+
+  LayerProfiler::Reset();
+  LayerProfiler::Record(1, 3, graph, samples);
+  LayerProfiler::Record(1, 3, graph, samples);
+
+  string report = LayerProfiler::Report();
+  auto by_node = report.find("Backend time by TF node");
+  ASSERT_NE(by_node, string::npos);
+
+  // Op types, most expensive first
+  auto relu_type = report.find("  Relu\n");
+  auto add_type = report.find("  Add\n");
+  auto convert_type = report.find("  (Convert)\n");
+  ASSERT_LT(relu_type, add_type);
+  ASSERT_LT(add_type, convert_type);
+  ASSERT_LT(convert_type, by_node);
+  ASSERT_NE(report.find("(total 0.092 ms)"), string::npos);
+
+  // Nodes, most expensive first, with the average time per step
+  auto relu_node = report.find("  Relu  relu\n", by_node);
+  auto add_node = report.find("  Add  add\n", by_node);
+  ASSERT_NE(relu_node, string::npos);
+  ASSERT_LT(relu_node, add_node);
+  ASSERT_NE(report.find("0.060", by_node), string::npos);
+  ASSERT_NE(report.find("15.0", by_node), string::npos);
+
+  ASSERT_EQ(LayerProfiler::Report(1).find("  Add  add\n"), string::npos);
+
+  // The same node of another graph, which reuses the cluster index, is kept
+  // apart
+  LayerProfiler::Record(2, 3, graph, samples);
+  report = LayerProfiler::Report();
+  by_node = report.find("Backend time by TF node");
+  relu_node = report.find("  Relu  relu\n", by_node);
+  ASSERT_NE(relu_node, string::npos);
+  ASSERT_NE(report.find("  Relu  relu\n", relu_node + 1), string::npos);
+  ASSERT_NE(report.find("      1        3  Relu  relu\n"), string::npos);
+  ASSERT_NE(report.find("      2        3  Relu  relu\n"), string::npos);
+
+  LayerProfiler::Reset();
+  ASSERT_EQ(LayerProfiler::Report().find("relu"), string::npos);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ngraph_bridge/ngraph_metrics.h"
+
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Increments from many threads add up
+TEST(NgraphMetrics, Counter) {
+  Counter* counter =
+      MetricsRegistry::GetCounter("test_counter_total", "Test counter", 1);
+  ASSERT_EQ(counter, MetricsRegistry::GetCounter("test_counter_total", "", 1));
+  ASSERT_NE(counter, MetricsRegistry::GetCounter("test_counter_total", "", 2));
+  counter->Reset();
+
+  vector<thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([counter]() {
+      for (int j = 0; j < 1000; j++) {
+        counter->Increment();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(counter->Value(), 8000);
+
+  counter->Reset();
+  ASSERT_EQ(counter->Value(), 0);
+}
+
+// Quantiles are upper bounds within 12.5% of the real value
+TEST(NgraphMetrics, HistogramQuantiles) {
+  Histogram histogram;
+  ASSERT_EQ(histogram.Quantile(0.5), 0);
+
+  for (int64 i = 1; i <= 1000; i++) {
+    histogram.Record(i);
+  }
+  ASSERT_EQ(histogram.Count(), 1000);
+  ASSERT_EQ(histogram.Sum(), 500500);
+
+  auto check = [&histogram](double q, int64 expected) {
+    int64 value = histogram.Quantile(q);
+    ASSERT_GE(value, expected);
+    ASSERT_LE(value, expected * 1.125);
+  };
+  check(0.5, 500);
+  check(0.99, 990);
+  check(0.999, 999);
+  // Never above the largest recorded value
+  ASSERT_EQ(histogram.Quantile(1.0), 1000);
+
+  // Small values are exact
+  histogram.Reset();
+  histogram.Record(3);
+  ASSERT_EQ(histogram.Quantile(0.5), 3);
+}
+
+TEST(NgraphMetrics, TextFormat) {
+  MetricsRegistry::GetCounter("test_text_total", "Some help", 7)->Increment(5);
+  MetricsRegistry::GetHistogram("test_text_us", "More help", 7)->Record(4);
+
+  string text = MetricsRegistry::ToText();
+  ASSERT_NE(text.find("# HELP test_text_total Some help\n"), string::npos);
+  ASSERT_NE(text.find("# TYPE test_text_total counter\n"), string::npos);
+  ASSERT_NE(text.find("test_text_total{cluster=\"7\"} 5\n"), string::npos);
+  ASSERT_NE(text.find("# TYPE test_text_us summary\n"), string::npos);
+  ASSERT_NE(text.find("test_text_us{cluster=\"7\",quantile=\"0.99\"} 4\n"),
+            string::npos);
+  ASSERT_NE(text.find("test_text_us_count{cluster=\"7\"} 1\n"), string::npos);
+
+  MetricsRegistry::Reset();
+  text = MetricsRegistry::ToText();
+  ASSERT_NE(text.find("test_text_total{cluster=\"7\"} 0\n"), string::npos);
+}
+
+// Gauges go up and down, and survive a reset
+TEST(NgraphMetrics, Gauge) {
+  Gauge* gauge = MetricsRegistry::GetGauge("test_gauge_bytes", "Held", 4);
+  gauge->Set(100);
+  {
+    ScopedGaugeAdd held(gauge);
+    held.Add(20);
+    held.Add(5);
+    ASSERT_EQ(gauge->Value(), 125);
+  }
+  ASSERT_EQ(gauge->Value(), 100);
+
+  string text = MetricsRegistry::ToText();
+  ASSERT_NE(text.find("# TYPE test_gauge_bytes gauge\n"), string::npos);
+  ASSERT_NE(text.find("test_gauge_bytes{cluster=\"4\"} 100\n"), string::npos);
+
+  MetricsRegistry::Reset();
+  ASSERT_EQ(gauge->Value(), 100);
+  gauge->Add(-100);
+  ASSERT_EQ(gauge->Value(), 0);
+}
+
+// The series of a cluster go away with the last of its ClusterMetrics
+TEST(NgraphMetrics, ClusterRelease) {
+  const string series = "ngraph_tf_cache_hits_total{cluster=\"93\"}";
+  std::unique_ptr<ClusterMetrics> first(new ClusterMetrics(93));
+  std::unique_ptr<ClusterMetrics> second(new ClusterMetrics(93));
+  ASSERT_EQ(first->cache_hits, second->cache_hits);
+  second->cache_hits->Increment(3);
+  ASSERT_NE(MetricsRegistry::ToText().find(series + " 3\n"), string::npos);
+
+  first.reset();
+  ASSERT_NE(MetricsRegistry::ToText().find(series + " 3\n"), string::npos);
+
+  second.reset();
+  ASSERT_EQ(MetricsRegistry::ToText().find(series), string::npos);
+
+  // A later user of the index starts from scratch
+  ClusterMetrics third(93);
+  ASSERT_NE(MetricsRegistry::ToText().find(series + " 0\n"), string::npos);
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
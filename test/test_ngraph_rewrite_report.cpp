@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+
+#include "ngraph_bridge/ngraph_assign_clusters.h"
+#include "ngraph_bridge/ngraph_metrics.h"
+#include "ngraph_bridge/ngraph_rewrite_report.h"
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+// Counts go to the phase that is running, and nowhere outside of a phase
+TEST(RewriteReport, CountsPerPhase) {
+  RewriteReport::Reset();
+  MetricsRegistry::Reset();
+  RewriteReport::Count("nodes", 5);
+  {
+    RewriteReport report(7);
+    ASSERT_OK(report.RunPhase("mark", []() {
+      RewriteReport::Count("nodes", 3);
+      RewriteReport::Count("nodes_marked", 2);
+      RewriteReport::Count("nodes", 1);
+      return Status::OK();
+    }));
+    Status status = report.RunPhase(
+        "assign", []() { return errors::Internal("assignment failed"); });
+    ASSERT_FALSE(status.ok());
+    // Finished, as failed, as it goes out of scope
+  }
+  RewriteReport::Count("nodes", 5);
+
+  string json = RewriteReport::Get(7);
+  ASSERT_EQ(json.find("{\"graph_id\":7,\"cache_hit\":false,\"failed\":true,"),
+            0u);
+  ASSERT_NE(json.find("{\"name\":\"mark\",\"time_us\":"), string::npos);
+  ASSERT_NE(json.find("\"counts\":{\"nodes\":4,\"nodes_marked\":2}"),
+            string::npos);
+  ASSERT_NE(json.find("{\"name\":\"assign\",\"time_us\":"), string::npos);
+  ASSERT_EQ(RewriteReport::Get(8), "");
+  ASSERT_EQ(RewriteReport::Get(), "[" + json + "]");
+
+  // A failed rewrite only counts as a failure
+  string metrics = MetricsRegistry::ToText();
+  ASSERT_NE(metrics.find("\nngraph_tf_rewrite_failures_total 1\n"),
+            string::npos);
+  ASSERT_EQ(metrics.find("\nngraph_tf_rewrite_nodes_marked_total 2\n"),
+            string::npos);
+  ASSERT_EQ(metrics.find("\nngraph_tf_rewrite_assign_time_us_count 1\n"),
+            string::npos);
+
+  {
+    RewriteReport report(8);
+    ASSERT_OK(report.RunPhase("mark", []() {
+      RewriteReport::Count("nodes_marked", 2);
+      return Status::OK();
+    }));
+    report.Finish();
+  }
+  ASSERT_NE(RewriteReport::Get(8).find("\"failed\":false,"), string::npos);
+  metrics = MetricsRegistry::ToText();
+  ASSERT_NE(metrics.find("\nngraph_tf_rewrite_failures_total 1\n"),
+            string::npos);
+  ASSERT_NE(metrics.find("\nngraph_tf_rewrite_nodes_marked_total 2\n"),
+            string::npos);
+  ASSERT_NE(metrics.find("\nngraph_tf_rewrite_mark_time_us_count 1\n"),
+            string::npos);
+
+  RewriteReport::Reset();
+  ASSERT_EQ(RewriteReport::Get(), "[]");
+}
+
+// AssignClusters reports its contraction
+TEST(RewriteReport, AssignClusters) {
+  Graph g(OpRegistry::Global());
+  Tensor t(DT_FLOAT, TensorShape{2, 3});
+
+  Node* node1;
+  ASSERT_OK(NodeBuilder("node1", "Const")
+                .Attr("dtype", DT_FLOAT)
+                .Attr("value", t)
+                .Attr("_ngraph_marked_for_clustering", true)
+                .Finalize(&g, &node1));
+  Node* node2;
+  ASSERT_OK(NodeBuilder("node2", "Abs")
+                .Input(node1, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("_ngraph_marked_for_clustering", true)
+                .Finalize(&g, &node2));
+  Node* node3;
+  ASSERT_OK(NodeBuilder("node3", "Neg")
+                .Input(node2, 0)
+                .Attr("T", DT_FLOAT)
+                .Attr("_ngraph_marked_for_clustering", true)
+                .Finalize(&g, &node3));
+  g.AddEdge(g.source_node(), Graph::kControlSlot, node1, Graph::kControlSlot);
+  g.AddEdge(node3, Graph::kControlSlot, g.sink_node(), Graph::kControlSlot);
+
+  RewriteReport::Reset();
+  RewriteReport report(11);
+  ASSERT_OK(report.RunPhase("assign", [&g]() { return AssignClusters(&g); }));
+  report.Finish();
+
+  // Both edges get contracted in the first iteration, the second one finds
+  // nothing more to do
+  string json = RewriteReport::Get(11);
+  ASSERT_NE(json.find("\"contraction_iterations\":2"), string::npos) << json;
+  ASSERT_NE(json.find("\"edges_contracted\":2"), string::npos) << json;
+  ASSERT_NE(json.find("\"clusters\":1"), string::npos) << json;
+  RewriteReport::Reset();
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+#include "ngraph_bridge/ngraph_tracer.h"
+
+#include "test/test_utilities.h"
+
+using namespace std;
+
+namespace tensorflow {
+namespace ngraph_bridge {
+namespace testing {
+
+static int CountOccurrences(const string& text, const string& pattern) {
+  int count = 0;
+  for (size_t pos = text.find(pattern); pos != string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+static string FlushToString() {
+  string path = io::JoinPath(::testing::TempDir(), "ngtf_trace_test.json");
+  EXPECT_EQ(Tracer::Flush(path), Status::OK());
+  string trace;
+  EXPECT_EQ(ReadFileToString(Env::Default(), path, &trace), Status::OK());
+  return trace;
+}
+
+// Events are recorded from every thread while tracing is on, and only then
+TEST(NgraphTracer, RecordsWhileEnabled) {
+  Tracer::Clear();
+  Tracer::Disable();
+  { NGRAPH_TF_TRACE_SCOPE(TraceEvent::kExecute, 3); }
+  ASSERT_EQ(CountOccurrences(FlushToString(), "Execute nGraph"), 0);
+
+  Tracer::Enable();
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([]() {
+      for (int j = 0; j < 10; j++) {
+        NGRAPH_TF_TRACE_SCOPE(TraceEvent::kExecute, 3);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  { NGRAPH_TF_TRACE_SCOPE(TraceEvent::kNgraphPass, -1, "TransposeSinking"); }
+  Tracer::Disable();
+
+  string trace = FlushToString();
+  ASSERT_EQ(trace.find("{\"traceEvents\":["), 0u);
+  ASSERT_EQ(CountOccurrences(trace, "\"name\":\"Execute nGraph\""), 40);
+  ASSERT_EQ(CountOccurrences(trace, "\"args\":{\"id\":3}"), 40);
+  ASSERT_EQ(CountOccurrences(trace, "\"detail\":\"TransposeSinking\""), 1);
+
+  Tracer::Clear();
+  ASSERT_EQ(CountOccurrences(FlushToString(), "\"ph\":\"X\""), 0);
+}
+
+// A full buffer keeps the most recent events
+TEST(NgraphTracer, RingBufferWrapsAround) {
+  Tracer::Clear();
+  Tracer::Enable();
+  thread t([]() {
+    for (int j = 0; j < 20000; j++) {
+      NGRAPH_TF_TRACE_SCOPE(TraceEvent::kTensorRead, j);
+    }
+  });
+  t.join();
+  Tracer::Disable();
+
+  string trace = FlushToString();
+  ASSERT_EQ(CountOccurrences(trace, "\"name\":\"Tensor Read D2H\""), 16384);
+  ASSERT_NE(trace.find("\"id\":19999}"), string::npos);
+  ASSERT_EQ(trace.find("\"id\":0}"), string::npos);
+  Tracer::Clear();
+}
+
+// Flushing while a thread records never yields a half-written record
+TEST(NgraphTracer, FlushWhileRecording) {
+  Tracer::Clear();
+  Tracer::Enable();
+  std::atomic<bool> done{false};
+  thread t([&done]() {
+    for (int64 j = 0; j < 200000; j++) {
+      Tracer::Record(TraceEvent::kTensorWrite, j, nullptr, j * 1000,
+                     j * 1000 + 1000);
+    }
+    done = true;
+  });
+
+  const string ts = "\"ts\":";
+  const string id = "\"id\":";
+  int flushes = 0;
+  while (!done || flushes == 0) {
+    string trace = FlushToString();
+    flushes++;
+    for (size_t pos = trace.find(ts); pos != string::npos;
+         pos = trace.find(ts, pos + 1)) {
+      size_t id_pos = trace.find(id, pos);
+      ASSERT_NE(id_pos, string::npos);
+      int64 start = strtoll(trace.c_str() + pos + ts.size(), nullptr, 10);
+      int64 arg = strtoll(trace.c_str() + id_pos + id.size(), nullptr, 10);
+      ASSERT_EQ(start, arg);
+      ASSERT_LT(trace.find("\"dur\":1.000,", pos), id_pos);
+    }
+  }
+  t.join();
+  Tracer::Disable();
+  Tracer::Clear();
+}
+
+}  // namespace testing
+}  // namespace ngraph_bridge
+}  // namespace tensorflow
@@ -16,10 +16,13 @@
 
 #include "test/test_utilities.h"
 #include <assert.h>
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <ctime>
 #include "logging/ngraph_log.h"
+#include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_timer.h"
 
 using namespace std;
 
@@ -402,6 +405,99 @@ void AssignInputValues(Tensor& A, int8 x) {
   cout << endl;
 }
 
+std::shared_ptr<ng::opset3::Constant> MakeConstant(const ng::Shape& shape,
+                                                   float offset) {
+  vector<float> values(ng::shape_size(shape));
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = 0.1f * (i % 7) + offset;
+  }
+  return make_shared<ng::opset3::Constant>(ng::element::f32, shape, values);
+}
+
+std::shared_ptr<ng::Node> MakeTranspose(const ng::Output<ng::Node>& arg,
+                                        const ng::AxisVector& order) {
+  auto ng_order = make_shared<ng::opset3::Constant>(
+      ng::element::u64, ng::Shape{order.size()}, order);
+  return make_shared<ng::opset3::Transpose>(arg, ng_order);
+}
+
+std::shared_ptr<ng::Node> MakeConv(const ng::Output<ng::Node>& input_nchw,
+                                   size_t in_channels, size_t out_channels,
+                                   size_t kernel, bool hwio_filter) {
+  std::shared_ptr<ng::Node> filter;
+  if (hwio_filter) {
+    filter = MakeTranspose(
+        MakeConstant({kernel, kernel, in_channels, out_channels}),
+        {3, 2, 0, 1});
+  } else {
+    filter = MakeConstant({out_channels, in_channels, kernel, kernel});
+  }
+  auto pad = static_cast<ptrdiff_t>(kernel / 2);
+  auto conv = make_shared<ng::opset3::Convolution>(
+      input_nchw, filter, ng::Strides{1, 1}, ng::CoordinateDiff{pad, pad},
+      ng::CoordinateDiff{pad, pad}, ng::Strides{1, 1});
+  return MakeTranspose(conv, {0, 2, 3, 1});
+}
+
+// Compiles func on the test backend and creates its input and output tensors
+static std::shared_ptr<ng::runtime::Executable> Prepare(
+    const std::shared_ptr<ng::Function>& func, const vector<float>& input,
+    std::shared_ptr<ng::runtime::Tensor>& t_input,
+    vector<std::shared_ptr<ng::runtime::Tensor>>& t_results) {
+  auto backend = BackendManager::GetBackend();
+  t_input = backend->create_tensor(ng::element::f32,
+                                   func->get_parameters()[0]->get_shape());
+  t_input->write(input.data(), input.size() * sizeof(float));
+  t_results.clear();
+  for (size_t i = 0; i < func->get_output_size(); i++) {
+    t_results.push_back(backend->create_tensor(ng::element::f32,
+                                               func->get_output_shape(i)));
+  }
+  return backend->compile(func);
+}
+
+static vector<float> Read(const std::shared_ptr<ng::runtime::Tensor>& t) {
+  vector<float> result(ng::shape_size(t->get_shape()));
+  t->read(result.data(), result.size() * sizeof(float));
+  return result;
+}
+
+vector<vector<float>> RunOutputs(const std::shared_ptr<ng::Function>& func,
+                                 const vector<float>& input) {
+  std::shared_ptr<ng::runtime::Tensor> t_input;
+  vector<std::shared_ptr<ng::runtime::Tensor>> t_results;
+  Prepare(func, input, t_input, t_results)->call(t_results, {t_input});
+  vector<vector<float>> results;
+  for (const auto& t_result : t_results) {
+    results.push_back(Read(t_result));
+  }
+  return results;
+}
+
+vector<float> Run(const std::shared_ptr<ng::Function>& func,
+                  const vector<float>& input) {
+  return RunOutputs(func, input).at(0);
+}
+
+vector<float> RunAndTime(const std::shared_ptr<ng::Function>& func,
+                         const vector<float>& input, int& time_us) {
+  const char* iterations_env = std::getenv("NGRAPH_TF_UTEST_BENCHMARK");
+  int iterations = iterations_env == nullptr ? 1 : std::atoi(iterations_env);
+  iterations = std::max(iterations, 1);
+
+  std::shared_ptr<ng::runtime::Tensor> t_input;
+  vector<std::shared_ptr<ng::runtime::Tensor>> t_results;
+  auto exec = Prepare(func, input, t_input, t_results);
+  // the first run is not timed
+  exec->call(t_results, {t_input});
+  Timer timer;
+  for (int i = 0; i < iterations; i++) {
+    exec->call(t_results, {t_input});
+  }
+  time_us = timer.ElapsedInMicroSec() / iterations;
+  return Read(t_results.at(0));
+}
+
 }  // namespace testing
 }  // namespace ngraph_bridge
 }  // namespace tensorflow
@@ -26,6 +26,7 @@
 #include "tensorflow/core/public/session.h"
 
 #include "ngraph/ngraph.hpp"
+#include "ngraph/opsets/opset3.hpp"
 #include "ngraph_bridge/version.h"
 
 // Define useful macros used by others
@@ -173,6 +174,37 @@ size_t count_ops_of_type(std::shared_ptr<ng::Function> f) {
   return count;
 }
 
+// Graph building and running functions for the nGraph pass tests
+
+// A float constant of the given shape, with values 0.1 * (i % 7) + offset
+std::shared_ptr<ng::opset3::Constant> MakeConstant(const ng::Shape& shape,
+                                                   float offset = -0.3f);
+
+std::shared_ptr<ng::Node> MakeTranspose(const ng::Output<ng::Node>& arg,
+                                        const ng::AxisVector& order);
+
+// A convolution of input_nchw with a kernel x kernel filter and same
+// padding, transposed back to NHWC, the way the translation builds it. With
+// hwio_filter the filter is an HWIO constant transposed to OIHW, as TF's
+// filters are.
+std::shared_ptr<ng::Node> MakeConv(const ng::Output<ng::Node>& input_nchw,
+                                   size_t in_channels, size_t out_channels,
+                                   size_t kernel, bool hwio_filter = false);
+
+// Runs func, whose only parameter and outputs are f32, on the test backend
+// and returns its outputs
+vector<vector<float>> RunOutputs(const std::shared_ptr<ng::Function>& func,
+                                 const vector<float>& input);
+
+// The first output of func
+vector<float> Run(const std::shared_ptr<ng::Function>& func,
+                  const vector<float>& input);
+
+// Runs func NGRAPH_TF_UTEST_BENCHMARK times (once if it is not set) after an
+// untimed first run, and returns its first output and the time per run
+vector<float> RunAndTime(const std::shared_ptr<ng::Function>& func,
+                         const vector<float>& input, int& time_us);
+
 }  // namespace testing
 
 }  // namespace ngraph_bridge
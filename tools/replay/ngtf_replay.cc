@@ -0,0 +1,265 @@
+/*******************************************************************************
+ * Copyright 2019-2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+//-----------------------------------------------------------------------------
+//  ngtf_replay: replays a cluster captured with NGRAPH_TF_CAPTURE_CLUSTERS
+//  (see ngraph_bridge/ngraph_capture.h) outside of TensorFlow
+//    1. Loads the TF graph of the cluster and the captured inputs
+//    2. Translates and compiles it on the chosen backend, the way the
+//       encapsulate op does
+//    3. Calls it with the captured inputs, round robin, and reports the
+//       compile time and the latency of the calls
+//
+//  The bridge is configured through the usual NGRAPH_TF_* environment
+//  variables, so the same capture can be timed under different settings.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+#include "ngraph_bridge/ngraph_backend_manager.h"
+#include "ngraph_bridge/ngraph_capture.h"
+#include "ngraph_bridge/ngraph_encapsulate_impl.h"
+#include "ngraph_bridge/ngraph_timer.h"
+
+using namespace std;
+namespace tf = tensorflow;
+namespace ngb = tensorflow::ngraph_bridge;
+
+// Latencies of the replayed calls, in microseconds
+struct LatencyStats {
+  void Add(int64_t value_us) { m_values.push_back(value_us); }
+
+  // Rounds to the nearest rank of the sorted values
+  double PercentileMs(double percentile) {
+    if (m_values.empty()) {
+      return 0;
+    }
+    std::sort(m_values.begin(), m_values.end());
+    size_t rank = static_cast<size_t>(percentile / 100 * m_values.size());
+    return m_values[std::min(rank, m_values.size() - 1)] / 1000.0;
+  }
+  double MeanMs() const {
+    double sum = 0;
+    for (auto value : m_values) {
+      sum += value;
+    }
+    return m_values.empty() ? 0 : sum / m_values.size() / 1000.0;
+  }
+  string ToJson() {
+    ostringstream out;
+    out << std::fixed << std::setprecision(3) << "{\"mean\":" << MeanMs()
+        << ",\"p50\":" << PercentileMs(50) << ",\"p90\":" << PercentileMs(90)
+        << ",\"p99\":" << PercentileMs(99) << ",\"max\":" << PercentileMs(100)
+        << "}";
+    return out.str();
+  }
+  string Summary() {
+    ostringstream out;
+    out << std::fixed << std::setprecision(3) << "mean " << MeanMs()
+        << " ms, p50 " << PercentileMs(50) << " ms, p90 " << PercentileMs(90)
+        << " ms, p99 " << PercentileMs(99) << " ms, max "
+        << PercentileMs(100) << " ms";
+    return out.str();
+  }
+
+ private:
+  vector<int64_t> m_values;
+};
+
+// Parses "key=value,key=value" into config
+static tf::Status ParseBackendConfig(const string& flag,
+                                     map<string, string>* config) {
+  for (const auto& item :
+       tf::str_util::Split(flag, ',', tf::str_util::SkipEmpty())) {
+    auto pos = item.find('=');
+    if (pos == string::npos) {
+      return tf::errors::InvalidArgument("Expected key=value in config: ",
+                                         item);
+    }
+    (*config)[item.substr(0, pos)] = item.substr(pos + 1);
+  }
+  return tf::Status::OK();
+}
+
+// Creates the result tensors of ng_exec on the current backend
+static tf::Status AllocateOutputs(
+    const shared_ptr<ngb::Executable>& ng_exec,
+    vector<shared_ptr<ngraph::runtime::Tensor>>& ng_outputs) {
+  auto backend = ngb::BackendManager::GetBackend();
+  for (const auto& result : ng_exec->get_results()) {
+    auto ng_element_type = result->get_element_type();
+    auto ng_partial_shape = result->get_output_partial_shape(0);
+    try {
+      if (ng_partial_shape.is_dynamic()) {
+        ng_outputs.push_back(
+            backend->create_dynamic_tensor(ng_element_type, ng_partial_shape));
+      } else {
+        ng_outputs.push_back(backend->create_tensor(
+            ng_element_type, ng_partial_shape.to_shape()));
+      }
+    } catch (const std::exception& exp) {
+      return tf::errors::Internal("Cannot create output tensor: ",
+                                  exp.what());
+    }
+  }
+  return tf::Status::OK();
+}
+
+int main(int argc, char** argv) {
+  string capture_file = "";
+  string backend_name = "";
+  string backend_config = "";
+  int warmup = 3;
+  int iterations = 100;
+  string json_output = "";
+
+  std::vector<tf::Flag> flag_list = {
+      tf::Flag("capture", &capture_file,
+               "Capture file (ngtf_capture_<cluster>_<instance>.tfrecord)"),
+      tf::Flag("backend", &backend_name,
+               "Backend to replay on (default: the one captured on)"),
+      tf::Flag("config", &backend_config,
+               "Backend configuration, as comma separated key=value pairs"),
+      tf::Flag("warmup", &warmup, "Calls before the measured ones"),
+      tf::Flag("iterations", &iterations, "Measured calls"),
+      tf::Flag("json_output", &json_output,
+               "File to write the results to as JSON"),
+  };
+
+  string usage = tf::Flags::Usage(argv[0], flag_list);
+  const bool parse_result = tf::Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result || capture_file.empty()) {
+    std::cout << usage;
+    return -1;
+  }
+  tf::port::InitMain(argv[0], &argc, &argv);
+  if (argc > 1) {
+    std::cout << "Error: Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+
+#if defined(NGRAPH_BRIDGE_STATIC_LIB_ENABLE)
+  ngraph_register_cpu_backend();
+#endif
+
+  ngb::CapturedCluster captured;
+  TF_CHECK_OK(ngb::ClusterCapture::Read(capture_file, &captured));
+  if (captured.steps.empty()) {
+    std::cout << "Error: " << capture_file << " has no captured calls\n";
+    return -1;
+  }
+  if (backend_name.empty()) {
+    backend_name = captured.backend.empty() ? "CPU" : captured.backend;
+  }
+  TF_CHECK_OK(ngb::BackendManager::SetBackend(backend_name));
+  map<string, string> config;
+  TF_CHECK_OK(ParseBackendConfig(backend_config, &config));
+  if (!config.empty()) {
+    ngb::BackendManager::SetConfig(config);
+  }
+
+  std::cout << "Replaying " << captured.name << " (cluster "
+            << captured.cluster << ", graph " << captured.graph_id << ") with "
+            << captured.steps.size() << " captured calls on " << backend_name
+            << "\n";
+
+  // Set up the cluster the way the encapsulate op does
+  ngb::NGraphEncapsulateImpl ng_encap_impl;
+  ng_encap_impl.SetName(captured.name);
+  ng_encap_impl.SetNgraphCluster(captured.cluster);
+  ng_encap_impl.SetGraphId(captured.graph_id);
+  auto graph = make_shared<tf::Graph>(tf::OpRegistry::Global());
+  TF_CHECK_OK(tf::ConvertGraphDefToGraph(tf::GraphConstructorOptions(),
+                                         captured.graph_def, graph.get()));
+  ng_encap_impl.m_graph = graph;
+  ng_encap_impl.ResizeStaticInputVector(captured.input_is_static.size());
+  for (size_t i = 0; i < captured.input_is_static.size(); i++) {
+    ng_encap_impl.SetStaticInputVector(i, captured.input_is_static[i]);
+  }
+
+  int64_t compile_us = 0;
+  LatencyStats execute_stats;
+  LatencyStats total_stats;
+  for (int i = 0; i < warmup + iterations; i++) {
+    const auto& inputs = captured.steps[i % captured.steps.size()];
+    ngb::Timer total_time;
+
+    vector<tf::TensorShape> input_shapes;
+    vector<const tf::Tensor*> static_input_map;
+    shared_ptr<ngb::Executable> ng_exec;
+    shared_ptr<ngraph::Function> ng_function;
+    ngb::Timer lookup_time;
+    TF_CHECK_OK(ng_encap_impl.GetNgExecutable(
+        inputs, input_shapes, static_input_map, ng_exec, ng_function));
+    if (i == 0) {
+      compile_us = lookup_time.ElapsedInMicroSec();
+    }
+
+    vector<shared_ptr<ngraph::runtime::Tensor>> ng_inputs;
+    vector<shared_ptr<ngraph::runtime::Tensor>> ng_outputs;
+    TF_CHECK_OK(ng_encap_impl.AllocateNGTensors(inputs, ng_inputs));
+    TF_CHECK_OK(AllocateOutputs(ng_exec, ng_outputs));
+
+    ngb::Timer execute_time;
+    try {
+      ng_exec->call(ng_outputs, ng_inputs);
+    } catch (const std::exception& exp) {
+      std::cout << "Error: Call " << i << " failed: " << exp.what() << "\n";
+      return -1;
+    }
+    if (i >= warmup) {
+      execute_stats.Add(execute_time.ElapsedInMicroSec());
+      total_stats.Add(total_time.ElapsedInMicroSec());
+    }
+  }
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "Translate and compile: " << compile_us / 1000.0 << " ms\n"
+            << "Execute: " << execute_stats.Summary() << "\n"
+            << "Total (lookup, tensors, execute): " << total_stats.Summary()
+            << "\n";
+
+  if (!json_output.empty()) {
+    ostringstream json;
+    json << std::fixed << std::setprecision(3) << "{\"capture\":\""
+         << capture_file << "\",\"cluster\":" << captured.cluster
+         << ",\"backend\":\"" << backend_name
+         << "\",\"iterations\":" << iterations
+         << ",\"compile_ms\":" << compile_us / 1000.0
+         << ",\"execute_ms\":" << execute_stats.ToJson()
+         << ",\"total_ms\":" << total_stats.ToJson() << "}\n";
+    TF_CHECK_OK(tf::WriteStringToFile(tf::Env::Default(), json_output,
+                                      json.str()));
+  }
+  return 0;
+}
@@ -41,6 +41,23 @@ def main():
         help="Location of the artifacts\n",
         action="store")
 
+    parser.add_argument(
+        '--run_perf_tests',
+        help=
+        "Also run the model level performance tests, which fail on\n" +
+        "regressions against baselines from a reference run. The\n" +
+        "checked-in baselines have none yet, so they only report\n",
+        action="store_true")
+
+    parser.add_argument(
+        '--perf_configuration',
+        type=str,
+        default='default',
+        help=
+        "Configuration of the performance baselines to compare against\n" +
+        "(default: CPU, interpreter: INTERPRETER)\n",
+        action="store")
+
     arguments = parser.parse_args()
 
     #-------------------------------
@@ -94,6 +111,18 @@ def main():
     # Execute the inference runs
     command_executor(["/bin/bash", "run-all-models.sh"])
 
+    # Compare compile time, latency and peak RSS of the self-contained
+    # models against their baselines
+    if arguments.run_perf_tests:
+        os.chdir(
+            os.path.join(
+                os.path.dirname(os.path.abspath(__file__)), "..", "test",
+                "model_level_tests"))
+        command_executor([
+            python_exe, "test_main.py", "--run_perf_tests", "--models",
+            "perf", "--configuration", arguments.perf_configuration
+        ])
+
     # Restore
     os.chdir(pwd)
 